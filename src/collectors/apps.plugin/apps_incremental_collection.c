@@ -92,8 +92,31 @@ static inline int incrementally_read_pid_io(struct pid_stat *p, void *ptr) {
 
 // --------------------------------------------------------------------------------------------------------------------
 
+#if (PROCESSES_HAVE_FDS == 1)
+int fds_refresh_seconds = 60;
+
+static inline bool pid_fds_need_refresh(struct pid_stat *p) {
+    if(!fds_refresh_seconds || !p->last_fds_collected_usec || p->exec_seen)
+        return true;
+
+    if(p->stat_collected_usec - p->last_fds_collected_usec >= (usec_t)fds_refresh_seconds * USEC_PER_SEC)
+        return true;
+
+#if (PROCESSES_HAVE_VOLCTX == 1) && (PROCESSES_HAVE_NVOLCTX == 1)
+    // a process that did not run since we last read its files, cannot have changed them.
+    // the context switches are counted for its main thread only, so this can be proven
+    // only for single threaded processes.
+    return p->values[PDF_THREADS] != 1 ||
+           p->values[PDF_UTIME] || p->values[PDF_STIME] ||
+           p->values[PDF_VOLCTX] || p->values[PDF_NVOLCTX];
+#else
+    return true;
+#endif
+}
+#endif
+
 int incrementally_collect_data_for_pid_stat(struct pid_stat *p, void *ptr) {
-    if(unlikely(p->read)) return 0;
+    if(unlikely(p->read || p->exited)) return 0;
 
     pid_collection_started(p);
 
@@ -124,12 +147,26 @@ int incrementally_collect_data_for_pid_stat(struct pid_stat *p, void *ptr) {
         return 0;
     }
 
+    // --------------------------------------------------------------------
+    // /proc/<pid>/cmdline
+
+#if (PROCESSES_HAVE_CMDLINE == 1)
+    // after exec() the command line is different, even when the comm is the same
+    if(unlikely(p->exec_seen && proc_pid_cmdline_is_needed))
+        managed_log(p, PID_LOG_CMDLINE, read_proc_pid_cmdline(p));
+#endif
+
     // --------------------------------------------------------------------
     // /proc/<pid>/fd
 
 #if (PROCESSES_HAVE_FDS == 1)
     if(enable_file_charts) {
-        managed_log(p, PID_LOG_FDS, read_pid_file_descriptors(p, ptr));
+        if(pid_fds_need_refresh(p)) {
+            usec_t started_ut = now_monotonic_usec();
+            managed_log(p, PID_LOG_FDS, read_pid_file_descriptors(p, ptr));
+            p->last_fds_collected_usec = p->stat_collected_usec;
+            apps_phases_ut[APPS_PHASE_FILES] += now_monotonic_usec() - started_ut;
+        }
 #if (PROCESSES_HAVE_PID_LIMITS == 1)
         managed_log(p, PID_LOG_LIMITS, OS_FUNCTION(apps_os_read_pid_limits)(p, ptr));
 #endif
@@ -147,6 +184,7 @@ int incrementally_collect_data_for_pid_stat(struct pid_stat *p, void *ptr) {
                p->pid, pid_stat_comm(p), p->sortlist, pp->pid, pid_stat_comm(pp), pp->sortlist);
 #endif
 
+    p->exec_seen = false;
     pid_collection_completed(p);
 
     return 1;
@@ -4,14 +4,355 @@
 
 #if defined(OS_LINUX)
 
+#include <linux/netlink.h>
+#include <linux/connector.h>
+#include <linux/cn_proc.h>
+
 #define MAX_PROC_PID_LIMITS 8192
 #define PROC_PID_LIMITS_MAX_OPEN_FILES_KEY "\nMax open files "
 
 int max_fds_cache_seconds = 60;
 kernel_uint_t system_uptime_secs;
 
+// --------------------------------------------------------------------------------------------------------------------
+// process events from the kernel (proc connector)
+//
+// When available (it needs CAP_NET_ADMIN), the kernel tells us about every fork(),
+// exec() and exit(), so we don't need to list /proc on every iteration to find the
+// new processes. We still scan /proc periodically and whenever we lose events.
+
+#define PROC_EVENTS_FULL_SCAN_EVERY_UT (60 * USEC_PER_SEC)
+#define PROC_EVENTS_RECEIVE_BUFFER (4 * 1024 * 1024)
+#define PROC_EVENTS_ACK_TIMEOUT_MS 1000
+
+bool enable_proc_events = true;
+struct proc_events_stats proc_events_stats = { 0 };
+
+static struct {
+    int fd;
+    bool full_scan;                 // true when we may have missed events
+    usec_t last_full_scan_ut;
+} proc_events = {
+    .fd = -1,
+    .full_scan = true,
+    .last_full_scan_ut = 0,
+};
+
+bool apps_os_proc_events_active_linux(void) {
+    return proc_events.fd != -1;
+}
+
+static void proc_events_disable(const char *reason) {
+    if(proc_events.fd != -1) {
+        close(proc_events.fd);
+        proc_events.fd = -1;
+    }
+
+    proc_events.full_scan = true;
+    netdata_log_info("process events from the kernel are not used (%s) - scanning %s/proc on every iteration",
+                     reason, netdata_configured_host_prefix);
+}
+
+static bool proc_events_send_op(enum proc_cn_mcast_op op) {
+    char buf[NLMSG_SPACE(sizeof(struct cn_msg) + sizeof(enum proc_cn_mcast_op))] __attribute__((aligned(NLMSG_ALIGNTO)));
+    memset(buf, 0, sizeof(buf));
+
+    struct nlmsghdr *nl = (struct nlmsghdr *)buf;
+    nl->nlmsg_len = NLMSG_LENGTH(sizeof(struct cn_msg) + sizeof(enum proc_cn_mcast_op));
+    nl->nlmsg_type = NLMSG_DONE;
+    nl->nlmsg_pid = getpid();
+
+    struct cn_msg *cn = NLMSG_DATA(nl);
+    cn->id.idx = CN_IDX_PROC;
+    cn->id.val = CN_VAL_PROC;
+    cn->ack = 1;
+    cn->len = sizeof(enum proc_cn_mcast_op);
+    memcpy(cn->data, &op, sizeof(op));
+
+    return send(proc_events.fd, buf, nl->nlmsg_len, 0) == (ssize_t)nl->nlmsg_len;
+}
+
+// returns 1 when the kernel accepted our subscription, 0 when it did not, -1 for other events
+static int proc_events_process_message(struct nlmsghdr *nl) {
+    if(nl->nlmsg_type == NLMSG_ERROR || nl->nlmsg_type == NLMSG_NOOP || nl->nlmsg_type == NLMSG_OVERRUN)
+        return -1;
+
+    if(nl->nlmsg_len < NLMSG_LENGTH(sizeof(struct cn_msg) + sizeof(struct proc_event)))
+        return -1;
+
+    struct cn_msg *cn = NLMSG_DATA(nl);
+    if(cn->id.idx != CN_IDX_PROC || cn->id.val != CN_VAL_PROC)
+        return -1;
+
+    struct proc_event *ev = (struct proc_event *)cn->data;
+    struct pid_stat *p;
+
+    switch(ev->what) {
+        case PROC_EVENT_NONE:
+            // the acknowledgement of our subscription
+            return ev->event_data.ack.err == 0 ? 1 : 0;
+
+        case PROC_EVENT_FORK:
+            // threads are reported as forks too
+            if(ev->event_data.fork.child_pid != ev->event_data.fork.child_tgid)
+                break;
+
+            proc_events_stats.forks++;
+            if(ev->event_data.fork.child_tgid < INIT_PID)
+                break;
+
+            p = find_pid_entry(ev->event_data.fork.child_tgid);
+            if(p) {
+                // we missed the exit of the previous process with this pid
+                p->exited = false;
+                p->exec_seen = true;
+            }
+            else
+                get_or_allocate_pid_entry(ev->event_data.fork.child_tgid);
+            break;
+
+        case PROC_EVENT_EXEC:
+            proc_events_stats.execs++;
+            if(ev->event_data.exec.process_tgid < INIT_PID)
+                break;
+
+            p = get_or_allocate_pid_entry(ev->event_data.exec.process_tgid);
+            p->exited = false;
+            p->exec_seen = true;
+            break;
+
+        case PROC_EVENT_EXIT:
+            // only the exit of the whole process matters to us
+            if(ev->event_data.exit.process_pid != ev->event_data.exit.process_tgid)
+                break;
+
+            proc_events_stats.exits++;
+            p = find_pid_entry(ev->event_data.exit.process_tgid);
+            if(p)
+                p->exited = true;
+            break;
+
+        default:
+            break;
+    }
+
+    return -1;
+}
+
+// returns 1 when the kernel accepted our subscription, 0 when it did not, -1 otherwise
+static int proc_events_receive(void) {
+    char buf[16384] __attribute__((aligned(NLMSG_ALIGNTO)));
+    int ack = -1;
+
+    while(proc_events.fd != -1) {
+        struct sockaddr_nl from = { 0 };
+        socklen_t from_len = sizeof(from);
+
+        ssize_t len = recvfrom(proc_events.fd, buf, sizeof(buf), 0, (struct sockaddr *)&from, &from_len);
+        if(len == -1) {
+            if(errno == EAGAIN || errno == EWOULDBLOCK)
+                break;
+
+            if(errno == EINTR)
+                continue;
+
+            if(errno == ENOBUFS) {
+                // the kernel dropped events - we have to scan /proc to find what we missed
+                proc_events_stats.overflows++;
+                proc_events.full_scan = true;
+                continue;
+            }
+
+            proc_events_disable("cannot receive from the netlink socket");
+            break;
+        }
+
+        // accept messages only from the kernel
+        if(from.nl_pid != 0)
+            continue;
+
+        for(struct nlmsghdr *nl = (struct nlmsghdr *)buf; NLMSG_OK(nl, len); nl = NLMSG_NEXT(nl, len)) {
+            int rc = proc_events_process_message(nl);
+            if(rc != -1)
+                ack = rc;
+        }
+    }
+
+    return ack;
+}
+
+static void proc_events_init(void) {
+    if(!enable_proc_events)
+        return;
+
+    if(netdata_configured_host_prefix && *netdata_configured_host_prefix) {
+        // the events are about our pid namespace, not the one of the host prefix
+        proc_events_disable("a host prefix is configured");
+        return;
+    }
+
+    proc_events.fd = socket(PF_NETLINK, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_CONNECTOR);
+    if(proc_events.fd == -1) {
+        proc_events_disable("cannot create a netlink connector socket");
+        return;
+    }
+
+    // bursts of forks are frequent, give the kernel room to queue them
+    int size = PROC_EVENTS_RECEIVE_BUFFER;
+    if(setsockopt(proc_events.fd, SOL_SOCKET, SO_RCVBUFFORCE, &size, sizeof(size)) != 0)
+        (void)setsockopt(proc_events.fd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+
+    struct sockaddr_nl sa = {
+        .nl_family = AF_NETLINK,
+        .nl_groups = CN_IDX_PROC,
+        .nl_pid = 0,
+    };
+
+    if(bind(proc_events.fd, (struct sockaddr *)&sa, sizeof(sa)) != 0) {
+        proc_events_disable("cannot bind to the proc connector");
+        return;
+    }
+
+    if(!proc_events_send_op(PROC_CN_MCAST_LISTEN)) {
+        proc_events_disable("cannot subscribe to the proc connector");
+        return;
+    }
+
+    // the kernel acknowledges the subscription only when it accepts it
+    usec_t stop_ut = now_monotonic_usec() + PROC_EVENTS_ACK_TIMEOUT_MS * USEC_PER_MS;
+    int ack = -1;
+    while(ack == -1 && proc_events.fd != -1) {
+        usec_t now_ut = now_monotonic_usec();
+        if(now_ut >= stop_ut)
+            break;
+
+        struct pollfd pfd = { .fd = proc_events.fd, .events = POLLIN };
+        if(poll(&pfd, 1, (int)((stop_ut - now_ut) / USEC_PER_MS) + 1) < 0 && errno != EINTR)
+            break;
+
+        ack = proc_events_receive();
+    }
+
+    if(ack != 1) {
+        proc_events_disable("the kernel did not accept our subscription to process events");
+        return;
+    }
+
+    proc_events.full_scan = true;
+    netdata_log_info("using process events from the kernel, scanning %s/proc every %d seconds",
+                     netdata_configured_host_prefix, (int)(PROC_EVENTS_FULL_SCAN_EVERY_UT / USEC_PER_SEC));
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+// the files of /proc/PID we read on every iteration (stat, status, io) are kept open,
+// and re-read with pread(), so that long running processes do not open and close them.
+//
+// An open /proc/PID file is bound to the process it was opened for: when the process
+// is gone, reading it fails, even if its pid has been reused. Then all the files of the
+// pid are closed and re-opened. The start time of the process is checked too.
+//
+// Every open /proc/PID file pins a kernel page for its seq_file buffer, so by default
+// only a few thousand are kept open (or a quarter of the soft RLIMIT_NOFILE, if lower).
+// max-open-proc-files N raises it, raising the soft RLIMIT_NOFILE up to the hard one
+// when needed. When the budget is exhausted, the files of the remaining processes are
+// opened and closed on every read, like before.
+
+int max_open_proc_files = -1; // -1 = automatic, 0 = disabled
+struct proc_syscalls_stats proc_syscalls = { 0 };
+
+static void proc_files_init(void) {
+    if(max_open_proc_files == 0)
+        return;
+
+    struct rlimit rl;
+    if(getrlimit(RLIMIT_NOFILE, &rl) != 0) {
+        netdata_log_error("cannot get RLIMIT_NOFILE - /proc files will not be kept open");
+        return;
+    }
+
+    size_t wanted = (max_open_proc_files > 0) ? (size_t)max_open_proc_files : PROC_FILES_DEFAULT_BUDGET;
+
+    // raise the soft limit only when asked to keep more files open than it allows
+    if(max_open_proc_files > 0 && rl.rlim_cur != RLIM_INFINITY &&
+        (rlim_t)(wanted + PROC_FILES_RESERVED_FDS) > rl.rlim_cur && rl.rlim_cur < rl.rlim_max) {
+        struct rlimit raised = rl;
+        raised.rlim_cur = (rl.rlim_max == RLIM_INFINITY || (rlim_t)(wanted + PROC_FILES_RESERVED_FDS) < rl.rlim_max) ?
+                          (rlim_t)(wanted + PROC_FILES_RESERVED_FDS) : rl.rlim_max;
+        if(setrlimit(RLIMIT_NOFILE, &raised) == 0)
+            rl = raised;
+    }
+
+    size_t available = (rl.rlim_cur == RLIM_INFINITY) ? SIZE_MAX : (size_t)rl.rlim_cur;
+    size_t budget;
+    if(max_open_proc_files > 0) {
+        size_t reserved = MIN(available / 2, PROC_FILES_RESERVED_FDS);
+        budget = MIN(wanted, available - reserved);
+    }
+    else
+        budget = MIN(wanted, available / 4);
+
+    proc_syscalls.open_files_budget = budget;
+    netdata_log_info("keeping up to %zu /proc files open", budget);
+}
+
+static inline void pid_proc_file_close(struct pid_stat *p, PID_PROC_FILE pf) {
+    uint8_t bit = (uint8_t)(1 << pf);
+    if(!(p->proc_fds_open & bit))
+        return;
+
+    close(p->proc_fds[pf]);
+    p->proc_fds_open &= ~bit;
+    proc_syscalls.closes++;
+    proc_syscalls.open_files--;
+}
+
+void apps_os_pid_close_proc_files_linux(struct pid_stat *p) {
+    for(PID_PROC_FILE pf = 0; pf < PID_PROC_FILE_MAX ; pf++)
+        pid_proc_file_close(p, pf);
+}
+
+static bool pid_proc_file_read(struct pid_stat *p, PID_PROC_FILE pf, const char *filename, procfile **ff) {
+    uint8_t bit = (uint8_t)(1 << pf);
+
+    // procfile counts every pread() it makes, including the one that hits EOF
+    size_t reads = (*ff)->stats.reads;
+
+    if(likely(p->proc_fds_open & bit)) {
+        bool ok = procfile_readall_fd(ff, p->proc_fds[pf]);
+        proc_syscalls.reads += (*ff)->stats.reads - reads;
+        if(likely(ok))
+            return true;
+
+        reads = (*ff)->stats.reads;
+
+        // the process exited, or its pid has been reused
+        apps_os_pid_close_proc_files_linux(p);
+    }
+
+    int fd = open(filename, procfile_open_flags, 0666);
+    proc_syscalls.opens++;
+    if(unlikely(fd == -1))
+        return false;
+
+    bool ret = procfile_readall_fd(ff, fd);
+    proc_syscalls.reads += (*ff)->stats.reads - reads;
+
+    if(ret && proc_syscalls.open_files < proc_syscalls.open_files_budget) {
+        p->proc_fds[pf] = fd;
+        p->proc_fds_open |= bit;
+        proc_syscalls.open_files++;
+    }
+    else {
+        close(fd);
+        proc_syscalls.closes++;
+    }
+
+    return ret;
+}
+
 void apps_os_init_linux(void) {
-    ;
+    proc_files_init();
+    proc_events_init();
 }
 
 // --------------------------------------------------------------------------------------------------------------------
@@ -23,17 +364,55 @@ struct arl_callback_ptr {
     size_t line;
 };
 
+// We list the fd directories with getdents64() directly, instead of readdir(),
+// so that we know how many system calls listing a directory really takes.
+
+struct linux_dirent64 {
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[];
+};
+
+struct proc_dir {
+    int fd;
+    size_t pos;
+    size_t len;
+    char buf[32 * 1024] __attribute__((aligned(8)));
+};
+
+static struct linux_dirent64 *proc_dir_next(struct proc_dir *d) {
+    if(d->pos >= d->len) {
+        ssize_t bytes = syscall(SYS_getdents64, d->fd, d->buf, sizeof(d->buf));
+        proc_syscalls.reads++;
+        if(bytes <= 0)
+            return NULL;
+
+        d->pos = 0;
+        d->len = (size_t)bytes;
+    }
+
+    struct linux_dirent64 *de = (struct linux_dirent64 *)&d->buf[d->pos];
+    d->pos += de->d_reclen;
+    return de;
+}
+
 bool apps_os_read_pid_fds_linux(struct pid_stat *p, void *ptr __maybe_unused) {
+    static struct proc_dir fds;
+
     if(unlikely(!p->fds_dirname)) {
         char dirname[FILENAME_MAX+1];
         snprintfz(dirname, FILENAME_MAX, "%s/proc/%d/fd", netdata_configured_host_prefix, p->pid);
         p->fds_dirname = strdupz(dirname);
     }
 
-    DIR *fds = opendir(p->fds_dirname);
-    if(unlikely(!fds)) return false;
+    fds.fd = open(p->fds_dirname, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    proc_syscalls.opens++;
+    if(unlikely(fds.fd == -1)) return false;
+    fds.pos = fds.len = 0;
 
-    struct dirent *de;
+    struct linux_dirent64 *de;
     char linkname[FILENAME_MAX + 1];
 
     // we make all pid fds negative, so that
@@ -41,7 +420,7 @@ bool apps_os_read_pid_fds_linux(struct pid_stat *p, void *ptr __maybe_unused) {
     // at the end, to free them
     make_all_pid_fds_negative(p);
 
-    while((de = readdir(fds))) {
+    while((de = proc_dir_next(&fds))) {
         // we need only files with numeric names
 
         if(unlikely(de->d_name[0] < '0' || de->d_name[0] > '9'))
@@ -88,6 +467,7 @@ bool apps_os_read_pid_fds_linux(struct pid_stat *p, void *ptr __maybe_unused) {
         }
 
         file_counter++;
+        proc_syscalls.reads++;
         ssize_t l = readlink(p->fds[fdid].filename, linkname, FILENAME_MAX);
         if(unlikely(l == -1)) {
             // cannot read the link
@@ -150,7 +530,8 @@ bool apps_os_read_pid_fds_linux(struct pid_stat *p, void *ptr __maybe_unused) {
         }
     }
 
-    closedir(fds);
+    close(fds.fd);
+    proc_syscalls.closes++;
 
     return true;
 }
@@ -198,11 +579,14 @@ bool apps_os_get_pid_cmdline_linux(struct pid_stat *p, char *cmdline, size_t byt
     }
 
     int fd = open(p->cmdline_filename, procfile_open_flags, 0666);
+    proc_syscalls.opens++;
     if(unlikely(fd == -1))
         return false;
 
     ssize_t i, b = read(fd, cmdline, bytes - 1);
     close(fd);
+    proc_syscalls.reads++;
+    proc_syscalls.closes++;
 
     if(unlikely(b < 0))
         return false;
@@ -230,12 +614,11 @@ bool apps_os_read_pid_io_linux(struct pid_stat *p, void *ptr __maybe_unused) {
         p->io_filename = strdupz(filename);
     }
 
-    // open the file
-    ff = procfile_reopen(ff, p->io_filename, NULL, PROCFILE_FLAG_NO_ERROR_ON_FILE_IO);
-    if(unlikely(!ff)) goto cleanup;
+    if(unlikely(!ff))
+        ff = procfile_create(NULL, PROCFILE_FLAG_NO_ERROR_ON_FILE_IO);
 
-    ff = procfile_readall(ff);
-    if(unlikely(!ff)) goto cleanup;
+    if(unlikely(!pid_proc_file_read(p, PID_PROC_FILE_IO, p->io_filename, &ff)))
+        goto cleanup;
 
     pid_incremental_rate(io, PDF_LREAD,     str2kernel_uint_t(procfile_lineword(ff, 0,  1)));
     pid_incremental_rate(io, PDF_LWRITE,    str2kernel_uint_t(procfile_lineword(ff, 1,  1)));
@@ -289,10 +672,13 @@ bool apps_os_read_pid_limits_linux(struct pid_stat *p, void *ptr __maybe_unused)
     }
 
     int fd = open(p->limits_filename, procfile_open_flags, 0666);
+    proc_syscalls.opens++;
     if(unlikely(fd == -1)) goto cleanup;
 
     ssize_t bytes = read(fd, proc_pid_limits_buffer, MAX_PROC_PID_LIMITS);
     close(fd);
+    proc_syscalls.reads++;
+    proc_syscalls.closes++;
 
     if(bytes <= 0)
         goto cleanup;
@@ -496,11 +882,11 @@ bool apps_os_read_pid_status_linux(struct pid_stat *p, void *ptr __maybe_unused)
         p->status_filename = strdupz(filename);
     }
 
-    ff = procfile_reopen(ff, p->status_filename, (!ff)?" \t:,-()/":NULL, PROCFILE_FLAG_NO_ERROR_ON_FILE_IO);
-    if(unlikely(!ff)) return false;
+    if(unlikely(!ff))
+        ff = procfile_create(" \t:,-()/", PROCFILE_FLAG_NO_ERROR_ON_FILE_IO);
 
-    ff = procfile_readall(ff);
-    if(unlikely(!ff)) return false;
+    if(unlikely(!pid_proc_file_read(p, PID_PROC_FILE_STATUS, p->status_filename, &ff)))
+        return false;
 
     calls_counter++;
 
@@ -618,17 +1004,16 @@ bool apps_os_read_pid_stat_linux(struct pid_stat *p, void *ptr __maybe_unused) {
         p->stat_filename = strdupz(filename);
     }
 
-    bool set_quotes = (!ff) ? true : false;
-
-    ff = procfile_reopen(ff, p->stat_filename, NULL, PROCFILE_FLAG_NO_ERROR_ON_FILE_IO);
-    if(unlikely(!ff)) goto cleanup;
-
-    // if(set_quotes) procfile_set_quotes(ff, "()");
-    if(unlikely(set_quotes))
+    if(unlikely(!ff)) {
+        ff = procfile_create(NULL, PROCFILE_FLAG_NO_ERROR_ON_FILE_IO);
+        // procfile_set_quotes(ff, "()");
         procfile_set_open_close(ff, "(", ")");
+    }
 
-    ff = procfile_readall(ff);
-    if(unlikely(!ff)) goto cleanup;
+    if(unlikely(!pid_proc_file_read(p, PID_PROC_FILE_STAT, p->stat_filename, &ff)))
+        goto cleanup;
+
+    proc_syscalls.pids++;
 
     // p->pid           = str2pid_t(procfile_lineword(ff, 0, 0));
     char *comm          = procfile_lineword(ff, 0, 1);
@@ -654,7 +1039,15 @@ bool apps_os_read_pid_stat_linux(struct pid_stat *p, void *ptr __maybe_unused) {
     // p->nice          = str2kernel_uint_t(procfile_lineword(ff, 0, 18));
     p->values[PDF_THREADS] = (int32_t) str2uint32_t(procfile_lineword(ff, 0, 19), NULL);
     // p->itrealvalue   = str2kernel_uint_t(procfile_lineword(ff, 0, 20));
-    kernel_uint_t collected_starttime = str2kernel_uint_t(procfile_lineword(ff, 0, 21)) / system_hz;
+    kernel_uint_t starttime = str2kernel_uint_t(procfile_lineword(ff, 0, 21));
+    if(unlikely(p->proc_starttime != starttime)) {
+        // a new process, or the pid has been reused - the files we keep open may be of another process
+        if(p->proc_starttime)
+            apps_os_pid_close_proc_files_linux(p);
+
+        p->proc_starttime = starttime;
+    }
+    kernel_uint_t collected_starttime = starttime / system_hz;
     p->values[PDF_UPTIME] = (system_uptime_secs > collected_starttime)?(system_uptime_secs - collected_starttime):0;
     // p->vsize         = str2kernel_uint_t(procfile_lineword(ff, 0, 22));
     // p->rss           = str2kernel_uint_t(procfile_lineword(ff, 0, 23));
@@ -732,6 +1125,22 @@ bool apps_os_collect_all_pids_linux(void) {
     memset(proc_state_count, 0, sizeof proc_state_count);
 #endif
 
+    bool full_scan = true;
+    if(proc_events.fd != -1) {
+        usec_t started_ut = now_monotonic_usec();
+        proc_events_receive();
+        apps_phases_ut[APPS_PHASE_EVENTS] += now_monotonic_usec() - started_ut;
+
+        full_scan = proc_events.full_scan || proc_events.fd == -1 ||
+                    started_ut - proc_events.last_full_scan_ut >= PROC_EVENTS_FULL_SCAN_EVERY_UT;
+    }
+
+    if(full_scan) {
+        // the exit events may be stale, /proc has the final word
+        for(struct pid_stat *p = root_of_pids(); p ; p = p->next)
+            p->exited = false;
+    }
+
     // preload the parents and then their children
     collect_parents_before_children();
 
@@ -741,6 +1150,14 @@ bool apps_os_collect_all_pids_linux(void) {
 
     system_uptime_secs = (kernel_uint_t)(uptime_msec(uptime_filename) / MSEC_PER_SEC);
 
+    if(!full_scan) {
+        // the process events keep the list of processes up to date
+        for(struct pid_stat *p = root_of_pids(); p ; p = p->next)
+            incrementally_collect_data_for_pid_stat(p, NULL);
+
+        return true;
+    }
+
     char dirname[FILENAME_MAX + 1];
 
     snprintfz(dirname, FILENAME_MAX, "%s/proc", netdata_configured_host_prefix);
@@ -765,6 +1182,12 @@ bool apps_os_collect_all_pids_linux(void) {
     }
     closedir(dir);
 
+    if(proc_events.fd != -1) {
+        proc_events.full_scan = false;
+        proc_events.last_full_scan_ut = now_monotonic_usec();
+        proc_events_stats.full_scans++;
+    }
+
     return true;
 }
 #endif
@@ -94,6 +94,110 @@ void send_resource_usage_to_netdata(usec_t dt) {
             , apps_groups_targets_count
             , targets_assignment_counter
     );
+
+    static bool phases_chart_created = false;
+    if(unlikely(!phases_chart_created)) {
+        phases_chart_created = true;
+
+        fprintf(stdout,
+                "CHART netdata.apps_phases '' 'Apps Plugin Time per Phase' 'milliseconds/run' apps.plugin netdata.apps_phases stacked 140002 %1$d\n"
+                "DIMENSION events '' absolute 1 1000\n"
+                "DIMENSION processes '' absolute 1 1000\n"
+                "DIMENSION files '' absolute 1 1000\n"
+                "DIMENSION aggregation '' absolute 1 1000\n"
+                "DIMENSION output '' absolute 1 1000\n"
+                , update_every
+        );
+    }
+
+    fprintf(stdout,
+            "BEGIN netdata.apps_phases %"PRIu64"\n"
+            "SET events = %"PRIu64"\n"
+            "SET processes = %"PRIu64"\n"
+            "SET files = %"PRIu64"\n"
+            "SET aggregation = %"PRIu64"\n"
+            "SET output = %"PRIu64"\n"
+            "END\n"
+            , dt
+            , apps_phases_ut[APPS_PHASE_EVENTS]
+            , apps_phases_ut[APPS_PHASE_PROCESSES]
+            , apps_phases_ut[APPS_PHASE_FILES]
+            , apps_phases_ut[APPS_PHASE_AGGREGATION]
+            , apps_phases_ut[APPS_PHASE_OUTPUT]
+    );
+
+#if defined(OS_LINUX)
+    static bool syscalls_chart_created = false;
+    if(unlikely(!syscalls_chart_created)) {
+        syscalls_chart_created = true;
+
+        fprintf(stdout,
+                "CHART netdata.apps_proc_syscalls '' 'Apps Plugin /proc System Calls' 'calls/s' apps.plugin netdata.apps_proc_syscalls line 140004 %1$d\n"
+                "DIMENSION opens '' incremental 1 1\n"
+                "DIMENSION reads '' incremental 1 1\n"
+                "DIMENSION closes '' incremental 1 1\n"
+                "DIMENSION per_process 'per process' absolute 1 100\n"
+                "DIMENSION open_files 'kept open' absolute 1 1\n"
+                , update_every
+        );
+    }
+
+    static size_t last_syscalls = 0, last_pids = 0;
+    size_t syscalls = proc_syscalls.opens + proc_syscalls.reads + proc_syscalls.closes;
+    size_t pids = proc_syscalls.pids - last_pids;
+    size_t per_process = pids ? (syscalls - last_syscalls) * 100 / pids : 0;
+    last_syscalls = syscalls;
+    last_pids = proc_syscalls.pids;
+
+    fprintf(stdout,
+            "BEGIN netdata.apps_proc_syscalls %"PRIu64"\n"
+            "SET opens = %zu\n"
+            "SET reads = %zu\n"
+            "SET closes = %zu\n"
+            "SET per_process = %zu\n"
+            "SET open_files = %zu\n"
+            "END\n"
+            , dt
+            , proc_syscalls.opens
+            , proc_syscalls.reads
+            , proc_syscalls.closes
+            , per_process
+            , proc_syscalls.open_files
+    );
+
+    if(apps_os_proc_events_active_linux()) {
+        static bool events_chart_created = false;
+        if(unlikely(!events_chart_created)) {
+            events_chart_created = true;
+
+            fprintf(stdout,
+                    "CHART netdata.apps_proc_events '' 'Apps Plugin Process Events' 'events/s' apps.plugin netdata.apps_proc_events line 140003 %1$d\n"
+                    "DIMENSION forks '' incremental 1 1\n"
+                    "DIMENSION execs '' incremental 1 1\n"
+                    "DIMENSION exits '' incremental 1 1\n"
+                    "DIMENSION full_scans 'full scans' incremental 1 1\n"
+                    "DIMENSION overflows '' incremental 1 1\n"
+                    , update_every
+            );
+        }
+
+        fprintf(stdout,
+                "BEGIN netdata.apps_proc_events %"PRIu64"\n"
+                "SET forks = %zu\n"
+                "SET execs = %zu\n"
+                "SET exits = %zu\n"
+                "SET full_scans = %zu\n"
+                "SET overflows = %zu\n"
+                "END\n"
+                , dt
+                , proc_events_stats.forks
+                , proc_events_stats.execs
+                , proc_events_stats.exits
+                , proc_events_stats.full_scans
+                , proc_events_stats.overflows
+        );
+    }
+#endif
 }
 
 void send_collected_data_to_netdata(struct target *root, const char *type, usec_t dt) {
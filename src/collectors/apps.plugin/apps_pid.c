@@ -115,6 +115,8 @@ void del_pid_entry(pid_t pid) {
     simple_hashtable_del_slot_PID(&pids.all_pids.ht, sl);
 
 #if defined(OS_LINUX)
+    apps_os_pid_close_proc_files_linux(p);
+
     {
         size_t i;
         for(i = 0; i < p->fds_size; i++)
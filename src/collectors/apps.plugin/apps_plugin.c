@@ -50,6 +50,8 @@ size_t
     targets_assignment_counter = 0,
     apps_groups_targets_count = 0;       // # of apps_groups.conf targets
 
+usec_t apps_phases_ut[APPS_PHASE_MAX] = { 0 };
+
 #if (PROCESSES_HAVE_CPU_GUEST_TIME == 1)
 bool enable_guest_charts = false;
 bool show_guest_time = false;            // set when guest values are collected
@@ -438,6 +440,35 @@ static void parse_args(int argc, char **argv)
             if(max_fds_cache_seconds < 0) max_fds_cache_seconds = 0;
             continue;
         }
+
+        if(strcmp("max-open-proc-files", argv[i]) == 0) {
+            if(argc <= i + 1) {
+                fprintf(stderr, "Parameter 'max-open-proc-files' requires a number as argument.\n");
+                exit(1);
+            }
+            i++;
+            max_open_proc_files = str2i(argv[i]);
+            if(max_open_proc_files < 0) max_open_proc_files = 0;
+            continue;
+        }
+
+        if(strcmp("without-proc-events", argv[i]) == 0) {
+            enable_proc_events = false;
+            continue;
+        }
+#endif
+
+#if (PROCESSES_HAVE_FDS == 1) && (INCREMENTAL_DATA_COLLECTION == 1)
+        if(strcmp("fds-refresh-secs", argv[i]) == 0) {
+            if(argc <= i + 1) {
+                fprintf(stderr, "Parameter 'fds-refresh-secs' requires a number as argument.\n");
+                exit(1);
+            }
+            i++;
+            fds_refresh_seconds = str2i(argv[i]);
+            if(fds_refresh_seconds < 0) fds_refresh_seconds = 0;
+            continue;
+        }
 #endif
 
 #if (PROCESSES_HAVE_CPU_CHILDREN_TIME == 1) || (PROCESSES_HAVE_CHILDREN_FLTS == 1)
@@ -557,12 +588,32 @@ static void parse_args(int argc, char **argv)
                     "                        max given)\n"
                     "                        (default is %d seconds)\n"
                     "\n"
+                    " max-open-proc-files N  keep at most N /proc/PID files open, to re-read\n"
+                    "                        them without opening them again\n"
+                    "                        (0 disables it, default is %d, or a quarter\n"
+                    "                        of the open files limit if that is lower)\n"
+                    "\n"
+                    " without-proc-events    do not use the process events of the kernel\n"
+                    "                        to find new processes, scan /proc instead\n"
+                    "                        (the events need CAP_NET_ADMIN)\n"
+                    "\n"
+#endif
+#if (PROCESSES_HAVE_FDS == 1) && (INCREMENTAL_DATA_COLLECTION == 1)
+                    " fds-refresh-secs N     re-read the files of processes that have not\n"
+                    "                        run since the last time, at least every N\n"
+                    "                        seconds (0 reads them on every iteration)\n"
+                    "                        (default is %d seconds)\n"
+                    "\n"
 #endif
                     " version or -v or -V print program version and exit\n"
                     "\n"
                     , NETDATA_VERSION
 #if defined(OS_LINUX)
                     , max_fds_cache_seconds
+                    , PROC_FILES_DEFAULT_BUDGET
+#endif
+#if (PROCESSES_HAVE_FDS == 1) && (INCREMENTAL_DATA_COLLECTION == 1)
+                    , fds_refresh_seconds
 #endif
             );
             exit(0);
@@ -751,6 +802,10 @@ int main(int argc, char **argv) {
     apps_pids_init();
     OS_FUNCTION(apps_os_init)();
 
+    // send our output through shared memory, when the agent offers it
+    if(shm_ring_stdout())
+        netdata_log_info("sending data to netdata via shared memory");
+
     // ------------------------------------------------------------------------
     // the event loop for functions
 
@@ -774,7 +829,19 @@ int main(int argc, char **argv) {
         if(profile_speed) {
             static int profiling_count=0;
             profiling_count++;
-            if(unlikely(profiling_count > 500)) exit(0);
+            if(unlikely(profiling_count > 500)) {
+#if defined(OS_LINUX)
+                size_t syscalls = proc_syscalls.opens + proc_syscalls.reads + proc_syscalls.closes;
+                fprintf(stderr, "apps.plugin: %zu processes collected with %zu /proc system calls "
+                                "(%zu opens, %zu reads, %zu closes), %.2f system calls per process, "
+                                "%zu /proc files kept open\n",
+                        proc_syscalls.pids, syscalls,
+                        proc_syscalls.opens, proc_syscalls.reads, proc_syscalls.closes,
+                        proc_syscalls.pids ? (double)syscalls / (double)proc_syscalls.pids : 0.0,
+                        proc_syscalls.open_files);
+#endif
+                exit(0);
+            }
             dt = update_every * USEC_PER_SEC;
         }
         else
@@ -782,7 +849,8 @@ int main(int argc, char **argv) {
 
         netdata_mutex_lock(&apps_and_stdout_mutex);
 
-        struct pollfd pollfd = { .fd = fileno(stdout), .events = POLLERR };
+        // stdout may be redirected to shared memory, but the pipe is still there
+        struct pollfd pollfd = { .fd = STDOUT_FILENO, .events = POLLERR };
         if (unlikely(poll(&pollfd, 1, 0) < 0)) {
             netdata_mutex_unlock(&apps_and_stdout_mutex);
             fatal("Cannot check if a pipe is available");
@@ -792,6 +860,10 @@ int main(int argc, char **argv) {
             fatal("Received error on read pipe.");
         }
 
+        usec_t phase_started_ut = now_monotonic_usec();
+        apps_phases_ut[APPS_PHASE_EVENTS] = 0;
+        apps_phases_ut[APPS_PHASE_FILES] = 0;
+
         if(!collect_data_for_all_pids()) {
             netdata_log_error("Cannot collect /proc data for running processes. Disabling apps.plugin...");
             printf("DISABLE\n");
@@ -799,6 +871,11 @@ int main(int argc, char **argv) {
             exit(1);
         }
 
+        usec_t now_ut = now_monotonic_usec();
+        apps_phases_ut[APPS_PHASE_PROCESSES] = now_ut - phase_started_ut
+            - apps_phases_ut[APPS_PHASE_EVENTS] - apps_phases_ut[APPS_PHASE_FILES];
+        phase_started_ut = now_ut;
+
         aggregate_processes_to_targets();
 
 #if (ALL_PIDS_ARE_READ_INSTANTLY == 0)
@@ -806,6 +883,10 @@ int main(int argc, char **argv) {
         normalize_utilization(apps_groups_root_target);
 #endif
 
+        now_ut = now_monotonic_usec();
+        apps_phases_ut[APPS_PHASE_AGGREGATION] = now_ut - phase_started_ut;
+        phase_started_ut = now_ut;
+
         if(unlikely(print_tree_and_exit)) {
             print_hierarchy(root_of_pids());
             exit(0);
@@ -844,6 +925,9 @@ int main(int argc, char **argv) {
 
         fflush(stdout);
 
+        // reported on the next iteration
+        apps_phases_ut[APPS_PHASE_OUTPUT] = now_monotonic_usec() - phase_started_ut;
+
         debug_log("done Loop No %zu", global_iterations_counter);
     }
     netdata_mutex_unlock(&apps_and_stdout_mutex);
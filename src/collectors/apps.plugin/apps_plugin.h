@@ -149,6 +149,44 @@ struct pid_info {
 #define OS_FUNCTION(func) OS_FUNC_CONCAT(func, _linux)
 
 extern int max_fds_cache_seconds;
+extern bool enable_proc_events;
+
+struct proc_events_stats {
+    size_t forks;
+    size_t execs;
+    size_t exits;
+    size_t full_scans;
+    size_t overflows;
+};
+extern struct proc_events_stats proc_events_stats;
+bool apps_os_proc_events_active_linux(void);
+
+// the files of /proc/PID read on every iteration, that are kept open
+typedef enum __attribute__((packed)) {
+    PID_PROC_FILE_STAT = 0,
+    PID_PROC_FILE_STATUS,
+    PID_PROC_FILE_IO,
+
+    // terminator
+    PID_PROC_FILE_MAX,
+} PID_PROC_FILE;
+
+#define PROC_FILES_RESERVED_FDS 1024
+#define PROC_FILES_DEFAULT_BUDGET 4096   // the /proc/PID files kept open by default
+extern int max_open_proc_files;
+
+struct proc_syscalls_stats {
+    size_t opens;
+    size_t reads;                   // read(), pread(), readlink() and getdents64() calls
+    size_t closes;
+    size_t pids;                    // the processes collected
+    size_t open_files;              // the /proc/PID files currently kept open
+    size_t open_files_budget;       // the max /proc/PID files we can keep open
+};
+extern struct proc_syscalls_stats proc_syscalls;
+
+struct pid_stat;
+void apps_os_pid_close_proc_files_linux(struct pid_stat *p);
 
 #else
 #error "Unsupported operating system"
@@ -175,6 +213,24 @@ extern bool proc_pid_cmdline_is_needed;
 extern int enable_file_charts;
 extern bool obsolete_file_charts;
 
+#if (PROCESSES_HAVE_FDS == 1) && (INCREMENTAL_DATA_COLLECTION == 1)
+extern int fds_refresh_seconds;
+#endif
+
+// the time spent in each phase of the last iteration
+typedef enum __attribute__((packed)) {
+    APPS_PHASE_EVENTS = 0,          // receiving process events from the kernel
+    APPS_PHASE_PROCESSES,           // reading the processes (except their open files)
+    APPS_PHASE_FILES,               // reading the open files of the processes
+    APPS_PHASE_AGGREGATION,         // aggregating the processes to their targets
+    APPS_PHASE_OUTPUT,              // sending the charts to netdata
+
+    // terminator
+    APPS_PHASE_MAX,
+} APPS_PHASE;
+
+extern usec_t apps_phases_ut[APPS_PHASE_MAX];
+
 extern size_t
     global_iterations_counter,
     calls_counter,
@@ -559,6 +615,9 @@ struct pid_stat {
 
     bool matched_by_config:1;
 
+    bool exited:1;                  // true when the kernel told us it exited (so don't read it)
+    bool exec_seen:1;               // true when the kernel told us it called exec() (so re-read it fully)
+
 #if (PROCESSES_HAVE_STATE == 1)
     char state;
 #endif
@@ -575,8 +634,13 @@ struct pid_stat {
     usec_t io_collected_usec;
     usec_t last_io_collected_usec;
     usec_t last_limits_collected_usec;
+    usec_t last_fds_collected_usec;
 
 #if defined(OS_LINUX)
+    int proc_fds[PID_PROC_FILE_MAX];    // the open /proc/PID files (when their bit is set in proc_fds_open)
+    uint8_t proc_fds_open;
+    kernel_uint_t proc_starttime;       // to detect pid reuse
+
     ARL_BASE *status_arl;
     char *fds_dirname;              // the full directory name in /proc/PID/fd
     char *stat_filename;
@@ -91,6 +91,8 @@ static inline void cgroup_free(struct cgroup *cg) {
     if(cg->st_merged_ops) rrdset_is_obsolete___safe_from_collector_thread(cg->st_merged_ops);
     if(cg->st_pids) rrdset_is_obsolete___safe_from_collector_thread(cg->st_pids);
 
+    cgroup_close_files(cg);
+
     freez(cg->filename_cpuset_cpus);
     freez(cg->filename_cpu_cfs_period);
     freez(cg->filename_cpu_cfs_quota);
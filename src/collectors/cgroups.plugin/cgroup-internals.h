@@ -9,8 +9,15 @@
 #define CGROUP_PROCFILE_FLAG PROCFILE_FLAG_NO_ERROR_ON_FILE_IO
 #endif
 
+// a file of a cgroup that is read on every iteration - it is kept open and re-read with pread()
+typedef struct cgroup_file {
+    int fd;
+    bool open;          // true when fd is valid (the structures are allocated zeroed)
+} CGROUP_FILE;
+
 struct blkio {
     char *filename;
+    CGROUP_FILE file;
     bool staterr;
 
     int updated;
@@ -21,6 +28,7 @@ struct blkio {
 
 struct pids {
     char *filename;
+    CGROUP_FILE file;
     bool staterr;
 
     int updated;
@@ -39,6 +47,11 @@ struct memory {
     char *filename_msw_usage_in_bytes;
     char *filename_failcnt;
 
+    CGROUP_FILE file_usage_in_bytes;
+    CGROUP_FILE file_detailed;
+    CGROUP_FILE file_msw_usage_in_bytes;
+    CGROUP_FILE file_failcnt;
+
     bool staterr_mem_current;
     bool staterr_mem_stat;
     bool staterr_failcnt;
@@ -81,6 +94,7 @@ struct memory {
 // https://www.kernel.org/doc/Documentation/cgroup-v1/cpuacct.txt
 struct cpuacct_stat {
     char *filename;
+    CGROUP_FILE file;
     bool staterr;
 
     int updated;
@@ -92,6 +106,7 @@ struct cpuacct_stat {
 // https://www.kernel.org/doc/Documentation/cgroup-v1/cpuacct.txt
 struct cpuacct_usage {
     char *filename;
+    CGROUP_FILE file;
     bool disabled;
     int updated;
 
@@ -102,6 +117,7 @@ struct cpuacct_usage {
 // represents cpuacct/cpu.stat, for v2 'cpuacct_stat' is used for 'user_usec', 'system_usec'
 struct cpuacct_cpu_throttling {
     char *filename;
+    CGROUP_FILE file;
     bool staterr;
 
     int updated;
@@ -117,6 +133,7 @@ struct cpuacct_cpu_throttling {
 // https://access.redhat.com/documentation/en-us/red_hat_enterprise_linux/8/html/managing_monitoring_and_updating_the_kernel/using-cgroups-v2-to-control-distribution-of-cpu-time-for-applications_managing-monitoring-and-updating-the-kernel#proc_controlling-distribution-of-cpu-time-for-applications-by-adjusting-cpu-weight_using-cgroups-v2-to-control-distribution-of-cpu-time-for-applications
 struct cpuacct_cpu_shares {
     char *filename;
+    CGROUP_FILE file;
     bool staterr;
 
     int updated;
@@ -192,6 +209,11 @@ struct cgroup {
     struct pressure memory_pressure;
     struct pressure irq_pressure;
 
+    CGROUP_FILE cpu_pressure_file;
+    CGROUP_FILE io_pressure_file;
+    CGROUP_FILE memory_pressure_file;
+    CGROUP_FILE irq_pressure_file;
+
     // Cpu
     RRDSET *st_cpu;
     RRDDIM *st_cpu_rd_user;
@@ -313,6 +335,8 @@ extern const char *cgroups_network_interface_script;
 
 extern int cgroups_check;
 
+void cgroup_close_files(struct cgroup *cg);
+
 extern uint32_t Read_hash;
 extern uint32_t Write_hash;
 extern uint32_t user_hash;
@@ -463,22 +463,152 @@ static unsigned long long calc_percentage(unsigned long long value, unsigned lon
     return (unsigned long long)((NETDATA_DOUBLE)value / (NETDATA_DOUBLE)total * 100);
 }
 
+// ----------------------------------------------------------------------------
+// the files of the cgroups are kept open between iterations
+//
+// Reading a file of a removed cgroup fails, so a failed read of a file kept open
+// closes it and tries once more with a freshly opened one (the cgroup may have
+// been re-created with the same path).
+// The number of files kept open is limited; above the limit, the files are opened
+// and closed on every read, like before.
+
+static struct {
+    size_t open;                    // atomic, the number of files currently open
+    size_t budget;                  // the max number of files to keep open
+} cgroup_files = { 0 };
+
+static void cgroup_files_init(void) {
+    // by default, a quarter of the open files limit of the agent
+    size_t budget = 0;
+    struct rlimit rl;
+    if(getrlimit(RLIMIT_NOFILE, &rl) == 0)
+        budget = (rl.rlim_cur == RLIM_INFINITY) ? 65536 : (size_t)(rl.rlim_cur / 4);
+
+    long long n = inicfg_get_number(&netdata_config, "plugin:cgroups", "max open cgroup files", (long long)budget);
+    cgroup_files.budget = (n > 0) ? (size_t)n : 0;
+}
+
+static inline void cgroup_file_close(CGROUP_FILE *f) {
+    if(!f->open)
+        return;
+
+    close(f->fd);
+    f->fd = -1;
+    f->open = false;
+    __atomic_sub_fetch(&cgroup_files.open, 1, __ATOMIC_RELAXED);
+}
+
+void cgroup_close_files(struct cgroup *cg) {
+    cgroup_file_close(&cg->cpuacct_stat.file);
+    cgroup_file_close(&cg->cpuacct_usage.file);
+    cgroup_file_close(&cg->cpuacct_cpu_throttling.file);
+    cgroup_file_close(&cg->cpuacct_cpu_shares.file);
+
+    cgroup_file_close(&cg->memory.file_usage_in_bytes);
+    cgroup_file_close(&cg->memory.file_detailed);
+    cgroup_file_close(&cg->memory.file_msw_usage_in_bytes);
+    cgroup_file_close(&cg->memory.file_failcnt);
+
+    cgroup_file_close(&cg->io_service_bytes.file);
+    cgroup_file_close(&cg->io_serviced.file);
+    cgroup_file_close(&cg->throttle_io_service_bytes.file);
+    cgroup_file_close(&cg->throttle_io_serviced.file);
+    cgroup_file_close(&cg->io_merged.file);
+    cgroup_file_close(&cg->io_queued.file);
+
+    cgroup_file_close(&cg->pids_current.file);
+
+    cgroup_file_close(&cg->cpu_pressure_file);
+    cgroup_file_close(&cg->io_pressure_file);
+    cgroup_file_close(&cg->memory_pressure_file);
+    cgroup_file_close(&cg->irq_pressure_file);
+}
+
+// returns the fd to read filename from - the caller has to close it, when it is not kept in f
+static inline int cgroup_file_fd(CGROUP_FILE *f, const char *filename) {
+    if(likely(f->open))
+        return f->fd;
+
+    int fd = open(filename, procfile_open_flags, 0666);
+    if(unlikely(fd == -1))
+        return -1;
+
+    if(__atomic_add_fetch(&cgroup_files.open, 1, __ATOMIC_RELAXED) <= cgroup_files.budget) {
+        f->fd = fd;
+        f->open = true;
+    }
+    else
+        __atomic_sub_fetch(&cgroup_files.open, 1, __ATOMIC_RELAXED);
+
+    return fd;
+}
+
+static inline void cgroup_file_done(CGROUP_FILE *f, int fd, bool failed) {
+    if(f->open && f->fd == fd) {
+        if(unlikely(failed))
+            cgroup_file_close(f);
+    }
+    else
+        close(fd);
+}
+
+static bool cgroup_file_readall(CGROUP_FILE *f, const char *filename, procfile **ff) {
+    for(int attempt = 0; attempt < 2 ; attempt++) {
+        bool was_open = f->open;
+
+        int fd = cgroup_file_fd(f, filename);
+        if(unlikely(fd == -1))
+            return false;
+
+        bool ok = procfile_readall_fd(ff, fd);
+        cgroup_file_done(f, fd, !ok);
+
+        if(likely(ok || !was_open))
+            return ok;
+    }
+
+    return false;
+}
+
+// like read_single_number_file(), returns 0 on success
+static int cgroup_file_read_single_number(CGROUP_FILE *f, const char *filename, unsigned long long *value) {
+    char buffer[30 + 1];
+
+    for(int attempt = 0; attempt < 2 ; attempt++) {
+        bool was_open = f->open;
+
+        int fd = cgroup_file_fd(f, filename);
+        if(unlikely(fd == -1))
+            break;
+
+        ssize_t r = pread(fd, buffer, sizeof(buffer) - 1, 0);
+        cgroup_file_done(f, fd, r < 0);
+
+        if(likely(r >= 0)) {
+            buffer[r] = '\0';
+            *value = str2ull(buffer, NULL);
+            return 0;
+        }
+
+        if(!was_open)
+            break;
+    }
+
+    *value = 0;
+    return -1;
+}
+
 // ----------------------------------------------------------------------------
 // read values from /sys
 
 static inline void cgroup_read_cpuacct_stat(struct cpuacct_stat *cp) {
-    static procfile *ff = NULL;
+    static __thread procfile *ff = NULL;
 
     if(likely(cp->filename)) {
-        ff = procfile_reopen(ff, cp->filename, NULL, CGROUP_PROCFILE_FLAG);
-        if(unlikely(!ff)) {
-            cp->updated = 0;
-            cgroups_check = 1;
-            return;
-        }
+        if(unlikely(!ff))
+            ff = procfile_create(NULL, CGROUP_PROCFILE_FLAG);
 
-        ff = procfile_readall(ff);
-        if(unlikely(!ff)) {
+        if(unlikely(!cgroup_file_readall(&cp->file, cp->filename, &ff))) {
             cp->updated = 0;
             cgroups_check = 1;
             return;
@@ -512,16 +642,11 @@ static inline void cgroup_read_cpuacct_cpu_stat(struct cpuacct_cpu_throttling *c
         return;
     }
 
-    static procfile *ff = NULL;
-    ff = procfile_reopen(ff, cp->filename, NULL, CGROUP_PROCFILE_FLAG);
-    if (unlikely(!ff)) {
-        cp->updated = 0;
-        cgroups_check = 1;
-        return;
-    }
+    static __thread procfile *ff = NULL;
+    if (unlikely(!ff))
+        ff = procfile_create(NULL, CGROUP_PROCFILE_FLAG);
 
-    ff = procfile_readall(ff);
-    if (unlikely(!ff)) {
+    if (unlikely(!cgroup_file_readall(&cp->file, cp->filename, &ff))) {
         cp->updated = 0;
         cgroups_check = 1;
         return;
@@ -556,20 +681,15 @@ static inline void cgroup_read_cpuacct_cpu_stat(struct cpuacct_cpu_throttling *c
 }
 
 static inline void cgroup2_read_cpuacct_cpu_stat(struct cpuacct_stat *cp, struct cpuacct_cpu_throttling *cpt) {
-    static procfile *ff = NULL;
+    static __thread procfile *ff = NULL;
     if (unlikely(!cp->filename)) {
         return;
     }
 
-    ff = procfile_reopen(ff, cp->filename, NULL, CGROUP_PROCFILE_FLAG);
-    if (unlikely(!ff)) {
-        cp->updated = 0;
-        cgroups_check = 1;
-        return;
-    }
+    if (unlikely(!ff))
+        ff = procfile_create(NULL, CGROUP_PROCFILE_FLAG);
 
-    ff = procfile_readall(ff);
-    if (unlikely(!ff)) {
+    if (unlikely(!cgroup_file_readall(&cp->file, cp->filename, &ff))) {
         cp->updated = 0;
         cgroups_check = 1;
         return;
@@ -614,7 +734,7 @@ static inline void cgroup_read_cpuacct_cpu_shares(struct cpuacct_cpu_shares *cp)
         return;
     }
 
-    if (unlikely(read_single_number_file(cp->filename, &cp->shares))) {
+    if (unlikely(cgroup_file_read_single_number(&cp->file, cp->filename, &cp->shares))) {
         cp->updated = 0;
         cgroups_check = 1;
         return;
@@ -624,18 +744,13 @@ static inline void cgroup_read_cpuacct_cpu_shares(struct cpuacct_cpu_shares *cp)
 }
 
 static inline void cgroup_read_cpuacct_usage(struct cpuacct_usage *ca) {
-    static procfile *ff = NULL;
+    static __thread procfile *ff = NULL;
 
     if(likely(ca->filename)) {
-        ff = procfile_reopen(ff, ca->filename, NULL, CGROUP_PROCFILE_FLAG);
-        if(unlikely(!ff)) {
-            ca->updated = 0;
-            cgroups_check = 1;
-            return;
-        }
+        if(unlikely(!ff))
+            ff = procfile_create(NULL, CGROUP_PROCFILE_FLAG);
 
-        ff = procfile_readall(ff);
-        if(unlikely(!ff)) {
+        if(unlikely(!cgroup_file_readall(&ca->file, ca->filename, &ff))) {
             ca->updated = 0;
             cgroups_check = 1;
             return;
@@ -679,17 +794,12 @@ static inline void cgroup_read_cpuacct_usage(struct cpuacct_usage *ca) {
 
 static inline void cgroup_read_blkio(struct blkio *io) {
     if (likely(io->filename)) {
-        static procfile *ff = NULL;
+        static __thread procfile *ff = NULL;
 
-        ff = procfile_reopen(ff, io->filename, NULL, CGROUP_PROCFILE_FLAG);
-        if (unlikely(!ff)) {
-            io->updated = 0;
-            cgroups_check = 1;
-            return;
-        }
+        if (unlikely(!ff))
+            ff = procfile_create(NULL, CGROUP_PROCFILE_FLAG);
 
-        ff = procfile_readall(ff);
-        if (unlikely(!ff)) {
+        if (unlikely(!cgroup_file_readall(&io->file, io->filename, &ff))) {
             io->updated = 0;
             cgroups_check = 1;
             return;
@@ -722,17 +832,12 @@ static inline void cgroup_read_blkio(struct blkio *io) {
 
 static inline void cgroup2_read_blkio(struct blkio *io, unsigned int word_offset) {
     if (likely(io->filename)) {
-        static procfile *ff = NULL;
+        static __thread procfile *ff = NULL;
 
-        ff = procfile_reopen(ff, io->filename, NULL, CGROUP_PROCFILE_FLAG);
-        if (unlikely(!ff)) {
-            io->updated = 0;
-            cgroups_check = 1;
-            return;
-        }
+        if (unlikely(!ff))
+            ff = procfile_create(NULL, CGROUP_PROCFILE_FLAG);
 
-        ff = procfile_readall(ff);
-        if (unlikely(!ff)) {
+        if (unlikely(!cgroup_file_readall(&io->file, io->filename, &ff))) {
             io->updated = 0;
             cgroups_check = 1;
             return;
@@ -758,19 +863,14 @@ static inline void cgroup2_read_blkio(struct blkio *io, unsigned int word_offset
     }
 }
 
-static inline void cgroup2_read_pressure(struct pressure *res) {
-    static procfile *ff = NULL;
+static inline void cgroup2_read_pressure(struct pressure *res, CGROUP_FILE *file) {
+    static __thread procfile *ff = NULL;
 
     if (likely(res->filename)) {
-        ff = procfile_reopen(ff, res->filename, " =", CGROUP_PROCFILE_FLAG);
-        if (unlikely(!ff)) {
-            res->updated = 0;
-            cgroups_check = 1;
-            return;
-        }
+        if (unlikely(!ff))
+            ff = procfile_create(" =", CGROUP_PROCFILE_FLAG);
 
-        ff = procfile_readall(ff);
-        if (unlikely(!ff)) {
+        if (unlikely(!cgroup_file_readall(file, res->filename, &ff))) {
             res->updated = 0;
             cgroups_check = 1;
             return;
@@ -810,18 +910,13 @@ static inline void cgroup2_read_pressure(struct pressure *res) {
 }
 
 static inline void cgroup_read_memory(struct memory *mem, char parent_cg_is_unified) {
-    static procfile *ff = NULL;
+    static __thread procfile *ff = NULL;
 
     if(likely(mem->filename_detailed)) {
-        ff = procfile_reopen(ff, mem->filename_detailed, NULL, CGROUP_PROCFILE_FLAG);
-        if(unlikely(!ff)) {
-            mem->updated_detailed = 0;
-            cgroups_check = 1;
-            goto memory_next;
-        }
+        if(unlikely(!ff))
+            ff = procfile_create(NULL, CGROUP_PROCFILE_FLAG);
 
-        ff = procfile_readall(ff);
-        if(unlikely(!ff)) {
+        if(unlikely(!cgroup_file_readall(&mem->file_detailed, mem->filename_detailed, &ff))) {
             mem->updated_detailed = 0;
             cgroups_check = 1;
             goto memory_next;
@@ -888,7 +983,7 @@ static inline void cgroup_read_memory(struct memory *mem, char parent_cg_is_unif
 memory_next:
 
     if (likely(mem->filename_usage_in_bytes)) {
-        mem->updated_usage_in_bytes = !read_single_number_file(mem->filename_usage_in_bytes, &mem->usage_in_bytes);
+        mem->updated_usage_in_bytes = !cgroup_file_read_single_number(&mem->file_usage_in_bytes, mem->filename_usage_in_bytes, &mem->usage_in_bytes);
     }
 
     if (likely(mem->updated_usage_in_bytes && mem->updated_detailed)) {
@@ -898,11 +993,11 @@ memory_next:
 
     if (likely(mem->filename_msw_usage_in_bytes)) {
         mem->updated_msw_usage_in_bytes =
-            !read_single_number_file(mem->filename_msw_usage_in_bytes, &mem->msw_usage_in_bytes);
+            !cgroup_file_read_single_number(&mem->file_msw_usage_in_bytes, mem->filename_msw_usage_in_bytes, &mem->msw_usage_in_bytes);
     }
 
     if (likely(mem->filename_failcnt)) {
-        mem->updated_failcnt = !read_single_number_file(mem->filename_failcnt, &mem->failcnt);
+        mem->updated_failcnt = !cgroup_file_read_single_number(&mem->file_failcnt, mem->filename_failcnt, &mem->failcnt);
     }
 }
 
@@ -912,7 +1007,7 @@ static void cgroup_read_pids_current(struct pids *pids) {
     if (unlikely(!pids->filename))
         return;
 
-    pids->updated = !read_single_number_file(pids->filename, &pids->pids_current);
+    pids->updated = !cgroup_file_read_single_number(&pids->file, pids->filename, &pids->pids_current);
 }
 
 static inline void read_cgroup(struct cgroup *cg) {
@@ -935,24 +1030,84 @@ static inline void read_cgroup(struct cgroup *cg) {
         cgroup2_read_blkio(&cg->io_serviced, 4);
         cgroup2_read_cpuacct_cpu_stat(&cg->cpuacct_stat, &cg->cpuacct_cpu_throttling);
         cgroup_read_cpuacct_cpu_shares(&cg->cpuacct_cpu_shares);
-        cgroup2_read_pressure(&cg->cpu_pressure);
-        cgroup2_read_pressure(&cg->io_pressure);
-        cgroup2_read_pressure(&cg->memory_pressure);
-        cgroup2_read_pressure(&cg->irq_pressure);
+        cgroup2_read_pressure(&cg->cpu_pressure, &cg->cpu_pressure_file);
+        cgroup2_read_pressure(&cg->io_pressure, &cg->io_pressure_file);
+        cgroup2_read_pressure(&cg->memory_pressure, &cg->memory_pressure_file);
+        cgroup2_read_pressure(&cg->irq_pressure, &cg->irq_pressure_file);
         cgroup_read_memory(&cg->memory, 1);
         cgroup_read_pids_current(&cg->pids_current);
     }
 }
 
+// ----------------------------------------------------------------------------
+// reading the cgroups in parallel
+//
+// The enabled cgroups are collected in an array and a few reader threads, together
+// with the main thread, pick them in batches from it. Each cgroup is read by exactly
+// one thread, and all its data belong to it, so no locking is needed.
+// The main thread continues when all of them have been read.
+
+#define CGROUPS_READ_BATCH 16
+#define CGROUPS_READ_PARALLEL_MIN (CGROUPS_READ_BATCH * 4)
+#define CGROUPS_READ_MAX_THREADS 16
+
+static struct {
+    ND_THREAD_POOL *pool;           // the reader threads, in addition to the main thread
+
+    struct cgroup **cgroups;        // the cgroups to read in this iteration
+    size_t used;
+    size_t size;
+} cgroup_readers = { 0 };
+
+static void cgroup_reader_read(size_t i, void *data __maybe_unused) {
+    read_cgroup(cgroup_readers.cgroups[i]);
+}
+
+static void cgroup_reader_register_worker(void) {
+    worker_register("CGREAD");
+    worker_register_job_name(WORKER_CGROUPS_READ, "read");
+}
+
+static void cgroup_readers_init(void) {
+    size_t cpus = os_get_system_cpus();
+    size_t threads = MIN(cpus, 4);
+
+    threads = (size_t)inicfg_get_number(&netdata_config, "plugin:cgroups", "read threads", (long long)threads);
+    if(threads < 1) threads = 1;
+    if(threads > CGROUPS_READ_MAX_THREADS) threads = CGROUPS_READ_MAX_THREADS;
+
+    // the main thread is one of them
+    cgroup_readers.pool = nd_thread_pool_create("CGREAD", threads - 1, cgroup_reader_register_worker, WORKER_CGROUPS_READ);
+}
+
+static void cgroup_readers_stop(void) {
+    nd_thread_pool_destroy(cgroup_readers.pool);
+    cgroup_readers.pool = NULL;
+    freez(cgroup_readers.cgroups);
+    cgroup_readers.cgroups = NULL;
+}
+
 static inline void read_all_discovered_cgroups(struct cgroup *root) {
     netdata_log_debug(D_CGROUP, "reading metrics for all cgroups");
 
-    struct cgroup *cg;
-    for (cg = root; cg; cg = cg->next) {
+    cgroup_readers.used = 0;
+    for (struct cgroup *cg = root; cg; cg = cg->next) {
         if (cg->enabled && !cg->pending_renames) {
-            read_cgroup(cg);
+            if(unlikely(cgroup_readers.used == cgroup_readers.size)) {
+                cgroup_readers.size = cgroup_readers.size ? cgroup_readers.size * 2 : 256;
+                cgroup_readers.cgroups = reallocz(cgroup_readers.cgroups, cgroup_readers.size * sizeof(struct cgroup *));
+            }
+            cgroup_readers.cgroups[cgroup_readers.used++] = cg;
         }
     }
+
+    if(!nd_thread_pool_threads(cgroup_readers.pool) || cgroup_readers.used < CGROUPS_READ_PARALLEL_MIN) {
+        for(size_t i = 0; i < cgroup_readers.used ; i++)
+            read_cgroup(cgroup_readers.cgroups[i]);
+        return;
+    }
+
+    nd_thread_pool_run(cgroup_readers.pool, cgroup_readers.used, CGROUPS_READ_BATCH, cgroup_reader_read, NULL);
 }
 
 // update CPU and memory limits
@@ -1319,6 +1474,66 @@ void update_cgroup_charts() {
     }
 }
 
+// ----------------------------------------------------------------------------
+// the cost of each phase of the cgroups main loop
+
+static void update_cgroups_phases_chart(usec_t lock_ut, usec_t read_ut, usec_t chart_ut) {
+    static RRDSET *st_phases = NULL, *st_files = NULL;
+    static RRDDIM *rd_lock = NULL, *rd_read = NULL, *rd_chart = NULL;
+    static RRDDIM *rd_cgroups = NULL, *rd_open = NULL;
+
+    if(!pulse_enabled)
+        return;
+
+    if(unlikely(!st_phases)) {
+        st_phases = rrdset_create_localhost(
+            "netdata",
+            "cgroups_phases",
+            NULL,
+            "cgroups",
+            NULL,
+            "Time spent in each phase of cgroups data collection",
+            "milliseconds/run",
+            PLUGIN_CGROUPS_NAME,
+            "stats",
+            132100,
+            cgroup_update_every,
+            RRDSET_TYPE_STACKED);
+
+        rd_lock = rrddim_add(st_phases, "lock", NULL, 1, USEC_PER_MS, RRD_ALGORITHM_ABSOLUTE);
+        rd_read = rrddim_add(st_phases, "read", NULL, 1, USEC_PER_MS, RRD_ALGORITHM_ABSOLUTE);
+        rd_chart = rrddim_add(st_phases, "chart", NULL, 1, USEC_PER_MS, RRD_ALGORITHM_ABSOLUTE);
+    }
+
+    rrddim_set_by_pointer(st_phases, rd_lock, (collected_number)lock_ut);
+    rrddim_set_by_pointer(st_phases, rd_read, (collected_number)read_ut);
+    rrddim_set_by_pointer(st_phases, rd_chart, (collected_number)chart_ut);
+    rrdset_done(st_phases);
+
+    if(unlikely(!st_files)) {
+        st_files = rrdset_create_localhost(
+            "netdata",
+            "cgroups_files",
+            NULL,
+            "cgroups",
+            NULL,
+            "Cgroups read and cgroup files kept open",
+            "count",
+            PLUGIN_CGROUPS_NAME,
+            "stats",
+            132101,
+            cgroup_update_every,
+            RRDSET_TYPE_LINE);
+
+        rd_cgroups = rrddim_add(st_files, "cgroups", NULL, 1, 1, RRD_ALGORITHM_ABSOLUTE);
+        rd_open = rrddim_add(st_files, "open files", NULL, 1, 1, RRD_ALGORITHM_ABSOLUTE);
+    }
+
+    rrddim_set_by_pointer(st_files, rd_cgroups, (collected_number)cgroup_readers.used);
+    rrddim_set_by_pointer(st_files, rd_open, (collected_number)__atomic_load_n(&cgroup_files.open, __ATOMIC_RELAXED));
+    rrdset_done(st_files);
+}
+
 // ----------------------------------------------------------------------------
 // cgroups main
 
@@ -1330,6 +1545,8 @@ static void cgroup_main_cleanup(void *pptr) {
 
     worker_unregister();
 
+    cgroup_readers_stop();
+
     usec_t max = 2 * USEC_PER_SEC, step = 50000;
 
     if (!__atomic_load_n(&discovery_thread.exited, __ATOMIC_RELAXED)) {
@@ -1378,6 +1595,7 @@ void cgroups_main(void *ptr) {
     }
 
     read_cgroup_plugin_configuration();
+    cgroup_files_init();
 
     cgroup_read_host_total_ram();
 
@@ -1408,6 +1626,8 @@ void cgroups_main(void *ptr) {
         return;
     }
 
+    cgroup_readers_init();
+
     rrd_function_add_inline(localhost, NULL, "containers-vms", 10,
                             RRDFUNCTIONS_PRIORITY_DEFAULT / 2, RRDFUNCTIONS_VERSION_DEFAULT,
                             RRDFUNCTIONS_CGTOP_HELP,
@@ -1441,9 +1661,11 @@ void cgroups_main(void *ptr) {
             cgroups_check = 0;
         }
 
+        usec_t lock_started_ut = now_monotonic_usec();
         worker_is_busy(WORKER_CGROUPS_LOCK);
         netdata_mutex_lock(&cgroup_root_mutex);
 
+        usec_t read_started_ut = now_monotonic_usec();
         worker_is_busy(WORKER_CGROUPS_READ);
         read_all_discovered_cgroups(cgroup_root);
 
@@ -1452,11 +1674,17 @@ void cgroups_main(void *ptr) {
             break;
         }
 
+        usec_t chart_started_ut = now_monotonic_usec();
         worker_is_busy(WORKER_CGROUPS_CHART);
 
         update_cgroup_charts();
         update_cgroup_systemd_services_charts();
 
+        usec_t chart_ended_ut = now_monotonic_usec();
+        update_cgroups_phases_chart(read_started_ut - lock_started_ut,
+                                    chart_started_ut - read_started_ut,
+                                    chart_ended_ut - chart_started_ut);
+
         if (unlikely(!service_running(SERVICE_COLLECTORS))) {
             netdata_mutex_unlock(&cgroup_root_mutex);
            break;
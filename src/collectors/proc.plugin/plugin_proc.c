@@ -11,6 +11,13 @@ static struct proc_module {
     int (*func)(int update_every, usec_t dt);
     void (*cleanup)(void);  // Cleanup function pointer
 
+    int update_every;       // the data collection frequency of the module, a multiple of the plugin's
+    size_t ticks_every;     // update_every in plugin iterations
+    size_t ticks;           // plugin iterations since the module last run
+    usec_t dt;              // time passed since the module last run
+    bool due;               // the module runs in this iteration
+
+    usec_t duration_ut;     // how long the last run of the module took
     RRDDIM *rd;
 
 } proc_modules[] = {
@@ -88,6 +95,117 @@ static struct proc_module {
 
 static ND_THREAD *netdev_thread = NULL;
 
+// ----------------------------------------------------------------------------
+// running the modules
+//
+// The modules are independent of each other, so on every iteration the ones that
+// are due are picked one by one by a few runner threads, together with the main
+// thread, which then waits for all of them to finish.
+// Each module runs on one thread at a time, and a module does not run again before
+// the iteration it runs in has finished, so the modules need no locking.
+// Modules with an "update every" longer than the plugin's run only on the
+// iterations they are due.
+
+#define PROC_MAX_THREADS 8
+
+static ND_THREAD_POOL *proc_runners = NULL;
+
+static bool log_proc_module(BUFFER *wb, void *data) {
+    struct proc_module *pm = data;
+    buffer_sprintf(wb, "proc.plugin[%s]", pm->name);
+    return true;
+}
+
+static void proc_module_run(size_t i, void *data __maybe_unused) {
+    struct proc_module *pm = &proc_modules[i];
+
+    if(!pm->due || !service_running(SERVICE_COLLECTORS))
+        return;
+
+    worker_is_busy(i);
+
+    ND_LOG_STACK lgs[] = {
+            ND_LOG_FIELD_CB(NDF_MODULE, log_proc_module, pm),
+            ND_LOG_FIELD_END(),
+    };
+    ND_LOG_STACK_PUSH(lgs);
+
+    usec_t started_ut = now_monotonic_usec();
+    pm->enabled = !pm->func(pm->update_every, pm->dt);
+    pm->duration_ut = now_monotonic_usec() - started_ut;
+
+    pm->dt = 0;
+    pm->due = false;
+}
+
+static void proc_register_worker(void) {
+    worker_register("PROC");
+
+    for(size_t i = 0; proc_modules[i].name; i++)
+        worker_register_job_name(i, proc_modules[i].dim);
+}
+
+static void proc_runners_init(size_t enabled_modules) {
+    size_t threads = MIN(os_get_system_cpus(), 4);
+    threads = (size_t)inicfg_get_number(&netdata_config, "plugin:proc", "threads", (long long)threads);
+    if(threads < 1) threads = 1;
+    if(threads > PROC_MAX_THREADS) threads = PROC_MAX_THREADS;
+    if(threads > enabled_modules) threads = enabled_modules ? enabled_modules : 1;
+
+    // the main thread is one of them
+    proc_runners = nd_thread_pool_create("PROC", threads - 1, proc_register_worker, WORKER_UTILIZATION_MAX_JOB_TYPES);
+}
+
+static void proc_runners_stop(void) {
+    nd_thread_pool_destroy(proc_runners);
+    proc_runners = NULL;
+}
+
+static void proc_modules_run(void) {
+    // the last one is the terminator
+    nd_thread_pool_run(proc_runners, _countof(proc_modules) - 1, 1, proc_module_run, NULL);
+
+    // the modules left behind when stopping
+    worker_is_idle();
+}
+
+static void proc_modules_durations_chart(void) {
+    static RRDSET *st = NULL;
+
+    if(!pulse_enabled)
+        return;
+
+    if(unlikely(!st)) {
+        st = rrdset_create_localhost(
+            "netdata",
+            "plugin_proc_modules",
+            NULL,
+            "proc",
+            NULL,
+            "Netdata proc plugin modules durations",
+            "milliseconds/run",
+            PLUGIN_PROC_NAME,
+            "stats",
+            132001,
+            localhost->rrd_update_every,
+            RRDSET_TYPE_STACKED);
+    }
+
+    for(size_t i = 0; proc_modules[i].name; i++) {
+        struct proc_module *pm = &proc_modules[i];
+        if(!pm->enabled && !pm->rd)
+            continue;
+
+        if(unlikely(!pm->rd))
+            pm->rd = rrddim_add(st, pm->dim, NULL, 1, USEC_PER_MS, RRD_ALGORITHM_ABSOLUTE);
+
+        // the modules not running on this iteration keep their last duration
+        rrddim_set_by_pointer(st, pm->rd, (collected_number)pm->duration_ut);
+    }
+
+    rrdset_done(st);
+}
+
 static void proc_main_cleanup(void *pptr)
 {
     struct netdata_static_thread *static_thread = CLEANUP_FUNCTION_GET_PTR(pptr);
@@ -95,6 +213,8 @@ static void proc_main_cleanup(void *pptr)
 
     static_thread->enabled = NETDATA_MAIN_THREAD_EXITING;
 
+    proc_runners_stop();
+
     // Run all module cleanup functions
     int i;
     for(i = 0; proc_modules[i].name; i++) {
@@ -201,17 +321,11 @@ static bool is_swap_enabled() {
     return swap_total > 0;
 }
 
-static bool log_proc_module(BUFFER *wb, void *data) {
-    struct proc_module *pm = data;
-    buffer_sprintf(wb, "proc.plugin[%s]", pm->name);
-    return true;
-}
-
 void proc_main(void *ptr)
 {
     CLEANUP_FUNCTION_REGISTER(proc_main_cleanup) cleanup_ptr = ptr;
 
-    worker_register("PROC");
+    proc_register_worker();
 
     rrd_collector_started();
 
@@ -222,17 +336,36 @@ void proc_main(void *ptr)
 
     inicfg_get_boolean(&netdata_config, "plugin:proc", "/proc/pagetypeinfo", CONFIG_BOOLEAN_NO);
 
-    // check the enabled status for each module
-    int i;
-    for(i = 0; proc_modules[i].name; i++) {
+    // check the enabled status and the data collection frequency of each module
+    int update_every = localhost->rrd_update_every;
+    size_t enabled_modules = 0;
+    for(size_t i = 0; proc_modules[i].name; i++) {
         struct proc_module *pm = &proc_modules[i];
 
         pm->enabled = inicfg_get_boolean(&netdata_config, "plugin:proc", pm->name, CONFIG_BOOLEAN_YES);
         pm->rd = NULL;
 
-        worker_register_job_name(i, proc_modules[i].dim);
+        if(!pm->enabled)
+            continue;
+
+        enabled_modules++;
+
+        char section[CONFIG_MAX_NAME + 1];
+        snprintfz(section, CONFIG_MAX_NAME, "plugin:proc:%s", pm->name);
+        time_t every = inicfg_get_duration_seconds(&netdata_config, section, "update every", update_every);
+        if(every < update_every)
+            every = update_every;
+
+        // a multiple of the plugin's update every, so that it runs on the plugin's iterations
+        pm->ticks_every = (every + update_every - 1) / update_every;
+        pm->update_every = (int)pm->ticks_every * update_every;
+
+        // run it on the first iteration
+        pm->ticks = pm->ticks_every - 1;
     }
 
+    proc_runners_init(enabled_modules);
+
     heartbeat_t hb;
     heartbeat_init(&hb, localhost->rrd_update_every * USEC_PER_SEC);
 
@@ -241,10 +374,8 @@ void proc_main(void *ptr)
     is_mem_zswap_enabled = is_zswap_enabled();
     is_mem_ksm_enabled = is_ksm_enabled();
 
-#define LGS_MODULE_ID 0
-
     ND_LOG_STACK lgs[] = {
-            [LGS_MODULE_ID] = ND_LOG_FIELD_TXT(NDF_MODULE, "proc.plugin"),
+            ND_LOG_FIELD_TXT(NDF_MODULE, "proc.plugin"),
             ND_LOG_FIELD_END(),
     };
     ND_LOG_STACK_PUSH(lgs);
@@ -256,19 +387,24 @@ void proc_main(void *ptr)
         if(unlikely(!service_running(SERVICE_COLLECTORS)))
             break;
 
-        for(i = 0; proc_modules[i].name; i++) {
-            if(unlikely(!service_running(SERVICE_COLLECTORS)))
-                break;
-
+        for(size_t i = 0; proc_modules[i].name; i++) {
             struct proc_module *pm = &proc_modules[i];
             if(unlikely(!pm->enabled))
                 continue;
 
-            worker_is_busy(i);
-            lgs[LGS_MODULE_ID] = ND_LOG_FIELD_CB(NDF_MODULE, log_proc_module, pm);
-            pm->enabled = !pm->func(localhost->rrd_update_every, hb_dt);
-            lgs[LGS_MODULE_ID] = ND_LOG_FIELD_TXT(NDF_MODULE, "proc.plugin");
+            pm->dt += hb_dt;
+            if(++pm->ticks >= pm->ticks_every) {
+                pm->ticks = 0;
+                pm->due = true;
+            }
         }
+
+        proc_modules_run();
+
+        if(unlikely(!service_running(SERVICE_COLLECTORS)))
+            break;
+
+        proc_modules_durations_chart();
     }
 }
 
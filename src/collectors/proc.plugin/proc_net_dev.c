@@ -92,6 +92,7 @@ static struct netdev {
     int enabled;
     bool updated;
     bool function_ready;
+    bool collected;         // the counters have been parsed at least once
 
     time_t discover_time;
     
@@ -946,7 +947,7 @@ int do_proc_net_dev(int update_every, usec_t dt) {
     }
 
     if(unlikely(!ff)) {
-        ff = procfile_open(proc_net_dev_filename, " \t,|", PROCFILE_FLAG_DEFAULT);
+        ff = procfile_open(proc_net_dev_filename, " \t,|", PROCFILE_FLAG_LINES_CHANGED);
         if(unlikely(!ff)) return 1;
     }
 
@@ -1081,46 +1082,51 @@ int do_proc_net_dev(int update_every, usec_t dt) {
             continue;
         }
 
-        if(likely(d->do_bandwidth != CONFIG_BOOLEAN_NO || !d->virtual)) {
-            d->rbytes      = str2kernel_uint_t(procfile_lineword(ff, l, 1));
-            d->tbytes      = str2kernel_uint_t(procfile_lineword(ff, l, 9));
+        // idle interfaces have the same line on every read - their counters are already up to date
+        if(unlikely(!d->collected || procfile_line_changed(ff, l))) {
+            d->collected = true;
 
-            if(likely(!d->virtual)) {
-                system_rbytes += d->rbytes;
-                system_tbytes += d->tbytes;
+            if(likely(d->do_bandwidth != CONFIG_BOOLEAN_NO || !d->virtual)) {
+                d->rbytes      = str2kernel_uint_t(procfile_lineword(ff, l, 1));
+                d->tbytes      = str2kernel_uint_t(procfile_lineword(ff, l, 9));
             }
-        }
 
-        if(likely(d->do_packets != CONFIG_BOOLEAN_NO)) {
-            d->rpackets    = str2kernel_uint_t(procfile_lineword(ff, l, 2));
-            d->rmulticast  = str2kernel_uint_t(procfile_lineword(ff, l, 8));
-            d->tpackets    = str2kernel_uint_t(procfile_lineword(ff, l, 10));
-        }
+            if(likely(d->do_packets != CONFIG_BOOLEAN_NO)) {
+                d->rpackets    = str2kernel_uint_t(procfile_lineword(ff, l, 2));
+                d->rmulticast  = str2kernel_uint_t(procfile_lineword(ff, l, 8));
+                d->tpackets    = str2kernel_uint_t(procfile_lineword(ff, l, 10));
+            }
 
-        if(likely(d->do_errors != CONFIG_BOOLEAN_NO)) {
-            d->rerrors     = str2kernel_uint_t(procfile_lineword(ff, l, 3));
-            d->terrors     = str2kernel_uint_t(procfile_lineword(ff, l, 11));
-        }
+            if(likely(d->do_errors != CONFIG_BOOLEAN_NO)) {
+                d->rerrors     = str2kernel_uint_t(procfile_lineword(ff, l, 3));
+                d->terrors     = str2kernel_uint_t(procfile_lineword(ff, l, 11));
+            }
 
-        if(likely(d->do_drops != CONFIG_BOOLEAN_NO)) {
-            d->rdrops      = str2kernel_uint_t(procfile_lineword(ff, l, 4));
-            d->tdrops      = str2kernel_uint_t(procfile_lineword(ff, l, 12));
-        }
+            if(likely(d->do_drops != CONFIG_BOOLEAN_NO)) {
+                d->rdrops      = str2kernel_uint_t(procfile_lineword(ff, l, 4));
+                d->tdrops      = str2kernel_uint_t(procfile_lineword(ff, l, 12));
+            }
 
-        if(likely(d->do_fifo != CONFIG_BOOLEAN_NO)) {
-            d->rfifo       = str2kernel_uint_t(procfile_lineword(ff, l, 5));
-            d->tfifo       = str2kernel_uint_t(procfile_lineword(ff, l, 13));
-        }
+            if(likely(d->do_fifo != CONFIG_BOOLEAN_NO)) {
+                d->rfifo       = str2kernel_uint_t(procfile_lineword(ff, l, 5));
+                d->tfifo       = str2kernel_uint_t(procfile_lineword(ff, l, 13));
+            }
 
-        if(likely(d->do_compressed != CONFIG_BOOLEAN_NO)) {
-            d->rcompressed = str2kernel_uint_t(procfile_lineword(ff, l, 7));
-            d->tcompressed = str2kernel_uint_t(procfile_lineword(ff, l, 16));
+            if(likely(d->do_compressed != CONFIG_BOOLEAN_NO)) {
+                d->rcompressed = str2kernel_uint_t(procfile_lineword(ff, l, 7));
+                d->tcompressed = str2kernel_uint_t(procfile_lineword(ff, l, 16));
+            }
+
+            if(likely(d->do_events != CONFIG_BOOLEAN_NO)) {
+                d->rframe      = str2kernel_uint_t(procfile_lineword(ff, l, 6));
+                d->tcollisions = str2kernel_uint_t(procfile_lineword(ff, l, 14));
+                d->tcarrier    = str2kernel_uint_t(procfile_lineword(ff, l, 15));
+            }
         }
 
-        if(likely(d->do_events != CONFIG_BOOLEAN_NO)) {
-            d->rframe      = str2kernel_uint_t(procfile_lineword(ff, l, 6));
-            d->tcollisions = str2kernel_uint_t(procfile_lineword(ff, l, 14));
-            d->tcarrier    = str2kernel_uint_t(procfile_lineword(ff, l, 15));
+        if(likely(!d->virtual)) {
+            system_rbytes += d->rbytes;
+            system_tbytes += d->tbytes;
         }
 
         if ((d->do_carrier != CONFIG_BOOLEAN_NO ||
@@ -188,11 +188,10 @@ int do_proc_spl_kstat_zfs_arcstats(int update_every, usec_t dt) {
         if(unlikely(arl_check(arl_base, key, value))) break;
     }
 
-    if (arcstats.size > arcstats.c_min) {
-        zfs_arcstats_shrinkable_cache_size_bytes = arcstats.size - arcstats.c_min;
-    } else {
-        zfs_arcstats_shrinkable_cache_size_bytes = 0;
-    }
+    // /proc/meminfo may be collected concurrently by another proc.plugin thread
+    __atomic_store_n(&zfs_arcstats_shrinkable_cache_size_bytes,
+                     arcstats.size > arcstats.c_min ? arcstats.size - arcstats.c_min : 0,
+                     __ATOMIC_RELAXED);
 
     if(unlikely(arcstats.l2exist == -1))
         arcstats.l2exist = 0;
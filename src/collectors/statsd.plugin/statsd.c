@@ -20,9 +20,6 @@
 
 // --------------------------------------------------------------------------------------
 
-// DO NOT ENABLE MULTITHREADING - IT IS NOT WELL TESTED
-// #define STATSD_MULTITHREADED 1
-
 #define STATSD_DICTIONARY_OPTIONS (DICT_OPTION_DONT_OVERWRITE_VALUE | DICT_OPTION_ADD_IN_FRONT)
 #define STATSD_DECIMAL_DETAIL 1000 // floating point values get multiplied by this, with the same divisor
 
@@ -31,6 +28,7 @@
 
 typedef struct statsd_metric_gauge {
     NETDATA_DOUBLE value;
+    bool absolute;                  // shards only: the value has been set (not incremented) since the last merge
 } STATSD_METRIC_GAUGE;
 
 typedef struct statsd_metric_counter { // counter and meter
@@ -60,6 +58,9 @@ typedef struct statsd_histogram_extensions {
     uint32_t size;
     uint32_t used;
     NETDATA_DOUBLE *values;   // dynamic array of values collected
+
+    SPINLOCK sketch_spinlock;
+    DDSKETCH *sketch;         // the sketch of values collected, when STATSD_METRIC_OPTION_HISTOGRAM_SKETCH is set
 } STATSD_METRIC_HISTOGRAM_EXTENSIONS;
 
 typedef struct statsd_metric_histogram { // histogram and timer
@@ -95,6 +96,7 @@ typedef enum __attribute__((packed)) statsd_metric_options {
     STATSD_METRIC_OPTION_USEFUL                       = 0x00000080, // set when the charting thread finds the metric useful (i.e. used in a chart)
     STATSD_METRIC_OPTION_COLLECTION_FULL_LOGGED       = 0x00000100, // set when the collection is full for this metric
     STATSD_METRIC_OPTION_UPDATED_CHART_METADATA       = 0x00000200, // set when the private chart metadata have been updated via tags
+    STATSD_METRIC_OPTION_HISTOGRAM_SKETCH             = 0x00000400, // aggregate this histogram or timer in a sketch, instead of keeping all its values
     STATSD_METRIC_OPTION_OBSOLETE                     = 0x00004000, // set when the metric is obsoleted
 } STATS_METRIC_OPTIONS;
 
@@ -216,10 +218,17 @@ typedef struct statsd_app_chart {
     struct statsd_app_chart *next;
 } STATSD_APP_CHART;
 
+typedef enum __attribute__((packed)) statsd_app_histogram_aggregation {
+    STATSD_APP_HISTOGRAM_AGGREGATION_DEFAULT,   // use the global setting
+    STATSD_APP_HISTOGRAM_AGGREGATION_EXACT,     // keep all values, sort them at flush
+    STATSD_APP_HISTOGRAM_AGGREGATION_SKETCH,    // aggregate values in a DDSketch
+} STATSD_APP_HISTOGRAM_AGGREGATION;
+
 typedef struct statsd_app {
     const char *name;
     SIMPLE_PATTERN *metrics;
     STATS_METRIC_OPTIONS default_options;
+    STATSD_APP_HISTOGRAM_AGGREGATION histogram_aggregation;
     RRD_DB_MODE rrd_memory_mode;
     int32_t rrd_history_entries;
     DICTIONARY *dict;
@@ -230,17 +239,14 @@ typedef struct statsd_app {
 } STATSD_APP;
 
 // --------------------------------------------------------------------------------------------------------------------
-// global statsd data
+// collector threads data
 
-struct collection_thread_status {
-    SPINLOCK spinlock;
-    bool initializing;
-    uint32_t max_sockets;
+// when there are multiple collector threads, each of them collects metrics into
+// its own shard, so that collector threads never share metrics or dictionaries.
+// The flushing thread merges all shards into the main indexes before flushing them.
+typedef struct statsd_shard {
+    SPINLOCK spinlock;              // held by the collector thread while processing, and by the flushing thread while merging
 
-    ND_THREAD *thread;
-};
-
-static struct statsd {
     STATSD_INDEX gauges;
     STATSD_INDEX counters;
     STATSD_INDEX timers;
@@ -248,7 +254,10 @@ static struct statsd {
     STATSD_INDEX meters;
     STATSD_INDEX sets;
     STATSD_INDEX dictionaries;
+} STATSD_SHARD;
 
+// updated only by the collector thread owning them, summed up for the statsd charts
+struct statsd_collector_stats {
     size_t unknown_types;
     size_t socket_errors;
     size_t tcp_socket_connects;
@@ -260,6 +269,35 @@ static struct statsd {
     size_t udp_socket_reads;
     size_t udp_packets_received;
     size_t udp_bytes_read;
+};
+
+struct collection_thread_status {
+    SPINLOCK spinlock;
+    bool initializing;
+    uint32_t max_sockets;
+
+    LISTEN_SOCKETS *sockets;                // the sockets polled by this thread
+    LISTEN_SOCKETS reuse_port_sockets;      // this thread's SO_REUSEPORT clones of the statsd sockets
+    STATSD_SHARD *shard;                    // NULL when there is only one collector thread
+
+    struct statsd_collector_stats stats;
+    uint32_t udp_drops[MAX_LISTEN_FDS];     // the packets the kernel dropped, per socket of this thread
+    RRDDIM *rd_udp_drops[MAX_LISTEN_FDS];   // used by the flushing thread
+
+    ND_THREAD *thread;
+};
+
+// --------------------------------------------------------------------------------------------------------------------
+// global statsd data
+
+static struct statsd {
+    STATSD_INDEX gauges;
+    STATSD_INDEX counters;
+    STATSD_INDEX timers;
+    STATSD_INDEX histograms;
+    STATSD_INDEX meters;
+    STATSD_INDEX sets;
+    STATSD_INDEX dictionaries;
 
     time_t update_every;
     bool enabled;
@@ -278,8 +316,10 @@ static struct statsd {
     uint32_t dictionary_max_unique;
     double histogram_percentile;
     char *histogram_percentile_str;
+    NETDATA_DOUBLE histogram_sketch_accuracy;
 
     int threads;
+    bool threads_reuse_port;
     struct collection_thread_status *collection_threads_status;
 
     LISTEN_SOCKETS sockets;
@@ -351,6 +391,7 @@ static struct statsd {
 
         .apps = NULL,
         .histogram_percentile = 95.0,
+        .histogram_sketch_accuracy = DDSKETCH_DEFAULT_RELATIVE_ACCURACY,
         .histogram_increase_step = 10,
         .dictionary_max_unique = 200,
         .threads = 0,
@@ -364,6 +405,12 @@ static struct statsd {
         },
 };
 
+// the collector thread running, NULL in all other threads
+static __thread struct collection_thread_status *statsd_collector = NULL;
+
+// the index of a metric type, in the shard of the collector thread, or the main one
+#define statsd_index(sh, member) ((sh) ? &(sh)->member : &statsd.member)
+
 
 // --------------------------------------------------------------------------------------------------------------------
 // statsd index management - add/find metrics
@@ -383,6 +430,7 @@ static void dictionary_metric_insert_callback(const DICTIONARY_ITEM *item, void
     if (m->type == STATSD_METRIC_TYPE_HISTOGRAM || m->type == STATSD_METRIC_TYPE_TIMER) {
         m->histogram.ext = callocz(1,sizeof(STATSD_METRIC_HISTOGRAM_EXTENSIONS));
         netdata_mutex_init(&m->histogram.ext->mutex);
+        spinlock_init(&m->histogram.ext->sketch_spinlock);
     }
 
     __atomic_fetch_add(&index->metrics, 1, __ATOMIC_RELAXED);
@@ -394,9 +442,22 @@ static void dictionary_metric_delete_callback(const DICTIONARY_ITEM *item, void
     STATSD_METRIC *m = (STATSD_METRIC *)value;
 
     if(m->type == STATSD_METRIC_TYPE_HISTOGRAM || m->type == STATSD_METRIC_TYPE_TIMER) {
+        if(m->histogram.ext->sketch) {
+            ddsketch_destroy(m->histogram.ext->sketch);
+            freez(m->histogram.ext->sketch);
+        }
+        freez(m->histogram.ext->values);
         freez(m->histogram.ext);
         m->histogram.ext = NULL;
     }
+    else if(m->type == STATSD_METRIC_TYPE_SET && m->set.dict) {
+        dictionary_destroy(m->set.dict);
+        m->set.dict = NULL;
+    }
+    else if(m->type == STATSD_METRIC_TYPE_DICTIONARY && m->dictionary.dict) {
+        dictionary_destroy(m->dictionary.dict);
+        m->dictionary.dict = NULL;
+    }
 
     freez(m->units);
     freez(m->family);
@@ -406,17 +467,12 @@ static void dictionary_metric_delete_callback(const DICTIONARY_ITEM *item, void
 static inline STATSD_METRIC *statsd_find_or_add_metric(STATSD_INDEX *index, const char *name) {
     netdata_log_debug(D_STATSD, "searching for metric '%s' under '%s'", name, index->name);
 
-#ifdef STATSD_MULTITHREADED
-    // avoid the write lock of dictionary_set() for existing metrics
-    STATSD_METRIC *m = dictionary_get(index->dict, name);
-    if(!m) m = dictionary_set(index->dict, name, NULL, sizeof(STATSD_METRIC));
-#else
-    // no locks here, go faster
-    // this will call the dictionary_metric_insert_callback() if an item
+    // each index is written by a single collector thread (the main ones when there is
+    // only one collector thread, or the thread's shard), so no need for dictionary_get() first.
+    // This will call the dictionary_metric_insert_callback() if an item
     // is inserted, otherwise it will return the existing one.
     // We used the flag DICT_OPTION_DONT_OVERWRITE_VALUE to support this.
     STATSD_METRIC *m = dictionary_set(index->dict, name, NULL, sizeof(STATSD_METRIC));
-#endif
 
     index->events++;
     return m;
@@ -505,8 +561,10 @@ static inline void statsd_process_gauge(STATSD_METRIC *m, const char *value, con
     else {
         if (unlikely(*value == '+' || *value == '-'))
             m->gauge.value += statsd_parse_float(value, 1.0) / statsd_parse_sampling_rate(sampling);
-        else
+        else {
             m->gauge.value = statsd_parse_float(value, 1.0);
+            m->gauge.absolute = true;
+        }
 
         metric_update_counters_and_obsoletion(m);
     }
@@ -532,6 +590,16 @@ static inline void statsd_process_counter_or_meter(STATSD_METRIC *m, const char
 #define statsd_process_counter(m, value, sampling) statsd_process_counter_or_meter(m, value, sampling)
 #define statsd_process_meter(m, value, sampling) statsd_process_counter_or_meter(m, value, sampling)
 
+// the caller has to hold the sketch spinlock
+static inline DDSKETCH *statsd_histogram_sketch(STATSD_METRIC_HISTOGRAM_EXTENSIONS *ext) {
+    if(unlikely(!ext->sketch)) {
+        ext->sketch = mallocz(sizeof(DDSKETCH));
+        ddsketch_init(ext->sketch, statsd.histogram_sketch_accuracy, DDSKETCH_DEFAULT_MAX_BUCKETS);
+    }
+
+    return ext->sketch;
+}
+
 static inline void statsd_process_histogram_or_timer(STATSD_METRIC *m, const char *value, const char *sampling, const char *type) {
     if(!is_metric_useful_for_collection(m)) return;
 
@@ -542,6 +610,13 @@ static inline void statsd_process_histogram_or_timer(STATSD_METRIC *m, const cha
 
     if(unlikely(m->reset)) {
         m->histogram.ext->used = 0;
+
+        if(m->histogram.ext->sketch) {
+            spinlock_lock(&m->histogram.ext->sketch_spinlock);
+            ddsketch_reset(m->histogram.ext->sketch);
+            spinlock_unlock(&m->histogram.ext->sketch_spinlock);
+        }
+
         statsd_reset_metric(m);
     }
 
@@ -555,7 +630,14 @@ static inline void statsd_process_histogram_or_timer(STATSD_METRIC *m, const cha
         if(unlikely(isgreater(sampling_rate, 1.0))) sampling_rate = 1.0;
 
         long long samples = llrintndd(1.0 / sampling_rate);
-        while(samples-- > 0) {
+
+        if(m->options & STATSD_METRIC_OPTION_HISTOGRAM_SKETCH) {
+            // constant time and bounded memory, regardless of the number of samples
+            spinlock_lock(&m->histogram.ext->sketch_spinlock);
+            ddsketch_add(statsd_histogram_sketch(m->histogram.ext), v, (uint64_t)samples);
+            spinlock_unlock(&m->histogram.ext->sketch_spinlock);
+        }
+        else while(samples-- > 0) {
 
             if(unlikely(m->histogram.ext->used == m->histogram.ext->size)) {
                 netdata_mutex_lock(&m->histogram.ext->mutex);
@@ -597,13 +679,7 @@ static inline void statsd_process_set(STATSD_METRIC *m, const char *value) {
         // magic loading of metric, without affecting anything
     }
     else {
-#ifdef STATSD_MULTITHREADED
-        // avoid the write lock to check if something is already there
-        if(!dictionary_get(m->set.dict, value))
-            dictionary_set(m->set.dict, value, NULL, 0);
-#else
         dictionary_set(m->set.dict, value, NULL, 0);
-#endif
         metric_update_counters_and_obsoletion(m);
     }
 }
@@ -677,7 +753,7 @@ static inline const char *statsd_parse_field_trim(const char *start, char *end)
     return start;
 }
 
-static void statsd_process_metric(const char *name, const char *value, const char *type, const char *sampling, const char *tags) {
+static void statsd_process_metric(STATSD_SHARD *sh, const char *name, const char *value, const char *type, const char *sampling, const char *tags) {
     netdata_log_debug(D_STATSD, "STATSD: raw metric '%s', value '%s', type '%s', sampling '%s', tags '%s'", name?name:"(null)", value?value:"(null)", type?type:"(null)", sampling?sampling:"(null)", tags?tags:"(null)");
 
     if(unlikely(!name || !*name)) return;
@@ -688,43 +764,43 @@ static void statsd_process_metric(const char *name, const char *value, const cha
     char t0 = type[0], t1 = type[1];
     if(unlikely(t0 == 'g' && t1 == '\0')) {
         statsd_process_gauge(
-            m = statsd_find_or_add_metric(&statsd.gauges, name),
+            m = statsd_find_or_add_metric(statsd_index(sh, gauges), name),
             value, sampling);
     }
     else if(unlikely((t0 == 'c' || t0 == 'C') && t1 == '\0')) {
         // etsy/statsd uses 'c'
         // brubeck     uses 'C'
         statsd_process_counter(
-            m = statsd_find_or_add_metric(&statsd.counters, name),
+            m = statsd_find_or_add_metric(statsd_index(sh, counters), name),
             value, sampling);
     }
     else if(unlikely(t0 == 'm' && t1 == '\0')) {
         statsd_process_meter(
-            m = statsd_find_or_add_metric(&statsd.meters, name),
+            m = statsd_find_or_add_metric(statsd_index(sh, meters), name),
             value, sampling);
     }
     else if(unlikely(t0 == 'h' && t1 == '\0')) {
         statsd_process_histogram(
-            m = statsd_find_or_add_metric(&statsd.histograms, name),
+            m = statsd_find_or_add_metric(statsd_index(sh, histograms), name),
             value, sampling);
     }
     else if(unlikely(t0 == 's' && t1 == '\0')) {
         statsd_process_set(
-            m = statsd_find_or_add_metric(&statsd.sets, name),
+            m = statsd_find_or_add_metric(statsd_index(sh, sets), name),
             value);
     }
     else if(unlikely(t0 == 'd' && t1 == '\0')) {
         statsd_process_dictionary(
-            m = statsd_find_or_add_metric(&statsd.dictionaries, name),
+            m = statsd_find_or_add_metric(statsd_index(sh, dictionaries), name),
             value);
     }
     else if(unlikely(t0 == 'm' && t1 == 's' && type[2] == '\0')) {
         statsd_process_timer(
-            m = statsd_find_or_add_metric(&statsd.timers, name),
+            m = statsd_find_or_add_metric(statsd_index(sh, timers), name),
             value, sampling);
     }
     else {
-        statsd.unknown_types++;
+        statsd_collector->stats.unknown_types++;
         netdata_log_error("STATSD: metric '%s' with value '%s' is sent with unknown metric type '%s'", name, value?value:"", type);
     }
 
@@ -771,7 +847,7 @@ static void statsd_process_metric(const char *name, const char *value, const cha
     }
 }
 
-static inline size_t statsd_process(char *buffer, size_t size, int require_newlines) {
+static inline size_t statsd_process_lines(STATSD_SHARD *sh, char *buffer, size_t size, int require_newlines) {
     buffer[size] = '\0';
     netdata_log_debug(D_STATSD, "RECEIVED: %zu bytes: '%s'", size, buffer);
 
@@ -825,7 +901,8 @@ static inline size_t statsd_process(char *buffer, size_t size, int require_newli
             s = statsd_parse_skip_spaces(s);
 
         statsd_process_metric(
-                  statsd_parse_field_trim(name, name_end)
+                  sh
+                , statsd_parse_field_trim(name, name_end)
                 , statsd_parse_field_trim(value, value_end)
                 , statsd_parse_field_trim(type, type_end)
                 , statsd_parse_field_trim(sampling, sampling_end)
@@ -836,6 +913,20 @@ static inline size_t statsd_process(char *buffer, size_t size, int require_newli
     return 0;
 }
 
+static inline size_t statsd_process(char *buffer, size_t size, int require_newlines) {
+    STATSD_SHARD *sh = statsd_collector->shard;
+
+    if(sh)
+        spinlock_lock(&sh->spinlock);
+
+    size = statsd_process_lines(sh, buffer, size, require_newlines);
+
+    if(sh)
+        spinlock_unlock(&sh->spinlock);
+
+    return size;
+}
+
 
 // --------------------------------------------------------------------------------------------------------------------
 // statsd pollfd interface
@@ -863,12 +954,40 @@ struct statsd_udp {
     size_t size;
     struct iovec *iovecs;
     struct mmsghdr *msgs;
+#ifdef SO_RXQ_OVFL
+    char *controls;             // ancillary data of each message, for the kernel drops counter
+#endif
 #else
     int *running;
     char buffer[STATSD_UDP_BUFFER_SIZE];
 #endif
 };
 
+#if defined(HAVE_RECVMMSG) && defined(SO_RXQ_OVFL)
+#define STATSD_UDP_CONTROL_SIZE CMSG_SPACE(sizeof(uint32_t))
+
+// the kernel attaches to received messages the number of packets
+// it has dropped on this socket, because its receive buffer was full
+static void statsd_udp_drops_update(int fd, struct msghdr *msg) {
+    struct cmsghdr *cmsg;
+    for(cmsg = CMSG_FIRSTHDR(msg); cmsg ; cmsg = CMSG_NXTHDR(msg, cmsg)) {
+        if(cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SO_RXQ_OVFL)
+            continue;
+
+        uint32_t drops;
+        memcpy(&drops, CMSG_DATA(cmsg), sizeof(drops));
+
+        LISTEN_SOCKETS *sockets = statsd_collector->sockets;
+        for(size_t i = 0; i < sockets->opened ;i++) {
+            if(sockets->fds[i] == fd) {
+                __atomic_store_n(&statsd_collector->udp_drops[i], drops, __ATOMIC_RELAXED);
+                break;
+            }
+        }
+    }
+}
+#endif
+
 // new TCP client connected
 static void *statsd_add_callback(POLLINFO *pi, nd_poll_event_t *events, void *data) {
     (void)pi;
@@ -880,8 +999,8 @@ static void *statsd_add_callback(POLLINFO *pi, nd_poll_event_t *events, void *da
     struct statsd_tcp *t = (struct statsd_tcp *)callocz(sizeof(struct statsd_tcp) + STATSD_TCP_BUFFER_SIZE, 1);
     t->type = STATSD_SOCKET_DATA_TYPE_TCP;
     t->size = STATSD_TCP_BUFFER_SIZE - 1;
-    statsd.tcp_socket_connects++;
-    statsd.tcp_socket_connected++;
+    statsd_collector->stats.tcp_socket_connects++;
+    statsd_collector->stats.tcp_socket_connected++;
 
     worker_is_idle();
     return t;
@@ -896,12 +1015,12 @@ static void statsd_del_callback(POLLINFO *pi) {
     if(likely(t)) {
         if(t->type == STATSD_SOCKET_DATA_TYPE_TCP) {
             if(t->len != 0) {
-                statsd.socket_errors++;
+                statsd_collector->stats.socket_errors++;
                 netdata_log_error("STATSD: client is probably sending unterminated metrics. Closed socket left with '%s'. Trying to process it.", t->buffer);
                 statsd_process(t->buffer, t->len, 0);
             }
-            statsd.tcp_socket_disconnects++;
-            statsd.tcp_socket_connected--;
+            statsd_collector->stats.tcp_socket_disconnects++;
+            statsd_collector->stats.tcp_socket_connected--;
         }
         else
             netdata_log_error("STATSD: internal error: received socket data type is %d, but expected %d", (int)t->type, (int)STATSD_SOCKET_DATA_TYPE_TCP);
@@ -926,7 +1045,7 @@ static int statsd_rcv_callback(POLLINFO *pi, nd_poll_event_t *events) {
             struct statsd_tcp *d = (struct statsd_tcp *)pi->data;
             if(unlikely(!d)) {
                 netdata_log_error("STATSD: internal error: expected TCP data pointer is NULL");
-                statsd.socket_errors++;
+                statsd_collector->stats.socket_errors++;
                 retval = -1;
                 goto cleanup;
             }
@@ -934,7 +1053,7 @@ static int statsd_rcv_callback(POLLINFO *pi, nd_poll_event_t *events) {
 #ifdef NETDATA_INTERNAL_CHECKS
             if(unlikely(d->type != STATSD_SOCKET_DATA_TYPE_TCP)) {
                 netdata_log_error("STATSD: internal error: socket data type should be %d, but it is %d", (int)STATSD_SOCKET_DATA_TYPE_TCP, (int)d->type);
-                statsd.socket_errors++;
+                statsd_collector->stats.socket_errors++;
                 retval = -1;
                 goto cleanup;
             }
@@ -948,7 +1067,7 @@ static int statsd_rcv_callback(POLLINFO *pi, nd_poll_event_t *events) {
                     // read failed
                     if (errno != EWOULDBLOCK && errno != EAGAIN && errno != EINTR) {
                         netdata_log_error("STATSD: recv() on TCP socket %d failed.", fd);
-                        statsd.socket_errors++;
+                        statsd_collector->stats.socket_errors++;
                         ret = -1;
                     }
                 }
@@ -960,14 +1079,14 @@ static int statsd_rcv_callback(POLLINFO *pi, nd_poll_event_t *events) {
                 else {
                     // data received
                     d->len += rc;
-                    statsd.tcp_socket_reads++;
-                    statsd.tcp_bytes_read += rc;
+                    statsd_collector->stats.tcp_socket_reads++;
+                    statsd_collector->stats.tcp_bytes_read += rc;
 
                     pulse_statsd_received_bytes(rc);
                 }
 
                 if(likely(d->len > 0)) {
-                    statsd.tcp_packets_received++;
+                    statsd_collector->stats.tcp_packets_received++;
                     d->len = statsd_process(d->buffer, d->len, 1);
                 }
 
@@ -984,7 +1103,7 @@ static int statsd_rcv_callback(POLLINFO *pi, nd_poll_event_t *events) {
             struct statsd_udp *d = (struct statsd_udp *)pi->data;
             if(unlikely(!d)) {
                 netdata_log_error("STATSD: internal error: expected UDP data pointer is NULL");
-                statsd.socket_errors++;
+                statsd_collector->stats.socket_errors++;
                 retval = -1;
                 goto cleanup;
             }
@@ -992,7 +1111,7 @@ static int statsd_rcv_callback(POLLINFO *pi, nd_poll_event_t *events) {
 #ifdef NETDATA_INTERNAL_CHECKS
             if(unlikely(d->type != STATSD_SOCKET_DATA_TYPE_UDP)) {
                 netdata_log_error("STATSD: internal error: socket data should be %d, but it is %d", (int)d->type, (int)STATSD_SOCKET_DATA_TYPE_UDP);
-                statsd.socket_errors++;
+                statsd_collector->stats.socket_errors++;
                 retval = -1;
                 goto cleanup;
             }
@@ -1001,28 +1120,38 @@ static int statsd_rcv_callback(POLLINFO *pi, nd_poll_event_t *events) {
 #ifdef HAVE_RECVMMSG
             ssize_t rc;
             do {
+#ifdef SO_RXQ_OVFL
+                for (size_t i = 0; i < d->size; i++)
+                    d->msgs[i].msg_hdr.msg_controllen = STATSD_UDP_CONTROL_SIZE;
+#endif
+
                 rc = recvmmsg(fd, d->msgs, (unsigned int)d->size, MSG_DONTWAIT, NULL);
                 if (rc < 0) {
                     // read failed
                     if (errno != EWOULDBLOCK && errno != EAGAIN && errno != EINTR) {
                         netdata_log_error("STATSD: recvmmsg() on UDP socket %d failed.", fd);
-                        statsd.socket_errors++;
+                        statsd_collector->stats.socket_errors++;
                         retval = -1;
                         goto cleanup;
                     }
                 } else if (rc) {
                     // data received
-                    statsd.udp_socket_reads++;
-                    statsd.udp_packets_received += rc;
+                    statsd_collector->stats.udp_socket_reads++;
+                    statsd_collector->stats.udp_packets_received += rc;
 
                     size_t i, total_size = 0;
                     for (i = 0; i < (size_t)rc; ++i) {
                         size_t len = (size_t)d->msgs[i].msg_len;
-                        statsd.udp_bytes_read += len;
+                        statsd_collector->stats.udp_bytes_read += len;
                         total_size += len;
                         statsd_process(d->msgs[i].msg_hdr.msg_iov->iov_base, len, 0);
                     }
 
+#ifdef SO_RXQ_OVFL
+                    // the counter is cumulative, the last message has the latest
+                    statsd_udp_drops_update(fd, &d->msgs[rc - 1].msg_hdr);
+#endif
+
                     pulse_statsd_received_bytes(total_size);
                 }
             } while (rc != -1);
@@ -1035,15 +1164,15 @@ static int statsd_rcv_callback(POLLINFO *pi, nd_poll_event_t *events) {
                     // read failed
                     if (errno != EWOULDBLOCK && errno != EAGAIN && errno != EINTR) {
                         netdata_log_error("STATSD: recv() on UDP socket %d failed.", fd);
-                        statsd.socket_errors++;
+                        statsd_collector->stats.socket_errors++;
                         retval = -1;
                         goto cleanup;
                     }
                 } else if (rc) {
                     // data received
-                    statsd.udp_socket_reads++;
-                    statsd.udp_packets_received++;
-                    statsd.udp_bytes_read += rc;
+                    statsd_collector->stats.udp_socket_reads++;
+                    statsd_collector->stats.udp_packets_received++;
+                    statsd_collector->stats.udp_bytes_read += rc;
                     statsd_process(d->buffer, (size_t) rc, 0);
 
                     pulse_statsd_received_bytes(rc);
@@ -1056,7 +1185,7 @@ static int statsd_rcv_callback(POLLINFO *pi, nd_poll_event_t *events) {
 
         default: {
             netdata_log_error("STATSD: internal error: unknown socktype %d on socket %d", pi->socktype, fd);
-            statsd.socket_errors++;
+            statsd_collector->stats.socket_errors++;
             retval = -1;
             goto cleanup;
         }
@@ -1090,9 +1219,13 @@ void statsd_collector_thread_cleanup(void *pptr) {
 
     freez(d->iovecs);
     freez(d->msgs);
+#ifdef SO_RXQ_OVFL
+    freez(d->controls);
+#endif
 #endif
 
     freez(d);
+    statsd_collector = NULL;
     worker_unregister();
 }
 
@@ -1106,6 +1239,8 @@ void statsd_collector_thread(void *ptr) {
     status->initializing = false;
     spinlock_unlock(&status->spinlock);
 
+    statsd_collector = status;
+
     worker_register("STATSD");
     worker_register_job_name(WORKER_JOB_TYPE_TCP_CONNECTED, "tcp connect");
     worker_register_job_name(WORKER_JOB_TYPE_TCP_DISCONNECTED, "tcp disconnect");
@@ -1124,6 +1259,9 @@ void statsd_collector_thread(void *ptr) {
     d->size = statsd.recvmmsg_size;
     d->iovecs = callocz(sizeof(struct iovec), d->size);
     d->msgs = callocz(sizeof(struct mmsghdr), d->size);
+#ifdef SO_RXQ_OVFL
+    d->controls = callocz(STATSD_UDP_CONTROL_SIZE, d->size);
+#endif
 
     size_t i;
     for (i = 0; i < d->size; i++) {
@@ -1131,10 +1269,13 @@ void statsd_collector_thread(void *ptr) {
         d->iovecs[i].iov_len = STATSD_UDP_BUFFER_SIZE - 1;
         d->msgs[i].msg_hdr.msg_iov = &d->iovecs[i];
         d->msgs[i].msg_hdr.msg_iovlen = 1;
+#ifdef SO_RXQ_OVFL
+        d->msgs[i].msg_hdr.msg_control = &d->controls[i * STATSD_UDP_CONTROL_SIZE];
+#endif
     }
 #endif
 
-    poll_events(&statsd.sockets
+    poll_events(status->sockets
             , statsd_add_callback
             , statsd_del_callback
             , statsd_rcv_callback
@@ -1408,6 +1549,14 @@ static int statsd_readfile(const char *filename, STATSD_APP *app, STATSD_APP_CHA
                 if (!strcmp(value, "yes") || !strcmp(value, "on"))
                     app->default_options |= STATSD_METRIC_OPTION_SHOW_GAPS_WHEN_NOT_COLLECTED;
             }
+            else if (!strcmp(name, "histograms aggregation")) {
+                if (!strcmp(value, "sketch"))
+                    app->histogram_aggregation = STATSD_APP_HISTOGRAM_AGGREGATION_SKETCH;
+                else if (!strcmp(value, "exact"))
+                    app->histogram_aggregation = STATSD_APP_HISTOGRAM_AGGREGATION_EXACT;
+                else
+                    netdata_log_error("STATSD: invalid histograms aggregation '%s' at line %zu of file '%s'. Use 'exact' or 'sketch'.", value, line, filename);
+            }
             else if (!strcmp(name, "memory mode")) {
                 // this is not supported anymore
                 // with the implementation of storage engines, all charts have the same storage engine always
@@ -1965,11 +2114,46 @@ static inline void statsd_flush_dictionary(STATSD_METRIC *m) {
     metric_check_obsoletion(m);
 }
 
+static inline void statsd_flush_timer_or_histogram_sketch(STATSD_METRIC *m) {
+    STATSD_METRIC_HISTOGRAM_EXTENSIONS *ext = m->histogram.ext;
+
+    spinlock_lock(&ext->sketch_spinlock);
+
+    if(unlikely(ext->used)) {
+        // values collected before the metric switched to the sketch
+        netdata_mutex_lock(&ext->mutex);
+        for(uint32_t i = 0; i < ext->used; i++)
+            ddsketch_add(ext->sketch, ext->values[i], 1);
+        netdata_mutex_unlock(&ext->mutex);
+    }
+
+    DDSKETCH *sk = ext->sketch;
+    ext->last_min = (collected_number)roundndd(ddsketch_min(sk) * statsd.decimal_detail);
+    ext->last_max = (collected_number)roundndd(ddsketch_max(sk) * statsd.decimal_detail);
+    m->last = (collected_number)roundndd(ddsketch_average(sk) * statsd.decimal_detail);
+    ext->last_stddev = (collected_number)roundndd(ddsketch_stddev(sk) * statsd.decimal_detail);
+    ext->last_sum = (collected_number)roundndd(ddsketch_sum(sk) * statsd.decimal_detail);
+    ext->last_median = (collected_number)roundndd(ddsketch_quantile(sk, 0.5) * statsd.decimal_detail);
+    ext->last_percentile = (collected_number)roundndd(ddsketch_quantile(sk, statsd.histogram_percentile / 100) * statsd.decimal_detail);
+
+    spinlock_unlock(&ext->sketch_spinlock);
+}
+
 static inline void statsd_flush_timer_or_histogram(STATSD_METRIC *m, const char *dim, const char *family, const char *units) {
     netdata_log_debug(D_STATSD, "flushing %s metric '%s'", dim, m->name);
 
     int updated = 0;
-    if(unlikely(!m->reset && m->count && m->histogram.ext->used > 0)) {
+    if(unlikely(!m->reset && m->count && m->histogram.ext->sketch && ddsketch_count(m->histogram.ext->sketch))) {
+        statsd_flush_timer_or_histogram_sketch(m);
+
+        netdata_log_debug(D_STATSD, "STATSD %s metric %s (sketch): min " COLLECTED_NUMBER_FORMAT ", max " COLLECTED_NUMBER_FORMAT ", last " COLLECTED_NUMBER_FORMAT ", pcent " COLLECTED_NUMBER_FORMAT ", median " COLLECTED_NUMBER_FORMAT ", stddev " COLLECTED_NUMBER_FORMAT ", sum " COLLECTED_NUMBER_FORMAT,
+              dim, m->name, m->histogram.ext->last_min, m->histogram.ext->last_max, m->last, m->histogram.ext->last_percentile, m->histogram.ext->last_median, m->histogram.ext->last_stddev, m->histogram.ext->last_sum);
+
+        m->histogram.ext->zeroed = 0;
+        m->reset = 1;
+        updated = 1;
+    }
+    else if(unlikely(!m->reset && m->count && m->histogram.ext->used > 0)) {
         netdata_mutex_lock(&m->histogram.ext->mutex);
 
         size_t len = m->histogram.ext->used;
@@ -2125,6 +2309,13 @@ static inline void check_if_metric_is_for_app(STATSD_INDEX *index, STATSD_METRIC
             else
                 m->options &= ~STATSD_METRIC_OPTION_SHOW_GAPS_WHEN_NOT_COLLECTED;
 
+            if(m->type == STATSD_METRIC_TYPE_HISTOGRAM || m->type == STATSD_METRIC_TYPE_TIMER) {
+                if(app->histogram_aggregation == STATSD_APP_HISTOGRAM_AGGREGATION_SKETCH)
+                    m->options |= STATSD_METRIC_OPTION_HISTOGRAM_SKETCH;
+                else if(app->histogram_aggregation == STATSD_APP_HISTOGRAM_AGGREGATION_EXACT)
+                    m->options &= ~STATSD_METRIC_OPTION_HISTOGRAM_SKETCH;
+            }
+
             m->options |= STATSD_METRIC_OPTION_PRIVATE_CHART_CHECKED;
 
             // check if there is a chart in this app, willing to get this metric
@@ -2380,11 +2571,324 @@ static inline void statsd_flush_index_metrics(STATSD_INDEX *index, void (*flush_
 }
 
 
+// --------------------------------------------------------------------------------------------------------------------
+// statsd shards - one per collector thread, when there are multiple collector threads
+
+// shard metrics not collected for this long are removed from the shard
+#define STATSD_SHARD_METRIC_EXPIRE_SECONDS 600
+
+// the options the flushing thread decides, copied to the shard metrics
+#define STATSD_SHARD_METRIC_SYNCED_OPTIONS (STATSD_METRIC_OPTION_CHECKED | STATSD_METRIC_OPTION_USEFUL | STATSD_METRIC_OPTION_HISTOGRAM_SKETCH)
+
+static void statsd_shard_index_init(STATSD_INDEX *shard_index, STATSD_INDEX *index) {
+    shard_index->name = index->name;
+    shard_index->type = index->type;
+    shard_index->default_options = index->default_options;
+
+    // the shard spinlock serializes all accesses to the shard dictionaries
+    shard_index->dict = dictionary_create_advanced(STATSD_DICTIONARY_OPTIONS | DICT_OPTION_FIXED_SIZE | DICT_OPTION_SINGLE_THREADED, &dictionary_stats_category_collectors, sizeof(STATSD_METRIC));
+    dictionary_register_insert_callback(shard_index->dict, dictionary_metric_insert_callback, shard_index);
+    dictionary_register_delete_callback(shard_index->dict, dictionary_metric_delete_callback, shard_index);
+}
+
+static STATSD_SHARD *statsd_shard_create(void) {
+    STATSD_SHARD *sh = callocz(1, sizeof(STATSD_SHARD));
+    spinlock_init(&sh->spinlock);
+
+    statsd_shard_index_init(&sh->gauges, &statsd.gauges);
+    statsd_shard_index_init(&sh->counters, &statsd.counters);
+    statsd_shard_index_init(&sh->timers, &statsd.timers);
+    statsd_shard_index_init(&sh->histograms, &statsd.histograms);
+    statsd_shard_index_init(&sh->meters, &statsd.meters);
+    statsd_shard_index_init(&sh->sets, &statsd.sets);
+    statsd_shard_index_init(&sh->dictionaries, &statsd.dictionaries);
+
+    return sh;
+}
+
+static void statsd_shard_destroy(STATSD_SHARD *sh) {
+    if(!sh) return;
+
+    dictionary_destroy(sh->gauges.dict);
+    dictionary_destroy(sh->counters.dict);
+    dictionary_destroy(sh->timers.dict);
+    dictionary_destroy(sh->histograms.dict);
+    dictionary_destroy(sh->meters.dict);
+    dictionary_destroy(sh->sets.dict);
+    dictionary_destroy(sh->dictionaries.dict);
+
+    freez(sh);
+}
+
+static inline void statsd_shard_metric_copy_tag(char **dst, const char *src) {
+    if(!src || (*dst && strcmp(*dst, src) == 0))
+        return;
+
+    freez(*dst);
+    *dst = strdupz(src);
+}
+
+static inline void statsd_shard_merge_histogram_or_timer(STATSD_METRIC *m, STATSD_METRIC *s) {
+    STATSD_METRIC_HISTOGRAM_EXTENSIONS *mx = m->histogram.ext, *sx = s->histogram.ext;
+
+    if(sx->sketch && ddsketch_count(sx->sketch)) {
+        spinlock_lock(&mx->sketch_spinlock);
+        ddsketch_merge(statsd_histogram_sketch(mx), sx->sketch);
+        spinlock_unlock(&mx->sketch_spinlock);
+        ddsketch_reset(sx->sketch);
+    }
+
+    if(!sx->used)
+        return;
+
+    if(m->options & STATSD_METRIC_OPTION_HISTOGRAM_SKETCH) {
+        spinlock_lock(&mx->sketch_spinlock);
+        DDSKETCH *sk = statsd_histogram_sketch(mx);
+        for(uint32_t i = 0; i < sx->used; i++)
+            ddsketch_add(sk, sx->values[i], 1);
+        spinlock_unlock(&mx->sketch_spinlock);
+    }
+    else {
+        netdata_mutex_lock(&mx->mutex);
+        if(unlikely(mx->used + sx->used > mx->size)) {
+            mx->size = mx->used + sx->used + statsd.histogram_increase_step;
+            mx->values = reallocz(mx->values, sizeof(NETDATA_DOUBLE) * mx->size);
+        }
+        memcpy(&mx->values[mx->used], sx->values, sizeof(NETDATA_DOUBLE) * sx->used);
+        mx->used += sx->used;
+        netdata_mutex_unlock(&mx->mutex);
+    }
+
+    sx->used = 0;
+}
+
+static inline void statsd_shard_merge_dictionary(STATSD_METRIC *m, STATSD_METRIC *s) {
+    if(unlikely(!s->dictionary.dict))
+        return;
+
+    if (unlikely(!m->dictionary.dict))
+        m->dictionary.dict = dictionary_create_advanced(STATSD_DICTIONARY_OPTIONS | DICT_OPTION_FIXED_SIZE, &dictionary_stats_category_collectors, sizeof(STATSD_METRIC_DICTIONARY_ITEM));
+
+    STATSD_METRIC_DICTIONARY_ITEM *st;
+    dfe_start_read(s->dictionary.dict, st) {
+        const char *value = st_dfe.name;
+        STATSD_METRIC_DICTIONARY_ITEM *t = (STATSD_METRIC_DICTIONARY_ITEM *)dictionary_get(m->dictionary.dict, value);
+
+        if (unlikely(!t)) {
+            if(dictionary_entries(m->dictionary.dict) >= statsd.dictionary_max_unique)
+                value = "other";
+
+            t = (STATSD_METRIC_DICTIONARY_ITEM *)dictionary_set(m->dictionary.dict, value, NULL, sizeof(STATSD_METRIC_DICTIONARY_ITEM));
+        }
+
+        t->count += st->count;
+    }
+    dfe_done(st);
+
+    dictionary_flush(s->dictionary.dict);
+}
+
+static inline void statsd_shard_merge_set(STATSD_METRIC *m, STATSD_METRIC *s) {
+    if(unlikely(!s->set.dict))
+        return;
+
+    if (unlikely(!m->set.dict))
+        m->set.dict = dictionary_create_advanced(STATSD_DICTIONARY_OPTIONS, &dictionary_stats_category_collectors, 0);
+
+    void *t;
+    dfe_start_read(s->set.dict, t) {
+        dictionary_set(m->set.dict, t_dfe.name, NULL, 0);
+    }
+    dfe_done(t);
+
+    dictionary_flush(s->set.dict);
+}
+
+// add the values collected by a shard metric to the main metric, and reset the shard metric
+static inline void statsd_shard_metric_merge(STATSD_INDEX *index, STATSD_METRIC *s) {
+    STATSD_METRIC *m = dictionary_set(index->dict, s->name, NULL, sizeof(STATSD_METRIC));
+
+    if(unlikely(s->options & STATSD_METRIC_OPTION_UPDATED_CHART_METADATA)) {
+        statsd_shard_metric_copy_tag(&m->units, s->units);
+        statsd_shard_metric_copy_tag(&m->dimname, s->dimname);
+        statsd_shard_metric_copy_tag(&m->family, s->family);
+        m->options |= STATSD_METRIC_OPTION_UPDATED_CHART_METADATA;
+        s->options &= ~STATSD_METRIC_OPTION_UPDATED_CHART_METADATA;
+    }
+
+    if(likely(s->count && is_metric_useful_for_collection(m))) {
+        if(unlikely(m->reset)) {
+            // the same resets the collector does on the next value it receives
+            if(m->type == STATSD_METRIC_TYPE_HISTOGRAM || m->type == STATSD_METRIC_TYPE_TIMER) {
+                m->histogram.ext->used = 0;
+
+                if(m->histogram.ext->sketch) {
+                    spinlock_lock(&m->histogram.ext->sketch_spinlock);
+                    ddsketch_reset(m->histogram.ext->sketch);
+                    spinlock_unlock(&m->histogram.ext->sketch_spinlock);
+                }
+            }
+            else if(m->type == STATSD_METRIC_TYPE_SET && m->set.dict) {
+                dictionary_destroy(m->set.dict);
+                m->set.dict = NULL;
+            }
+
+            statsd_reset_metric(m);
+        }
+
+        switch(m->type) {
+            case STATSD_METRIC_TYPE_GAUGE:
+                if(s->gauge.absolute)
+                    m->gauge.value = s->gauge.value;
+                else
+                    m->gauge.value += s->gauge.value;
+                break;
+
+            case STATSD_METRIC_TYPE_COUNTER:
+            case STATSD_METRIC_TYPE_METER:
+                m->counter.value += s->counter.value;
+                break;
+
+            case STATSD_METRIC_TYPE_HISTOGRAM:
+            case STATSD_METRIC_TYPE_TIMER:
+                statsd_shard_merge_histogram_or_timer(m, s);
+                break;
+
+            case STATSD_METRIC_TYPE_SET:
+                statsd_shard_merge_set(m, s);
+                break;
+
+            case STATSD_METRIC_TYPE_DICTIONARY:
+                statsd_shard_merge_dictionary(m, s);
+                break;
+        }
+
+        m->events += s->events;
+        m->count += s->count;
+        if(s->last_collected > m->last_collected)
+            m->last_collected = s->last_collected;
+        m->options &= ~STATSD_METRIC_OPTION_OBSOLETE;
+    }
+
+    // reset the shard metric
+    s->events = 0;
+    s->count = 0;
+    switch(s->type) {
+        case STATSD_METRIC_TYPE_GAUGE:
+            s->gauge.value = 0;
+            s->gauge.absolute = false;
+            break;
+
+        case STATSD_METRIC_TYPE_COUNTER:
+        case STATSD_METRIC_TYPE_METER:
+            s->counter.value = 0;
+            break;
+
+        case STATSD_METRIC_TYPE_HISTOGRAM:
+        case STATSD_METRIC_TYPE_TIMER:
+            s->histogram.ext->used = 0;
+            if(s->histogram.ext->sketch)
+                ddsketch_reset(s->histogram.ext->sketch);
+            break;
+
+        case STATSD_METRIC_TYPE_SET:
+            if(s->set.dict)
+                dictionary_flush(s->set.dict);
+            break;
+
+        case STATSD_METRIC_TYPE_DICTIONARY:
+            if(s->dictionary.dict)
+                dictionary_flush(s->dictionary.dict);
+            break;
+    }
+
+    // so that the collector thread skips the metrics that are not useful,
+    // and aggregates histograms the way the main metric does
+    s->options = (s->options & ~STATSD_SHARD_METRIC_SYNCED_OPTIONS) | (m->options & STATSD_SHARD_METRIC_SYNCED_OPTIONS);
+}
+
+static void statsd_shard_index_merge(STATSD_INDEX *index, STATSD_INDEX *shard_index, time_t now) {
+    index->events += shard_index->events;
+    shard_index->events = 0;
+
+    STATSD_METRIC *s;
+    dfe_start_write(shard_index->dict, s) {
+        if(s->count || !s->last_collected || (s->options & STATSD_METRIC_OPTION_UPDATED_CHART_METADATA)) {
+            // new metrics are merged even without values, to be created in the main index
+            statsd_shard_metric_merge(index, s);
+
+            if(!s->last_collected)
+                s->last_collected = now;
+        }
+
+        else if(s->last_collected + STATSD_SHARD_METRIC_EXPIRE_SECONDS < now)
+            dictionary_del(shard_index->dict, s_dfe.name);
+    }
+    dfe_done(s);
+}
+
+static void statsd_shards_merge(void) {
+    time_t now = now_realtime_sec();
+
+    for(int i = 0; i < statsd.threads ;i++) {
+        STATSD_SHARD *sh = statsd.collection_threads_status[i].shard;
+        if(!sh) continue;
+
+        spinlock_lock(&sh->spinlock);
+        statsd_shard_index_merge(&statsd.gauges, &sh->gauges, now);
+        statsd_shard_index_merge(&statsd.counters, &sh->counters, now);
+        statsd_shard_index_merge(&statsd.meters, &sh->meters, now);
+        statsd_shard_index_merge(&statsd.timers, &sh->timers, now);
+        statsd_shard_index_merge(&statsd.histograms, &sh->histograms, now);
+        statsd_shard_index_merge(&statsd.sets, &sh->sets, now);
+        statsd_shard_index_merge(&statsd.dictionaries, &sh->dictionaries, now);
+        spinlock_unlock(&sh->spinlock);
+    }
+}
+
+static void statsd_collector_stats_sum(struct statsd_collector_stats *total) {
+    memset(total, 0, sizeof(*total));
+
+    for(int i = 0; i < statsd.threads ;i++) {
+        struct statsd_collector_stats *t = &statsd.collection_threads_status[i].stats;
+        total->unknown_types += t->unknown_types;
+        total->socket_errors += t->socket_errors;
+        total->tcp_socket_connects += t->tcp_socket_connects;
+        total->tcp_socket_disconnects += t->tcp_socket_disconnects;
+        total->tcp_socket_connected += t->tcp_socket_connected;
+        total->tcp_socket_reads += t->tcp_socket_reads;
+        total->tcp_packets_received += t->tcp_packets_received;
+        total->tcp_bytes_read += t->tcp_bytes_read;
+        total->udp_socket_reads += t->udp_socket_reads;
+        total->udp_packets_received += t->udp_packets_received;
+        total->udp_bytes_read += t->udp_bytes_read;
+    }
+}
+
 // --------------------------------------------------------------------------------------
 // statsd main thread
 
+static void statsd_listen_sockets_enable_drops(LISTEN_SOCKETS *sockets __maybe_unused) {
+#if defined(HAVE_RECVMMSG) && defined(SO_RXQ_OVFL)
+    for(size_t i = 0; i < sockets->opened ;i++) {
+        if(sockets->fds_types[i] != SOCK_DGRAM)
+            continue;
+
+        int enable = 1;
+        if(setsockopt(sockets->fds[i], SOL_SOCKET, SO_RXQ_OVFL, &enable, sizeof(enable)) != 0)
+            collector_error("STATSD: cannot enable drops accounting on socket %s", sockets->fds_names[i]);
+    }
+#endif
+}
+
 static int statsd_listen_sockets_setup(void) {
-    return listen_sockets_setup(&statsd.sockets);
+    // with multiple collector threads, each thread gets its own copy of each socket,
+    // and the kernel distributes the incoming packets and connections among them
+    statsd.sockets.reuse_port = statsd.threads > 1 && statsd.threads_reuse_port;
+
+    int opened = listen_sockets_setup(&statsd.sockets);
+    statsd_listen_sockets_enable_drops(&statsd.sockets);
+    return opened;
 }
 
 static void statsd_main_cleanup(void *pptr) {
@@ -2406,6 +2910,9 @@ static void statsd_main_cleanup(void *pptr) {
             } while(initializing);
 
             (void) nd_thread_join(statsd.collection_threads_status[i].thread);
+
+            listen_sockets_close(&statsd.collection_threads_status[i].reuse_port_sockets);
+            statsd_shard_destroy(statsd.collection_threads_status[i].shard);
         }
         freez(statsd.collection_threads_status);
     }
@@ -2446,9 +2953,10 @@ static void statsd_main_cleanup(void *pptr) {
 #define WORKER_STATSD_FLUSH_SETS 5
 #define WORKER_STATSD_FLUSH_DICTIONARIES 6
 #define WORKER_STATSD_FLUSH_STATS 7
+#define WORKER_STATSD_MERGE_SHARDS 8
 
-#if WORKER_UTILIZATION_MAX_JOB_TYPES < 8
-#error WORKER_UTILIZATION_MAX_JOB_TYPES has to be at least 8
+#if WORKER_UTILIZATION_MAX_JOB_TYPES < 9
+#error WORKER_UTILIZATION_MAX_JOB_TYPES has to be at least 9
 #endif
 
 void *statsd_main(void *ptr) {
@@ -2463,6 +2971,7 @@ void *statsd_main(void *ptr) {
     worker_register_job_name(WORKER_STATSD_FLUSH_SETS, "sets");
     worker_register_job_name(WORKER_STATSD_FLUSH_DICTIONARIES, "dictionaries");
     worker_register_job_name(WORKER_STATSD_FLUSH_STATS, "statistics");
+    worker_register_job_name(WORKER_STATSD_MERGE_SHARDS, "merge shards");
 
     statsd.gauges.dict = dictionary_create_advanced(STATSD_DICTIONARY_OPTIONS | DICT_OPTION_FIXED_SIZE, &dictionary_stats_category_collectors, sizeof(STATSD_METRIC));
     statsd.meters.dict = dictionary_create_advanced(STATSD_DICTIONARY_OPTIONS | DICT_OPTION_FIXED_SIZE, &dictionary_stats_category_collectors, sizeof(STATSD_METRIC));
@@ -2539,6 +3048,26 @@ void *statsd_main(void *ptr) {
         statsd.histogram_percentile_str = strdupz(buffer);
     }
 
+    {
+        const char *aggregation = inicfg_get(&netdata_config, CONFIG_SECTION_STATSD, "histograms and timers aggregation", "exact");
+        if(!strcmp(aggregation, "sketch")) {
+            statsd.histograms.default_options |= STATSD_METRIC_OPTION_HISTOGRAM_SKETCH;
+            statsd.timers.default_options |= STATSD_METRIC_OPTION_HISTOGRAM_SKETCH;
+        }
+        else if(strcmp(aggregation, "exact") != 0)
+            collector_error("STATSD: invalid histograms and timers aggregation '%s' given, using 'exact'", aggregation);
+    }
+
+    statsd.histogram_sketch_accuracy =
+        inicfg_get_double(&netdata_config, CONFIG_SECTION_STATSD, "histograms and timers sketch relative accuracy %",
+                          statsd.histogram_sketch_accuracy * 100.0) / 100.0;
+
+    if(!isgreater(statsd.histogram_sketch_accuracy, 0) || !isless(statsd.histogram_sketch_accuracy, 0.5)) {
+        collector_error("STATSD: invalid histograms and timers sketch relative accuracy %0.5f%% given",
+                        (double)(statsd.histogram_sketch_accuracy * 100.0));
+        statsd.histogram_sketch_accuracy = DDSKETCH_DEFAULT_RELATIVE_ACCURACY;
+    }
+
     statsd.dictionary_max_unique =
         inicfg_get_number(&netdata_config, CONFIG_SECTION_STATSD, "dictionaries max unique dimensions", statsd.dictionary_max_unique);
 
@@ -2575,16 +3104,16 @@ void *statsd_main(void *ptr) {
 
     size_t max_sockets = (size_t)inicfg_get_number(&netdata_config, CONFIG_SECTION_STATSD, "statsd server max TCP sockets", (long long int)(rlimit_nofile.rlim_cur / 4));
 
-#ifdef STATSD_MULTITHREADED
-    statsd.threads = (int)inicfg_get_number(&netdata_config, CONFIG_SECTION_STATSD, "threads", processors);
-    if(statsd.threads < 1) {
-        collector_error("STATSD: Invalid number of threads %d, using %d", statsd.threads, processors);
-        statsd.threads = processors;
-        inicfg_set_number(&netdata_config, CONFIG_SECTION_STATSD, "collector threads", statsd.threads);
+    int max_threads = (int)os_get_system_cpus() * 2;
+    statsd.threads = (int)inicfg_get_number(&netdata_config, CONFIG_SECTION_STATSD, "threads", 1);
+    if(statsd.threads < 1 || statsd.threads > max_threads) {
+        int threads = MAX(1, MIN(statsd.threads, max_threads));
+        collector_error("STATSD: Invalid number of threads %d, using %d", statsd.threads, threads);
+        statsd.threads = threads;
+        inicfg_set_number(&netdata_config, CONFIG_SECTION_STATSD, "threads", statsd.threads);
     }
-#else
-    statsd.threads = 1;
-#endif
+
+    statsd.threads_reuse_port = inicfg_get_boolean(&netdata_config, CONFIG_SECTION_STATSD, "threads reuse port", true);
 
     // read custom application definitions
     statsd_readdir(netdata_configured_user_config_dir, netdata_configured_stock_config_dir, "statsd.d");
@@ -2604,6 +3133,20 @@ void *statsd_main(void *ptr) {
 
     int i;
     for(i = 0; i < statsd.threads ;i++) {
+        struct collection_thread_status *status = &statsd.collection_threads_status[i];
+        status->sockets = &statsd.sockets;
+
+        if(statsd.threads > 1) {
+            status->shard = statsd_shard_create();
+
+            // the first thread uses the statsd sockets, all others their clones
+            if(i > 0 && statsd.sockets.reuse_port &&
+                listen_sockets_clone_reuse_port(&status->reuse_port_sockets, &statsd.sockets) > 0) {
+                statsd_listen_sockets_enable_drops(&status->reuse_port_sockets);
+                status->sockets = &status->reuse_port_sockets;
+            }
+        }
+
         statsd.collection_threads_status[i].max_sockets = max_sockets / statsd.threads;
         char tag[NETDATA_THREAD_TAG_MAX + 1];
         snprintfz(tag, NETDATA_THREAD_TAG_MAX, "STATSD_IN[%d]", i + 1);
@@ -2658,6 +3201,7 @@ void *statsd_main(void *ptr) {
     RRDDIM *rd_tcp_connected = NULL;
     RRDSET *st_pcharts = NULL;
     RRDDIM *rd_pcharts = NULL;
+    RRDSET *st_udp_drops = NULL;
 
     if(pulse_enabled) {
         st_metrics = rrdset_create_localhost(
@@ -2818,6 +3362,40 @@ void *statsd_main(void *ptr) {
             statsd.update_every,
             RRDSET_TYPE_AREA);
         rd_pcharts = rrddim_add(st_pcharts, "charts", NULL, 1, 1, RRD_ALGORITHM_ABSOLUTE);
+
+#if defined(HAVE_RECVMMSG) && defined(SO_RXQ_OVFL)
+        st_udp_drops = rrdset_create_localhost(
+            "netdata",
+            "statsd_udp_drops",
+            NULL,
+            "statsd",
+            NULL,
+            "UDP packets dropped by the kernel, per statsd socket",
+            "packets/s",
+            PLUGIN_STATSD_NAME,
+            "stats",
+            132017,
+            statsd.update_every,
+            RRDSET_TYPE_STACKED);
+
+        for(i = 0; i < statsd.threads ;i++) {
+            struct collection_thread_status *status = &statsd.collection_threads_status[i];
+
+            // threads without their own sockets report nothing, the first thread reports the shared ones
+            if(i > 0 && status->sockets == &statsd.sockets)
+                continue;
+
+            for(size_t j = 0; j < status->sockets->opened ;j++) {
+                if(status->sockets->fds_types[j] != SOCK_DGRAM)
+                    continue;
+
+                char id[RRD_ID_LENGTH_MAX + 1], name[RRD_ID_LENGTH_MAX + 1];
+                snprintfz(id, sizeof(id), "thread%d_socket%zu", i + 1, j);
+                snprintfz(name, sizeof(name), "%s #%d", status->sockets->fds_names[j], i + 1);
+                status->rd_udp_drops[j] = rrddim_add(st_udp_drops, id, name, 1, 1, RRD_ALGORITHM_INCREMENTAL);
+            }
+        }
+#endif
     }
 
     // ----------------------------------------------------------------------------------------------------------------
@@ -2829,6 +3407,11 @@ void *statsd_main(void *ptr) {
         worker_is_idle();
         heartbeat_next(&hb);
 
+        if(statsd.threads > 1) {
+            worker_is_busy(WORKER_STATSD_MERGE_SHARDS);
+            statsd_shards_merge();
+        }
+
         worker_is_busy(WORKER_STATSD_FLUSH_GAUGES);
         statsd_flush_index_metrics(&statsd.gauges,     statsd_flush_gauge);
 
@@ -2857,6 +3440,9 @@ void *statsd_main(void *ptr) {
             break;
 
         if(pulse_enabled) {
+            struct statsd_collector_stats stats;
+            statsd_collector_stats_sum(&stats);
+
             rrddim_set_by_pointer(st_metrics, rd_metrics_gauge,        (collected_number)statsd.gauges.metrics);
             rrddim_set_by_pointer(st_metrics, rd_metrics_counter,      (collected_number)statsd.counters.metrics);
             rrddim_set_by_pointer(st_metrics, rd_metrics_timer,        (collected_number)statsd.timers.metrics);
@@ -2882,31 +3468,43 @@ void *statsd_main(void *ptr) {
             rrddim_set_by_pointer(st_events,  rd_events_histogram,     (collected_number)statsd.histograms.events);
             rrddim_set_by_pointer(st_events,  rd_events_set,           (collected_number)statsd.sets.events);
             rrddim_set_by_pointer(st_events,  rd_events_dictionary,    (collected_number)statsd.dictionaries.events);
-            rrddim_set_by_pointer(st_events,  rd_events_unknown,       (collected_number)statsd.unknown_types);
-            rrddim_set_by_pointer(st_events,  rd_events_errors,        (collected_number)statsd.socket_errors);
+            rrddim_set_by_pointer(st_events,  rd_events_unknown,       (collected_number)stats.unknown_types);
+            rrddim_set_by_pointer(st_events,  rd_events_errors,        (collected_number)stats.socket_errors);
             rrdset_done(st_events);
 
-            rrddim_set_by_pointer(st_reads,   rd_reads_tcp,            (collected_number)statsd.tcp_socket_reads);
-            rrddim_set_by_pointer(st_reads,   rd_reads_udp,            (collected_number)statsd.udp_socket_reads);
+            rrddim_set_by_pointer(st_reads,   rd_reads_tcp,            (collected_number)stats.tcp_socket_reads);
+            rrddim_set_by_pointer(st_reads,   rd_reads_udp,            (collected_number)stats.udp_socket_reads);
             rrdset_done(st_reads);
 
-            rrddim_set_by_pointer(st_bytes,   rd_bytes_tcp,            (collected_number)statsd.tcp_bytes_read);
-            rrddim_set_by_pointer(st_bytes,   rd_bytes_udp,            (collected_number)statsd.udp_bytes_read);
+            rrddim_set_by_pointer(st_bytes,   rd_bytes_tcp,            (collected_number)stats.tcp_bytes_read);
+            rrddim_set_by_pointer(st_bytes,   rd_bytes_udp,            (collected_number)stats.udp_bytes_read);
             rrdset_done(st_bytes);
 
-            rrddim_set_by_pointer(st_packets, rd_packets_tcp,          (collected_number)statsd.tcp_packets_received);
-            rrddim_set_by_pointer(st_packets, rd_packets_udp,          (collected_number)statsd.udp_packets_received);
+            rrddim_set_by_pointer(st_packets, rd_packets_tcp,          (collected_number)stats.tcp_packets_received);
+            rrddim_set_by_pointer(st_packets, rd_packets_udp,          (collected_number)stats.udp_packets_received);
             rrdset_done(st_packets);
 
-            rrddim_set_by_pointer(st_tcp_connects, rd_tcp_connects,    (collected_number)statsd.tcp_socket_connects);
-            rrddim_set_by_pointer(st_tcp_connects, rd_tcp_disconnects, (collected_number)statsd.tcp_socket_disconnects);
+            rrddim_set_by_pointer(st_tcp_connects, rd_tcp_connects,    (collected_number)stats.tcp_socket_connects);
+            rrddim_set_by_pointer(st_tcp_connects, rd_tcp_disconnects, (collected_number)stats.tcp_socket_disconnects);
             rrdset_done(st_tcp_connects);
 
-            rrddim_set_by_pointer(st_tcp_connected, rd_tcp_connected,  (collected_number)statsd.tcp_socket_connected);
+            rrddim_set_by_pointer(st_tcp_connected, rd_tcp_connected,  (collected_number)stats.tcp_socket_connected);
             rrdset_done(st_tcp_connected);
 
             rrddim_set_by_pointer(st_pcharts, rd_pcharts,              (collected_number)statsd.private_charts);
             rrdset_done(st_pcharts);
+
+            if(st_udp_drops) {
+                for(i = 0; i < statsd.threads; i++) {
+                    struct collection_thread_status *status = &statsd.collection_threads_status[i];
+                    for(size_t j = 0; j < status->sockets->opened; j++) {
+                        if(status->rd_udp_drops[j])
+                            rrddim_set_by_pointer(st_udp_drops, status->rd_udp_drops[j],
+                                                  (collected_number)__atomic_load_n(&status->udp_drops[j], __ATOMIC_RELAXED));
+                    }
+                }
+                rrdset_done(st_udp_drops);
+            }
         }
     }
 
@@ -430,6 +430,10 @@ void netdata_conf_section_db(void) {
     }
     gap_when_lost_iterations_above += 2;
 
+    long long dimensions_budget = inicfg_get_number(&netdata_config, CONFIG_SECTION_DB, "dimensions budget per plugin", 0);
+    if(dimensions_budget > 0)
+        rrddim_budget_init((size_t)dimensions_budget);
+
     // ------------------------------------------------------------------------
 
     netdata_conf_dbengine_pre_logs();
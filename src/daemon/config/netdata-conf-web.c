@@ -24,6 +24,25 @@ size_t netdata_conf_web_query_threads(void) {
     return threads;
 }
 
+size_t netdata_conf_web_query_executor_threads(void) {
+    // heavy API queries (data, weights, contexts, functions, mcp, exports) are executed
+    // by these threads, so that they do not block the web server threads - 0 disables it
+    long long threads = (long long)MIN(MAX(netdata_conf_cpus(), 2), 16);
+
+    threads = inicfg_get_number(&netdata_config, CONFIG_SECTION_WEB, "query executor threads", threads);
+    if(threads < 0) {
+        netdata_log_error("[" CONFIG_SECTION_WEB "].query executor threads in netdata.conf cannot be negative. Disabling it.");
+        threads = 0;
+        inicfg_set_number(&netdata_config, CONFIG_SECTION_WEB, "query executor threads", threads);
+    }
+    return (size_t)threads;
+}
+
+size_t netdata_conf_web_static_cache_size(void) {
+    // the memory for the compressed variants of the static files of the dashboard - 0 disables it
+    return (size_t)inicfg_get_size_bytes(&netdata_config, CONFIG_SECTION_WEB, "static files cache size", 64 * 1024 * 1024);
+}
+
 static int make_dns_decision(const char *section_name, const char *config_name, const char *default_value, SIMPLE_PATTERN *p) {
     const char *value = inicfg_get(&netdata_config, section_name,config_name,default_value);
 
@@ -139,6 +158,20 @@ void netdata_conf_section_web(void) {
         netdata_log_error("Invalid compression level %d. Valid levels are 1 (fastest) to 9 (best ratio). Proceeding with level 9 (best compression).", web_gzip_level);
         web_gzip_level = 9;
     }
+
+    web_enable_brotli = inicfg_get_boolean(&netdata_config, CONFIG_SECTION_WEB, "enable brotli compression", web_enable_brotli);
+    web_brotli_level = (int)inicfg_get_number(&netdata_config, CONFIG_SECTION_WEB, "brotli compression level", web_brotli_level);
+    if(web_brotli_level < 0 || web_brotli_level > 11) {
+        netdata_log_error("Invalid brotli compression level %d. Valid levels are 0 (fastest) to 11 (best ratio). Proceeding with level 5.", web_brotli_level);
+        web_brotli_level = 5;
+    }
+
+    web_enable_zstd = inicfg_get_boolean(&netdata_config, CONFIG_SECTION_WEB, "enable zstd compression", web_enable_zstd);
+    web_zstd_level = (int)inicfg_get_number(&netdata_config, CONFIG_SECTION_WEB, "zstd compression level", web_zstd_level);
+    if(web_zstd_level < 1 || web_zstd_level > 19) {
+        netdata_log_error("Invalid zstd compression level %d. Valid levels are 1 (fastest) to 19 (best ratio). Proceeding with level 3.", web_zstd_level);
+        web_zstd_level = 3;
+    }
 }
 
 void netdata_conf_web_security_init(void) {
@@ -10,5 +10,7 @@ void web_server_threading_selection(void);
 void netdata_conf_web_security_init(void);
 
 size_t netdata_conf_web_query_threads(void);
+size_t netdata_conf_web_query_executor_threads(void);
+size_t netdata_conf_web_static_cache_size(void);
 
 #endif //NETDATA_NETDATA_CONF_WEB_H
@@ -145,6 +145,11 @@ int help(int exitcode) {
             "  -W sqlite-compact        Reclaim metadata database unused space and exit.\n\n"
             "  -W sqlite-analyze        Run update statistics and exit.\n\n"
             "  -W sqlite-alert-cleanup  Perform maintenance on the alerts table.\n\n"
+            "  -W querybench=A,B,C,D,E,F\n"
+            "                           Run the query engine benchmark on A in-memory nodes,\n"
+            "                           with B contexts, C instances per context, D dimensions\n"
+            "                           per instance and E points per metric, running each\n"
+            "                           workload F times, and exit.\n\n"
 #ifdef ENABLE_DBENGINE
             "  -W createdataset=N       Create a DB engine dataset of N seconds and exit.\n\n"
             "  -W stresstest=A,B,C,D,E,F,G\n"
@@ -219,6 +224,7 @@ int progress_unittest(void);
 int dyncfg_unittest(void);
 int eval_unittest(void);
 int duration_unittest(void);
+int query_benchmark(size_t nodes, size_t contexts, size_t instances, size_t dimensions, size_t points, size_t iterations);
 bool netdata_random_session_id_generate(void);
 
 #ifdef OS_WINDOWS
@@ -342,6 +348,7 @@ int netdata_main(int argc, char **argv) {
                     {
                         char* stacksize_string = "stacksize=";
                         char* debug_flags_string = "debug_flags=";
+                        char* querybench_string = "querybench=";
 #ifdef ENABLE_DBENGINE
                         char* createdataset_string = "createdataset=";
                         char* stresstest_string = "stresstest=";
@@ -402,17 +409,23 @@ int netdata_main(int argc, char **argv) {
                             if (dictionary_unittest(10000)) return 1;
                             if (aral_unittest(10000)) return 1;
                             if (rrdlabels_unittest()) return 1;
+                            if (rrdcontext_labels_index_unittest()) return 1;
                             if (ctx_unittest()) return 1;
                             if (uuid_unittest()) return 1;
                             if (dyncfg_unittest()) return 1;
                             if (eval_unittest()) return 1;
                             if (duration_unittest()) return 1;
+                            if (json_scan_unittest()) return 1;
+                            if (simple_pattern_unittest()) return 1;
+                            if (ddsketch_unittest()) return 1;
+                            if (shm_ring_unittest()) return 1;
                             if (unittest_waiting_queue()) return 1;
                             if (uuidmap_unittest()) return 1;
 #ifdef HAVE_LIBBACKTRACE
                             if (stacktrace_unittest()) return 1;
 #endif
                             if (test_cmd_pool_fifo()) return 1;
+                            if (nd_thread_pool_unittest()) return 1;
 #ifdef OS_WINDOWS
                             if (perflibnamestest_main()) return 1;
 #endif
@@ -448,6 +461,10 @@ int netdata_main(int argc, char **argv) {
                             unittest_running = true;
                             return rwlocks_stress_test();
                         }
+                        else if(strcmp(optarg, "lockprofilingtest") == 0) {
+                            unittest_running = true;
+                            return lock_profiling_unittest();
+                        }
                         else if(strcmp(optarg, "stringtest") == 0)  {
                             unittest_running = true;
                             return string_unittest(10000);
@@ -471,6 +488,21 @@ int netdata_main(int argc, char **argv) {
                             unittest_running = true;
                             return uuid_unittest();
                         }
+                        else if(strncmp(optarg, querybench_string, strlen(querybench_string)) == 0) {
+                            char *endptr;
+                            size_t qb[6] = { 0 };
+
+                            optarg += strlen(querybench_string);
+                            qb[0] = (size_t)strtoul(optarg, &endptr, 0);
+                            for(size_t q = 1; q < 6 && ',' == *endptr ;q++)
+                                qb[q] = (size_t)strtoul(endptr + 1, &endptr, 0);
+
+                            unittest_running = true;
+                            if(unittest_prepare_rrd(&user))
+                                return 1;
+
+                            return query_benchmark(qb[0], qb[1], qb[2], qb[3], qb[4], qb[5]);
+                        }
 #ifdef HAVE_LIBBACKTRACE
                         else if(strcmp(optarg, "stacktracetest") == 0) {
                             unittest_running = true;
@@ -527,6 +559,22 @@ int netdata_main(int argc, char **argv) {
                             unittest_running = true;
                             return duration_unittest();
                         }
+                        else if(strcmp(optarg, "simplepatterntest") == 0) {
+                            unittest_running = true;
+                            return simple_pattern_unittest();
+                        }
+                        else if(strcmp(optarg, "jsonscantest") == 0) {
+                            unittest_running = true;
+                            return json_scan_unittest();
+                        }
+                        else if(strcmp(optarg, "ddsketchtest") == 0) {
+                            unittest_running = true;
+                            return ddsketch_unittest();
+                        }
+                        else if(strcmp(optarg, "shmringtest") == 0) {
+                            unittest_running = true;
+                            return shm_ring_unittest();
+                        }
                         else if(strcmp(optarg, "dyncfgtest") == 0) {
                             unittest_running = true;
                             if(unittest_prepare_rrd(&user))
@@ -902,6 +950,10 @@ int netdata_main(int argc, char **argv) {
         // this has to run before starting any other threads that use workers
         workers_utilization_enable();
 
+    // this has to run before starting any other threads that use locks
+    lock_profiling_enable(
+        inicfg_get_boolean(&netdata_config, CONFIG_SECTION_PULSE, "lock contention profiling", lock_profiling_is_enabled()));
+
     // ----------------------------------------------------------------------------------------------------------------
     delta_startup_time("replication");
 
@@ -10,6 +10,12 @@ struct aral_info {
 
     RRDSET *st_utilization;
     RRDDIM *rd_utilization;
+
+    RRDSET *st_thread_cache;
+    RRDDIM *rd_thread_cache_hits, *rd_thread_cache_misses;
+
+    RRDSET *st_numa;
+    RRDDIM *rd_numa_local, *rd_numa_remote;
 };
 
 DEFINE_JUDYL_TYPED(ARAL_STATS, struct aral_info *);
@@ -174,6 +180,74 @@ void pulse_aral_do(bool extended) {
             rrddim_set_by_pointer(ai->st_utilization, ai->rd_utilization, (collected_number)(utilization * 1000.0));
             rrdset_done(ai->st_utilization);
         }
+
+        size_t thread_cache_hits = __atomic_load_n(&stats->thread_cache.hits, __ATOMIC_RELAXED);
+        size_t thread_cache_misses = __atomic_load_n(&stats->thread_cache.misses, __ATOMIC_RELAXED);
+        if(thread_cache_hits || thread_cache_misses || ai->st_thread_cache) {
+            if (unlikely(!ai->st_thread_cache)) {
+                char id[256];
+
+                snprintfz(id, sizeof(id), "aral_%s_thread_cache", ai->name);
+                netdata_fix_chart_id(id);
+
+                ai->st_thread_cache = rrdset_create_localhost(
+                    "netdata",
+                    id,
+                    NULL,
+                    "ARAL",
+                    "netdata.aral_thread_cache",
+                    "Array Allocator Per-Thread Cache Allocations",
+                    "allocations/s",
+                    "netdata",
+                    "pulse",
+                    910002,
+                    localhost->rrd_update_every,
+                    RRDSET_TYPE_STACKED);
+
+                rrdlabels_add(ai->st_thread_cache->rrdlabels, "ARAL", ai->name, RRDLABEL_SRC_AUTO);
+
+                ai->rd_thread_cache_hits = rrddim_add(ai->st_thread_cache, "hits", NULL, 1, 1, RRD_ALGORITHM_INCREMENTAL);
+                ai->rd_thread_cache_misses = rrddim_add(ai->st_thread_cache, "misses", NULL, 1, 1, RRD_ALGORITHM_INCREMENTAL);
+            }
+
+            rrddim_set_by_pointer(ai->st_thread_cache, ai->rd_thread_cache_hits, (collected_number)thread_cache_hits);
+            rrddim_set_by_pointer(ai->st_thread_cache, ai->rd_thread_cache_misses, (collected_number)thread_cache_misses);
+            rrdset_done(ai->st_thread_cache);
+        }
+
+        size_t numa_local_frees = __atomic_load_n(&stats->numa.local_frees, __ATOMIC_RELAXED);
+        size_t numa_remote_frees = __atomic_load_n(&stats->numa.remote_frees, __ATOMIC_RELAXED);
+        if(numa_local_frees || numa_remote_frees || ai->st_numa) {
+            if (unlikely(!ai->st_numa)) {
+                char id[256];
+
+                snprintfz(id, sizeof(id), "aral_%s_numa", ai->name);
+                netdata_fix_chart_id(id);
+
+                ai->st_numa = rrdset_create_localhost(
+                    "netdata",
+                    id,
+                    NULL,
+                    "ARAL",
+                    "netdata.aral_numa_frees",
+                    "Array Allocator Frees per NUMA Locality",
+                    "frees/s",
+                    "netdata",
+                    "pulse",
+                    910003,
+                    localhost->rrd_update_every,
+                    RRDSET_TYPE_STACKED);
+
+                rrdlabels_add(ai->st_numa->rrdlabels, "ARAL", ai->name, RRDLABEL_SRC_AUTO);
+
+                ai->rd_numa_local = rrddim_add(ai->st_numa, "local", NULL, 1, 1, RRD_ALGORITHM_INCREMENTAL);
+                ai->rd_numa_remote = rrddim_add(ai->st_numa, "cross-node", NULL, 1, 1, RRD_ALGORITHM_INCREMENTAL);
+            }
+
+            rrddim_set_by_pointer(ai->st_numa, ai->rd_numa_local, (collected_number)numa_local_frees);
+            rrddim_set_by_pointer(ai->st_numa, ai->rd_numa_remote, (collected_number)numa_remote_frees);
+            rrdset_done(ai->st_numa);
+        }
     }
 
     spinlock_unlock(&globals.spinlock);
@@ -16,6 +16,13 @@ static struct web_statistics {
 
     PAD64(uint64_t) content_size_uncompressed;
     PAD64(uint64_t) content_size_compressed;
+
+    struct {
+        PAD64(int64_t) queued;
+        PAD64(uint64_t) executed;
+        PAD64(uint64_t) queue_ut;
+        PAD64(uint64_t) exec_ut;
+    } executor[WEB_QUERY_PRIORITY_MAX];
 } live_stats = { 0 };
 
 void pulse_web_client_connected(void) {
@@ -43,6 +50,17 @@ void pulse_web_request_completed(uint64_t dt,
     __atomic_fetch_add(&live_stats.content_size_compressed, compressed_content_size, __ATOMIC_RELAXED);
 }
 
+void pulse_web_query_queued(WEB_QUERY_PRIORITY priority) {
+    __atomic_fetch_add(&live_stats.executor[priority].queued, 1, __ATOMIC_RELAXED);
+}
+
+void pulse_web_query_executed(WEB_QUERY_PRIORITY priority, uint64_t queue_ut, uint64_t exec_ut) {
+    __atomic_fetch_sub(&live_stats.executor[priority].queued, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&live_stats.executor[priority].executed, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&live_stats.executor[priority].queue_ut, queue_ut, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&live_stats.executor[priority].exec_ut, exec_ut, __ATOMIC_RELAXED);
+}
+
 static inline void pulse_web_copy(struct web_statistics *gs, uint8_t options) {
     gs->connected_clients = __atomic_load_n(&live_stats.connected_clients, __ATOMIC_RELAXED);
     gs->web_requests = __atomic_load_n(&live_stats.web_requests, __ATOMIC_RELAXED);
@@ -53,6 +71,13 @@ static inline void pulse_web_copy(struct web_statistics *gs, uint8_t options) {
     gs->content_size_uncompressed = __atomic_load_n(&live_stats.content_size_uncompressed, __ATOMIC_RELAXED);
     gs->content_size_compressed = __atomic_load_n(&live_stats.content_size_compressed, __ATOMIC_RELAXED);
 
+    for(size_t p = 0; p < WEB_QUERY_PRIORITY_MAX ;p++) {
+        gs->executor[p].queued = __atomic_load_n(&live_stats.executor[p].queued, __ATOMIC_RELAXED);
+        gs->executor[p].executed = __atomic_load_n(&live_stats.executor[p].executed, __ATOMIC_RELAXED);
+        gs->executor[p].queue_ut = __atomic_load_n(&live_stats.executor[p].queue_ut, __ATOMIC_RELAXED);
+        gs->executor[p].exec_ut = __atomic_load_n(&live_stats.executor[p].exec_ut, __ATOMIC_RELAXED);
+    }
+
     if(options & GLOBAL_STATS_RESET_WEB_USEC_MAX) {
         uint64_t n = 0;
         __atomic_compare_exchange(&live_stats.web_usec_max, (uint64_t *) &gs->web_usec_max, &n, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED);
@@ -174,6 +199,90 @@ void pulse_web_do(bool extended) {
 
     // ----------------------------------------------------------------
 
+    if(web_query_executor_enabled()) {
+        static RRDSET *st_queued = NULL, *st_queue_time = NULL, *st_exec_time = NULL;
+        static RRDDIM *rd_queued[WEB_QUERY_PRIORITY_MAX] = { 0 },
+                      *rd_queue_time[WEB_QUERY_PRIORITY_MAX] = { 0 },
+                      *rd_exec_time[WEB_QUERY_PRIORITY_MAX] = { 0 };
+        static uint64_t old_executed[WEB_QUERY_PRIORITY_MAX] = { 0 },
+                        old_queue_ut[WEB_QUERY_PRIORITY_MAX] = { 0 },
+                        old_exec_ut[WEB_QUERY_PRIORITY_MAX] = { 0 };
+
+        if (unlikely(!st_queued)) {
+            st_queued = rrdset_create_localhost(
+                "netdata"
+                , "http_api_queries_queued"
+                , NULL
+                , "HTTP API"
+                , "netdata.http_api_queries_queued"
+                , "Netdata Web API Queries Waiting for the Query Executor"
+                , "queries"
+                , "netdata"
+                , "pulse"
+                , 130510
+                , localhost->rrd_update_every
+                , RRDSET_TYPE_LINE
+            );
+
+            st_queue_time = rrdset_create_localhost(
+                "netdata"
+                , "http_api_queries_queue_time"
+                , NULL
+                , "HTTP API"
+                , "netdata.http_api_queries_queue_time"
+                , "Netdata Web API Queries Average Time in the Query Executor Queue"
+                , "milliseconds/query"
+                , "netdata"
+                , "pulse"
+                , 130520
+                , localhost->rrd_update_every
+                , RRDSET_TYPE_LINE
+            );
+
+            st_exec_time = rrdset_create_localhost(
+                "netdata"
+                , "http_api_queries_execution_time"
+                , NULL
+                , "HTTP API"
+                , "netdata.http_api_queries_execution_time"
+                , "Netdata Web API Queries Average Execution Time"
+                , "milliseconds/query"
+                , "netdata"
+                , "pulse"
+                , 130530
+                , localhost->rrd_update_every
+                , RRDSET_TYPE_LINE
+            );
+
+            for(size_t p = 0; p < WEB_QUERY_PRIORITY_MAX ;p++) {
+                const char *name = web_query_priority_2str(p);
+                rd_queued[p] = rrddim_add(st_queued, name, NULL, 1, 1, RRD_ALGORITHM_ABSOLUTE);
+                rd_queue_time[p] = rrddim_add(st_queue_time, name, NULL, 1, 1000, RRD_ALGORITHM_ABSOLUTE);
+                rd_exec_time[p] = rrddim_add(st_exec_time, name, NULL, 1, 1000, RRD_ALGORITHM_ABSOLUTE);
+            }
+        }
+
+        for(size_t p = 0; p < WEB_QUERY_PRIORITY_MAX ;p++) {
+            uint64_t executed = gs.executor[p].executed - old_executed[p];
+            uint64_t queue_ut = gs.executor[p].queue_ut - old_queue_ut[p];
+            uint64_t exec_ut = gs.executor[p].exec_ut - old_exec_ut[p];
+
+            old_executed[p] = gs.executor[p].executed;
+            old_queue_ut[p] = gs.executor[p].queue_ut;
+            old_exec_ut[p] = gs.executor[p].exec_ut;
+
+            rrddim_set_by_pointer(st_queued, rd_queued[p], gs.executor[p].queued > 0 ? (collected_number)gs.executor[p].queued : 0);
+            rrddim_set_by_pointer(st_queue_time, rd_queue_time[p], executed ? (collected_number)(queue_ut / executed) : 0);
+            rrddim_set_by_pointer(st_exec_time, rd_exec_time[p], executed ? (collected_number)(exec_ut / executed) : 0);
+        }
+
+        rrdset_done(st_queued);
+        rrdset_done(st_queue_time);
+        rrdset_done(st_exec_time);
+    }
+
+    // ----------------------------------------------------------------
+
     if(!extended) return;
 
     // ----------------------------------------------------------------
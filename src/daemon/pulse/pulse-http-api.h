@@ -4,6 +4,7 @@
 #define NETDATA_PULSE_HTTP_API_H
 
 #include "daemon/common.h"
+#include "web/server/web_query_executor.h"
 
 void pulse_web_client_connected(void);
 void pulse_web_client_disconnected(void);
@@ -14,6 +15,9 @@ void pulse_web_request_completed(uint64_t dt,
                                      uint64_t content_size,
                                      uint64_t compressed_content_size);
 
+void pulse_web_query_queued(WEB_QUERY_PRIORITY priority);
+void pulse_web_query_executed(WEB_QUERY_PRIORITY priority, uint64_t queue_ut, uint64_t exec_ut);
+
 #if defined(PULSE_INTERNALS)
 void pulse_web_do(bool extended);
 #endif
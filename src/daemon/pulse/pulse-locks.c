@@ -0,0 +1,246 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#define PULSE_INTERNALS 1
+#include "pulse-locks.h"
+
+#define RRDFUNCTIONS_LOCK_CONTENTION_HELP "Shows the spinlock and rw-spinlock acquisition sites of the agent, with their contention and wait times."
+
+// the upper bound of the wait time below which the given percentage of the contended acquisitions waited
+static uint64_t lock_site_wait_percentile_ut(LOCK_PROFILE_SITE *s, double percent) {
+    if(!s->contended)
+        return 0;
+
+    uint64_t target = (uint64_t)((double)s->contended * percent / 100.0);
+    if(!target) target = 1;
+
+    uint64_t sum = 0;
+    for(size_t b = 1; b < LOCK_PROFILE_HISTOGRAM_BUCKETS; b++) {
+        sum += s->histogram[b];
+        if(sum >= target)
+            return b == LOCK_PROFILE_HISTOGRAM_BUCKETS - 1 ? s->max_wait_ut : lock_profile_histogram_bucket_max_ut(b);
+    }
+
+    return s->max_wait_ut;
+}
+
+static void lock_contention_add_number_field(BUFFER *wb, size_t field_id, const char *key, const char *name,
+                                             size_t decimal_points, const char *units, double max, RRDF_FIELD_OPTIONS options) {
+    buffer_rrdf_table_add_field(wb, field_id, key, name,
+            RRDF_FIELD_TYPE_BAR_WITH_INTEGER, RRDF_FIELD_VISUAL_BAR, RRDF_FIELD_TRANSFORM_NUMBER,
+            decimal_points, units, max, RRDF_FIELD_SORT_DESCENDING, NULL,
+            RRDF_FIELD_SUMMARY_SUM, RRDF_FIELD_FILTER_NONE,
+            options, NULL);
+}
+
+static int lock_contention_function(BUFFER *wb, const char *function __maybe_unused, BUFFER *payload __maybe_unused, const char *source __maybe_unused) {
+    buffer_flush(wb);
+    wb->content_type = CT_APPLICATION_JSON;
+    buffer_json_initialize(wb, "\"", "\"", 0, true, BUFFER_JSON_OPTIONS_DEFAULT);
+
+    buffer_json_member_add_string(wb, "hostname", rrdhost_hostname(localhost));
+    buffer_json_member_add_uint64(wb, "status", HTTP_RESP_OK);
+    buffer_json_member_add_string(wb, "type", "table");
+    buffer_json_member_add_time_t(wb, "update_every", 1);
+    buffer_json_member_add_boolean(wb, "has_history", false);
+    buffer_json_member_add_string(wb, "help", RRDFUNCTIONS_LOCK_CONTENTION_HELP);
+    buffer_json_member_add_array(wb, "data");
+
+    double max_acquisitions = 0.0, max_contended = 0.0, max_contention = 0.0, max_spins = 0.0;
+    double max_wait = 0.0, max_avg_wait = 0.0, max_p50 = 0.0, max_p99 = 0.0, max_max_wait = 0.0;
+
+    size_t entries = 0;
+    LOCK_PROFILE_SITE *sites = lock_profiling_sites(&entries);
+    for(size_t i = 0; i < entries; i++) {
+        LOCK_PROFILE_SITE *s = &sites[i];
+
+        char site[FILENAME_MAX + 50];
+        snprintfz(site, sizeof(site), "%s:%u (%s)", s->file, s->line, lock_profile_type_to_string(s->type));
+
+        double contention = s->acquisitions ? (double)s->contended * 100.0 / (double)s->acquisitions : 0.0;
+        double wait_ms = (double)s->wait_ut / (double)USEC_PER_MS;
+        double avg_wait = s->contended ? (double)s->wait_ut / (double)s->contended : 0.0;
+        double p50 = (double)lock_site_wait_percentile_ut(s, 50.0);
+        double p99 = (double)lock_site_wait_percentile_ut(s, 99.0);
+
+        max_acquisitions = MAX(max_acquisitions, (double)s->acquisitions);
+        max_contended = MAX(max_contended, (double)s->contended);
+        max_contention = MAX(max_contention, contention);
+        max_spins = MAX(max_spins, (double)s->spins);
+        max_wait = MAX(max_wait, wait_ms);
+        max_avg_wait = MAX(max_avg_wait, avg_wait);
+        max_p50 = MAX(max_p50, p50);
+        max_p99 = MAX(max_p99, p99);
+        max_max_wait = MAX(max_max_wait, (double)s->max_wait_ut);
+
+        buffer_json_add_array_item_array(wb);
+        buffer_json_add_array_item_string(wb, site);
+        buffer_json_add_array_item_string(wb, s->func);
+        buffer_json_add_array_item_string(wb, lock_profile_type_to_string(s->type));
+        buffer_json_add_array_item_uint64(wb, s->acquisitions);
+        buffer_json_add_array_item_uint64(wb, s->contended);
+        buffer_json_add_array_item_double(wb, contention);
+        buffer_json_add_array_item_uint64(wb, s->spins);
+        buffer_json_add_array_item_double(wb, wait_ms);
+        buffer_json_add_array_item_double(wb, avg_wait);
+        buffer_json_add_array_item_double(wb, p50);
+        buffer_json_add_array_item_double(wb, p99);
+        buffer_json_add_array_item_uint64(wb, s->max_wait_ut);
+        buffer_json_array_close(wb);
+    }
+    freez(sites);
+
+    buffer_json_array_close(wb); // data
+    buffer_json_member_add_object(wb, "columns");
+    {
+        size_t field_id = 0;
+
+        buffer_rrdf_table_add_field(wb, field_id++, "Site", "Lock Site",
+                RRDF_FIELD_TYPE_STRING, RRDF_FIELD_VISUAL_VALUE, RRDF_FIELD_TRANSFORM_NONE,
+                0, NULL, NAN, RRDF_FIELD_SORT_ASCENDING, NULL,
+                RRDF_FIELD_SUMMARY_COUNT, RRDF_FIELD_FILTER_MULTISELECT,
+                RRDF_FIELD_OPTS_VISIBLE | RRDF_FIELD_OPTS_UNIQUE_KEY | RRDF_FIELD_OPTS_STICKY | RRDF_FIELD_OPTS_FULL_WIDTH,
+                NULL);
+        buffer_rrdf_table_add_field(wb, field_id++, "Function", "Function Acquiring the Lock",
+                RRDF_FIELD_TYPE_STRING, RRDF_FIELD_VISUAL_VALUE, RRDF_FIELD_TRANSFORM_NONE,
+                0, NULL, NAN, RRDF_FIELD_SORT_ASCENDING, NULL,
+                RRDF_FIELD_SUMMARY_COUNT, RRDF_FIELD_FILTER_MULTISELECT,
+                RRDF_FIELD_OPTS_VISIBLE,
+                NULL);
+        buffer_rrdf_table_add_field(wb, field_id++, "Type", "Lock Type",
+                RRDF_FIELD_TYPE_STRING, RRDF_FIELD_VISUAL_VALUE, RRDF_FIELD_TRANSFORM_NONE,
+                0, NULL, NAN, RRDF_FIELD_SORT_ASCENDING, NULL,
+                RRDF_FIELD_SUMMARY_COUNT, RRDF_FIELD_FILTER_MULTISELECT,
+                RRDF_FIELD_OPTS_VISIBLE,
+                NULL);
+
+        lock_contention_add_number_field(wb, field_id++, "Acquisitions", "Acquisitions", 0, "locks", max_acquisitions, RRDF_FIELD_OPTS_VISIBLE);
+        lock_contention_add_number_field(wb, field_id++, "Contended", "Contended Acquisitions", 0, "locks", max_contended, RRDF_FIELD_OPTS_VISIBLE);
+        lock_contention_add_number_field(wb, field_id++, "Contention", "Contended Acquisitions Percentage", 2, "%", max_contention, RRDF_FIELD_OPTS_VISIBLE);
+        lock_contention_add_number_field(wb, field_id++, "Spins", "Failed Acquisition Attempts", 0, "spins", max_spins, RRDF_FIELD_OPTS_NONE);
+        lock_contention_add_number_field(wb, field_id++, "Wait", "Total Wait Time", 2, "ms", max_wait, RRDF_FIELD_OPTS_VISIBLE);
+        lock_contention_add_number_field(wb, field_id++, "AvgWait", "Average Wait Time of Contended Acquisitions", 2, "usec", max_avg_wait, RRDF_FIELD_OPTS_VISIBLE);
+        lock_contention_add_number_field(wb, field_id++, "P50Wait", "50th Percentile Wait Time of Contended Acquisitions (upper bound)", 0, "usec", max_p50, RRDF_FIELD_OPTS_NONE);
+        lock_contention_add_number_field(wb, field_id++, "P99Wait", "99th Percentile Wait Time of Contended Acquisitions (upper bound)", 0, "usec", max_p99, RRDF_FIELD_OPTS_VISIBLE);
+        lock_contention_add_number_field(wb, field_id++, "MaxWait", "Maximum Wait Time", 0, "usec", max_max_wait, RRDF_FIELD_OPTS_VISIBLE);
+    }
+    buffer_json_object_close(wb); // columns
+    buffer_json_member_add_string(wb, "default_sort_column", "Wait");
+
+    buffer_json_member_add_object(wb, "charts");
+    {
+        buffer_json_member_add_object(wb, "Wait");
+        {
+            buffer_json_member_add_string(wb, "name", "Total Wait Time");
+            buffer_json_member_add_string(wb, "type", "stacked-bar");
+            buffer_json_member_add_array(wb, "columns");
+            {
+                buffer_json_add_array_item_string(wb, "Wait");
+            }
+            buffer_json_array_close(wb);
+        }
+        buffer_json_object_close(wb);
+
+        buffer_json_member_add_object(wb, "Acquisitions");
+        {
+            buffer_json_member_add_string(wb, "name", "Acquisitions");
+            buffer_json_member_add_string(wb, "type", "stacked-bar");
+            buffer_json_member_add_array(wb, "columns");
+            {
+                buffer_json_add_array_item_string(wb, "Acquisitions");
+                buffer_json_add_array_item_string(wb, "Contended");
+            }
+            buffer_json_array_close(wb);
+        }
+        buffer_json_object_close(wb);
+    }
+    buffer_json_object_close(wb); // charts
+
+    buffer_json_member_add_array(wb, "default_charts");
+    {
+        buffer_json_add_array_item_array(wb);
+        buffer_json_add_array_item_string(wb, "Wait");
+        buffer_json_add_array_item_string(wb, "Function");
+        buffer_json_array_close(wb);
+    }
+    buffer_json_array_close(wb);
+
+    buffer_json_member_add_time_t(wb, "expires", now_realtime_sec() + 1);
+    buffer_json_finalize(wb);
+
+    return HTTP_RESP_OK;
+}
+
+void pulse_locks_init(void) {
+    if(!lock_profiling_is_enabled())
+        return;
+
+    rrd_function_add_inline(localhost, NULL, "lock-contention", 10,
+                            RRDFUNCTIONS_PRIORITY_DEFAULT, RRDFUNCTIONS_VERSION_DEFAULT,
+                            RRDFUNCTIONS_LOCK_CONTENTION_HELP,
+                            "top", HTTP_ACCESS_ANONYMOUS_DATA,
+                            lock_contention_function);
+}
+
+void pulse_locks_do(bool extended __maybe_unused) {
+    if(!lock_profiling_is_enabled())
+        return;
+
+    LOCK_PROFILE_TOTALS t;
+    lock_profiling_totals(&t);
+
+    {
+        static RRDSET *st = NULL;
+        static RRDDIM *rd_acquisitions = NULL, *rd_contended = NULL, *rd_dropped = NULL;
+
+        if (unlikely(!st)) {
+            st = rrdset_create_localhost(
+                "netdata"
+                , "lock_acquisitions"
+                , NULL
+                , "locks"
+                , NULL
+                , "Spinlock Acquisitions"
+                , "locks/s"
+                , "netdata"
+                , "pulse"
+                , 920100
+                , localhost->rrd_update_every
+                , RRDSET_TYPE_LINE);
+
+            rd_acquisitions = rrddim_add(st, "acquisitions", NULL, 1, 1, RRD_ALGORITHM_INCREMENTAL);
+            rd_contended    = rrddim_add(st, "contended",    NULL, 1, 1, RRD_ALGORITHM_INCREMENTAL);
+            rd_dropped      = rrddim_add(st, "untracked",    NULL, 1, 1, RRD_ALGORITHM_INCREMENTAL);
+        }
+
+        rrddim_set_by_pointer(st, rd_acquisitions, (collected_number)t.acquisitions);
+        rrddim_set_by_pointer(st, rd_contended, (collected_number)t.contended);
+        rrddim_set_by_pointer(st, rd_dropped, (collected_number)t.dropped);
+        rrdset_done(st);
+    }
+
+    {
+        static RRDSET *st = NULL;
+        static RRDDIM *rd_wait = NULL;
+
+        if (unlikely(!st)) {
+            st = rrdset_create_localhost(
+                "netdata"
+                , "lock_wait"
+                , NULL
+                , "locks"
+                , NULL
+                , "Time Spent Waiting for Spinlocks"
+                , "milliseconds/s"
+                , "netdata"
+                , "pulse"
+                , 920101
+                , localhost->rrd_update_every
+                , RRDSET_TYPE_AREA);
+
+            rd_wait = rrddim_add(st, "wait", NULL, 1, USEC_PER_MS, RRD_ALGORITHM_INCREMENTAL);
+        }
+
+        rrddim_set_by_pointer(st, rd_wait, (collected_number)t.wait_ut);
+        rrdset_done(st);
+    }
+}
@@ -0,0 +1,13 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef NETDATA_PULSE_LOCKS_H
+#define NETDATA_PULSE_LOCKS_H
+
+#include "daemon/common.h"
+
+#if defined(PULSE_INTERNALS)
+void pulse_locks_init(void);
+void pulse_locks_do(bool extended);
+#endif
+
+#endif //NETDATA_PULSE_LOCKS_H
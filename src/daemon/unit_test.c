@@ -1453,6 +1453,114 @@ int check_strdupz_path_subpath() {
     return 0;
 }
 
+static int test_dimensions_budget(void) {
+    fprintf(stderr, "%s() running...\n", __FUNCTION__ );
+
+    int errors = 0;
+    default_rrd_memory_mode = RRD_DB_MODE_ALLOC;
+
+    // the plugin has a budget of 3 dimensions
+    rrddim_budget_init(3);
+
+    RRDSET *st = rrdset_create_localhost("netdata", "unittest-budget", NULL, "netdata", NULL, "Unit Testing", "a value", "unittest-budget", NULL, 1, 1, RRDSET_TYPE_LINE);
+
+    RRDDIM *rd1 = rrddim_add(st, "dim1", NULL, 1, 1, RRD_ALGORITHM_ABSOLUTE);
+    RRDDIM *rd2 = rrddim_add(st, "dim2", NULL, 1, 1, RRD_ALGORITHM_ABSOLUTE);
+    RRDDIM *rd3 = rrddim_add(st, "dim3", NULL, 1, 1, RRD_ALGORITHM_ABSOLUTE);
+
+    // over the budget: absolute dimensions with the same multiplier and divisor are aggregated
+    RRDDIM *rd4 = rrddim_add(st, "dim4", NULL, 1, 1, RRD_ALGORITHM_ABSOLUTE);
+    RRDDIM *rd5 = rrddim_add(st, "dim5", NULL, 1, 1, RRD_ALGORITHM_ABSOLUTE);
+
+    // over the budget: counters and dimensions with a different multiplier are refused aggregation
+    RRDDIM *rd6 = rrddim_add(st, "dim6", NULL, 1, 1, RRD_ALGORITHM_INCREMENTAL);
+    RRDDIM *rd7 = rrddim_add(st, "dim7", NULL, 8, 1, RRD_ALGORITHM_ABSOLUTE);
+
+    if(rd1 == rd2 || rd2 == rd3 || strcmp(rrddim_id(rd3), "dim3") != 0) {
+        fprintf(stderr, "    dimensions within the budget are not created as usual, ### E R R O R ###\n");
+        errors++;
+    }
+
+    if(rd4 != rd5 || strcmp(rrddim_id(rd4), RRDDIM_BUDGET_OVERFLOW_ID) != 0 || rd4->algorithm != RRD_ALGORITHM_ABSOLUTE) {
+        fprintf(stderr, "    absolute dimensions over the budget are not aggregated, ### E R R O R ###\n");
+        errors++;
+    }
+
+    if(rd6 == rd4 || strcmp(rrddim_id(rd6), "dim6") != 0 || rd6->algorithm != RRD_ALGORITHM_INCREMENTAL) {
+        fprintf(stderr, "    an incremental dimension over the budget is aggregated, ### E R R O R ###\n");
+        errors++;
+    }
+
+    if(rd7 == rd4 || strcmp(rrddim_id(rd7), "dim7") != 0 || rd7->multiplier != 8) {
+        fprintf(stderr, "    a dimension with a different multiplier over the budget is aggregated, ### E R R O R ###\n");
+        errors++;
+    }
+
+    if(__atomic_load_n(&st->cost.dimensions_aggregated, __ATOMIC_RELAXED) != 2 ||
+       __atomic_load_n(&st->cost.dimensions_refused, __ATOMIC_RELAXED) != 2) {
+        fprintf(stderr, "    expected 2 aggregated and 2 refused dimensions, found %u and %u, ### E R R O R ###\n",
+                st->cost.dimensions_aggregated, st->cost.dimensions_refused);
+        errors++;
+    }
+
+    // a plugin sending an aggregated dimension again does not count it again
+    if(rrddim_add(st, "dim4", NULL, 1, 1, RRD_ALGORITHM_ABSOLUTE) != rd4 ||
+       __atomic_load_n(&st->cost.dimensions_aggregated, __ATOMIC_RELAXED) != 2) {
+        fprintf(stderr, "    an aggregated dimension added again is counted again, ### E R R O R ###\n");
+        errors++;
+    }
+
+    // the collector of a member cannot rename, hide or obsolete the aggregated dimension
+    rrddim_reset_name(st, rd4, "renamed");
+    rrddim_hide(st, "dim5");
+    rrddim_is_obsolete___safe_from_collector_thread(st, rd4);
+    if(strcmp(rrddim_name(rd4), RRDDIM_BUDGET_OVERFLOW_NAME) != 0 ||
+       rrddim_option_check(rd4, RRDDIM_OPTION_HIDDEN) ||
+       rrddim_flag_check(rd4, RRDDIM_FLAG_OBSOLETE)) {
+        fprintf(stderr, "    a member changed the aggregated dimension, ### E R R O R ###\n");
+        errors++;
+    }
+
+    // the values of the aggregated dimensions are summed on each iteration
+    rrddim_set_by_pointer(st, rd1, 1);
+    rrddim_set_by_pointer(st, rd4, 10);
+    rrddim_set(st, "dim5", 5);
+    rrdset_done(st);
+
+    if(rd4->collector.last_collected_value != 15) {
+        fprintf(stderr, "    aggregated dimension collected " COLLECTED_NUMBER_FORMAT ", expected 15, ### E R R O R ###\n",
+                rd4->collector.last_collected_value);
+        errors++;
+    }
+
+    // a member that is not updated is not summed
+    rrddim_set_by_pointer(st, rd1, 1);
+    rrddim_set_by_pointer(st, rd4, 7);
+    rrdset_done(st);
+
+    if(rd4->collector.last_collected_value != 7) {
+        fprintf(stderr, "    aggregated dimension collected " COLLECTED_NUMBER_FORMAT ", expected 7, ### E R R O R ###\n",
+                rd4->collector.last_collected_value);
+        errors++;
+    }
+
+    // the dimensions of other charts of the plugin are accounted too
+    RRDSET *st2 = rrdset_create_localhost("netdata", "unittest-budget2", NULL, "netdata", NULL, "Unit Testing", "a value", "unittest-budget", NULL, 1, 1, RRDSET_TYPE_LINE);
+    RRDDIM *rd8 = rrddim_add(st2, "dim8", NULL, 1, 1, RRD_ALGORITHM_ABSOLUTE);
+    if(strcmp(rrddim_id(rd8), RRDDIM_BUDGET_OVERFLOW_ID) != 0) {
+        fprintf(stderr, "    the budget is not shared by the charts of the plugin, ### E R R O R ###\n");
+        errors++;
+    }
+
+    rrddim_budget_init(0);
+
+    rrdset_is_obsolete___safe_from_collector_thread(st);
+    rrdset_is_obsolete___safe_from_collector_thread(st2);
+
+    fprintf(stderr, "%s() %s\n", __FUNCTION__, errors ? "FAILED" : "OK");
+    return errors;
+}
+
 int run_all_mockup_tests(void)
 {
     fprintf(stderr, "%s() running...\n", __FUNCTION__ );
@@ -1468,6 +1576,9 @@ int run_all_mockup_tests(void)
     if(!test_variable_renames())
         return 1;
 
+    if(test_dimensions_budget())
+        return 1;
+
     if(run_test(&test1))
         return 1;
 
@@ -1057,6 +1057,9 @@ static void contexts_v2_search_results_to_json(BUFFER *wb, struct rrdcontext_to_
         buffer_json_object_close(wb);
         
         contexts_count++;
+
+        if(unlikely(!buffer_drain_checkpoint(wb)))
+            break;
     }
     dfe_done(z);
 
@@ -1194,6 +1197,9 @@ static void contexts_v2_contexts_to_json(BUFFER *wb, struct rrdcontext_to_json_v
             }
 
             contexts_count++;
+
+            if(unlikely(!buffer_drain_checkpoint(wb)))
+                break;
         }
         dfe_done(z);
 
@@ -1395,6 +1401,9 @@ int rrdcontext_to_json_v2(BUFFER *wb, struct api_v2_contexts_request *req, CONTE
             struct contexts_v2_node *t;
             dfe_start_read(ctl.nodes.dict, t) {
                 rrdcontext_to_json_v2_rrdhost(wb, t->host, &ctl, t->ni);
+
+                if(unlikely(!buffer_drain_checkpoint(wb)))
+                    break;
             }
             dfe_done(t);
             buffer_json_array_close(wb);
@@ -231,6 +231,7 @@ typedef struct query_target_locals {
 
     char host_node_id_str[UUID_STR_LEN];
     QUERY_NODE *qn; // temp to pass on callbacks, ignore otherwise - no need to free
+    RRDCONTEXT_LABELS_MATCH *labels_match; // temp to pass on callbacks, the instances of the context matching the labels filter
 } QUERY_TARGET_LOCALS;
 
 struct storage *query_metric_storage_engine(QUERY_TARGET *qt, QUERY_METRIC *qm, size_t tier) {
@@ -770,8 +771,12 @@ static inline SIMPLE_PATTERN_RESULT query_instance_matches(QUERY_INSTANCE *qi,
 static inline bool query_instance_matches_labels(
     RRDINSTANCE *ri,
     SIMPLE_PATTERN *chart_label_key_sp,
-    struct pattern_array *labels_pa)
+    struct pattern_array *labels_pa,
+    RRDCONTEXT_LABELS_MATCH *m)
 {
+    if (m && m->indexed)
+        return rrdcontext_labels_match_has_instance(m, ri);
+
     RRDLABELS *labels = rrdinstance_labels(ri);
     if (chart_label_key_sp && rrdlabels_match_simple_pattern_parsed(labels, chart_label_key_sp, '\0', NULL) != SP_MATCHED_POSITIVE)
         return false;
@@ -803,7 +808,8 @@ static bool query_instance_add(QUERY_TARGET_LOCALS *qtl, QUERY_NODE *qn, QUERY_C
         queryable_instance = query_instance_matches_labels(
             ri,
             qt->instances.chart_label_key_pattern,
-            qt->instances.labels_pa);
+            qt->instances.labels_pa,
+            qtl->labels_match);
 
     if(queryable_instance) {
         if(qt->instances.alerts_pattern && !query_target_match_alert_pattern(ria, qt->instances.alerts_pattern))
@@ -895,7 +901,7 @@ static ssize_t query_scope_foreach_instance(QUERY_TARGET_LOCALS *qtl, QUERY_NODE
         if(qt->instances.scope_labels_pa || qt->instances.scope_chart_label_key_pattern) {
             if(!query_instance_matches_labels(ri,
                 qt->instances.scope_chart_label_key_pattern,
-                qt->instances.scope_labels_pa))
+                qt->instances.scope_labels_pa, NULL))
                 return 0;
         }
         
@@ -921,7 +927,7 @@ static ssize_t query_scope_foreach_instance(QUERY_TARGET_LOCALS *qtl, QUERY_NODE
         if(qt->instances.scope_labels_pa || qt->instances.scope_chart_label_key_pattern) {
             if(!query_instance_matches_labels(ri,
                 qt->instances.scope_chart_label_key_pattern,
-                qt->instances.scope_labels_pa))
+                qt->instances.scope_labels_pa, NULL))
                 return 0;
         }
         
@@ -930,6 +936,28 @@ static ssize_t query_scope_foreach_instance(QUERY_TARGET_LOCALS *qtl, QUERY_NODE
     }
     else {
         // Pattern query - iterate through all instances
+
+        // resolve the label filters once for the whole context, using its labels index
+        RRDCONTEXT_LABELS_MATCH scope_labels_match, labels_match;
+
+        rrdcontext_labels_index_match(rc,
+            qt->instances.scope_chart_label_key_pattern,
+            qt->instances.scope_labels_pa,
+            &scope_labels_match);
+
+        if(scope_labels_match.indexed && !scope_labels_match.entries) {
+            // no instance of this context is in scope
+            rrdcontext_labels_match_cleanup(&scope_labels_match);
+            return 0;
+        }
+
+        rrdcontext_labels_index_match(rc,
+            qt->instances.chart_label_key_pattern,
+            qt->instances.labels_pa,
+            &labels_match);
+
+        qtl->labels_match = &labels_match;
+
         RRDINSTANCE *ri;
         dfe_start_read(rc->rrdinstances, ri) {
             if(rrd_flag_is_deleted(ri))
@@ -952,7 +980,8 @@ static ssize_t query_scope_foreach_instance(QUERY_TARGET_LOCALS *qtl, QUERY_NODE
             if(qt->instances.scope_labels_pa || qt->instances.scope_chart_label_key_pattern) {
                 if(!query_instance_matches_labels(ri,
                     qt->instances.scope_chart_label_key_pattern,
-                    qt->instances.scope_labels_pa))
+                    qt->instances.scope_labels_pa,
+                    &scope_labels_match))
                     continue;
             }
             
@@ -960,6 +989,10 @@ static ssize_t query_scope_foreach_instance(QUERY_TARGET_LOCALS *qtl, QUERY_NODE
                 added++;
         }
         dfe_done(ri);
+
+        qtl->labels_match = NULL;
+        rrdcontext_labels_match_cleanup(&labels_match);
+        rrdcontext_labels_match_cleanup(&scope_labels_match);
     }
     
     return added;
@@ -1313,6 +1346,16 @@ ssize_t weights_foreach_rrdmetric_in_context(RRDCONTEXT_ACQUIRED *rca,
 
     bool proceed = true;
 
+    RRDCONTEXT_LABELS_MATCH scope_labels_match, labels_match;
+
+    rrdcontext_labels_index_match(rc, NULL, scope_labels_pa, &scope_labels_match);
+    if(scope_labels_match.indexed && !scope_labels_match.entries) {
+        rrdcontext_labels_match_cleanup(&scope_labels_match);
+        return 0;
+    }
+
+    rrdcontext_labels_index_match(rc, chart_label_key_sp, labels_pa, &labels_match);
+
     ssize_t count = 0;
     RRDINSTANCE *ri;
     dfe_start_read(rc->rrdinstances, ri) {
@@ -1333,7 +1376,7 @@ ssize_t weights_foreach_rrdmetric_in_context(RRDCONTEXT_ACQUIRED *rca,
                 
                 // Check scope_labels - if it doesn't match, skip entirely
                 if(scope_labels_pa) {
-                    if(!query_instance_matches_labels(ri, NULL, scope_labels_pa))
+                    if(!query_instance_matches_labels(ri, NULL, scope_labels_pa, &scope_labels_match))
                         continue;
                 }
 
@@ -1346,7 +1389,7 @@ ssize_t weights_foreach_rrdmetric_in_context(RRDCONTEXT_ACQUIRED *rca,
                         continue;
                 }
 
-                if(!query_instance_matches_labels(ri, chart_label_key_sp, labels_pa))
+                if(!query_instance_matches_labels(ri, chart_label_key_sp, labels_pa, &labels_match))
                     continue;
 
                 if(alerts_sp && !query_target_match_alert_pattern(ria, alerts_sp))
@@ -1404,6 +1447,9 @@ ssize_t weights_foreach_rrdmetric_in_context(RRDCONTEXT_ACQUIRED *rca,
                     break;
             }
     dfe_done(ri);
-    
+
+    rrdcontext_labels_match_cleanup(&labels_match);
+    rrdcontext_labels_match_cleanup(&scope_labels_match);
+
     return count;
 }
@@ -84,6 +84,7 @@ static void rrdcontext_insert_callback(const DICTIONARY_ITEM *item __maybe_unuse
 
     rrdinstances_create_in_rrdcontext(rc);
     spinlock_init(&rc->spinlock);
+    rw_spinlock_init(&rc->labels_index.spinlock);
 
     // update the count of contexts
     __atomic_add_fetch(&rc->rrdhost->rrdctx.contexts_count, 1, __ATOMIC_RELAXED);
@@ -106,6 +107,7 @@ static void rrdcontext_delete_callback(const DICTIONARY_ITEM *item __maybe_unuse
     rrdcontext_del_from_pp_queue(rc, false);
 
     rrdinstances_destroy_from_rrdcontext(rc);
+    rrdcontext_labels_index_destroy(rc);
     rrdcontext_freez(rc);
 }
 
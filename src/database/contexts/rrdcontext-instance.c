@@ -133,6 +133,10 @@ static void rrdinstance_insert_callback(const DICTIONARY_ITEM *item __maybe_unus
 
     // update the count of instances
     __atomic_add_fetch(&ri->rc->rrdhost->rrdctx.instances_count, 1, __ATOMIC_RELAXED);
+    rrdcontext_labels_index_track(ri->rc, ri->rrdlabels);
+    if(ri->rrdset)
+        rrdcontext_labels_index_track(ri->rc, ri->rrdset->rrdlabels);
+    rrdcontext_labels_index_invalidate(ri->rc);
 
     // signal the react callback to do the job
     rrd_flag_set_updated(ri, RRD_FLAG_UPDATE_REASON_NEW_OBJECT);
@@ -145,6 +149,10 @@ static void rrdinstance_delete_callback(const DICTIONARY_ITEM *item __maybe_unus
 
     // update the count of instances
     __atomic_sub_fetch(&ri->rc->rrdhost->rrdctx.instances_count, 1, __ATOMIC_RELAXED);
+    rrdcontext_labels_index_untrack(ri->rc, ri->rrdlabels);
+    if(ri->rrdset)
+        rrdcontext_labels_index_untrack(ri->rc, ri->rrdset->rrdlabels);
+    rrdcontext_labels_index_invalidate(ri->rc);
 
     rrdinstance_free(ri);
 }
@@ -208,6 +216,7 @@ static bool rrdinstance_conflict_callback(const DICTIONARY_ITEM *item __maybe_un
     if(ri_new->rrdset && ri->rrdset != ri_new->rrdset) {
         ri->rrdset = ri_new->rrdset;
         rrd_flag_set_updated(ri, RRD_FLAG_UPDATE_REASON_CHANGED_LINKING);
+        rrdcontext_labels_index_track(ri->rc, ri->rrdset->rrdlabels);
     }
 
     if(ri->rrdset) {
@@ -238,6 +247,11 @@ static bool rrdinstance_conflict_callback(const DICTIONARY_ITEM *item __maybe_un
 static void rrdinstance_react_callback(const DICTIONARY_ITEM *item __maybe_unused, void *value, void *rrdcontext __maybe_unused) {
     RRDINSTANCE *ri = value;
 
+    // the insert callback runs before the instance can be found in the context,
+    // so an index built in between would not have it - invalidate it again now
+    if(rrd_flag_check(ri, RRD_FLAG_UPDATE_REASON_NEW_OBJECT))
+        rrdcontext_labels_index_invalidate(ri->rc);
+
     rrdinstance_trigger_updates(ri, __FUNCTION__ );
 }
 
@@ -361,11 +375,14 @@ inline void rrdinstance_from_rrdset(RRDSET *st) {
         rrddim_foreach_done(rd);
 
         // mark the old instance, ready to be deleted
-        if(!rrd_flag_check(ri_old, RRD_FLAG_OWN_LABELS))
+        if(!rrd_flag_check(ri_old, RRD_FLAG_OWN_LABELS)) {
             ri_old->rrdlabels = rrdlabels_create();
+            rrdcontext_labels_index_track(ri_old->rc, ri_old->rrdlabels);
+        }
 
         rrdinstance_set_deleted_overwrite(ri_old, RRD_FLAG_UPDATED|RRD_FLAG_OWN_LABELS|RRD_FLAG_LIVE_RETENTION|RRD_FLAG_UPDATE_REASON_UNUSED|RRD_FLAG_UPDATE_REASON_ZERO_RETENTION);
         ri_old->rrdset = NULL;
+        rrdcontext_labels_index_invalidate(ri_old->rc);
         ri_old->first_time_s = 0;
         ri_old->last_time_s = 0;
 
@@ -436,6 +453,7 @@ inline void rrdinstance_rrdset_is_freed(RRDSET *st) {
     rrd_flag_set(ri, RRD_FLAG_OWN_LABELS);
 
     ri->rrdset = NULL;
+    rrdcontext_labels_index_invalidate(ri->rc);
 
     rrdinstance_trigger_updates(ri, __FUNCTION__ );
 
@@ -258,6 +258,15 @@ typedef struct rrdinstance {
     } internal;
 } RRDINSTANCE;
 
+typedef struct rrdcontext_labels_index {
+    RW_SPINLOCK spinlock;
+    uint32_t version;                   // incremented when instances are added, deleted, re-linked or their labels change
+    uint32_t built_version;             // the version the index was built with
+    bool built;
+    bool usable;                        // false when some instances cannot be represented in the index
+    Pvoid_t JudyL;                      // STRING *key -> STRING *value -> STRING *instance id
+} RRDCONTEXT_LABELS_INDEX;
+
 typedef struct rrdcontext {
     uint64_t version;
 
@@ -279,6 +288,8 @@ typedef struct rrdcontext {
     DICTIONARY *rrdinstances;
     RRDHOST *rrdhost;
 
+    RRDCONTEXT_LABELS_INDEX labels_index;   // built on demand, by queries filtering instances by labels
+
     struct {
         Word_t idx;
         RRD_FLAGS queued_flags;         // the last flags that triggered the post-processing
@@ -465,6 +476,23 @@ void rrdcontext_trigger_updates(RRDCONTEXT *rc, const char *function);
 void rrdinstances_create_in_rrdcontext(RRDCONTEXT *rc);
 void rrdinstances_destroy_from_rrdcontext(RRDCONTEXT *rc);
 
+// ----------------------------------------------------------------------------
+// labels index of RRDCONTEXT
+
+typedef struct rrdcontext_labels_match {
+    bool indexed;                       // when false, the labels of each instance have to be checked
+    size_t entries;                     // the number of instances matched
+    Pvoid_t JudyL;                      // STRING *instance id -> 1 (the ids are referenced)
+} RRDCONTEXT_LABELS_MATCH;
+
+void rrdcontext_labels_index_invalidate(RRDCONTEXT *rc);
+void rrdcontext_labels_index_track(RRDCONTEXT *rc, RRDLABELS *labels);
+void rrdcontext_labels_index_untrack(RRDCONTEXT *rc, RRDLABELS *labels);
+void rrdcontext_labels_index_destroy(RRDCONTEXT *rc);
+void rrdcontext_labels_index_match(RRDCONTEXT *rc, SIMPLE_PATTERN *chart_label_key_sp, struct pattern_array *labels_pa, RRDCONTEXT_LABELS_MATCH *m);
+bool rrdcontext_labels_match_has_instance(RRDCONTEXT_LABELS_MATCH *m, RRDINSTANCE *ri);
+void rrdcontext_labels_match_cleanup(RRDCONTEXT_LABELS_MATCH *m);
+
 void rrdmetrics_destroy_from_rrdinstance(RRDINSTANCE *ri);
 void rrdmetrics_create_in_rrdinstance(RRDINSTANCE *ri);
 
@@ -0,0 +1,543 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "rrdcontext-internal.h"
+
+// ----------------------------------------------------------------------------
+// inverted index of instance labels, per context
+//
+// key STRING -> value STRING -> set of instance id STRINGs
+//
+// The index is built lazily, the first time a context is queried with label
+// filters, and it is rebuilt when the version of the context changed: when
+// instances of the context were added (once they are visible in the context),
+// removed or re-linked to charts (rrdcontext_labels_index_invalidate()),
+// or when the labels of any of its
+// instances changed (the labels of the instances increment the version
+// themselves, see rrdcontext_labels_index_track()).
+//
+// Matching against the index is exact: when a pattern cannot be resolved
+// with set operations (negative terms, names matching the whole pattern),
+// the caller is told to scan the labels of each instance, as before.
+
+#define RRDCONTEXT_LABELS_INDEX_MIN_INSTANCES 16
+
+typedef struct rrdcontext_labels_index_key {
+    Pvoid_t values;                     // JudyL: STRING *value -> Pvoid_t (JudyL: STRING *instance id -> 1)
+} RRDCONTEXT_LABELS_INDEX_KEY;
+
+static void rrdcontext_labels_index_free_unsafe(RRDCONTEXT_LABELS_INDEX *idx) {
+    Pvoid_t *PValue;
+    Word_t key = 0;
+    bool key_first = true;
+    while((PValue = JudyLFirstThenNext(idx->JudyL, &key, &key_first))) {
+        RRDCONTEXT_LABELS_INDEX_KEY *k = *PValue;
+
+        Pvoid_t *PValue2;
+        Word_t value = 0;
+        bool value_first = true;
+        while((PValue2 = JudyLFirstThenNext(k->values, &value, &value_first))) {
+            Pvoid_t instances = *PValue2;
+
+            Word_t id = 0;
+            bool id_first = true;
+            while(JudyLFirstThenNext(instances, &id, &id_first))
+                string_freez((STRING *)id);
+
+            JudyLFreeArray(&instances, PJE0);
+            string_freez((STRING *)value);
+        }
+
+        JudyLFreeArray(&k->values, PJE0);
+        string_freez((STRING *)key);
+        freez(k);
+    }
+
+    JudyLFreeArray(&idx->JudyL, PJE0);
+    idx->built = false;
+    idx->usable = false;
+}
+
+struct rrdcontext_labels_index_add {
+    RRDCONTEXT_LABELS_INDEX *idx;
+    STRING *id;
+};
+
+static int rrdcontext_labels_index_add_label(STRING *name, STRING *value, RRDLABEL_SRC ls __maybe_unused, void *data) {
+    struct rrdcontext_labels_index_add *t = data;
+    RRDCONTEXT_LABELS_INDEX *idx = t->idx;
+
+    Pvoid_t *PValue = JudyLIns(&idx->JudyL, (Word_t)name, PJE0);
+    if(unlikely(!PValue || PValue == PJERR))
+        fatal("RRDCONTEXT: corrupted labels index JudyL array");
+
+    RRDCONTEXT_LABELS_INDEX_KEY *k = *PValue;
+    if(!k) {
+        k = callocz(1, sizeof(*k));
+        *PValue = k;
+        string_dup(name);
+    }
+
+    PValue = JudyLIns(&k->values, (Word_t)value, PJE0);
+    if(unlikely(!PValue || PValue == PJERR))
+        fatal("RRDCONTEXT: corrupted labels index values JudyL array");
+
+    if(!*PValue)
+        string_dup(value);
+
+    PValue = JudyLIns(PValue, (Word_t)t->id, PJE0);
+    if(unlikely(!PValue || PValue == PJERR))
+        fatal("RRDCONTEXT: corrupted labels index instances JudyL array");
+
+    if(!*PValue) {
+        string_dup(t->id);
+        *PValue = (void *)1;
+    }
+
+    return 1;
+}
+
+static void rrdcontext_labels_index_build_unsafe(RRDCONTEXT *rc, uint32_t version) {
+    RRDCONTEXT_LABELS_INDEX *idx = &rc->labels_index;
+
+    rrdcontext_labels_index_free_unsafe(idx);
+    idx->usable = true;
+
+    RRDINSTANCE *ri;
+    dfe_start_read(rc->rrdinstances, ri) {
+        RRDLABELS *labels = rrdinstance_labels(ri);
+        if(unlikely(!labels)) {
+            // pattern_array_label_match() accepts instances without labels,
+            // the index cannot represent that
+            idx->usable = false;
+            continue;
+        }
+
+        struct rrdcontext_labels_index_add t = {
+            .idx = idx,
+            .id = ri->id,
+        };
+        rrdlabels_walkthrough_read_string(labels, rrdcontext_labels_index_add_label, &t);
+    }
+    dfe_done(ri);
+
+    idx->built = true;
+    idx->built_version = version;
+}
+
+static inline bool rrdcontext_labels_index_is_fresh(RRDCONTEXT_LABELS_INDEX *idx, uint32_t version) {
+    return idx->built && idx->built_version == version;
+}
+
+static void rrdcontext_labels_index_refresh(RRDCONTEXT *rc) {
+    RRDCONTEXT_LABELS_INDEX *idx = &rc->labels_index;
+
+    // read the version before building, so that changes made
+    // while we build will trigger another rebuild next time
+    uint32_t version = __atomic_load_n(&idx->version, __ATOMIC_ACQUIRE);
+
+    rw_spinlock_read_lock(&idx->spinlock);
+    bool fresh = rrdcontext_labels_index_is_fresh(idx, version);
+    rw_spinlock_read_unlock(&idx->spinlock);
+
+    if(fresh)
+        return;
+
+    rw_spinlock_write_lock(&idx->spinlock);
+    if(!rrdcontext_labels_index_is_fresh(idx, version))
+        rrdcontext_labels_index_build_unsafe(rc, version);
+    rw_spinlock_write_unlock(&idx->spinlock);
+}
+
+void rrdcontext_labels_index_invalidate(RRDCONTEXT *rc) {
+    if(unlikely(!rc))
+        return;
+
+    __atomic_add_fetch(&rc->labels_index.version, 1, __ATOMIC_RELEASE);
+}
+
+// the labels of an instance of this context increment its version when they change
+// labels not tracked by any context (e.g. the temporary ones of queries) do not affect any index
+void rrdcontext_labels_index_track(RRDCONTEXT *rc, RRDLABELS *labels) {
+    if(unlikely(!rc || !labels))
+        return;
+
+    rrdlabels_set_changes_counter(labels, &rc->labels_index.version);
+    rrdcontext_labels_index_invalidate(rc);
+}
+
+void rrdcontext_labels_index_untrack(RRDCONTEXT *rc, RRDLABELS *labels) {
+    if(unlikely(!rc || !labels))
+        return;
+
+    rrdlabels_clear_changes_counter(labels, &rc->labels_index.version);
+}
+
+void rrdcontext_labels_index_destroy(RRDCONTEXT *rc) {
+    rw_spinlock_write_lock(&rc->labels_index.spinlock);
+    rrdcontext_labels_index_free_unsafe(&rc->labels_index);
+    rw_spinlock_write_unlock(&rc->labels_index.spinlock);
+}
+
+// ----------------------------------------------------------------------------
+// set operations on JudyL arrays of instance ids
+
+static void instances_set_union(Pvoid_t *dst, Pvoid_t src) {
+    Word_t id = 0;
+    bool first = true;
+    while(JudyLFirstThenNext(src, &id, &first)) {
+        Pvoid_t *PValue = JudyLIns(dst, id, PJE0);
+        if(unlikely(!PValue || PValue == PJERR))
+            fatal("RRDCONTEXT: corrupted labels match JudyL array");
+        *PValue = (void *)1;
+    }
+}
+
+static void instances_set_intersect(Pvoid_t *dst, Pvoid_t src) {
+    Word_t id = 0;
+    bool first = true;
+    while(JudyLFirstThenNext(*dst, &id, &first)) {
+        // JudyLNext() works even when the current index has been deleted
+        if(!JudyLGet(src, id, PJE0))
+            (void)JudyLDel(dst, id, PJE0);
+    }
+}
+
+static void instances_set_union_all_values(Pvoid_t *dst, RRDCONTEXT_LABELS_INDEX_KEY *k) {
+    Pvoid_t *PValue;
+    Word_t value = 0;
+    bool first = true;
+    while((PValue = JudyLFirstThenNext(k->values, &value, &first)))
+        instances_set_union(dst, *PValue);
+}
+
+// the instances having a label that matches the pattern
+// returns false when the result cannot be calculated from the index
+static bool rrdcontext_labels_index_pattern_unsafe(RRDCONTEXT_LABELS_INDEX *idx, SIMPLE_PATTERN *sp, char eq, Pvoid_t *set) {
+    const char *literal = simple_pattern_exact_literal(sp);
+    const char *sep = literal ? strchr(literal, eq) : NULL;
+
+    if(sep && (size_t)(sep - literal) <= RRDLABELS_MAX_NAME_LENGTH) {
+        // a single exact key:value term
+        // label names cannot contain the separator, so only this key:value pair can match
+
+        char key[RRDLABELS_MAX_NAME_LENGTH + 1];
+        strncpyz(key, literal, sep - literal);
+
+        STRING *k_str = string_strdupz(key);
+        STRING *v_str = string_strdupz(&sep[1]);
+
+        Pvoid_t *PValue = JudyLGet(idx->JudyL, (Word_t)k_str, PJE0);
+        if(PValue) {
+            RRDCONTEXT_LABELS_INDEX_KEY *k = *PValue;
+            PValue = JudyLGet(k->values, (Word_t)v_str, PJE0);
+            if(PValue)
+                instances_set_union(set, *PValue);
+        }
+
+        string_freez(k_str);
+        string_freez(v_str);
+        return true;
+    }
+
+    // evaluate the pattern against each distinct key:value pair
+    Pvoid_t *PValue;
+    Word_t key = 0;
+    bool key_first = true;
+    while((PValue = JudyLFirstThenNext(idx->JudyL, &key, &key_first))) {
+        RRDCONTEXT_LABELS_INDEX_KEY *k = *PValue;
+
+        Pvoid_t *PValue2;
+        Word_t value = 0;
+        bool value_first = true;
+        while((PValue2 = JudyLFirstThenNext(k->values, &value, &value_first))) {
+            SIMPLE_PATTERN_RESULT ret = rrdlabels_match_simple_pattern_pair(
+                sp, string2str((STRING *)key), string2str((STRING *)value), eq, NULL);
+
+            if(ret == SP_MATCHED_POSITIVE)
+                instances_set_union(set, *PValue2);
+
+            else if(ret != SP_NOT_MATCHED)
+                // the result depends on the order of the labels of each instance
+                return false;
+        }
+    }
+
+    return true;
+}
+
+// the instances having a label key that matches the pattern
+static void rrdcontext_labels_index_key_pattern_unsafe(RRDCONTEXT_LABELS_INDEX *idx, SIMPLE_PATTERN *sp, Pvoid_t *set) {
+    Pvoid_t *PValue;
+    Word_t key = 0;
+    bool first = true;
+    while((PValue = JudyLFirstThenNext(idx->JudyL, &key, &first))) {
+        if(rrdlabels_match_simple_pattern_pair(sp, string2str((STRING *)key), NULL, '\0', NULL) == SP_MATCHED_POSITIVE)
+            instances_set_union_all_values(set, *PValue);
+    }
+}
+
+static bool rrdcontext_labels_index_match_unsafe(RRDCONTEXT_LABELS_INDEX *idx, SIMPLE_PATTERN *chart_label_key_sp, struct pattern_array *labels_pa, Pvoid_t *result) {
+    bool first = true;
+
+    if(chart_label_key_sp) {
+        rrdcontext_labels_index_key_pattern_unsafe(idx, chart_label_key_sp, result);
+        first = false;
+    }
+
+    if(!labels_pa)
+        return true;
+
+    Pvoid_t *PValue;
+    Word_t Index = 0;
+    bool first_then_next = true;
+    while((PValue = JudyLFirstThenNext(labels_pa->JudyL, &Index, &first_then_next))) {
+        // for each label key in the pattern array - all of them have to match
+
+        if(!first && !*result)
+            break;
+
+        struct pattern_array *pai = *PValue;
+        Pvoid_t set = NULL;
+
+        Word_t Index2 = 0;
+        bool first_then_next2 = true;
+        while((PValue = JudyLFirstThenNext(pai->JudyL, &Index2, &first_then_next2))) {
+            // for each pattern in the label key pattern list - any of them may match
+            if(!*PValue)
+                continue;
+
+            if(!rrdcontext_labels_index_pattern_unsafe(idx, (SIMPLE_PATTERN *)*PValue, ':', &set)) {
+                JudyLFreeArray(&set, PJE0);
+                return false;
+            }
+        }
+
+        if(first) {
+            JudyLFreeArray(result, PJE0);
+            *result = set;
+            first = false;
+        }
+        else {
+            instances_set_intersect(result, set);
+            JudyLFreeArray(&set, PJE0);
+        }
+    }
+
+    return true;
+}
+
+void rrdcontext_labels_index_match(RRDCONTEXT *rc, SIMPLE_PATTERN *chart_label_key_sp, struct pattern_array *labels_pa, RRDCONTEXT_LABELS_MATCH *m) {
+    memset(m, 0, sizeof(*m));
+
+    if(!chart_label_key_sp && (!labels_pa || !labels_pa->JudyL))
+        return;
+
+    if(dictionary_entries(rc->rrdinstances) < RRDCONTEXT_LABELS_INDEX_MIN_INSTANCES)
+        return;
+
+    rrdcontext_labels_index_refresh(rc);
+
+    RRDCONTEXT_LABELS_INDEX *idx = &rc->labels_index;
+    Pvoid_t result = NULL;
+
+    rw_spinlock_read_lock(&idx->spinlock);
+
+    if(idx->built && idx->usable && rrdcontext_labels_index_match_unsafe(idx, chart_label_key_sp, labels_pa, &result)) {
+        // the ids are referenced by the index, make them ours
+        Word_t id = 0;
+        bool first = true;
+        while(JudyLFirstThenNext(result, &id, &first)) {
+            string_dup((STRING *)id);
+            m->entries++;
+        }
+
+        m->JudyL = result;
+        m->indexed = true;
+    }
+    else
+        JudyLFreeArray(&result, PJE0);
+
+    rw_spinlock_read_unlock(&idx->spinlock);
+}
+
+bool rrdcontext_labels_match_has_instance(RRDCONTEXT_LABELS_MATCH *m, RRDINSTANCE *ri) {
+    return JudyLGet(m->JudyL, (Word_t)ri->id, PJE0) != NULL;
+}
+
+void rrdcontext_labels_match_cleanup(RRDCONTEXT_LABELS_MATCH *m) {
+    Word_t id = 0;
+    bool first = true;
+    while(JudyLFirstThenNext(m->JudyL, &id, &first))
+        string_freez((STRING *)id);
+
+    JudyLFreeArray(&m->JudyL, PJE0);
+    m->entries = 0;
+    m->indexed = false;
+}
+
+// ----------------------------------------------------------------------------
+// unittest
+
+struct rrdcontext_labels_index_unittest_case {
+    const char *chart_label_key;
+    const char *labels[2][2];           // label key, pattern
+};
+
+static bool rrdcontext_labels_index_unittest_scan(RRDINSTANCE *ri, SIMPLE_PATTERN *chart_label_key_sp, struct pattern_array *labels_pa) {
+    // the same as query_instance_matches_labels() does without the index
+    RRDLABELS *labels = rrdinstance_labels(ri);
+    if (chart_label_key_sp && rrdlabels_match_simple_pattern_parsed(labels, chart_label_key_sp, '\0', NULL) != SP_MATCHED_POSITIVE)
+        return false;
+
+    if (labels_pa)
+        return pattern_array_label_match(labels_pa, labels, ':', NULL);
+
+    return true;
+}
+
+static int rrdcontext_labels_index_unittest_compare(RRDCONTEXT *rc, struct rrdcontext_labels_index_unittest_case *t, bool *indexed) {
+    int errors = 0;
+
+    SIMPLE_PATTERN *chart_label_key_sp = NULL;
+    if(t->chart_label_key)
+        chart_label_key_sp = simple_pattern_create(t->chart_label_key, SIMPLE_PATTERN_DEFAULT_WEB_SEPARATORS, SIMPLE_PATTERN_EXACT, true);
+
+    struct pattern_array *labels_pa = NULL;
+    for(size_t i = 0; i < _countof(t->labels) && t->labels[i][0]; i++)
+        labels_pa = pattern_array_add_key_simple_pattern(
+            labels_pa, t->labels[i][0],
+            simple_pattern_create(t->labels[i][1], SIMPLE_PATTERN_DEFAULT_WEB_SEPARATORS, SIMPLE_PATTERN_EXACT, true));
+
+    RRDCONTEXT_LABELS_MATCH m;
+    rrdcontext_labels_index_match(rc, chart_label_key_sp, labels_pa, &m);
+    *indexed = m.indexed;
+
+    size_t matched = 0;
+    RRDINSTANCE *ri;
+    dfe_start_read(rc->rrdinstances, ri) {
+        bool scan = rrdcontext_labels_index_unittest_scan(ri, chart_label_key_sp, labels_pa);
+        if(scan)
+            matched++;
+
+        if(m.indexed && rrdcontext_labels_match_has_instance(&m, ri) != scan) {
+            fprintf(stderr, "  instance '%s' is %s by the index, but %s by scanning its labels\n",
+                    string2str(ri->id),
+                    scan ? "not selected" : "selected",
+                    scan ? "selected" : "not selected");
+            errors++;
+        }
+    }
+    dfe_done(ri);
+
+    if(m.indexed && m.entries != matched) {
+        fprintf(stderr, "  the index selected %zu instances, scanning selected %zu\n", m.entries, matched);
+        errors++;
+    }
+
+    rrdcontext_labels_match_cleanup(&m);
+    pattern_array_free(labels_pa);
+    simple_pattern_free(chart_label_key_sp);
+
+    return errors;
+}
+
+int rrdcontext_labels_index_unittest(void) {
+    fprintf(stderr, "\n%s() tests\n", __FUNCTION__);
+
+    int errors = 0;
+
+    RRDCONTEXT *rc = callocz(1, sizeof(*rc));
+    rw_spinlock_init(&rc->labels_index.spinlock);
+    rc->rrdinstances = dictionary_create(DICT_OPTION_DONT_OVERWRITE_VALUE);
+
+    for(size_t i = 0; i < 64; i++) {
+        char id[64], value[64];
+        snprintfz(id, sizeof(id) - 1, "instance%zu", i);
+
+        RRDINSTANCE tmp = {
+            .id = string_strdupz(id),
+            .rrdlabels = rrdlabels_create(),
+            .rc = rc,
+        };
+
+        snprintfz(value, sizeof(value) - 1, "z%zu", i % 3);
+        rrdlabels_add(tmp.rrdlabels, "zone", value, RRDLABEL_SRC_AUTO);
+
+        if(i % 5)
+            rrdlabels_add(tmp.rrdlabels, "role", (i % 2) ? "db" : "web", RRDLABEL_SRC_AUTO);
+
+        if(i % 7 == 0)
+            rrdlabels_add(tmp.rrdlabels, "canary", "true", RRDLABEL_SRC_AUTO);
+
+        RRDINSTANCE *ri = dictionary_set(rc->rrdinstances, id, &tmp, sizeof(tmp));
+        rrdcontext_labels_index_track(rc, ri->rrdlabels);
+    }
+
+    struct rrdcontext_labels_index_unittest_case cases[] = {
+        { .labels = { { "zone", "zone:z1" } } },
+        { .labels = { { "zone", "zone:z1 zone:z2" } } },
+        { .labels = { { "zone", "zone:z*" }, { "role", "role:db" } } },
+        { .labels = { { "role", "role:w*" } } },
+        { .labels = { { "zone", "zone:nothing" } } },
+        { .labels = { { "zone", "!zone:z0 *" } } },
+        { .chart_label_key = "canary" },
+        { .chart_label_key = "can*", .labels = { { "role", "role:db" } } },
+        { .chart_label_key = "missing" },
+    };
+
+    size_t indexed = 0;
+    for(size_t i = 0; i < _countof(cases); i++) {
+        bool was_indexed;
+        errors += rrdcontext_labels_index_unittest_compare(rc, &cases[i], &was_indexed);
+        if(was_indexed)
+            indexed++;
+    }
+
+    if(!indexed) {
+        fprintf(stderr, "  none of the label filters used the index\n");
+        errors++;
+    }
+
+    // labels not tracked by the context do not invalidate its index
+    uint32_t version = __atomic_load_n(&rc->labels_index.version, __ATOMIC_RELAXED);
+    RRDLABELS *tmp_labels = rrdlabels_create();
+    rrdlabels_add(tmp_labels, "zone", "z1", RRDLABEL_SRC_AUTO);
+    rrdlabels_destroy(tmp_labels);
+    if(__atomic_load_n(&rc->labels_index.version, __ATOMIC_RELAXED) != version) {
+        fprintf(stderr, "  the index is invalidated by labels not belonging to its instances\n");
+        errors++;
+    }
+
+    // changing the labels of an instance invalidates the index
+    RRDINSTANCE *ri = dictionary_get(rc->rrdinstances, "instance1");
+    rrdlabels_add(ri->rrdlabels, "zone", "z5", RRDLABEL_SRC_AUTO);
+    if(__atomic_load_n(&rc->labels_index.version, __ATOMIC_RELAXED) == version) {
+        fprintf(stderr, "  the index is not invalidated when the labels of an instance change\n");
+        errors++;
+    }
+
+    bool was_indexed;
+    for(size_t i = 0; i < _countof(cases); i++)
+        errors += rrdcontext_labels_index_unittest_compare(rc, &cases[i], &was_indexed);
+
+    struct rrdcontext_labels_index_unittest_case changed = { .labels = { { "zone", "zone:z5" } } };
+    errors += rrdcontext_labels_index_unittest_compare(rc, &changed, &was_indexed);
+    if(!was_indexed) {
+        fprintf(stderr, "  the index is not used after the labels of an instance changed\n");
+        errors++;
+    }
+
+    dfe_start_read(rc->rrdinstances, ri) {
+        rrdcontext_labels_index_untrack(rc, ri->rrdlabels);
+        rrdlabels_destroy(ri->rrdlabels);
+        string_freez(ri->id);
+    }
+    dfe_done(ri);
+
+    dictionary_destroy(rc->rrdinstances);
+    rrdcontext_labels_index_destroy(rc);
+    freez(rc);
+
+    fprintf(stderr, "%d errors found\n", errors);
+    return errors;
+}
@@ -45,6 +45,58 @@ static void rrddim_reinitialize_collection(RRDDIM *rd) {
     }
 }
 
+// ----------------------------------------------------------------------------
+// RRDDIM cardinality budget of the plugins of localhost
+
+static struct {
+    size_t dimensions_per_plugin;
+    DICTIONARY *plugins;                // the number of dimensions of each plugin (size_t, atomic)
+} rrddim_budget = { 0 };
+
+void rrddim_budget_init(size_t dimensions_per_plugin) {
+    // the dimensions are counted from the moment the budget is enabled for the first time
+    if(dimensions_per_plugin && !rrddim_budget.plugins)
+        rrddim_budget.plugins = dictionary_create(DICT_OPTION_DONT_OVERWRITE_VALUE);
+
+    __atomic_store_n(&rrddim_budget.dimensions_per_plugin, dimensions_per_plugin, __ATOMIC_RELAXED);
+}
+
+static inline size_t *rrddim_budget_plugin_dimensions(RRDSET *st) {
+    if(likely(!rrddim_budget.plugins || st->rrdhost != localhost))
+        return NULL;
+
+    size_t zero = 0;
+    return dictionary_set(rrddim_budget.plugins, rrdset_plugin_name(st), &zero, sizeof(zero));
+}
+
+static inline void rrddim_budget_dimension_added(RRDSET *st) {
+    size_t *dimensions = rrddim_budget_plugin_dimensions(st);
+    if(dimensions)
+        __atomic_add_fetch(dimensions, 1, __ATOMIC_RELAXED);
+}
+
+static inline void rrddim_budget_dimension_deleted(RRDSET *st) {
+    size_t *dimensions = rrddim_budget_plugin_dimensions(st);
+    if(dimensions && __atomic_load_n(dimensions, __ATOMIC_RELAXED))
+        __atomic_sub_fetch(dimensions, 1, __ATOMIC_RELAXED);
+}
+
+static inline bool rrddim_budget_exceeded(RRDSET *st, const char *id) {
+    size_t budget = __atomic_load_n(&rrddim_budget.dimensions_per_plugin, __ATOMIC_RELAXED);
+    if(likely(!budget))
+        return false;
+
+    size_t *dimensions = rrddim_budget_plugin_dimensions(st);
+    if(likely(!dimensions))
+        return false;
+
+    return __atomic_load_n(dimensions, __ATOMIC_RELAXED) >= budget &&
+           strcmp(id, RRDDIM_BUDGET_OVERFLOW_ID) != 0;
+}
+
+// ----------------------------------------------------------------------------
+// RRDDIM index callbacks
+
 static void rrddim_insert_callback(const DICTIONARY_ITEM *item __maybe_unused, void *rrddim, void *constructor_data) {
     struct rrddim_constructor *ctr = constructor_data;
     RRDDIM *rd = rrddim;
@@ -67,6 +119,9 @@ static void rrddim_insert_callback(const DICTIONARY_ITEM *item __maybe_unused, v
 
     rd->stream.snd.dim_slot = __atomic_add_fetch(&st->stream.snd.dim_last_slot_used, 1, __ATOMIC_RELAXED);
 
+    __atomic_add_fetch(&st->cost.dimensions_added, 1, __ATOMIC_RELAXED);
+    rrddim_budget_dimension_added(st);
+
     if(rrdset_flag_check(st, RRDSET_FLAG_STORE_FIRST))
         rd->collector.counter = 1;
 
@@ -225,6 +280,9 @@ static void rrddim_delete_callback(const DICTIONARY_ITEM *item __maybe_unused, v
 
     rrdcontext_removed_rrddim(rd);
 
+    __atomic_add_fetch(&st->cost.dimensions_deleted, 1, __ATOMIC_RELAXED);
+    rrddim_budget_dimension_deleted(st);
+
     ml_dimension_delete(rd);
 
     netdata_log_debug(D_RRD_CALLS, "rrddim_free() %s.%s", rrdset_name(st), rrddim_name(rd));
@@ -322,6 +380,9 @@ void rrddim_index_init(RRDSET *st) {
 void rrddim_index_destroy(RRDSET *st) {
     dictionary_destroy(st->rrddim_root_index);
     st->rrddim_root_index = NULL;
+
+    dictionary_destroy(st->cost.aggregated_ids);
+    st->cost.aggregated_ids = NULL;
 }
 
 static inline RRDDIM *rrddim_index_find(RRDSET *st, const char *id) {
@@ -384,6 +445,11 @@ inline int rrddim_reset_name(RRDSET *st __maybe_unused, RRDDIM *rd, const char *
     if(unlikely(!name || !*name || !strcmp(rrddim_name(rd), name)))
         return 0;
 
+    // the aggregated dimension is shared by all its members,
+    // a collector renaming its own dimension should not rename it for all
+    if(unlikely(rrddim_option_check(rd, RRDDIM_OPTION_AGGREGATED)))
+        return 0;
+
     netdata_log_debug(D_RRD_CALLS, "rrddim_reset_name() from %s.%s to %s.%s", rrdset_name(st), rrddim_name(rd), rrdset_name(st), name);
 
     STRING *old = rd->name;
@@ -488,6 +554,68 @@ time_t rrddim_first_entry_s(RRDDIM *rd) {
     return oldest_time_s;
 }
 
+static void rrddim_budget_aggregated_id_insert_callback(const DICTIONARY_ITEM *item __maybe_unused, void *value __maybe_unused, void *data) {
+    RRDSET *st = data;
+    __atomic_add_fetch(&st->cost.dimensions_aggregated, 1, __ATOMIC_RELAXED);
+}
+
+static inline bool rrddim_budget_is_aggregated(RRDSET *st, const char *id) {
+    DICTIONARY *ids = __atomic_load_n(&st->cost.aggregated_ids, __ATOMIC_ACQUIRE);
+    return ids && dictionary_get(ids, id) != NULL;
+}
+
+// Only gauges can be summed into one dimension: the sum of counters (INCREMENTAL)
+// jumps when a counter joins it and drops when one misses an update, and the
+// sum of percentages is meaningless. Also, the values of the members have to be
+// in the units of the aggregated dimension, so their multiplier and divisor have
+// to be the same with the first member's.
+// The dimensions that cannot be aggregated are refused: they are created as
+// any other dimension, over the budget of the plugin.
+static RRDDIM *rrddim_budget_overflow(RRDSET *st, const char *id, collected_number multiplier, collected_number divisor, RRD_ALGORITHM algorithm, RRD_DB_MODE memory_mode) {
+    RRDDIM *rd = rrddim_index_find(st, RRDDIM_BUDGET_OVERFLOW_ID);
+
+    if(algorithm != RRD_ALGORITHM_ABSOLUTE ||
+        (rd && (rd->multiplier != multiplier || rd->divisor != divisor))) {
+        __atomic_add_fetch(&st->cost.dimensions_refused, 1, __ATOMIC_RELAXED);
+
+        nd_log_limit_static_global_var(erl, 60, 0);
+        nd_log_limit(&erl, NDLS_DAEMON, NDLP_WARNING,
+                     "RRDDIM: plugin '%s' has reached its budget of %zu dimensions; "
+                     "dimension '%s' of chart '%s' cannot be aggregated into dimension '%s' "
+                     "(it is not absolute, or its multiplier or divisor is different), so it is added over the budget.",
+                     rrdset_plugin_name(st), rrddim_budget.dimensions_per_plugin,
+                     id, rrdset_id(st), RRDDIM_BUDGET_OVERFLOW_ID);
+
+        return NULL;
+    }
+
+    // the plugin may send the same dimension again (e.g. on every iteration),
+    // so each id is counted only the first time it is aggregated
+    DICTIONARY *ids = __atomic_load_n(&st->cost.aggregated_ids, __ATOMIC_ACQUIRE);
+    if(unlikely(!ids)) {
+        DICTIONARY *expected = NULL;
+        ids = dictionary_create_advanced(DICT_OPTION_DONT_OVERWRITE_VALUE | DICT_OPTION_FIXED_SIZE, &dictionary_stats_category_rrddim, sizeof(bool));
+        dictionary_register_insert_callback(ids, rrddim_budget_aggregated_id_insert_callback, st);
+        if(!__atomic_compare_exchange_n(&st->cost.aggregated_ids, &expected, ids, false, __ATOMIC_RELEASE, __ATOMIC_ACQUIRE)) {
+            dictionary_destroy(ids);
+            ids = expected;
+        }
+    }
+    bool aggregated = true;
+    dictionary_set(ids, id, &aggregated, sizeof(aggregated));
+
+    nd_log_limit_static_global_var(erl, 60, 0);
+    nd_log_limit(&erl, NDLS_DAEMON, NDLP_WARNING,
+                 "RRDDIM: plugin '%s' has reached its budget of %zu dimensions; "
+                 "dimension '%s' of chart '%s' is aggregated into dimension '%s'.",
+                 rrdset_plugin_name(st), rrddim_budget.dimensions_per_plugin,
+                 id, rrdset_id(st), RRDDIM_BUDGET_OVERFLOW_ID);
+
+    rd = rrddim_add_custom(st, RRDDIM_BUDGET_OVERFLOW_ID, RRDDIM_BUDGET_OVERFLOW_NAME, multiplier, divisor, RRD_ALGORITHM_ABSOLUTE, memory_mode);
+    rrddim_option_set(rd, RRDDIM_OPTION_AGGREGATED);
+    return rd;
+}
+
 RRDDIM *rrddim_add_custom(RRDSET *st
                           , const char *id
                           , const char *name
@@ -512,6 +640,11 @@ RRDDIM *rrddim_add_custom(RRDSET *st
                 continue;
             }
         }
+        else if(unlikely(rrddim_budget_exceeded(st, id))) {
+            rd = rrddim_budget_overflow(st, id, multiplier, divisor, algorithm, memory_mode);
+            if(rd)
+                return rd;
+        }
 
         struct rrddim_constructor tmp = {
             .st = st,
@@ -546,10 +679,18 @@ int rrddim_hide(RRDSET *st, const char *id) {
     RRDHOST *host = st->rrdhost;
 
     RRDDIM *rd = rrddim_find(st, id, true);
+    if(unlikely(!rd && rrddim_budget_is_aggregated(st, id)))
+        return 0;
+
     if(unlikely(!rd)) {
         netdata_log_error("Cannot find dimension with id '%s' on stats '%s' (%s) on host '%s'.", id, rrdset_name(st), rrdset_id(st), rrdhost_hostname(host));
         return 1;
     }
+
+    // the aggregated dimension is shared by all its members
+    if(unlikely(rrddim_option_check(rd, RRDDIM_OPTION_AGGREGATED)))
+        return 0;
+
     if (!rrddim_flag_check(rd, RRDDIM_FLAG_META_HIDDEN)) {
         rrddim_flag_set(rd, RRDDIM_FLAG_META_HIDDEN | RRDDIM_FLAG_METADATA_UPDATE);
         rrdhost_flag_set(rd->rrdset->rrdhost, RRDHOST_FLAG_METADATA_UPDATE);
@@ -566,10 +707,18 @@ int rrddim_unhide(RRDSET *st, const char *id) {
 
     RRDHOST *host = st->rrdhost;
     RRDDIM *rd = rrddim_find(st, id, true);
+    if(unlikely(!rd && rrddim_budget_is_aggregated(st, id)))
+        return 0;
+
     if(unlikely(!rd)) {
         netdata_log_error("Cannot find dimension with id '%s' on stats '%s' (%s) on host '%s'.", id, rrdset_name(st), rrdset_id(st), rrdhost_hostname(host));
         return 1;
     }
+
+    // the aggregated dimension is shared by all its members
+    if(unlikely(rrddim_option_check(rd, RRDDIM_OPTION_AGGREGATED)))
+        return 0;
+
     if (rrddim_flag_check(rd, RRDDIM_FLAG_META_HIDDEN)) {
         rrddim_flag_clear(rd, RRDDIM_FLAG_META_HIDDEN);
         rrddim_flag_set(rd, RRDDIM_FLAG_METADATA_UPDATE);
@@ -585,6 +734,11 @@ int rrddim_unhide(RRDSET *st, const char *id) {
 inline void rrddim_is_obsolete___safe_from_collector_thread(RRDSET *st, RRDDIM *rd) {
     netdata_log_debug(D_RRD_CALLS, "rrddim_is_obsolete___safe_from_collector_thread() for chart %s, dimension %s", rrdset_name(st), rrddim_name(rd));
 
+    // the aggregated dimension is shared by all its members,
+    // it is not obsoleted when one of them goes away
+    if(unlikely(rrddim_option_check(rd, RRDDIM_OPTION_AGGREGATED)))
+        return;
+
     rrddim_flag_set(rd, RRDDIM_FLAG_OBSOLETE);
     rrdset_flag_set(st, RRDSET_FLAG_OBSOLETE_DIMENSIONS);
     rrdhost_flag_set(st->rrdhost, RRDHOST_FLAG_PENDING_OBSOLETE_DIMENSIONS);
@@ -615,7 +769,12 @@ collected_number rrddim_timed_set_by_pointer(RRDSET *st __maybe_unused, RRDDIM *
     netdata_log_debug(D_RRD_CALLS, "rrddim_set_by_pointer() for chart %s, dimension %s, value " COLLECTED_NUMBER_FORMAT, rrdset_name(st), rrddim_name(rd), value);
 
     rd->collector.last_collected_time = collected_time;
-    rd->collector.collected_value = value;
+
+    if(unlikely(rrddim_option_check(rd, RRDDIM_OPTION_AGGREGATED) && rrddim_check_updated(rd)))
+        rd->collector.collected_value += value;
+    else
+        rd->collector.collected_value = value;
+
     rrddim_set_updated(rd);
     rd->collector.counter++;
 
@@ -625,7 +784,7 @@ collected_number rrddim_timed_set_by_pointer(RRDSET *st __maybe_unused, RRDDIM *
 //        *((int64_t *)Pvalue) = *((int64_t *)Pvalue) + 1;
 //    spinlock_unlock(&st->rrdhost->accounting.spinlock);
 
-    collected_number v = (value >= 0) ? value : -value;
+    collected_number v = (rd->collector.collected_value >= 0) ? rd->collector.collected_value : -rd->collector.collected_value;
     if (unlikely(v > rd->collector.collected_value_max))
         rd->collector.collected_value_max = v;
 
@@ -636,6 +795,11 @@ collected_number rrddim_timed_set_by_pointer(RRDSET *st __maybe_unused, RRDDIM *
 collected_number rrddim_set(RRDSET *st, const char *id, collected_number value) {
     RRDHOST *host = st->rrdhost;
     RRDDIM *rd = rrddim_find_active(st, id);
+
+    // the dimension may have been aggregated, over the plugin's budget
+    if(unlikely(!rd && rrddim_budget_is_aggregated(st, id)))
+        rd = rrddim_find_active(st, RRDDIM_BUDGET_OVERFLOW_ID);
+
     if(unlikely(!rd)) {
         netdata_log_error("Cannot find dimension with id '%s' on stats '%s' (%s) on host '%s'.", id, rrdset_name(st), rrdset_id(st), rrdhost_hostname(host));
         return 0;
@@ -27,6 +27,7 @@ typedef enum __attribute__ ((__packed__)) rrddim_options {
     RRDDIM_OPTION_DONT_DETECT_RESETS_OR_OVERFLOWS   = (1 << 1), // do not offer RESET or OVERFLOW info to callers
     RRDDIM_OPTION_BACKFILLED_HIGH_TIERS             = (1 << 2), // when set, we have backfilled higher tiers
     RRDDIM_OPTION_UPDATED                           = (1 << 3), // single-threaded collector updated flag
+    RRDDIM_OPTION_AGGREGATED                        = (1 << 4), // the values set before rrdset_done() are added together
 
     // this is 8-bit
 } RRDDIM_OPTIONS;
@@ -209,6 +210,16 @@ RRDDIM *rrddim_add_custom(RRDSET *st
 #define rrddim_add(st, id, name, multiplier, divisor, algorithm) \
     rrddim_add_custom(st, id, name, multiplier, divisor, algorithm, (st)->rrd_memory_mode)
 
+// the cardinality budget of the plugins of localhost
+// when a plugin has as many dimensions as its budget, the new absolute dimensions it adds to a chart
+// are aggregated into a single dimension of the chart (their values are summed)
+// the rest are refused aggregation and are added over the budget
+#define RRDDIM_BUDGET_OVERFLOW_ID "_over_budget"
+#define RRDDIM_BUDGET_OVERFLOW_NAME "over budget"
+
+// 0 disables the budget
+void rrddim_budget_init(size_t dimensions_per_plugin);
+
 int rrddim_reset_name(RRDSET *st, RRDDIM *rd, const char *name);
 int rrddim_set_algorithm(RRDSET *st, RRDDIM *rd, RRD_ALGORITHM algorithm);
 int rrddim_set_multiplier(RRDSET *st, RRDDIM *rd, int32_t multiplier);
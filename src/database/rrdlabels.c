@@ -30,9 +30,16 @@ typedef struct labels_registry_idx_entry {
 typedef struct rrdlabels {
     SPINLOCK spinlock;
     uint32_t version;
+    uint32_t *changes;          // the owner's counter, incremented when a label is added or removed
     Pvoid_t JudyL;
 } RRDLABELS;
 
+// called with the labels spinlock held
+#define rrdlabels_changed_unsafe(labels) do {                                   \
+        if((labels)->changes)                                                   \
+            __atomic_add_fetch((labels)->changes, 1, __ATOMIC_RELEASE);         \
+    } while(0)
+
 #define lfe_start_nolock(label_list, label, ls)                                                                        \
     do {                                                                                                               \
         bool _first_then_next = true;                                                                                  \
@@ -106,10 +113,30 @@ RRDLABELS *rrdlabels_create(void)
     RRDLABELS *labels = aral_mallocz(labels_aral);
     spinlock_init(&labels->spinlock);
     labels->version = 0;
+    labels->changes = NULL;
     labels->JudyL = NULL;
     return labels;
 }
 
+void rrdlabels_set_changes_counter(RRDLABELS *labels, uint32_t *counter) {
+    if(unlikely(!labels))
+        return;
+
+    spinlock_lock(&labels->spinlock);
+    labels->changes = counter;
+    spinlock_unlock(&labels->spinlock);
+}
+
+void rrdlabels_clear_changes_counter(RRDLABELS *labels, uint32_t *counter) {
+    if(unlikely(!labels))
+        return;
+
+    spinlock_lock(&labels->spinlock);
+    if(labels->changes == counter)
+        labels->changes = NULL;
+    spinlock_unlock(&labels->spinlock);
+}
+
 static void dup_label(RRDLABEL *label_index)
 {
     if (!label_index)
@@ -204,6 +231,9 @@ void rrdlabels_flush(RRDLABELS *labels) {
 
     spinlock_lock(&labels->spinlock);
 
+    if(labels->JudyL)
+        rrdlabels_changed_unsafe(labels);
+
     Pvoid_t *PValue;
     Word_t Index = 0;
     bool first_then_next = true;
@@ -280,6 +310,7 @@ static void labels_add_already_sanitized(RRDLABELS *labels, const char *key, con
     else {
         new_ls |= RRDLABEL_FLAG_NEW;
         *((RRDLABEL_SRC *)PValue) = new_ls;
+        rrdlabels_changed_unsafe(labels);
 
         RRDLABEL *old_label_with_same_key = rrdlabels_find_label_with_key_unsafe(labels, new_label, false);
         if (old_label_with_same_key) {
@@ -566,6 +597,7 @@ static void rrdlabels_remove_all_unmarked_unsafe(RRDLABELS *labels)
             RRDLABELS_MEMORY_DELTA(&dictionary_stats_category_rrdlabels, judy_mem, 0);
 
             delete_label((RRDLABEL *)Index);
+            rrdlabels_changed_unsafe(labels);
             if (labels->JudyL != (Pvoid_t) NULL) {
                 Index = 0;
                 first_then_next = true;
@@ -670,6 +702,7 @@ void rrdlabels_migrate_to_these(RRDLABELS *dst, RRDLABELS *src) {
         if (!*PValue) {
             flag = (ls & ~(RRDLABEL_FLAG_OLD | RRDLABEL_FLAG_NEW)) | RRDLABEL_FLAG_NEW;
             dup_label(label);
+            rrdlabels_changed_unsafe(dst);
             int64_t judy_mem = JudyAllocThreadPulseGetAndReset();
             RRDLABELS_MEMORY_DELTA(&dictionary_stats_category_rrdlabels, judy_mem, 0);
         }
@@ -745,6 +778,7 @@ void rrdlabels_copy(RRDLABELS *dst, RRDLABELS *src)
             dup_label(label);
             ls = (ls & ~(RRDLABEL_FLAG_OLD)) | RRDLABEL_FLAG_NEW;
             dst->version++;
+            rrdlabels_changed_unsafe(dst);
             update_statistics = true;
             if (old_label_with_key) {
                 int64_t judy_mem = JudyAllocThreadPulseGetAndReset();
@@ -779,24 +813,18 @@ struct simple_pattern_match_name_value {
     char equal;
 };
 
-static SIMPLE_PATTERN_RESULT simple_pattern_match_name_only_callback(const char *name, const char *value, RRDLABEL_SRC ls __maybe_unused, void *data) {
-    struct simple_pattern_match_name_value *t = (struct simple_pattern_match_name_value *)data;
-    (void)value;
-
-    // we return -1 to stop the walkthrough on first match
-    t->searches++;
-    SIMPLE_PATTERN_RESULT ret = simple_pattern_matches_extract(t->pattern, name, NULL, 0);
-    if (ret == SP_MATCHED_NEGATIVE)
-        ret = SP_NOT_MATCHED;
-    return ret;
-}
-
-static SIMPLE_PATTERN_RESULT simple_pattern_match_name_and_value_callback(const char *name, const char *value, RRDLABEL_SRC ls __maybe_unused, void *data) {
-    struct simple_pattern_match_name_value *t = (struct simple_pattern_match_name_value *)data;
+SIMPLE_PATTERN_RESULT rrdlabels_match_simple_pattern_pair(SIMPLE_PATTERN *pattern, const char *name, const char *value, char equal, size_t *searches) {
+    if(!equal) {
+        if(searches) (*searches)++;
+        SIMPLE_PATTERN_RESULT ret = simple_pattern_matches_extract(pattern, name, NULL, 0);
+        if (ret == SP_MATCHED_NEGATIVE)
+            ret = SP_NOT_MATCHED;
+        return ret;
+    }
 
     // we return -1 to stop the walkthrough on first match
-    t->searches++;
-    if(simple_pattern_matches(t->pattern, name)) return -1;
+    if(searches) (*searches)++;
+    if(simple_pattern_matches(pattern, name)) return -1;
 
     size_t len = RRDLABELS_MAX_NAME_LENGTH + RRDLABELS_MAX_VALUE_LENGTH + 2; // +1 for =, +1 for \0
     char tmp[len], *dst = &tmp[0];
@@ -806,7 +834,7 @@ static SIMPLE_PATTERN_RESULT simple_pattern_match_name_and_value_callback(const
     while(*name) *dst++ = *name++;
 
     // add the equal
-    *dst++ = t->equal;
+    *dst++ = equal;
 
     // add the value
     while(*v) *dst++ = *v++;
@@ -814,8 +842,18 @@ static SIMPLE_PATTERN_RESULT simple_pattern_match_name_and_value_callback(const
     // terminate it
     *dst = '\0';
 
-    t->searches++;
-    return simple_pattern_matches_length_extract(t->pattern, tmp, dst - tmp, NULL, 0);
+    if(searches) (*searches)++;
+    return simple_pattern_matches_length_extract(pattern, tmp, dst - tmp, NULL, 0);
+}
+
+static SIMPLE_PATTERN_RESULT simple_pattern_match_name_only_callback(const char *name, const char *value __maybe_unused, RRDLABEL_SRC ls __maybe_unused, void *data) {
+    struct simple_pattern_match_name_value *t = (struct simple_pattern_match_name_value *)data;
+    return rrdlabels_match_simple_pattern_pair(t->pattern, name, NULL, '\0', &t->searches);
+}
+
+static SIMPLE_PATTERN_RESULT simple_pattern_match_name_and_value_callback(const char *name, const char *value, RRDLABEL_SRC ls __maybe_unused, void *data) {
+    struct simple_pattern_match_name_value *t = (struct simple_pattern_match_name_value *)data;
+    return rrdlabels_match_simple_pattern_pair(t->pattern, name, value, t->equal, &t->searches);
 }
 
 SIMPLE_PATTERN_RESULT rrdlabels_match_simple_pattern_parsed(RRDLABELS *labels, SIMPLE_PATTERN *pattern, char equal, size_t *searches) {
@@ -1611,6 +1649,77 @@ int rrdlabels_unittest_sanitization() {
     return errors;
 }
 
+static int rrdlabels_unittest_changes_counter()
+{
+    fprintf(stderr, "\n%s() tests\n", __FUNCTION__);
+
+    int errors = 0;
+    uint32_t changes = 0;
+
+    RRDLABELS *labels = rrdlabels_create();
+    rrdlabels_set_changes_counter(labels, &changes);
+
+    rrdlabels_add(labels, "key1", "value1", RRDLABEL_SRC_CONFIG);
+    if(changes != 1) {
+        fprintf(stderr, "changes counter is %u, expected 1, after adding a label\n", changes);
+        errors++;
+    }
+
+    rrdlabels_add(labels, "key1", "value1", RRDLABEL_SRC_CONFIG);
+    if(changes != 1) {
+        fprintf(stderr, "changes counter is %u, expected 1, after re-adding the same label\n", changes);
+        errors++;
+    }
+
+    // labels without a counter, like the temporary ones built by queries, do not affect it
+    RRDLABELS *tmp = rrdlabels_create();
+    rrdlabels_add(tmp, "key1", "value2", RRDLABEL_SRC_CONFIG);
+    rrdlabels_add(tmp, "key2", "value2", RRDLABEL_SRC_CONFIG);
+    if(changes != 1) {
+        fprintf(stderr, "changes counter is %u, expected 1, after changing other labels\n", changes);
+        errors++;
+    }
+
+    uint32_t before = changes;
+    rrdlabels_migrate_to_these(labels, tmp);
+    rrdlabels_destroy(tmp);
+    if(changes == before) {
+        fprintf(stderr, "changes counter not changed when labels are migrated\n");
+        errors++;
+    }
+
+    SIMPLE_PATTERN *sp = simple_pattern_create("key1:value2", NULL, SIMPLE_PATTERN_EXACT, true);
+    if(rrdlabels_match_simple_pattern_pair(sp, "key1", "value2", ':', NULL) != SP_MATCHED_POSITIVE ||
+       rrdlabels_match_simple_pattern_pair(sp, "key1", "value1", ':', NULL) != SP_NOT_MATCHED ||
+       rrdlabels_match_simple_pattern_parsed(labels, sp, ':', NULL) != SP_MATCHED_POSITIVE) {
+        fprintf(stderr, "single label matching is not consistent\n");
+        errors++;
+    }
+
+    if(!simple_pattern_exact_literal(sp) || strcmp(simple_pattern_exact_literal(sp), "key1:value2") != 0) {
+        fprintf(stderr, "exact literal of pattern not found\n");
+        errors++;
+    }
+    simple_pattern_free(sp);
+
+    rrdlabels_clear_changes_counter(labels, &changes);
+    before = changes;
+    rrdlabels_add(labels, "key3", "value3", RRDLABEL_SRC_CONFIG);
+    if(changes != before) {
+        fprintf(stderr, "changes counter changed after it was cleared\n");
+        errors++;
+    }
+
+    rrdlabels_set_changes_counter(labels, &changes);
+    rrdlabels_destroy(labels);
+    if(changes == before) {
+        fprintf(stderr, "changes counter not changed when labels are destroyed\n");
+        errors++;
+    }
+
+    return errors;
+}
+
 int rrdlabels_unittest(void) {
     int errors = 0;
 
@@ -1621,6 +1730,7 @@ int rrdlabels_unittest(void) {
     errors += rrdlabels_unittest_double_check();
     errors += rrdlabels_unittest_migrate_check();
     errors += rrdlabels_unittest_pattern_check();
+    errors += rrdlabels_unittest_changes_counter();
 
     fprintf(stderr, "%d errors found\n", errors);
 
@@ -41,6 +41,11 @@ void rrdlabels_get_value_to_buffer_or_unset(RRDLABELS *labels, BUFFER *wb, const
 bool rrdlabels_exist(RRDLABELS *labels, const char *key);
 size_t rrdlabels_entries(RRDLABELS *labels __maybe_unused);
 uint32_t rrdlabels_version(RRDLABELS *labels __maybe_unused);
+
+// the owner of the labels may give a counter, to be incremented every time a label is added or removed
+void rrdlabels_set_changes_counter(RRDLABELS *labels, uint32_t *counter);
+void rrdlabels_clear_changes_counter(RRDLABELS *labels, uint32_t *counter);
+
 void rrdlabels_get_value_strcpyz(RRDLABELS *labels, char *dst, size_t dst_len, const char *key);
 
 void rrdlabels_unmark_all(RRDLABELS *labels);
@@ -53,6 +58,9 @@ bool rrdlabels_match_simple_pattern(RRDLABELS *labels, const char *simple_patter
 
 SIMPLE_PATTERN_RESULT rrdlabels_match_simple_pattern_parsed(RRDLABELS *labels, SIMPLE_PATTERN *pattern, char equal, size_t *searches);
 
+// match a single label against a pattern, exactly like rrdlabels_match_simple_pattern_parsed() does for each label
+SIMPLE_PATTERN_RESULT rrdlabels_match_simple_pattern_pair(SIMPLE_PATTERN *pattern, const char *name, const char *value, char equal, size_t *searches);
+
 // Forward declaration for RRDLABELS_AGGREGATED
 struct rrdlabels_aggregated;
 // Full text search through labels - matches if either key OR value matches the pattern
@@ -278,17 +278,55 @@ struct rda_item {
     bool reset_or_overflow;
 };
 
+// the dimensions rrdset_done() calculates in a batch, laid out in arrays,
+// so that they are calculated a few at a time with SIMD instructions
+// absolute dimensions and incremental ones without a reset or an overflow are
+// batched - everything else goes through the per dimension calculation
+struct rda_batch {
+    size_t used;
+    NETDATA_DOUBLE *delta;              // the collected value minus the last collected (zero for absolute dimensions)
+    NETDATA_DOUBLE *multiplier;
+    NETDATA_DOUBLE *divisor;
+    NETDATA_DOUBLE *calculated;
+    uint32_t *slot;                     // the rda slot of each batched dimension
+};
+
+#define RDA_BATCH_ENTRY_SIZE (4 * sizeof(NETDATA_DOUBLE) + sizeof(uint32_t))
+#define RDA_ENTRY_SIZE (sizeof(struct rda_item) + RDA_BATCH_ENTRY_SIZE)
+
+// the compiler generates the best instructions available for the target (SSE2, AVX, NEON),
+// or scalar code when there are none
+#if !defined(NETDATA_WITH_LONG_DOUBLE) && (defined(__GNUC__) || defined(__clang__))
+typedef NETDATA_DOUBLE rda_vector __attribute__((vector_size(4 * sizeof(NETDATA_DOUBLE))));
+#define RDA_VECTOR_ENTRIES (sizeof(rda_vector) / sizeof(NETDATA_DOUBLE))
+#endif
+
 static __thread struct rda_item *thread_rda = NULL;
+static __thread struct rda_batch thread_rda_batch = { 0 };
 static __thread size_t thread_rda_entries = 0;
 
+static void rrdset_thread_rda_batch_allocate(size_t entries) {
+    // one allocation, the arrays ordered by alignment
+    char *mem = mallocz(entries * RDA_BATCH_ENTRY_SIZE);
+
+    thread_rda_batch.delta = (NETDATA_DOUBLE *)mem;         mem += entries * sizeof(NETDATA_DOUBLE);
+    thread_rda_batch.multiplier = (NETDATA_DOUBLE *)mem;    mem += entries * sizeof(NETDATA_DOUBLE);
+    thread_rda_batch.divisor = (NETDATA_DOUBLE *)mem;       mem += entries * sizeof(NETDATA_DOUBLE);
+    thread_rda_batch.calculated = (NETDATA_DOUBLE *)mem;    mem += entries * sizeof(NETDATA_DOUBLE);
+    thread_rda_batch.slot = (uint32_t *)mem;
+    thread_rda_batch.used = 0;
+}
+
 static struct rda_item *rrdset_thread_rda_get(size_t *dimensions) {
 
     if(unlikely(!thread_rda || (*dimensions) > thread_rda_entries)) {
-        size_t old_mem = thread_rda_entries * sizeof(struct rda_item);
+        size_t old_mem = thread_rda_entries * RDA_ENTRY_SIZE;
         freez(thread_rda);
+        freez(thread_rda_batch.delta);
         thread_rda_entries = *dimensions;
-        size_t new_mem = thread_rda_entries * sizeof(struct rda_item);
-        thread_rda = mallocz(new_mem);
+        size_t new_mem = thread_rda_entries * RDA_ENTRY_SIZE;
+        thread_rda = mallocz(thread_rda_entries * sizeof(struct rda_item));
+        rrdset_thread_rda_batch_allocate(thread_rda_entries);
 
         __atomic_add_fetch(&netdata_buffers_statistics.rrdset_done_rda_size, new_mem - old_mem, __ATOMIC_RELAXED);
     }
@@ -298,13 +336,58 @@ static struct rda_item *rrdset_thread_rda_get(size_t *dimensions) {
 }
 
 void rrdset_thread_rda_free(void) {
-    __atomic_sub_fetch(&netdata_buffers_statistics.rrdset_done_rda_size, thread_rda_entries * sizeof(struct rda_item), __ATOMIC_RELAXED);
+    __atomic_sub_fetch(&netdata_buffers_statistics.rrdset_done_rda_size, thread_rda_entries * RDA_ENTRY_SIZE, __ATOMIC_RELAXED);
 
     freez(thread_rda);
     thread_rda = NULL;
+    freez(thread_rda_batch.delta);
+    memset(&thread_rda_batch, 0, sizeof(thread_rda_batch));
     thread_rda_entries = 0;
 }
 
+static inline void rda_batch_add(struct rda_batch *b, size_t slot, RRDDIM *rd, collected_number last_collected) {
+    size_t i = b->used++;
+    b->slot[i] = (uint32_t)slot;
+    b->delta[i] = (NETDATA_DOUBLE)(rd->collector.collected_value - last_collected);
+    b->multiplier[i] = (NETDATA_DOUBLE)rd->multiplier;
+    b->divisor[i] = (NETDATA_DOUBLE)rd->divisor;
+}
+
+// the same operations, in the same order, as the per dimension calculation,
+// so that the results are identical
+static void rda_batch_calculate(struct rda_batch *b) {
+    size_t i = 0;
+
+#ifdef RDA_VECTOR_ENTRIES
+    for(; i + RDA_VECTOR_ENTRIES <= b->used ; i += RDA_VECTOR_ENTRIES) {
+        rda_vector delta, multiplier, divisor, calculated;
+        memcpy(&delta, &b->delta[i], sizeof(delta));
+        memcpy(&multiplier, &b->multiplier[i], sizeof(multiplier));
+        memcpy(&divisor, &b->divisor[i], sizeof(divisor));
+
+        calculated = delta * multiplier / divisor;
+
+        memcpy(&b->calculated[i], &calculated, sizeof(calculated));
+    }
+#endif
+
+    for(; i < b->used ; i++)
+        b->calculated[i] = b->delta[i] * b->multiplier[i] / b->divisor[i];
+}
+
+static void rda_batch_apply(struct rda_batch *b, struct rda_item *rda_base) {
+    for(size_t i = 0; i < b->used ; i++) {
+        RRDDIM *rd = rda_base[b->slot[i]].rd;
+
+        if(rd->algorithm == RRD_ALGORITHM_INCREMENTAL)
+            rd->collector.calculated_value += b->calculated[i];
+        else
+            rd->collector.calculated_value = b->calculated[i];
+    }
+
+    b->used = 0;
+}
+
 static inline size_t rrdset_done_interpolate(
     RRDSET_STREAM_BUFFER *rsb
     , RRDSET *st
@@ -508,6 +591,8 @@ void rrdset_done(RRDSET *st) {
 void rrdset_timed_done(RRDSET *st, struct timeval now, bool pending_rrdset_next) {
     if(unlikely(!service_running(SERVICE_COLLECTORS))) return;
 
+    usec_t started_ut = now_monotonic_usec();
+
     RRDSET_STREAM_BUFFER stream_buffer = { .wb = NULL, };
     if(unlikely(rrdhost_has_stream_sender_enabled(st->rrdhost)))
         stream_buffer = stream_send_metrics_init(st, now.tv_sec);
@@ -702,6 +787,8 @@ void rrdset_timed_done(RRDSET *st, struct timeval now, bool pending_rrdset_next)
     // process all dimensions to calculate their values
     // based on the collected figures only
     // at this stage we do not interpolate anything
+    // the common cases are calculated in a batch, unless the chart is being debugged
+    struct rda_batch *batch = (rrdset_flags & RRDSET_FLAG_DEBUG) ? NULL : &thread_rda_batch;
     for(dim_id = 0, rda = rda_base ; dim_id < rda_slots ; ++dim_id, ++rda) {
         rd = rda->rd;
         if(unlikely(!rd)) continue;
@@ -711,6 +798,19 @@ void rrdset_timed_done(RRDSET *st, struct timeval now, bool pending_rrdset_next)
             continue;
         }
 
+        if(likely(batch)) {
+            if(rd->algorithm == RRD_ALGORITHM_ABSOLUTE) {
+                rda_batch_add(batch, dim_id, rd, 0);
+                continue;
+            }
+
+            if(rd->algorithm == RRD_ALGORITHM_INCREMENTAL && rd->collector.counter > 1 &&
+                (uint64_t)rd->collector.last_collected_value <= (uint64_t)rd->collector.collected_value) {
+                rda_batch_add(batch, dim_id, rd, rd->collector.last_collected_value);
+                continue;
+            }
+        }
+
         rrdset_debug(st, "%s: START "
                          " last_collected_value = " COLLECTED_NUMBER_FORMAT
                          " collected_value = " COLLECTED_NUMBER_FORMAT
@@ -882,6 +982,11 @@ void rrdset_timed_done(RRDSET *st, struct timeval now, bool pending_rrdset_next)
         );
     }
 
+    if(batch && batch->used) {
+        rda_batch_calculate(batch);
+        rda_batch_apply(batch, rda_base);
+    }
+
     // at this point we have all the calculated values ready
     // it is now time to interpolate values on a second boundary
 
@@ -893,7 +998,7 @@ void rrdset_timed_done(RRDSET *st, struct timeval now, bool pending_rrdset_next)
     //     }
     // #endif
 
-    rrdset_done_interpolate(
+    size_t stored_entries = rrdset_done_interpolate(
         &stream_buffer
         , st
         , rda_base
@@ -981,4 +1086,8 @@ void rrdset_timed_done(RRDSET *st, struct timeval now, bool pending_rrdset_next)
     rrdcontext_collected_rrdset(st);
 
     store_metric_collection_completed();
+
+    st->cost.points_stored += stored_entries;
+    st->cost.done_ut += now_monotonic_usec() - started_ut;
+    st->cost.done++;
 }
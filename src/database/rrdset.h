@@ -154,6 +154,21 @@ struct rrdset {
 
     DICTIONARY *functions_view;                     // collector functions this rrdset supports, can be NULL
 
+    // ------------------------------------------------------------------------
+    // data collection - cost accounting, for the netdata-collection-cost function
+
+    struct {
+        usec_t done_ut;                             // the time spent in rrdset_done()
+        uint64_t done;                              // the number of rrdset_done() calls accounted in done_ut
+        uint64_t points_stored;                     // the points stored in tier 0, for all dimensions
+        uint64_t bytes_streamed;                    // the bytes of collected data sent to the parent
+        uint32_t dimensions_added;                  // atomic, the dimensions created
+        uint32_t dimensions_deleted;                // atomic, the dimensions deleted
+        uint32_t dimensions_aggregated;             // atomic, the dimensions aggregated over the plugin's budget
+        uint32_t dimensions_refused;                // atomic, the dimensions that could not be aggregated over the budget
+        DICTIONARY *aggregated_ids;                 // the ids of the aggregated dimensions, created on first use
+    } cost;
+
     // ------------------------------------------------------------------------
     // data collection - streaming to parents, temp variables
 
@@ -28,6 +28,14 @@
 
 #define ARAL_PAGE_INCOMING_PARTITIONS 4 // up to 32 (32-bits bitmap)
 
+// pages with free elements are kept in one list per NUMA node
+// systems with more nodes share the lists (node % ARAL_NUMA_NODES_MAX)
+#define ARAL_NUMA_NODES_MAX 8
+
+#if !defined(FSANITIZE_ADDRESS) && !defined(NETDATA_TRACE_ALLOCATIONS)
+#define ARAL_WITH_THREAD_CACHE 1
+#endif
+
 typedef struct aral_free {
     size_t size;
     struct aral_free *next;
@@ -41,6 +49,7 @@ typedef struct aral_page {
 
     bool started_marked;
     bool mapped;
+    uint8_t numa_node;                  // the NUMA node of the thread that created the page
     uint32_t size;                      // the allocation size of the page
     uint32_t max_elements;              // the number of elements that can fit on this page
     uint64_t elements_segmented;        // fast path for acquiring new elements in this page
@@ -80,6 +89,7 @@ typedef enum {
     ARAL_LOCKLESS           = (1 << 0),
     ARAL_ALLOCATED_STATS    = (1 << 1),
     ARAL_DONT_DUMP          = (1 << 2),
+    ARAL_THREAD_CACHE       = (1 << 3),
 } ARAL_OPTIONS;
 
 struct aral_ops {
@@ -101,11 +111,11 @@ struct aral {
         SPINLOCK spinlock;
         size_t file_number;             // for mmap
 
-        ARAL_PAGE *pages_free;          // pages with free items
-        ARAL_PAGE *pages_full;          // pages that are completely full
+        ARAL_PAGE *pages_free[ARAL_NUMA_NODES_MAX];         // pages with free items, per NUMA node
+        ARAL_PAGE *pages_full;                              // pages that are completely full
 
-        ARAL_PAGE *pages_marked_free;   // pages with marked items and free slots
-        ARAL_PAGE *pages_marked_full;   // pages with marked items completely full
+        ARAL_PAGE *pages_marked_free[ARAL_NUMA_NODES_MAX];  // pages with marked items and free slots, per NUMA node
+        ARAL_PAGE *pages_marked_full;                       // pages with marked items completely full
     } aral_lock;
 
     struct {
@@ -123,6 +133,8 @@ struct aral {
 
         size_t min_required_page_size;
 
+        uint32_t thread_cache_id;       // the index of the magazines of this ARAL, in the per-thread caches
+
         struct {
             bool enabled;
             const char *filename;
@@ -141,11 +153,54 @@ struct aral {
 };
 
 #define mark_to_idx(marked) (marked ? 1 : 0)
-#define aral_pages_head_free(ar, marked) (marked ? &ar->aral_lock.pages_marked_free : &ar->aral_lock.pages_free)
+#define aral_pages_head_free(ar, marked, node) (marked ? &ar->aral_lock.pages_marked_free[node] : &ar->aral_lock.pages_free[node])
 #define aral_pages_head_full(ar, marked) (marked ? &ar->aral_lock.pages_marked_full : &ar->aral_lock.pages_full)
 
 static size_t aral_max_allocation_size(ARAL *ar);
 
+#ifdef ARAL_WITH_THREAD_CACHE
+#define ARAL_THREAD_CACHE_ELEMENTS 16               // the max free elements a thread keeps per ARAL
+#define ARAL_THREAD_CACHE_MAX_ELEMENT_SIZE 1024     // larger elements are not cached
+#define ARAL_THREAD_CACHE_PUBLISH_EVERY 1024        // operations between updates of the shared statistics
+
+typedef struct aral_magazine {
+    ARAL *ar;                           // the ARAL currently using this magazine
+    uint32_t entries;
+    uint32_t ops;
+
+    // statistics not yet published to the ARAL
+    size_t hits;
+    size_t frees;
+    size_t returned;
+
+    void *elements[ARAL_THREAD_CACHE_ELEMENTS];
+} ARAL_MAGAZINE;
+
+typedef struct aral_thread_cache {
+    SPINLOCK spinlock;                  // uncontended - it is taken by other threads only by aral_destroy()
+    uint32_t size;                      // the number of slots in magazines
+    ARAL_MAGAZINE **magazines;          // indexed by the thread_cache_id of each ARAL, allocated on first use
+    struct aral_thread_cache *prev, *next;
+} ARAL_THREAD_MAGAZINES;
+
+static __thread ARAL_THREAD_MAGAZINES *aral_thread_cache = NULL;
+
+static struct {
+    SPINLOCK spinlock;
+    ARAL_THREAD_MAGAZINES *list;            // the caches of all threads
+    uint32_t next_id;                       // the next thread_cache_id never used
+    uint32_t *free_ids;                     // the thread_cache_id of destroyed ARALs, to be reused
+    uint32_t free_ids_count;
+    uint32_t free_ids_size;
+    bool disabled;
+    pthread_key_t key;                      // releases the caches of threads not created with nd_thread_create()
+    pthread_once_t once;
+} aral_thread_caches = {
+    .spinlock = SPINLOCK_INITIALIZER,
+    .once = PTHREAD_ONCE_INIT,
+};
+#endif
+
 static inline bool aral_malloc_use_mmap(ARAL *ar __maybe_unused, size_t size) {
     unsigned long long mmap_limit = os_mmap_limit();
 
@@ -159,6 +214,10 @@ const char *aral_name(ARAL *ar) {
     return ar->config.name;
 }
 
+static ALWAYS_INLINE size_t aral_numa_node(void) {
+    return os_numa_node_current() % ARAL_NUMA_NODES_MAX;
+}
+
 static ALWAYS_INLINE void aral_element_given(ARAL *ar, ARAL_PAGE *page) {
     if(ar->config.mmap.enabled || page->mapped)
         __atomic_add_fetch(&ar->stats->mmap.used_bytes, ar->config.requested_element_size, __ATOMIC_RELAXED);
@@ -226,9 +285,9 @@ struct aral_statistics *aral_get_statistics(ARAL *ar) {
     return ar->stats;
 }
 
-static ALWAYS_INLINE void aral_lock_with_trace(ARAL *ar, const char *func) {
+static ALWAYS_INLINE void aral_lock_with_trace(ARAL *ar, const char *func, const char *file, uint32_t line) {
     if(likely(!(ar->config.options & ARAL_LOCKLESS)))
-        spinlock_lock_with_trace(&ar->aral_lock.spinlock, func);
+        spinlock_lock_with_trace(&ar->aral_lock.spinlock, func, file, line);
 }
 
 static ALWAYS_INLINE void aral_unlock_with_trace(ARAL *ar, const char *func) {
@@ -236,7 +295,7 @@ static ALWAYS_INLINE void aral_unlock_with_trace(ARAL *ar, const char *func) {
         spinlock_unlock_with_trace(&ar->aral_lock.spinlock, func);
 }
 
-#define aral_lock(ar) aral_lock_with_trace(ar, __FUNCTION__)
+#define aral_lock(ar) aral_lock_with_trace(ar, __FUNCTION__, __FILE__, __LINE__)
 #define aral_unlock(ar) aral_unlock_with_trace(ar, __FUNCTION__)
 
 static ALWAYS_INLINE void aral_page_lock(ARAL *ar, ARAL_PAGE *page) {
@@ -339,16 +398,18 @@ static inline struct free_space check_free_space___aral_lock_needed(ARAL *ar, AR
     struct free_space f = { 0 };
 
     f.max_page_elements = aral_max_allocation_size(ar) / ar->config.element_size;
-    for(f.p = *aral_pages_head_free(ar, marked); f.p ; f.lp = f.p, f.p = f.p->aral_lock.next) {
-        f.pages++;
-        internal_fatal(!f.p->aral_lock.free_elements, "page is in the free list, but does not have any elements free");
-        internal_fatal(f.p->marked != marked, "page is in the wrong mark list");
+    for(size_t node = 0; node < ARAL_NUMA_NODES_MAX ; node++) {
+        for(f.p = *aral_pages_head_free(ar, marked, node); f.p ; f.lp = f.p, f.p = f.p->aral_lock.next) {
+            f.pages++;
+            internal_fatal(!f.p->aral_lock.free_elements, "page is in the free list, but does not have any elements free");
+            internal_fatal(f.p->marked != marked, "page is in the wrong mark list");
 
-        if(f.p != my_page && f.max_free_elements_on_a_page < f.p->aral_lock.free_elements)
-            f.max_free_elements_on_a_page = f.p->aral_lock.free_elements;
+            if(f.p != my_page && f.max_free_elements_on_a_page < f.p->aral_lock.free_elements)
+                f.max_free_elements_on_a_page = f.p->aral_lock.free_elements;
 
-        f.free_elements += f.p->aral_lock.free_elements;
-        f.pages_with_free_elements++;
+            f.free_elements += f.p->aral_lock.free_elements;
+            f.pages_with_free_elements++;
+        }
     }
 
     for(f.p = *aral_pages_head_full(ar, marked); f.p ; f.lp = f.p, f.p = f.p->aral_lock.next) {
@@ -386,8 +447,8 @@ static inline ARAL_PAGE *find_page_with_allocation_internal_check(ARAL *ar, void
             break;
     }
 
-    if(!page) {
-        for(page = *aral_pages_head_free(ar, marked); page ; page = page->aral_lock.next) {
+    for(size_t node = 0; !page && node < ARAL_NUMA_NODES_MAX ; node++) {
+        for(page = *aral_pages_head_free(ar, marked, node); page ; page = page->aral_lock.next) {
             if(unlikely(seeking >= (uintptr_t)page->data && seeking < (uintptr_t)page->data + page->size))
                 break;
         }
@@ -598,6 +659,7 @@ static ARAL_PAGE *aral_create_page___no_lock_needed(ARAL *ar, size_t size TRACE_
         spinlock_init(&page->incoming[p].spinlock);
 
     page->size = size;
+    page->numa_node = aral_numa_node();
     page->max_elements = aral_elements_in_page_size(ar, page->size);
     page->page_lock.free_elements = page->max_elements;
     spinlock_init(&page->page_lock.spinlock);
@@ -689,10 +751,14 @@ static bool aral_page_acquire(ARAL_PAGE *page) {
 
 ALWAYS_INLINE WARNUNUSED
 static ARAL_PAGE *aral_acquire_first_page(ARAL *ar, bool marked) {
+    size_t local_node = aral_numa_node();
+
     aral_lock(ar);
 
-    ARAL_PAGE **head_ptr_free = aral_pages_head_free(ar, marked);
-    ARAL_PAGE *page = *head_ptr_free;
+    // prefer the pages of our NUMA node, and fall back to the pages of the other nodes
+    ARAL_PAGE *page = *aral_pages_head_free(ar, marked, local_node);
+    for(size_t n = 1; !page && n < ARAL_NUMA_NODES_MAX ; n++)
+        page = *aral_pages_head_free(ar, marked, (local_node + n) % ARAL_NUMA_NODES_MAX);
 
     if(page && !aral_page_acquire(page))
         page = NULL;
@@ -750,7 +816,7 @@ static ALWAYS_INLINE ARAL_PAGE *aral_get_first_page_with_a_free_slot(ARAL *ar, b
             page = aral_create_page___no_lock_needed(ar, page_allocation_size TRACE_ALLOCATIONS_FUNCTION_CALL_PARAMS);
             page->aral_lock.marked = page->started_marked = marked;
 
-            ARAL_PAGE **head_ptr_free = aral_pages_head_free(ar, marked);
+            ARAL_PAGE **head_ptr_free = aral_pages_head_free(ar, marked, page->numa_node);
             aral_lock(ar);
             DOUBLE_LINKED_LIST_APPEND_ITEM_UNSAFE(*head_ptr_free, page, aral_lock.prev, aral_lock.next);
             page->aral_lock.head_ptr = head_ptr_free;
@@ -913,91 +979,7 @@ static inline void aral_add_free_slot___no_lock_required(ARAL *ar, ARAL_PAGE *pa
     }
 }
 
-ALWAYS_INLINE void *aral_callocz_internal(ARAL *ar, bool marked TRACE_ALLOCATIONS_FUNCTION_DEFINITION_PARAMS) {
-    void *r = aral_mallocz_internal(ar, marked TRACE_ALLOCATIONS_FUNCTION_CALL_PARAMS);
-    memset(r, 0, ar->config.requested_element_size);
-    return r;
-}
-
-void *aral_mallocz_internal(ARAL *ar, bool marked TRACE_ALLOCATIONS_FUNCTION_DEFINITION_PARAMS) {
-#if defined(FSANITIZE_ADDRESS)
-    if(ar->stats) {
-        __atomic_add_fetch(&ar->stats->malloc.allocations, 1, __ATOMIC_RELAXED);
-        __atomic_add_fetch(&ar->stats->malloc.allocated_bytes, ar->config.requested_element_size, __ATOMIC_RELAXED);
-        __atomic_add_fetch(&ar->stats->malloc.used_bytes, ar->config.requested_element_size, __ATOMIC_RELAXED);
-    }
-    return mallocz(ar->config.requested_element_size);
-#endif
-
-    // reserve a slot on a free page
-    ARAL_PAGE *page = aral_get_first_page_with_a_free_slot(ar, marked TRACE_ALLOCATIONS_FUNCTION_CALL_PARAMS);
-    // the page returned has reserved a slot for us
-
-    void *data = aral_get_free_slot___no_lock_required(ar, page, marked);
-
-    internal_fatal((uintptr_t)data % SYSTEM_REQUIRED_ALIGNMENT != 0, "Pointer is not aligned properly");
-
-    return data;
-}
-
-void aral_unmark_allocation(ARAL *ar, void *ptr) {
-#if defined(FSANITIZE_ADDRESS)
-    return;
-#endif
-
-    if(unlikely(!ptr)) return;
-
-    // get the page pointer
-    bool marked;
-    ARAL_PAGE *page = aral_get_page_pointer_after_element___do_NOT_have_aral_lock(ar, ptr, &marked);
-
-    internal_fatal(!marked, "This allocation does is not marked");
-
-    if(marked)
-        aral_set_page_pointer_after_element___do_NOT_have_aral_lock(ar, page, ptr, false);
-
-    aral_page_lock(ar, page);
-    internal_fatal(marked && !page->page_lock.marked_elements, "Marked counter going negative.");
-    bool unmark = marked && --page->page_lock.marked_elements == 0 && page->page_lock.used_elements;
-
-    if(unmark) {
-        aral_lock(ar);
-        internal_fatal(!is_page_in_list(*page->aral_lock.head_ptr, page), "Page is not in this list");
-
-        ARAL_PAGE **head_ptr_to = (page->page_lock.free_elements) ? aral_pages_head_free(ar, false) : aral_pages_head_full(ar, false);
-        if(page->aral_lock.head_ptr != head_ptr_to) {
-            internal_fatal(!is_page_in_list(*page->aral_lock.head_ptr, page), "Page is not in this list");
-            DOUBLE_LINKED_LIST_REMOVE_ITEM_UNSAFE(*page->aral_lock.head_ptr, page, aral_lock.prev, aral_lock.next);
-            DOUBLE_LINKED_LIST_APPEND_ITEM_UNSAFE(*head_ptr_to, page, aral_lock.prev, aral_lock.next);
-            page->aral_lock.head_ptr = head_ptr_to;
-            page->aral_lock.marked = false;
-        }
-
-        internal_fatal(page->page_lock.marked_elements > page->page_lock.used_elements,
-                       "page has more marked elements than the used ones");
-        aral_unlock(ar);
-    }
-
-    aral_page_unlock(ar, page);
-}
-
-void aral_freez_internal(ARAL *ar, void *ptr TRACE_ALLOCATIONS_FUNCTION_DEFINITION_PARAMS) {
-#if defined(FSANITIZE_ADDRESS)
-    if(ptr && ar->stats) {
-        __atomic_sub_fetch(&ar->stats->malloc.allocations, 1, __ATOMIC_RELAXED);
-        __atomic_sub_fetch(&ar->stats->malloc.allocated_bytes, ar->config.requested_element_size, __ATOMIC_RELAXED);
-        __atomic_sub_fetch(&ar->stats->malloc.used_bytes, ar->config.requested_element_size, __ATOMIC_RELAXED);
-    }
-    freez(ptr);
-    return;
-#endif
-
-    if(unlikely(!ptr)) return;
-
-    // get the page pointer
-    bool marked;
-    ARAL_PAGE *page = aral_get_page_pointer_after_element___do_NOT_have_aral_lock(ar, ptr, &marked);
-
+static void aral_freez_to_page___no_lock_required(ARAL *ar, ARAL_PAGE *page, void *ptr, bool marked TRACE_ALLOCATIONS_FUNCTION_DEFINITION_PARAMS) {
     size_t idx = mark_to_idx(marked);
     __atomic_add_fetch(&ar->ops[idx].atomic.deallocators, 1, __ATOMIC_RELAXED);
 
@@ -1006,7 +988,6 @@ void aral_freez_internal(ARAL *ar, void *ptr TRACE_ALLOCATIONS_FUNCTION_DEFINITI
 
     // statistic, outside the lock
     aral_element_returned(ar, page);
-    __atomic_add_fetch(&ar->atomic.user_free_operations, 1, __ATOMIC_RELAXED);
 
     aral_page_lock(ar, page);
     internal_fatal(!page->page_lock.used_elements,
@@ -1074,7 +1055,7 @@ void aral_freez_internal(ARAL *ar, void *ptr TRACE_ALLOCATIONS_FUNCTION_DEFINITI
     else if(unlikely(unmark)) {
         aral_lock(ar);
 
-        ARAL_PAGE **head_ptr_to = aral_pages_head_free(ar, false);
+        ARAL_PAGE **head_ptr_to = aral_pages_head_free(ar, false, page->numa_node);
         if(page->aral_lock.head_ptr != head_ptr_to) {
             internal_fatal(!is_page_in_list(*page->aral_lock.head_ptr, page), "Page is not in this list");
             DOUBLE_LINKED_LIST_REMOVE_ITEM_UNSAFE(*page->aral_lock.head_ptr, page, aral_lock.prev, aral_lock.next);
@@ -1086,7 +1067,7 @@ void aral_freez_internal(ARAL *ar, void *ptr TRACE_ALLOCATIONS_FUNCTION_DEFINITI
     }
     else if(unlikely(page->page_lock.used_elements == page->max_elements - 1)) {
         aral_lock(ar);
-        ARAL_PAGE **head_ptr_to = aral_pages_head_free(ar, page->aral_lock.marked);
+        ARAL_PAGE **head_ptr_to = aral_pages_head_free(ar, page->aral_lock.marked, page->numa_node);
         if(page->aral_lock.head_ptr != head_ptr_to) {
             internal_fatal(!is_page_in_list(*page->aral_lock.head_ptr, page), "Page is not in this list");
             DOUBLE_LINKED_LIST_REMOVE_ITEM_UNSAFE(*page->aral_lock.head_ptr, page, aral_lock.prev, aral_lock.next);
@@ -1100,20 +1081,393 @@ void aral_freez_internal(ARAL *ar, void *ptr TRACE_ALLOCATIONS_FUNCTION_DEFINITI
     __atomic_sub_fetch(&ar->ops[idx].atomic.deallocators, 1, __ATOMIC_RELAXED);
 }
 
+// --------------------------------------------------------------------------------------------------------------------
+// per-thread caches of free elements
+//
+// Every thread keeps a magazine of free elements per ARAL, so that alloc/free cycles on the
+// same thread are served without touching the shared pages and their locks.
+// Each ARAL has its own id, indexing its magazine in the caches of all threads,
+// so ARALs never share or evict each other's magazines. Ids are reused after aral_destroy().
+// Only unmarked allocations of locked, malloc based ARALs with small elements are cached.
+// Elements in the magazines are still accounted as used on their pages.
+// Hoarding is bounded: a full magazine gives half of its elements back to their pages,
+// and all of them are given back when the thread exits.
+
+#ifdef ARAL_WITH_THREAD_CACHE
+
+static void aral_thread_cache_publish(ARAL_MAGAZINE *mg) {
+    ARAL *ar = mg->ar;
+
+    if(mg->hits) {
+        __atomic_add_fetch(&ar->stats->thread_cache.hits, mg->hits, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&ar->atomic.user_malloc_operations, mg->hits, __ATOMIC_RELAXED);
+    }
+
+    if(mg->frees) {
+        __atomic_add_fetch(&ar->stats->thread_cache.frees, mg->frees, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&ar->atomic.user_free_operations, mg->frees, __ATOMIC_RELAXED);
+    }
+
+    if(mg->returned)
+        __atomic_add_fetch(&ar->stats->thread_cache.returned, mg->returned, __ATOMIC_RELAXED);
+
+    mg->hits = mg->frees = mg->returned = 0;
+    mg->ops = 0;
+}
+
+// give back to their pages the oldest elements of a magazine
+static void aral_thread_cache_flush_magazine___thread_cache_lock_needed(ARAL_MAGAZINE *mg, uint32_t elements) {
+    ARAL *ar = mg->ar;
+    if(!ar) return;
+
+    if(elements > mg->entries)
+        elements = mg->entries;
+
+    for(uint32_t i = 0; i < elements ; i++) {
+        bool marked;
+        ARAL_PAGE *page = aral_get_page_pointer_after_element___do_NOT_have_aral_lock(ar, mg->elements[i], &marked);
+        aral_freez_to_page___no_lock_required(ar, page, mg->elements[i], marked);
+    }
+
+    mg->entries -= elements;
+    if(mg->entries)
+        memmove(&mg->elements[0], &mg->elements[elements], mg->entries * sizeof(void *));
+
+    mg->returned += elements;
+    aral_thread_cache_publish(mg);
+
+    if(!mg->entries)
+        mg->ar = NULL;
+}
+
+static uint32_t aral_thread_cache_id_get(void) {
+    uint32_t id;
+
+    spinlock_lock(&aral_thread_caches.spinlock);
+    if(aral_thread_caches.free_ids_count)
+        id = aral_thread_caches.free_ids[--aral_thread_caches.free_ids_count];
+    else
+        id = aral_thread_caches.next_id++;
+    spinlock_unlock(&aral_thread_caches.spinlock);
+
+    return id;
+}
+
+static void aral_thread_cache_id_put___thread_caches_lock_needed(uint32_t id) {
+    if(aral_thread_caches.free_ids_count >= aral_thread_caches.free_ids_size) {
+        aral_thread_caches.free_ids_size = aral_thread_caches.free_ids_size ? aral_thread_caches.free_ids_size * 2 : 64;
+        aral_thread_caches.free_ids = reallocz(aral_thread_caches.free_ids, aral_thread_caches.free_ids_size * sizeof(uint32_t));
+    }
+
+    aral_thread_caches.free_ids[aral_thread_caches.free_ids_count++] = id;
+}
+
+static ALWAYS_INLINE ARAL_MAGAZINE *aral_thread_cache_magazine___thread_cache_lock_needed(ARAL_THREAD_MAGAZINES *tc, ARAL *ar) {
+    uint32_t id = ar->config.thread_cache_id;
+    return id < tc->size ? tc->magazines[id] : NULL;
+}
+
+static ARAL_MAGAZINE *aral_thread_cache_magazine_create___thread_cache_lock_needed(ARAL_THREAD_MAGAZINES *tc, ARAL *ar) {
+    uint32_t id = ar->config.thread_cache_id;
+
+    if(id >= tc->size) {
+        uint32_t size = tc->size ? tc->size : 16;
+        while(size <= id)
+            size *= 2;
+
+        tc->magazines = reallocz(tc->magazines, size * sizeof(ARAL_MAGAZINE *));
+        memset(&tc->magazines[tc->size], 0, (size - tc->size) * sizeof(ARAL_MAGAZINE *));
+        tc->size = size;
+    }
+
+    if(!tc->magazines[id])
+        tc->magazines[id] = callocz(1, sizeof(ARAL_MAGAZINE));
+
+    return tc->magazines[id];
+}
+
+static void aral_thread_cache_key_destructor(void *ptr __maybe_unused) {
+    // the cache may have been released already by nd_thread_create()'s exit path,
+    // and the other destructors may create it again, which registers it again
+    aral_thread_cache_release();
+}
+
+static void aral_thread_cache_key_create(void) {
+    pthread_key_create(&aral_thread_caches.key, aral_thread_cache_key_destructor);
+}
+
+static ARAL_THREAD_MAGAZINES *aral_thread_cache_get_or_create(void) {
+    if(likely(aral_thread_cache))
+        return aral_thread_cache;
+
+    pthread_once(&aral_thread_caches.once, aral_thread_cache_key_create);
+
+    ARAL_THREAD_MAGAZINES *tc = callocz(1, sizeof(*tc));
+    spinlock_init(&tc->spinlock);
+
+    spinlock_lock(&aral_thread_caches.spinlock);
+    DOUBLE_LINKED_LIST_APPEND_ITEM_UNSAFE(aral_thread_caches.list, tc, prev, next);
+    spinlock_unlock(&aral_thread_caches.spinlock);
+
+    aral_thread_cache = tc;
+
+    // the value is not used, it only has to be non-NULL for the destructor to run
+    pthread_setspecific(aral_thread_caches.key, tc);
+    return tc;
+}
+
+static ALWAYS_INLINE void *aral_thread_cache_get(ARAL *ar) {
+    ARAL_THREAD_MAGAZINES *tc = aral_thread_cache;
+    if(!tc) return NULL;
+
+    void *ptr = NULL;
+
+    spinlock_lock(&tc->spinlock);
+    ARAL_MAGAZINE *mg = aral_thread_cache_magazine___thread_cache_lock_needed(tc, ar);
+    if(mg && mg->entries) {
+        ptr = mg->elements[--mg->entries];
+        mg->hits++;
+
+        if(unlikely(++mg->ops >= ARAL_THREAD_CACHE_PUBLISH_EVERY))
+            aral_thread_cache_publish(mg);
+    }
+    spinlock_unlock(&tc->spinlock);
+
+    return ptr;
+}
+
+static ALWAYS_INLINE bool aral_thread_cache_put(ARAL *ar, ARAL_PAGE *page, void *ptr) {
+    if(unlikely(__atomic_load_n(&aral_thread_caches.disabled, __ATOMIC_RELAXED)))
+        return false;
+
+    // elements of pages of other NUMA nodes go back home
+    if(unlikely(os_numa_nodes() > 1 && page->numa_node != aral_numa_node()))
+        return false;
+
+    ARAL_THREAD_MAGAZINES *tc = aral_thread_cache_get_or_create();
+
+    spinlock_lock(&tc->spinlock);
+    ARAL_MAGAZINE *mg = aral_thread_cache_magazine___thread_cache_lock_needed(tc, ar);
+    if(unlikely(!mg))
+        mg = aral_thread_cache_magazine_create___thread_cache_lock_needed(tc, ar);
+    else if(unlikely(mg->entries >= ARAL_THREAD_CACHE_ELEMENTS))
+        aral_thread_cache_flush_magazine___thread_cache_lock_needed(mg, ARAL_THREAD_CACHE_ELEMENTS / 2);
+
+    mg->ar = ar;
+    mg->elements[mg->entries++] = ptr;
+    mg->frees++;
+
+    if(unlikely(++mg->ops >= ARAL_THREAD_CACHE_PUBLISH_EVERY))
+        aral_thread_cache_publish(mg);
+
+    spinlock_unlock(&tc->spinlock);
+
+    return true;
+}
+
+// called by aral_destroy() - the elements of the ARAL in the caches of all threads are dropped,
+// since all its pages are going to be freed
+static void aral_thread_caches_drop_aral(ARAL *ar) {
+    if(!(ar->config.options & ARAL_THREAD_CACHE))
+        return;
+
+    spinlock_lock(&aral_thread_caches.spinlock);
+    for(ARAL_THREAD_MAGAZINES *tc = aral_thread_caches.list; tc ; tc = tc->next) {
+        spinlock_lock(&tc->spinlock);
+        ARAL_MAGAZINE *mg = aral_thread_cache_magazine___thread_cache_lock_needed(tc, ar);
+        if(mg && mg->ar == ar) {
+            for(uint32_t i = 0; i < mg->entries ; i++) {
+                bool marked;
+                ARAL_PAGE *page = aral_get_page_pointer_after_element___do_NOT_have_aral_lock(ar, mg->elements[i], &marked);
+                aral_element_returned(ar, page);
+            }
+            aral_thread_cache_publish(mg);
+            mg->entries = 0;
+            mg->ar = NULL;
+        }
+        spinlock_unlock(&tc->spinlock);
+    }
+
+    // no thread has anything for this id anymore, another ARAL can use it
+    aral_thread_cache_id_put___thread_caches_lock_needed(ar->config.thread_cache_id);
+    spinlock_unlock(&aral_thread_caches.spinlock);
+}
+
+// give back the elements of the calling thread for this ARAL
+static void aral_thread_cache_flush_aral(ARAL *ar) {
+    ARAL_THREAD_MAGAZINES *tc = aral_thread_cache;
+    if(!tc || !(ar->config.options & ARAL_THREAD_CACHE)) return;
+
+    spinlock_lock(&tc->spinlock);
+    ARAL_MAGAZINE *mg = aral_thread_cache_magazine___thread_cache_lock_needed(tc, ar);
+    if(mg)
+        aral_thread_cache_flush_magazine___thread_cache_lock_needed(mg, mg->entries);
+    spinlock_unlock(&tc->spinlock);
+}
+
+void aral_thread_cache_release(void) {
+    ARAL_THREAD_MAGAZINES *tc = aral_thread_cache;
+    if(!tc) return;
+
+    spinlock_lock(&tc->spinlock);
+    for(uint32_t i = 0; i < tc->size ; i++) {
+        ARAL_MAGAZINE *mg = tc->magazines[i];
+        if(!mg) continue;
+
+        aral_thread_cache_flush_magazine___thread_cache_lock_needed(mg, mg->entries);
+        freez(mg);
+        tc->magazines[i] = NULL;
+    }
+    spinlock_unlock(&tc->spinlock);
+
+    spinlock_lock(&aral_thread_caches.spinlock);
+    DOUBLE_LINKED_LIST_REMOVE_ITEM_UNSAFE(aral_thread_caches.list, tc, prev, next);
+    spinlock_unlock(&aral_thread_caches.spinlock);
+
+    aral_thread_cache = NULL;
+    freez(tc->magazines);
+    freez(tc);
+}
+
+#else // !ARAL_WITH_THREAD_CACHE
+
+#define aral_thread_caches_drop_aral(ar) debug_dummy()
+#define aral_thread_cache_flush_aral(ar) debug_dummy()
+void aral_thread_cache_release(void) { ; }
+
+#endif // !ARAL_WITH_THREAD_CACHE
+
+ALWAYS_INLINE void *aral_callocz_internal(ARAL *ar, bool marked TRACE_ALLOCATIONS_FUNCTION_DEFINITION_PARAMS) {
+    void *r = aral_mallocz_internal(ar, marked TRACE_ALLOCATIONS_FUNCTION_CALL_PARAMS);
+    memset(r, 0, ar->config.requested_element_size);
+    return r;
+}
+
+void *aral_mallocz_internal(ARAL *ar, bool marked TRACE_ALLOCATIONS_FUNCTION_DEFINITION_PARAMS) {
+#if defined(FSANITIZE_ADDRESS)
+    if(ar->stats) {
+        __atomic_add_fetch(&ar->stats->malloc.allocations, 1, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&ar->stats->malloc.allocated_bytes, ar->config.requested_element_size, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&ar->stats->malloc.used_bytes, ar->config.requested_element_size, __ATOMIC_RELAXED);
+    }
+    return mallocz(ar->config.requested_element_size);
+#endif
+
+#ifdef ARAL_WITH_THREAD_CACHE
+    if(!marked && (ar->config.options & ARAL_THREAD_CACHE)) {
+        void *cached = aral_thread_cache_get(ar);
+        if(cached)
+            return cached;
+
+        __atomic_add_fetch(&ar->stats->thread_cache.misses, 1, __ATOMIC_RELAXED);
+    }
+#endif
+
+    // reserve a slot on a free page
+    ARAL_PAGE *page = aral_get_first_page_with_a_free_slot(ar, marked TRACE_ALLOCATIONS_FUNCTION_CALL_PARAMS);
+    // the page returned has reserved a slot for us
+
+    void *data = aral_get_free_slot___no_lock_required(ar, page, marked);
+
+    internal_fatal((uintptr_t)data % SYSTEM_REQUIRED_ALIGNMENT != 0, "Pointer is not aligned properly");
+
+    return data;
+}
+
+void aral_unmark_allocation(ARAL *ar, void *ptr) {
+#if defined(FSANITIZE_ADDRESS)
+    return;
+#endif
+
+    if(unlikely(!ptr)) return;
+
+    // get the page pointer
+    bool marked;
+    ARAL_PAGE *page = aral_get_page_pointer_after_element___do_NOT_have_aral_lock(ar, ptr, &marked);
+
+    internal_fatal(!marked, "This allocation does is not marked");
+
+    if(marked)
+        aral_set_page_pointer_after_element___do_NOT_have_aral_lock(ar, page, ptr, false);
+
+    aral_page_lock(ar, page);
+    internal_fatal(marked && !page->page_lock.marked_elements, "Marked counter going negative.");
+    bool unmark = marked && --page->page_lock.marked_elements == 0 && page->page_lock.used_elements;
+
+    if(unmark) {
+        aral_lock(ar);
+        internal_fatal(!is_page_in_list(*page->aral_lock.head_ptr, page), "Page is not in this list");
+
+        ARAL_PAGE **head_ptr_to = (page->page_lock.free_elements) ? aral_pages_head_free(ar, false, page->numa_node) : aral_pages_head_full(ar, false);
+        if(page->aral_lock.head_ptr != head_ptr_to) {
+            internal_fatal(!is_page_in_list(*page->aral_lock.head_ptr, page), "Page is not in this list");
+            DOUBLE_LINKED_LIST_REMOVE_ITEM_UNSAFE(*page->aral_lock.head_ptr, page, aral_lock.prev, aral_lock.next);
+            DOUBLE_LINKED_LIST_APPEND_ITEM_UNSAFE(*head_ptr_to, page, aral_lock.prev, aral_lock.next);
+            page->aral_lock.head_ptr = head_ptr_to;
+            page->aral_lock.marked = false;
+        }
+
+        internal_fatal(page->page_lock.marked_elements > page->page_lock.used_elements,
+                       "page has more marked elements than the used ones");
+        aral_unlock(ar);
+    }
+
+    aral_page_unlock(ar, page);
+}
+
+void aral_freez_internal(ARAL *ar, void *ptr TRACE_ALLOCATIONS_FUNCTION_DEFINITION_PARAMS) {
+#if defined(FSANITIZE_ADDRESS)
+    if(ptr && ar->stats) {
+        __atomic_sub_fetch(&ar->stats->malloc.allocations, 1, __ATOMIC_RELAXED);
+        __atomic_sub_fetch(&ar->stats->malloc.allocated_bytes, ar->config.requested_element_size, __ATOMIC_RELAXED);
+        __atomic_sub_fetch(&ar->stats->malloc.used_bytes, ar->config.requested_element_size, __ATOMIC_RELAXED);
+    }
+    freez(ptr);
+    return;
+#endif
+
+    if(unlikely(!ptr)) return;
+
+    // get the page pointer
+    bool marked;
+    ARAL_PAGE *page = aral_get_page_pointer_after_element___do_NOT_have_aral_lock(ar, ptr, &marked);
+
+#ifdef ARAL_WITH_THREAD_CACHE
+    if(!marked && (ar->config.options & ARAL_THREAD_CACHE) && aral_thread_cache_put(ar, page, ptr))
+        return;
+#endif
+
+    __atomic_add_fetch(&ar->atomic.user_free_operations, 1, __ATOMIC_RELAXED);
+
+    if(unlikely(os_numa_nodes() > 1)) {
+        if(page->numa_node == aral_numa_node())
+            __atomic_add_fetch(&ar->stats->numa.local_frees, 1, __ATOMIC_RELAXED);
+        else
+            __atomic_add_fetch(&ar->stats->numa.remote_frees, 1, __ATOMIC_RELAXED);
+    }
+
+    aral_freez_to_page___no_lock_required(ar, page, ptr, marked TRACE_ALLOCATIONS_FUNCTION_CALL_PARAMS);
+}
+
 void aral_destroy_internal(ARAL *ar TRACE_ALLOCATIONS_FUNCTION_DEFINITION_PARAMS) {
+    aral_thread_caches_drop_aral(ar);
+
     aral_lock(ar);
 
-    ARAL_PAGE **head_ptr = aral_pages_head_free(ar, false);
+    ARAL_PAGE **head_ptr;
     ARAL_PAGE *page;
-    while((page = *head_ptr)) {
-        DOUBLE_LINKED_LIST_REMOVE_ITEM_UNSAFE(*head_ptr, page, aral_lock.prev, aral_lock.next);
-        aral_del_page___no_lock_needed(ar, page TRACE_ALLOCATIONS_FUNCTION_CALL_PARAMS);
-    }
+    for(size_t node = 0; node < ARAL_NUMA_NODES_MAX ; node++) {
+        head_ptr = aral_pages_head_free(ar, false, node);
+        while((page = *head_ptr)) {
+            DOUBLE_LINKED_LIST_REMOVE_ITEM_UNSAFE(*head_ptr, page, aral_lock.prev, aral_lock.next);
+            aral_del_page___no_lock_needed(ar, page TRACE_ALLOCATIONS_FUNCTION_CALL_PARAMS);
+        }
 
-    head_ptr = aral_pages_head_free(ar, true);
-    while((page = *head_ptr)) {
-        DOUBLE_LINKED_LIST_REMOVE_ITEM_UNSAFE(*head_ptr, page, aral_lock.prev, aral_lock.next);
-        aral_del_page___no_lock_needed(ar, page TRACE_ALLOCATIONS_FUNCTION_CALL_PARAMS);
+        head_ptr = aral_pages_head_free(ar, true, node);
+        while((page = *head_ptr)) {
+            DOUBLE_LINKED_LIST_REMOVE_ITEM_UNSAFE(*head_ptr, page, aral_lock.prev, aral_lock.next);
+            aral_del_page___no_lock_needed(ar, page TRACE_ALLOCATIONS_FUNCTION_CALL_PARAMS);
+        }
     }
 
     head_ptr = aral_pages_head_full(ar, false);
@@ -1239,10 +1593,18 @@ ARAL *aral_create(const char *name, size_t element_size, size_t initial_page_ele
 
     // ----------------------------------------------------------------------------------------------------------------
 
-    ar->aral_lock.pages_free = NULL;
-    ar->aral_lock.pages_marked_free = NULL;
     ar->aral_lock.file_number = 0;
 
+    // ----------------------------------------------------------------------------------------------------------------
+    // per-thread caches
+
+#ifdef ARAL_WITH_THREAD_CACHE
+    if(!lockless && !ar->config.mmap.enabled && ar->config.requested_element_size <= ARAL_THREAD_CACHE_MAX_ELEMENT_SIZE) {
+        ar->config.options |= ARAL_THREAD_CACHE;
+        ar->config.thread_cache_id = aral_thread_cache_id_get();
+    }
+#endif
+
     // ----------------------------------------------------------------------------------------------------------------
 
     if(ar->config.mmap.enabled) {
@@ -1406,6 +1768,19 @@ static inline struct aral_unittest_entry *unittest_aral_malloc(ARAL *ar, bool ma
     return t;
 }
 
+static bool aral_unittest_leftovers(ARAL *ar) {
+    // the elements of this thread are still used, while they are in its cache
+    aral_thread_cache_flush_aral(ar);
+
+    for(size_t node = 0; node < ARAL_NUMA_NODES_MAX ; node++) {
+        ARAL_PAGE *page = ar->aral_lock.pages_free[node];
+        if(page && page->page_lock.used_elements)
+            return true;
+    }
+
+    return false;
+}
+
 static void aral_test_thread(void *ptr) {
     struct aral_unittest_config *auc = ptr;
     ARAL *ar = auc->ar;
@@ -1455,7 +1830,7 @@ static void aral_test_thread(void *ptr) {
             pointers[i] = NULL;
         }
 
-        if (auc->single_threaded && ar->aral_lock.pages_free && ar->aral_lock.pages_free->page_lock.used_elements) {
+        if (auc->single_threaded && aral_unittest_leftovers(ar)) {
             fprintf(stderr, "\n\nARAL leftovers detected (1)\n\n");
             __atomic_add_fetch(&auc->errors, 1, __ATOMIC_RELAXED);
         }
@@ -1496,7 +1871,7 @@ static void aral_test_thread(void *ptr) {
             pointers[i] = NULL;
         }
 
-        if (auc->single_threaded && ar->aral_lock.pages_free && ar->aral_lock.pages_free->page_lock.used_elements) {
+        if (auc->single_threaded && aral_unittest_leftovers(ar)) {
             fprintf(stderr, "\n\nARAL leftovers detected (2)\n\n");
             __atomic_add_fetch(&auc->errors, 1, __ATOMIC_RELAXED);
         }
@@ -1560,7 +1935,7 @@ int aral_stress_test(size_t threads, size_t elements, size_t seconds) {
 
     usec_t ended_ut = now_monotonic_usec();
 
-    if (auc.ar->aral_lock.pages_free && auc.ar->aral_lock.pages_free->page_lock.used_elements) {
+    if (aral_unittest_leftovers(auc.ar)) {
         fprintf(stderr, "\n\nARAL leftovers detected (3)\n\n");
         __atomic_add_fetch(&auc.errors, 1, __ATOMIC_RELAXED);
     }
@@ -1577,6 +1952,200 @@ int aral_stress_test(size_t threads, size_t elements, size_t seconds) {
     return auc.errors;
 }
 
+#ifdef ARAL_WITH_THREAD_CACHE
+struct aral_unittest_thread_cache {
+    ARAL *ar;
+    size_t elements;
+    bool cached;
+    bool destroyed;
+    usec_t ut;
+};
+
+static void aral_unittest_thread_cache_keeper(void *ptr) {
+    struct aral_unittest_thread_cache *t = ptr;
+
+    void *pointers[ARAL_THREAD_CACHE_ELEMENTS];
+    for(size_t i = 0; i < ARAL_THREAD_CACHE_ELEMENTS ; i++)
+        pointers[i] = aral_mallocz(t->ar);
+    for(size_t i = 0; i < ARAL_THREAD_CACHE_ELEMENTS ; i++)
+        aral_freez(t->ar, pointers[i]);
+
+    __atomic_store_n(&t->cached, true, __ATOMIC_RELEASE);
+
+    // keep the elements in our cache, while the ARAL is destroyed
+    while(!__atomic_load_n(&t->destroyed, __ATOMIC_ACQUIRE))
+        tinysleep();
+
+    // exiting releases our cache, which should not touch the destroyed ARAL
+}
+
+static void *aral_unittest_thread_cache_foreign_thread(void *ptr) {
+    ARAL *ar = ptr;
+
+    // the freed element stays in the cache of this thread, until it exits
+    aral_freez(ar, aral_mallocz(ar));
+    return NULL;
+}
+
+static void aral_unittest_thread_cache_benchmark_thread(void *ptr) {
+    struct aral_unittest_thread_cache *t = ptr;
+
+    void *pointers[8];
+    usec_t started_ut = now_monotonic_usec();
+    for(size_t i = 0; i < t->elements ; i += _countof(pointers)) {
+        for(size_t p = 0; p < _countof(pointers) ; p++)
+            pointers[p] = aral_mallocz(t->ar);
+
+        for(size_t p = 0; p < _countof(pointers) ; p++)
+            aral_freez(t->ar, pointers[p]);
+    }
+    t->ut = now_monotonic_usec() - started_ut;
+}
+
+static double aral_unittest_thread_cache_benchmark(bool disabled, size_t threads, size_t elements) {
+    struct aral_statistics stats = { 0 };
+    ARAL *ar = aral_create("aral-cache-bench", sizeof(struct aral_unittest_entry), 0, 0,
+                           &stats, NULL, NULL, false, false, false);
+
+    __atomic_store_n(&aral_thread_caches.disabled, disabled, __ATOMIC_RELAXED);
+
+    struct aral_unittest_thread_cache t[threads];
+    ND_THREAD *thread_ptrs[threads];
+    for(size_t i = 0; i < threads ; i++) {
+        t[i] = (struct aral_unittest_thread_cache){ .ar = ar, .elements = elements, };
+        char tag[ND_THREAD_TAG_MAX + 1];
+        snprintfz(tag, ND_THREAD_TAG_MAX, "ARALB[%zu]", i);
+        thread_ptrs[i] = nd_thread_create(tag, NETDATA_THREAD_OPTION_DONT_LOG, aral_unittest_thread_cache_benchmark_thread, &t[i]);
+    }
+
+    usec_t ut = 0;
+    for(size_t i = 0; i < threads ; i++) {
+        nd_thread_join(thread_ptrs[i]);
+        if(t[i].ut > ut) ut = t[i].ut;
+    }
+
+    __atomic_store_n(&aral_thread_caches.disabled, false, __ATOMIC_RELAXED);
+    aral_destroy(ar);
+
+    // million alloc/free pairs per second
+    return ut ? (double)(threads * elements) / (double)ut : 0.0;
+}
+
+static int aral_unittest_thread_cache(void) {
+    int errors = 0;
+
+    fprintf(stderr, "\nTesting ARAL per-thread caches...\n");
+
+    struct aral_statistics stats = { 0 };
+    ARAL *ar = aral_create("aral-cache-test", sizeof(struct aral_unittest_entry), 0, 0,
+                           &stats, NULL, NULL, false, false, false);
+
+    void *p1 = aral_mallocz(ar);
+    aral_freez(ar, p1);
+    void *p2 = aral_mallocz(ar);
+    if(p1 != p2) {
+        fprintf(stderr, "ARAL thread cache: a freed element was not reused by the same thread\n");
+        errors++;
+    }
+    aral_freez(ar, p2);
+
+    // hoarding is bounded
+    size_t entries = ARAL_THREAD_CACHE_ELEMENTS * 4;
+    void *pointers[entries];
+    for(size_t i = 0; i < entries ; i++)
+        pointers[i] = aral_mallocz(ar);
+    for(size_t i = 0; i < entries ; i++)
+        aral_freez(ar, pointers[i]);
+
+    size_t cached = aral_used_bytes(ar) / aral_requested_element_size(ar);
+    if(cached > ARAL_THREAD_CACHE_ELEMENTS) {
+        fprintf(stderr, "ARAL thread cache: %zu elements are cached, but the limit is %d\n", cached, ARAL_THREAD_CACHE_ELEMENTS);
+        errors++;
+    }
+
+    if(aral_unittest_leftovers(ar) || aral_used_bytes(ar) != 0) {
+        fprintf(stderr, "ARAL thread cache: elements are still used after flushing the cache (%zu bytes)\n", aral_used_bytes(ar));
+        errors++;
+    }
+
+    if(!__atomic_load_n(&stats.thread_cache.hits, __ATOMIC_RELAXED)) {
+        fprintf(stderr, "ARAL thread cache: no cache hits have been recorded\n");
+        errors++;
+    }
+
+    // many ARALs used together keep their own magazines
+    {
+        ARAL *many[40];
+        void *freed[_countof(many)];
+        for(size_t i = 0; i < _countof(many) ; i++) {
+            many[i] = aral_create("aral-cache-many", sizeof(struct aral_unittest_entry), 0, 0,
+                                  NULL, NULL, NULL, false, false, false);
+            freed[i] = aral_mallocz(many[i]);
+        }
+
+        for(size_t i = 0; i < _countof(many) ; i++)
+            aral_freez(many[i], freed[i]);
+
+        size_t evicted = 0;
+        for(size_t i = 0; i < _countof(many) ; i++) {
+            void *p = aral_mallocz(many[i]);
+            if(p != freed[i])
+                evicted++;
+            aral_freez(many[i], p);
+        }
+
+        if(evicted) {
+            fprintf(stderr, "ARAL thread cache: %zu of %zu ARALs lost their cached elements to other ARALs\n", evicted, _countof(many));
+            errors++;
+        }
+
+        for(size_t i = 0; i < _countof(many) ; i++)
+            aral_destroy(many[i]);
+    }
+
+    // a thread not created with nd_thread_create() releases its cache when it exits
+    {
+        pthread_t thread;
+        if(pthread_create(&thread, NULL, aral_unittest_thread_cache_foreign_thread, ar) != 0 ||
+            pthread_join(thread, NULL) != 0) {
+            fprintf(stderr, "ARAL thread cache: cannot run a thread with pthread_create()\n");
+            errors++;
+        }
+        else if(aral_used_bytes(ar) != 0) {
+            fprintf(stderr, "ARAL thread cache: a thread with pthread_create() exited without releasing its cache (%zu bytes)\n", aral_used_bytes(ar));
+            errors++;
+        }
+    }
+
+    // destroy the ARAL while another thread keeps elements of it in its cache
+    struct aral_unittest_thread_cache t = { .ar = ar, };
+    ND_THREAD *th = nd_thread_create("ARALTC", NETDATA_THREAD_OPTION_DONT_LOG, aral_unittest_thread_cache_keeper, &t);
+    while(!__atomic_load_n(&t.cached, __ATOMIC_ACQUIRE))
+        tinysleep();
+
+    aral_destroy(ar);
+    __atomic_store_n(&t.destroyed, true, __ATOMIC_RELEASE);
+    nd_thread_join(th);
+
+    if(aral_used_bytes_from_stats(&stats) != 0) {
+        fprintf(stderr, "ARAL thread cache: %zu bytes are still used after destroying the ARAL\n", aral_used_bytes_from_stats(&stats));
+        errors++;
+    }
+
+    size_t threads = 4, elements = 1000000;
+    double without = aral_unittest_thread_cache_benchmark(true, threads, elements);
+    double with = aral_unittest_thread_cache_benchmark(false, threads, elements);
+    fprintf(stderr, "ARAL %zu threads: %0.2f M alloc/free pairs/s without thread caches, %0.2f M with thread caches\n",
+            threads, without, with);
+
+    return errors;
+}
+#else
+static int aral_unittest_thread_cache(void) {
+    return 0;
+}
+#endif
+
 int aral_unittest(size_t elements) {
     const char *cache_dir = "/tmp/";
 
@@ -1600,6 +2169,7 @@ int aral_unittest(size_t elements) {
     aral_destroy(auc.ar);
 
     int errors = aral_stress_test(2, elements, 10);
+    errors += aral_unittest_thread_cache();
 
     return auc.errors + errors;
 }
@@ -23,6 +23,18 @@ struct aral_statistics {
 
     struct aral_page_type_stats malloc;
     struct aral_page_type_stats mmap;
+
+    struct {
+        PAD64(size_t) hits;                 // allocations served by the per-thread caches
+        PAD64(size_t) misses;               // allocations of cached ARALs served by the pages
+        PAD64(size_t) frees;                // frees kept by the per-thread caches
+        PAD64(size_t) returned;             // elements the per-thread caches gave back to the pages
+    } thread_cache;
+
+    struct {
+        PAD64(size_t) local_frees;          // frees on pages of the NUMA node of the thread
+        PAD64(size_t) remote_frees;         // frees on pages of other NUMA nodes
+    } numa;
 };
 
 // --------------------------------------------------------------------------------------------------------------------
@@ -43,6 +55,12 @@ size_t aral_actual_element_size(ARAL *ar);
 
 // --------------------------------------------------------------------------------------------------------------------
 
+// give back the free elements the calling thread keeps in its cache
+// it is called automatically when netdata threads exit
+void aral_thread_cache_release(void);
+
+// --------------------------------------------------------------------------------------------------------------------
+
 size_t aral_optimal_malloc_page_size(void);
 void aral_optimal_malloc_page_size_set(size_t size);
 
@@ -16,6 +16,7 @@ ALWAYS_INLINE void buffer_reset(BUFFER *wb) {
     wb->date = 0;
     wb->expires = 0;
     buffer_no_cacheable(wb);
+    buffer_drain_set(wb, NULL, NULL, 0);
 
     buffer_overflow_check(wb);
 }
@@ -52,6 +52,9 @@ typedef enum __attribute__ ((__packed__)) {
     BUFFER_JSON_OPTIONS_NON_ANONYMOUS = (1 << 2),
 } BUFFER_JSON_OPTIONS;
 
+struct web_buffer;
+typedef bool (*buffer_drain_cb_t)(struct web_buffer *wb, void *data);
+
 typedef struct web_buffer {
     uint32_t size;          // allocation size of buffer, in bytes
     uint32_t len;           // current data length in buffer, in bytes
@@ -70,6 +73,12 @@ typedef struct web_buffer {
         BUFFER_JSON_OPTIONS options;
         BUFFER_JSON_NODE stack[BUFFER_JSON_MAX_DEPTH];
     } json;
+
+    struct {
+        buffer_drain_cb_t cb;   // when set, the content can be consumed while it is generated
+        void *data;
+        uint32_t threshold;     // the length above which buffer_drain_checkpoint() calls cb
+    } drain;
 } BUFFER;
 
 #define CLEAN_BUFFER _cleanup_(buffer_freep) BUFFER
@@ -109,6 +118,38 @@ static void buffer_flush(BUFFER *wb) {
 
 void buffer_reset(BUFFER *wb);
 
+// ----------------------------------------------------------------------------
+// draining: producers of large outputs call buffer_drain_checkpoint() between
+// items, so that a consumer can send the content generated so far and empty
+// the buffer, keeping the json state intact
+
+#define buffer_drain_enabled(wb) ((wb)->drain.cb != NULL)
+
+static inline void buffer_drain_set(BUFFER *wb, buffer_drain_cb_t cb, void *data, size_t threshold) {
+    wb->drain.cb = cb;
+    wb->drain.data = data;
+    wb->drain.threshold = (uint32_t)threshold;
+}
+
+// to be called by the drain callback, once it has consumed the content
+ALWAYS_INLINE
+static void buffer_drained(BUFFER *wb) {
+    wb->len = 0;
+
+    if(wb->buffer)
+        wb->buffer[0] = '\0';
+}
+
+// returns false when the consumer cannot accept more data
+// (the producer should stop generating output)
+ALWAYS_INLINE
+static bool buffer_drain_checkpoint(BUFFER *wb) {
+    if(unlikely(wb->drain.cb && wb->len >= wb->drain.threshold))
+        return wb->drain.cb(wb, wb->drain.data);
+
+    return true;
+}
+
 void buffer_date(BUFFER *wb, int year, int month, int day, int hours, int minutes, int seconds);
 void buffer_jsdate(BUFFER *wb, int year, int month, int day, int hours, int minutes, int seconds);
 
@@ -8,6 +8,8 @@
 struct buffered_reader {
     ssize_t read_len;
     ssize_t pos;
+    ssize_t saved_pos;          // buffered_reader_next_line_inplace() terminated the line here
+    char saved_char;            // the byte it overwrote
     char read_buffer[PLUGINSD_LINE_MAX + 1];
 };
 
@@ -15,6 +17,7 @@ static inline void buffered_reader_init(struct buffered_reader *reader) {
     reader->read_buffer[0] = '\0';
     reader->read_len = 0;
     reader->pos = 0;
+    reader->saved_pos = -1;
 }
 
 typedef enum {
@@ -149,4 +152,68 @@ static inline bool buffered_reader_next_line(struct buffered_reader *reader, BUF
     return false;
 }
 
+/* Like buffered_reader_next_line(), but without copying the line: *line points into the read buffer
+ * and remains valid until the next call. The line includes its newline and is terminated by
+ * overwriting the first byte of the next line, which is restored on the next call.
+ * A partial line is moved to the beginning of the buffer, to be completed by the next read.
+ * dst is used only for lines that do not fit in the read buffer, so the caller has to empty it
+ * after processing each line, exactly like with buffered_reader_next_line().
+ */
+static inline bool buffered_reader_next_line_inplace(struct buffered_reader *reader, BUFFER *dst, char **line) {
+    if(reader->saved_pos >= 0) {
+        reader->read_buffer[reader->saved_pos] = reader->saved_char;
+        reader->saved_pos = -1;
+    }
+
+    if(unlikely(dst->len)) {
+        // we are in the middle of a line that did not fit in the read buffer
+        if(!buffered_reader_next_line(reader, dst))
+            return false;
+
+        *line = dst->buffer;
+        return true;
+    }
+
+    char *ss = &reader->read_buffer[reader->pos];
+    char *se = &reader->read_buffer[reader->read_len];
+
+    if(ss >= se) {
+        reader->pos = 0;
+        reader->read_len = 0;
+        reader->read_buffer[reader->read_len] = '\0';
+        return false;
+    }
+
+    char *next_newline = (char *) memchr(ss, '\n', se - ss);
+    if(likely(next_newline)) {
+        ssize_t next = (next_newline - reader->read_buffer) + 1;
+
+        // when this is the last line, the buffer is already terminated
+        if(next < reader->read_len) {
+            reader->saved_pos = next;
+            reader->saved_char = reader->read_buffer[next];
+            reader->read_buffer[next] = '\0';
+        }
+
+        reader->pos = next;
+        *line = ss;
+        return true;
+    }
+
+    if(unlikely(!reader->pos && reader->read_len >= (ssize_t)sizeof(reader->read_buffer) - 1)) {
+        // the partial line fills the whole buffer, continue it in dst
+        buffered_reader_next_line(reader, dst);
+        return false;
+    }
+
+    if(reader->pos) {
+        reader->read_len -= reader->pos;
+        memmove(reader->read_buffer, ss, reader->read_len);
+        reader->read_buffer[reader->read_len] = '\0';
+        reader->pos = 0;
+    }
+
+    return false;
+}
+
 #endif //NETDATA_BUFFERED_READER_H
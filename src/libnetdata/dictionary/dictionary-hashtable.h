@@ -6,98 +6,180 @@
 #include "dictionary-internals.h"
 
 // ----------------------------------------------------------------------------
-// hashtable operations with simple hashtable
-
-//static inline bool compare_keys(void *key1, void *key2) {
-//    const char *k1 = key1;
-//    const char *k2 = key2;
-//    return strcmp(k1, k2) == 0;
-//}
-//
-//static inline void *item_to_key(DICTIONARY_ITEM *item) {
-//    return (void *)item_get_name(item);
-//}
-//
-//#define SIMPLE_HASHTABLE_VALUE_TYPE DICTIONARY_ITEM
-//#define SIMPLE_HASHTABLE_NAME _DICTIONARY
-//#define SIMPLE_HASHTABLE_VALUE2KEY_FUNCTION item_to_key
-//#define SIMPLE_HASHTABLE_COMPARE_KEYS_FUNCTION compare_keys
-//#include "..//simple_hashtable.h"
-
-//static inline size_t hashtable_init_hashtable(DICTIONARY *dict) {
-//    SIMPLE_HASHTABLE_DICTIONARY *ht = callocz(1, sizeof(*ht));
-//    simple_hashtable_init_DICTIONARY(ht, 4);
-//    dict->index.JudyHSArray = ht;
-//    return 0;
-//}
-//
-//static inline size_t hashtable_destroy_hashtable(DICTIONARY *dict) {
-//    SIMPLE_HASHTABLE_DICTIONARY *ht = dict->index.JudyHSArray;
-//    if(unlikely(!ht)) return 0;
-//
-//    size_t mem = sizeof(*ht) + ht->size * sizeof(SIMPLE_HASHTABLE_SLOT_DICTIONARY);
-//    simple_hashtable_destroy_DICTIONARY(ht);
-//    freez(ht);
-//    dict->index.JudyHSArray = NULL;
-//
-//    return mem;
-//}
-//
-//static inline void *hashtable_insert_hashtable(DICTIONARY *dict, const char *name, size_t name_len) {
-//    SIMPLE_HASHTABLE_DICTIONARY *ht = dict->index.JudyHSArray;
-//
-//    char key[name_len+1];
-//    memcpy(key, name, name_len);
-//    key[name_len] = '\0';
-//
-//    XXH64_hash_t hash = XXH3_64bits(name, name_len);
-//    SIMPLE_HASHTABLE_SLOT_DICTIONARY *sl = simple_hashtable_get_slot_DICTIONARY(ht, hash, key, true);
-//    sl->hash = hash; // we will need it in insert later - it is ok to overwrite - it is the same already
-//    return sl;
-//}
-//
-//static inline DICTIONARY_ITEM *hashtable_insert_handle_to_item_hashtable(DICTIONARY *dict, void *handle) {
-//    (void)dict;
-//    SIMPLE_HASHTABLE_SLOT_DICTIONARY *sl = handle;
-//    DICTIONARY_ITEM *item = SIMPLE_HASHTABLE_SLOT_DATA(sl);
-//    return item;
-//}
-//
-//static inline void hashtable_set_item_hashtable(DICTIONARY *dict, void *handle, DICTIONARY_ITEM *item) {
-//    SIMPLE_HASHTABLE_DICTIONARY *ht = dict->index.JudyHSArray;
-//    SIMPLE_HASHTABLE_SLOT_DICTIONARY *sl = handle;
-//    simple_hashtable_set_slot_DICTIONARY(ht, sl, sl->hash, item);
-//}
-//
-//static inline int hashtable_delete_hashtable(DICTIONARY *dict, const char *name, size_t name_len, DICTIONARY_ITEM *item_to_delete) {
-//    (void)item_to_delete;
-//    SIMPLE_HASHTABLE_DICTIONARY *ht = dict->index.JudyHSArray;
-//
-//    char key[name_len+1];
-//    memcpy(key, name, name_len);
-//    key[name_len] = '\0';
-//
-//    XXH64_hash_t hash = XXH3_64bits(name, name_len);
-//    SIMPLE_HASHTABLE_SLOT_DICTIONARY *sl = simple_hashtable_get_slot_DICTIONARY(ht, hash, key, false);
-//    DICTIONARY_ITEM *item = SIMPLE_HASHTABLE_SLOT_DATA(sl);
-//    if(!item) return 0; // return not-found
-//
-//    simple_hashtable_del_slot_DICTIONARY(ht, sl);
-//    return 1; // return deleted
-//}
-//
-//static inline DICTIONARY_ITEM *hashtable_get_hashtable(DICTIONARY *dict, const char *name, size_t name_len) {
-//    SIMPLE_HASHTABLE_DICTIONARY *ht = dict->index.JudyHSArray;
-//    if(unlikely(!ht)) return NULL;
-//
-//    char key[name_len+1];
-//    memcpy(key, name, name_len);
-//    key[name_len] = '\0';
+// hashtable operations with an open addressing hashtable
 //
-//    XXH64_hash_t hash = XXH3_64bits(name, name_len);
-//    SIMPLE_HASHTABLE_SLOT_DICTIONARY *sl = simple_hashtable_get_slot_DICTIONARY(ht, hash, key, true);
-//    return SIMPLE_HASHTABLE_SLOT_DATA(sl);
-//}
+// A flat array of { hash, item } slots with linear probing.
+// The XXH3 hash of each key is stored in its slot, so that probing compares
+// 64-bit integers and the key itself is compared only when the hashes match.
+// Deletions shift back the following slots of the cluster, so there are no
+// tombstones and lookups of missing keys stop at the first empty slot.
+
+#define DICT_HASHTABLE_MIN_SIZE 8
+
+typedef struct dictionary_hashtable_slot {
+    uint64_t hash;
+    DICTIONARY_ITEM *item;              // NULL when the slot is empty
+} DICT_HASHTABLE_SLOT;
+
+struct dictionary_hashtable {
+    size_t size;                        // always a power of 2
+    size_t used;                        // occupied slots
+    DICT_HASHTABLE_SLOT *slots;
+};
+
+static inline uint64_t hashtable_hash_key(const char *name, size_t name_len) {
+    return XXH3_64bits(name, name_len);
+}
+
+static inline bool hashtable_slot_matches(DICT_HASHTABLE_SLOT *sl, uint64_t hash, const char *name, size_t name_len) {
+    return sl->hash == hash && sl->item->key_len == name_len && memcmp(item_get_name(sl->item), name, name_len) == 0;
+}
+
+static inline void hashtable_resize_hashtable(DICTIONARY *dict, size_t new_size) {
+    struct dictionary_hashtable *ht = dict->index.hashtable;
+    DICT_HASHTABLE_SLOT *old_slots = ht->slots;
+    size_t old_size = ht->size;
+
+    ht->slots = callocz(new_size, sizeof(DICT_HASHTABLE_SLOT));
+    ht->size = new_size;
+
+    size_t mask = new_size - 1;
+    for(size_t i = 0; i < old_size ;i++) {
+        if(!old_slots[i].item)
+            continue;
+
+        size_t pos = old_slots[i].hash & mask;
+        while(ht->slots[pos].item)
+            pos = (pos + 1) & mask;
+
+        ht->slots[pos] = old_slots[i];
+    }
+
+    freez(old_slots);
+
+    __atomic_add_fetch(&dict->stats->memory.index, (long)(new_size * sizeof(DICT_HASHTABLE_SLOT)) - (long)(old_size * sizeof(DICT_HASHTABLE_SLOT)), __ATOMIC_RELAXED);
+}
+
+static inline size_t hashtable_init_hashtable(DICTIONARY *dict) {
+    // allocated on the first insert, so that empty dictionaries cost nothing
+    dict->index.hashtable = NULL;
+    return 0;
+}
+
+static inline struct dictionary_hashtable *hashtable_create_hashtable(DICTIONARY *dict) {
+    struct dictionary_hashtable *ht = callocz(1, sizeof(*ht));
+    ht->size = DICT_HASHTABLE_MIN_SIZE;
+    ht->slots = callocz(ht->size, sizeof(DICT_HASHTABLE_SLOT));
+    dict->index.hashtable = ht;
+
+    __atomic_add_fetch(&dict->stats->memory.index, (long)(sizeof(*ht) + ht->size * sizeof(DICT_HASHTABLE_SLOT)), __ATOMIC_RELAXED);
+    return ht;
+}
+
+static inline size_t hashtable_destroy_hashtable(DICTIONARY *dict) {
+    struct dictionary_hashtable *ht = dict->index.hashtable;
+    if(unlikely(!ht)) return 0;
+
+    size_t mem = sizeof(*ht) + ht->size * sizeof(DICT_HASHTABLE_SLOT);
+    __atomic_sub_fetch(&dict->stats->memory.index, (long)mem, __ATOMIC_RELAXED);
+
+    freez(ht->slots);
+    freez(ht);
+    dict->index.hashtable = NULL;
+
+    return mem;
+}
+
+static inline void *hashtable_insert_hashtable(DICTIONARY *dict, const char *name, size_t name_len) {
+    struct dictionary_hashtable *ht = dict->index.hashtable;
+    if(unlikely(!ht))
+        ht = hashtable_create_hashtable(dict);
+
+    uint64_t hash = hashtable_hash_key(name, name_len);
+
+    // grow before probing, so that the slot we return stays valid
+    // until the caller sets the item (max load factor 3/4)
+    if(unlikely((ht->used + 1) * 4 > ht->size * 3))
+        hashtable_resize_hashtable(dict, ht->size * 2);
+
+    size_t mask = ht->size - 1;
+    size_t pos = hash & mask;
+    while(ht->slots[pos].item) {
+        if(hashtable_slot_matches(&ht->slots[pos], hash, name, name_len))
+            return &ht->slots[pos];
+
+        pos = (pos + 1) & mask;
+    }
+
+    // reserve the empty slot - the caller will set the item
+    ht->slots[pos].hash = hash;
+    ht->used++;
+    return &ht->slots[pos];
+}
+
+static inline DICTIONARY_ITEM *hashtable_insert_handle_to_item_hashtable(DICTIONARY *dict, void *handle) {
+    (void)dict;
+    DICT_HASHTABLE_SLOT *sl = handle;
+    return sl->item;
+}
+
+static inline void hashtable_set_item_hashtable(DICTIONARY *dict, void *handle, DICTIONARY_ITEM *item) {
+    (void)dict;
+    DICT_HASHTABLE_SLOT *sl = handle;
+    sl->item = item;
+}
+
+static inline int hashtable_delete_hashtable(DICTIONARY *dict, const char *name, size_t name_len, DICTIONARY_ITEM *item) {
+    (void)item;
+    struct dictionary_hashtable *ht = dict->index.hashtable;
+    if(unlikely(!ht || !ht->used)) return 0;
+
+    uint64_t hash = hashtable_hash_key(name, name_len);
+    size_t mask = ht->size - 1;
+    size_t pos = hash & mask;
+    while(ht->slots[pos].item && !hashtable_slot_matches(&ht->slots[pos], hash, name, name_len))
+        pos = (pos + 1) & mask;
+
+    if(!ht->slots[pos].item)
+        return 0; // not found
+
+    // backward shift deletion: move back the slots of the cluster that
+    // would be unreachable after emptying this one
+    size_t hole = pos;
+    for(size_t next = (hole + 1) & mask; ht->slots[next].item ; next = (next + 1) & mask) {
+        size_t home = ht->slots[next].hash & mask;
+        if(((next - home) & mask) >= ((next - hole) & mask)) {
+            ht->slots[hole] = ht->slots[next];
+            hole = next;
+        }
+    }
+    ht->slots[hole].item = NULL;
+    ht->slots[hole].hash = 0;
+    ht->used--;
+
+    // give memory back when most of the items are gone
+    if(unlikely(ht->size > DICT_HASHTABLE_MIN_SIZE && ht->used * 8 < ht->size))
+        hashtable_resize_hashtable(dict, ht->size / 2);
+
+    return 1; // deleted
+}
+
+static inline DICTIONARY_ITEM *hashtable_get_hashtable(DICTIONARY *dict, const char *name, size_t name_len) {
+    struct dictionary_hashtable *ht = dict->index.hashtable;
+    if(unlikely(!ht || !ht->used)) return NULL;
+
+    uint64_t hash = hashtable_hash_key(name, name_len);
+    size_t mask = ht->size - 1;
+    size_t pos = hash & mask;
+    while(ht->slots[pos].item) {
+        if(hashtable_slot_matches(&ht->slots[pos], hash, name, name_len))
+            return ht->slots[pos].item;
+
+        pos = (pos + 1) & mask;
+    }
+
+    return NULL;
+}
 
 // ----------------------------------------------------------------------------
 // hashtable operations with Judy
@@ -216,44 +298,40 @@ static inline DICTIONARY_ITEM *hashtable_get_judy(DICTIONARY *dict, const char *
 // select the right hashtable
 
 static inline size_t hashtable_init_unsafe(DICTIONARY *dict) {
-    return hashtable_init_judy(dict);
-//    if(dict->options & DICT_OPTION_INDEX_JUDY)
-//        return hashtable_init_judy(dict);
-//    else
-//        return hashtable_init_hashtable(dict);
+    if(dict->options & DICT_OPTION_INDEX_JUDY)
+        return hashtable_init_judy(dict);
+    else
+        return hashtable_init_hashtable(dict);
 }
 
 static inline size_t hashtable_destroy_unsafe(DICTIONARY *dict) {
     pointer_destroy_index(dict);
 
-//    if(dict->options & DICT_OPTION_INDEX_JUDY)
-    return hashtable_destroy_judy(dict);
-//    else
-//        return hashtable_destroy_hashtable(dict);
+    if(dict->options & DICT_OPTION_INDEX_JUDY)
+        return hashtable_destroy_judy(dict);
+    else
+        return hashtable_destroy_hashtable(dict);
 }
 
 static inline void *hashtable_insert_unsafe(DICTIONARY *dict, const char *name, size_t name_len) {
-    return hashtable_insert_judy(dict, name, name_len);
-//    if(dict->options & DICT_OPTION_INDEX_JUDY)
-//        return hashtable_insert_judy(dict, name, name_len);
-//    else
-//        return hashtable_insert_hashtable(dict, name, name_len);
+    if(dict->options & DICT_OPTION_INDEX_JUDY)
+        return hashtable_insert_judy(dict, name, name_len);
+    else
+        return hashtable_insert_hashtable(dict, name, name_len);
 }
 
 static inline DICTIONARY_ITEM *hashtable_insert_handle_to_item_unsafe(DICTIONARY *dict, void *handle) {
-    return hashtable_insert_handle_to_item_judy(dict, handle);
-//    if(dict->options & DICT_OPTION_INDEX_JUDY)
-//        return hashtable_insert_handle_to_item_judy(dict, handle);
-//    else
-//        return hashtable_insert_handle_to_item_hashtable(dict, handle);
+    if(dict->options & DICT_OPTION_INDEX_JUDY)
+        return hashtable_insert_handle_to_item_judy(dict, handle);
+    else
+        return hashtable_insert_handle_to_item_hashtable(dict, handle);
 }
 
 static inline int hashtable_delete_unsafe(DICTIONARY *dict, const char *name, size_t name_len, DICTIONARY_ITEM *item) {
-    return hashtable_delete_judy(dict, name, name_len, item);
-//    if(dict->options & DICT_OPTION_INDEX_JUDY)
-//        return hashtable_delete_judy(dict, name, name_len, item);
-//    else
-//        return hashtable_delete_hashtable(dict, name, name_len, item);
+    if(dict->options & DICT_OPTION_INDEX_JUDY)
+        return hashtable_delete_judy(dict, name, name_len, item);
+    else
+        return hashtable_delete_hashtable(dict, name, name_len, item);
 }
 
 static inline DICTIONARY_ITEM *hashtable_get_unsafe(DICTIONARY *dict, const char *name, size_t name_len) {
@@ -261,11 +339,10 @@ static inline DICTIONARY_ITEM *hashtable_get_unsafe(DICTIONARY *dict, const char
 
     DICTIONARY_ITEM *item;
 
-    item = hashtable_get_judy(dict, name, name_len);
-//    if(dict->options & DICT_OPTION_INDEX_JUDY)
-//        item = hashtable_get_judy(dict, name, name_len);
-//    else
-//        item = hashtable_get_hashtable(dict, name, name_len);
+    if(dict->options & DICT_OPTION_INDEX_JUDY)
+        item = hashtable_get_judy(dict, name, name_len);
+    else
+        item = hashtable_get_hashtable(dict, name, name_len);
 
     if(item)
         pointer_check(dict, item);
@@ -274,11 +351,10 @@ static inline DICTIONARY_ITEM *hashtable_get_unsafe(DICTIONARY *dict, const char
 }
 
 static inline void hashtable_set_item_unsafe(DICTIONARY *dict, void *handle, DICTIONARY_ITEM *item) {
-    hashtable_set_item_judy(dict, handle, item);
-//    if(dict->options & DICT_OPTION_INDEX_JUDY)
-//        hashtable_set_item_judy(dict, handle, item);
-//    else
-//        hashtable_set_item_hashtable(dict, handle, item);
+    if(dict->options & DICT_OPTION_INDEX_JUDY)
+        hashtable_set_item_judy(dict, handle, item);
+    else
+        hashtable_set_item_hashtable(dict, handle, item);
 }
 
 #endif //NETDATA_DICTIONARY_HASHTABLE_H
@@ -1028,6 +1028,86 @@ bool dictionary_traverse_or_destroy_unittest(void) {
     return counted == 1;
 }
 
+// ----------------------------------------------------------------------------
+// index benchmark - JudyHS vs the open addressing hashtable
+
+struct dictionary_index_benchmark_result {
+    double insert_ns;
+    double lookup_ns;
+    double walk_ns;
+    size_t errors;
+};
+
+static struct dictionary_index_benchmark_result dictionary_unittest_index_benchmark_run(DICT_OPTIONS index, char **names, size_t entries) {
+    struct dictionary_index_benchmark_result r = { 0 };
+
+    // repeat small dictionaries, so that each measurement has about 1M operations
+    size_t rounds = entries < 1000000 ? 1000000 / entries : 1;
+    DICTIONARY **dicts = mallocz(rounds * sizeof(DICTIONARY *));
+    for(size_t rnd = 0; rnd < rounds ;rnd++)
+        dicts[rnd] = dictionary_create(DICT_OPTION_SINGLE_THREADED | DICT_OPTION_NAME_LINK_DONT_CLONE |
+                                       DICT_OPTION_VALUE_LINK_DONT_CLONE | DICT_OPTION_DONT_OVERWRITE_VALUE | index);
+
+    usec_t started = now_monotonic_high_precision_usec();
+    for(size_t rnd = 0; rnd < rounds ;rnd++)
+        for(size_t i = 0; i < entries ;i++)
+            dictionary_set(dicts[rnd], names[i], names[i], 0);
+    r.insert_ns = (double)(now_monotonic_high_precision_usec() - started) * 1000.0 / (double)(rounds * entries);
+
+    started = now_monotonic_high_precision_usec();
+    for(size_t rnd = 0; rnd < rounds ;rnd++)
+        for(size_t i = 0; i < entries ;i++)
+            if(dictionary_get(dicts[rnd], names[i]) != names[i])
+                r.errors++;
+    r.lookup_ns = (double)(now_monotonic_high_precision_usec() - started) * 1000.0 / (double)(rounds * entries);
+
+    size_t walked = 0;
+    started = now_monotonic_high_precision_usec();
+    for(size_t rnd = 0; rnd < rounds ;rnd++) {
+        void *t;
+        dfe_start_read(dicts[rnd], t) {
+            walked++;
+        }
+        dfe_done(t);
+    }
+    r.walk_ns = (double)(now_monotonic_high_precision_usec() - started) * 1000.0 / (double)(rounds * entries);
+
+    if(walked != rounds * entries)
+        r.errors++;
+
+    for(size_t rnd = 0; rnd < rounds ;rnd++)
+        dictionary_destroy(dicts[rnd]);
+
+    freez(dicts);
+    return r;
+}
+
+static size_t dictionary_unittest_index_benchmark(void) {
+    size_t errors = 0;
+    size_t sizes[] = { 10, 1000, 1000000 };
+
+    fprintf(stderr, "\nDictionary index benchmark (ns per operation):\n");
+    fprintf(stderr, "%10s %10s %10s %10s %10s\n", "items", "index", "insert", "lookup", "walk");
+
+    for(size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]) ;s++) {
+        char **names = dictionary_unittest_generate_names(sizes[s]);
+
+        struct dictionary_index_benchmark_result judy = dictionary_unittest_index_benchmark_run(DICT_OPTION_INDEX_JUDY, names, sizes[s]);
+        struct dictionary_index_benchmark_result ht = dictionary_unittest_index_benchmark_run(DICT_OPTION_INDEX_HASHTABLE, names, sizes[s]);
+
+        fprintf(stderr, "%10zu %10s %10.1f %10.1f %10.1f\n", sizes[s], "judy", judy.insert_ns, judy.lookup_ns, judy.walk_ns);
+        fprintf(stderr, "%10zu %10s %10.1f %10.1f %10.1f\n", sizes[s], "hashtable", ht.insert_ns, ht.lookup_ns, ht.walk_ns);
+
+        errors += judy.errors + ht.errors;
+        dictionary_unittest_free_char_pp(names, sizes[s]);
+    }
+
+    if(errors)
+        fprintf(stderr, "Dictionary index benchmark found %zu errors\n", errors);
+
+    return errors;
+}
+
 /*
  * FIXME: a dictionary-related leak is reported when running the address
  * sanitizer. Need to investigate if it's introduced by the unit-test itself,
@@ -1051,6 +1131,15 @@ int dictionary_unittest(size_t entries) {
     dict = dictionary_create(DICT_OPTION_NONE);
     dictionary_unittest_clone(dict, names, values, entries, &errors);
 
+    fprintf(stderr, "\nCreating dictionary single threaded, clone, hashtable index, %zu items\n", entries);
+    dict = dictionary_create(DICT_OPTION_SINGLE_THREADED | DICT_OPTION_INDEX_HASHTABLE);
+    dictionary_unittest_clone(dict, names, values, entries, &errors);
+
+    fprintf(stderr, "\nCreating dictionary multi threaded, non-clone, hashtable index, %zu items\n", entries);
+    dict = dictionary_create(
+        DICT_OPTION_NAME_LINK_DONT_CLONE | DICT_OPTION_VALUE_LINK_DONT_CLONE | DICT_OPTION_INDEX_HASHTABLE);
+    dictionary_unittest_nonclone(dict, names, values, entries, &errors);
+
     fprintf(stderr, "\nCreating dictionary single threaded, non-clone, add-in-front options, %zu items\n", entries);
     dict = dictionary_create(
         DICT_OPTION_SINGLE_THREADED | DICT_OPTION_NAME_LINK_DONT_CLONE | DICT_OPTION_VALUE_LINK_DONT_CLONE |
@@ -1181,6 +1270,7 @@ int dictionary_unittest(size_t entries) {
     dictionary_unittest_free_char_pp(values, entries);
 
     errors += dictionary_unittest_views();
+    errors += dictionary_unittest_index_benchmark();
     errors += dictionary_unittest_threads();
     errors += dictionary_unittest_view_threads();
 
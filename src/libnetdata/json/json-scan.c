@@ -0,0 +1,968 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "../libnetdata.h"
+
+// ----------------------------------------------------------------------------
+// word-at-a-time helpers
+// strings and containers are skipped 8 bytes per step, while none of the
+// bytes is one of the structural characters we are looking for
+
+#define JSON_SCAN_ONES  0x0101010101010101ULL
+#define JSON_SCAN_HIGHS 0x8080808080808080ULL
+
+static ALWAYS_INLINE uint64_t json_scan_load8(const char *s) {
+    uint64_t x;
+    memcpy(&x, s, sizeof(x));
+    return x;
+}
+
+// non-zero when any of the 8 bytes of x is zero
+static ALWAYS_INLINE uint64_t json_scan_has_zero(uint64_t x) {
+    return (x - JSON_SCAN_ONES) & ~x & JSON_SCAN_HIGHS;
+}
+
+// non-zero when any of the 8 bytes of x is b
+static ALWAYS_INLINE uint64_t json_scan_has_byte(uint64_t x, uint8_t b) {
+    return json_scan_has_zero(x ^ (JSON_SCAN_ONES * b));
+}
+
+// non-zero when any of the 8 bytes of x is less than n (n <= 128)
+static ALWAYS_INLINE uint64_t json_scan_has_less(uint64_t x, uint8_t n) {
+    return (x - JSON_SCAN_ONES * n) & ~x & JSON_SCAN_HIGHS;
+}
+
+static ALWAYS_INLINE bool json_scan_is_space(char c) {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+static ALWAYS_INLINE const char *json_scan_skip_spaces(const char *s, const char *e) {
+    while(s < e && json_scan_is_space(*s))
+        s++;
+
+    return s;
+}
+
+static ALWAYS_INLINE bool json_scan_is_hex(char c) {
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f') || (c >= 'A' && c <= 'F');
+}
+
+// s points after the opening quote
+// returns the position of the closing quote, or NULL when the string is not terminated or invalid
+static const char *json_scan_string_end(const char *s, const char *e, bool *escaped, bool validate) {
+    while(true) {
+        while(e - s >= 8) {
+            uint64_t x = json_scan_load8(s);
+            if(json_scan_has_byte(x, '"') || json_scan_has_byte(x, '\\') || (validate && json_scan_has_less(x, 0x20)))
+                break;
+
+            s += 8;
+        }
+
+        if(unlikely(s >= e))
+            return NULL;
+
+        unsigned char c = (unsigned char)*s;
+        if(c == '"')
+            return s;
+
+        if(c == '\\') {
+            *escaped = true;
+            if(unlikely(++s >= e))
+                return NULL;
+
+            if(validate) {
+                switch(*s) {
+                    case '"':
+                    case '\\':
+                    case '/':
+                    case 'b':
+                    case 'f':
+                    case 'n':
+                    case 'r':
+                    case 't':
+                        break;
+
+                    case 'u':
+                        if(e - s < 5 || !json_scan_is_hex(s[1]) || !json_scan_is_hex(s[2]) || !json_scan_is_hex(s[3]) || !json_scan_is_hex(s[4]))
+                            return NULL;
+                        s += 4;
+                        break;
+
+                    default:
+                        return NULL;
+                }
+            }
+
+            s++;
+            continue;
+        }
+
+        if(validate && unlikely(c < 0x20))
+            return NULL;
+
+        s++;
+    }
+}
+
+// ----------------------------------------------------------------------------
+// validation
+
+struct json_scan_state {
+    const char *end;
+    const char *error_at;
+};
+
+static ALWAYS_INLINE const char *json_scan_failed(struct json_scan_state *st, const char *s) {
+    if(!st->error_at)
+        st->error_at = s;
+
+    return NULL;
+}
+
+static const char *json_scan_number_end(const char *s, const char *e) {
+    if(s < e && *s == '-')
+        s++;
+
+    if(s >= e)
+        return NULL;
+
+    if(*s == '0')
+        s++;
+    else if(*s >= '1' && *s <= '9') {
+        while(s < e && isdigit((uint8_t)*s))
+            s++;
+    }
+    else
+        return NULL;
+
+    if(s < e && *s == '.') {
+        const char *digits = ++s;
+        while(s < e && isdigit((uint8_t)*s))
+            s++;
+
+        if(s == digits)
+            return NULL;
+    }
+
+    if(s < e && (*s == 'e' || *s == 'E')) {
+        s++;
+        if(s < e && (*s == '+' || *s == '-'))
+            s++;
+
+        const char *digits = s;
+        while(s < e && isdigit((uint8_t)*s))
+            s++;
+
+        if(s == digits)
+            return NULL;
+    }
+
+    return s;
+}
+
+static const char *json_scan_literal_end(const char *s, const char *e, const char *literal, size_t len) {
+    if((size_t)(e - s) < len || memcmp(s, literal, len) != 0)
+        return NULL;
+
+    return s + len;
+}
+
+// s points to the first byte of the value (spaces already skipped)
+static const char *json_scan_parse_value(struct json_scan_state *st, const char *s, JSON_SCAN_VALUE *v, size_t depth) {
+    const char *e = st->end;
+
+    if(unlikely(s >= e))
+        return json_scan_failed(st, s);
+
+    v->s = s;
+    v->escaped = false;
+
+    switch(*s) {
+        case '"': {
+            const char *q = json_scan_string_end(s + 1, e, &v->escaped, true);
+            if(!q)
+                return json_scan_failed(st, s);
+
+            v->type = JSON_SCAN_STRING;
+            v->s = s + 1;
+            v->len = q - v->s;
+            return q + 1;
+        }
+
+        case '{':
+        case '[': {
+            if(unlikely(depth >= JSON_SCAN_MAX_DEPTH))
+                return json_scan_failed(st, s);
+
+            bool object = (*s == '{');
+            char close = object ? '}' : ']';
+            JSON_SCAN_VALUE child;
+
+            s = json_scan_skip_spaces(s + 1, e);
+            if(s < e && *s == close) {
+                v->type = object ? JSON_SCAN_OBJECT : JSON_SCAN_ARRAY;
+                v->len = s + 1 - v->s;
+                return s + 1;
+            }
+
+            while(true) {
+                if(object) {
+                    if(s >= e || *s != '"')
+                        return json_scan_failed(st, s);
+
+                    s = json_scan_parse_value(st, s, &child, depth + 1);
+                    if(!s)
+                        return NULL;
+
+                    s = json_scan_skip_spaces(s, e);
+                    if(s >= e || *s != ':')
+                        return json_scan_failed(st, s);
+
+                    s = json_scan_skip_spaces(s + 1, e);
+                }
+
+                s = json_scan_parse_value(st, s, &child, depth + 1);
+                if(!s)
+                    return NULL;
+
+                s = json_scan_skip_spaces(s, e);
+                if(s >= e)
+                    return json_scan_failed(st, s);
+
+                if(*s == close)
+                    break;
+
+                if(*s != ',')
+                    return json_scan_failed(st, s);
+
+                s = json_scan_skip_spaces(s + 1, e);
+            }
+
+            v->type = object ? JSON_SCAN_OBJECT : JSON_SCAN_ARRAY;
+            v->len = s + 1 - v->s;
+            return s + 1;
+        }
+
+        case 't':
+            v->type = JSON_SCAN_TRUE;
+            s = json_scan_literal_end(s, e, "true", 4);
+            break;
+
+        case 'f':
+            v->type = JSON_SCAN_FALSE;
+            s = json_scan_literal_end(s, e, "false", 5);
+            break;
+
+        case 'n':
+            v->type = JSON_SCAN_NULL;
+            s = json_scan_literal_end(s, e, "null", 4);
+            break;
+
+        default:
+            v->type = JSON_SCAN_NUMBER;
+            s = json_scan_number_end(s, e);
+            break;
+    }
+
+    if(!s)
+        return json_scan_failed(st, v->s);
+
+    v->len = s - v->s;
+    return s;
+}
+
+bool json_scan(const char *json, size_t len, JSON_SCAN_VALUE *root, const char **error_at) {
+    struct json_scan_state st = {
+        .end = json + len,
+        .error_at = NULL,
+    };
+
+    JSON_SCAN_VALUE v;
+    const char *s = json_scan_skip_spaces(json, st.end);
+    s = json_scan_parse_value(&st, s, &v, 0);
+
+    if(s) {
+        s = json_scan_skip_spaces(s, st.end);
+        if(s < st.end && *s)
+            s = json_scan_failed(&st, s);
+    }
+
+    if(!s) {
+        if(error_at)
+            *error_at = st.error_at;
+
+        memset(root, 0, sizeof(*root));
+        return false;
+    }
+
+    *root = v;
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+// navigation - the text has already been validated
+
+// s points to the first byte of a value
+// fills v and returns the position after the value
+static const char *json_scan_fill_value(const char *s, const char *e, JSON_SCAN_VALUE *v) {
+    v->s = s;
+    v->escaped = false;
+
+    switch(*s) {
+        case '"': {
+            const char *q = json_scan_string_end(s + 1, e, &v->escaped, false);
+            v->type = JSON_SCAN_STRING;
+            v->s = s + 1;
+            v->len = q - v->s;
+            return q + 1;
+        }
+
+        case '{':
+        case '[': {
+            v->type = (*s == '{') ? JSON_SCAN_OBJECT : JSON_SCAN_ARRAY;
+
+            size_t depth = 0;
+            while(s < e) {
+                while(e - s >= 8) {
+                    uint64_t x = json_scan_load8(s);
+                    if(json_scan_has_byte(x, '"') ||
+                       json_scan_has_byte(x, '{') || json_scan_has_byte(x, '}') ||
+                       json_scan_has_byte(x, '[') || json_scan_has_byte(x, ']'))
+                        break;
+
+                    s += 8;
+                }
+
+                if(s >= e)
+                    break;
+
+                char c = *s;
+                if(c == '"') {
+                    bool escaped;
+                    s = json_scan_string_end(s + 1, e, &escaped, false) + 1;
+                    continue;
+                }
+
+                if(c == '{' || c == '[')
+                    depth++;
+
+                else if((c == '}' || c == ']') && --depth == 0) {
+                    s++;
+                    break;
+                }
+
+                s++;
+            }
+
+            v->len = s - v->s;
+            return s;
+        }
+
+        case 't':
+            v->type = JSON_SCAN_TRUE;
+            break;
+
+        case 'f':
+            v->type = JSON_SCAN_FALSE;
+            break;
+
+        case 'n':
+            v->type = JSON_SCAN_NULL;
+            break;
+
+        default:
+            v->type = JSON_SCAN_NUMBER;
+            break;
+    }
+
+    while(s < e && *s != ',' && *s != '}' && *s != ']' && !json_scan_is_space(*s))
+        s++;
+
+    v->len = s - v->s;
+    return s;
+}
+
+void json_scan_iterator_init(JSON_SCAN_ITERATOR *it, const JSON_SCAN_VALUE *container) {
+    it->index = 0;
+
+    if(container->type != JSON_SCAN_OBJECT && container->type != JSON_SCAN_ARRAY) {
+        it->pos = it->end = NULL;
+        return;
+    }
+
+    // between the opening and the closing bracket
+    it->pos = container->s + 1;
+    it->end = container->s + container->len - 1;
+}
+
+static ALWAYS_INLINE const char *json_scan_iterator_next_value(JSON_SCAN_ITERATOR *it) {
+    const char *s = json_scan_skip_spaces(it->pos, it->end);
+    if(s < it->end && *s == ',')
+        s = json_scan_skip_spaces(s + 1, it->end);
+
+    return (s < it->end) ? s : NULL;
+}
+
+bool json_scan_object_next(JSON_SCAN_ITERATOR *it, JSON_SCAN_VALUE *key, JSON_SCAN_VALUE *value) {
+    const char *s = json_scan_iterator_next_value(it);
+    if(!s || *s != '"')
+        return false;
+
+    s = json_scan_fill_value(s, it->end, key);
+    s = json_scan_skip_spaces(s, it->end);
+    s = json_scan_skip_spaces(s + 1, it->end); // the colon
+    it->pos = json_scan_fill_value(s, it->end, value);
+    it->index++;
+
+    return true;
+}
+
+bool json_scan_array_next(JSON_SCAN_ITERATOR *it, JSON_SCAN_VALUE *value) {
+    const char *s = json_scan_iterator_next_value(it);
+    if(!s)
+        return false;
+
+    it->pos = json_scan_fill_value(s, it->end, value);
+    it->index++;
+
+    return true;
+}
+
+size_t json_scan_length(const JSON_SCAN_VALUE *container) {
+    JSON_SCAN_ITERATOR it;
+    JSON_SCAN_VALUE key, value;
+
+    json_scan_iterator_init(&it, container);
+
+    if(container->type == JSON_SCAN_OBJECT)
+        while(json_scan_object_next(&it, &key, &value)) ;
+    else
+        while(json_scan_array_next(&it, &value)) ;
+
+    return it.index;
+}
+
+bool json_scan_object_get(const JSON_SCAN_VALUE *obj, const char *key, JSON_SCAN_VALUE *value) {
+    if(obj->type != JSON_SCAN_OBJECT)
+        return false;
+
+    JSON_SCAN_ITERATOR it;
+    JSON_SCAN_VALUE k, v;
+    bool found = false;
+
+    json_scan_iterator_init(&it, obj);
+    while(json_scan_object_next(&it, &k, &v)) {
+        if(json_scan_string_equals(&k, key)) {
+            *value = v;
+            found = true;
+        }
+    }
+
+    return found;
+}
+
+// ----------------------------------------------------------------------------
+// conversions
+
+static size_t json_scan_utf8_encode(uint32_t cp, char *out) {
+    if(cp < 0x80) {
+        out[0] = (char)cp;
+        return 1;
+    }
+    if(cp < 0x800) {
+        out[0] = (char)(0xC0 | (cp >> 6));
+        out[1] = (char)(0x80 | (cp & 0x3F));
+        return 2;
+    }
+    if(cp < 0x10000) {
+        out[0] = (char)(0xE0 | (cp >> 12));
+        out[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+        out[2] = (char)(0x80 | (cp & 0x3F));
+        return 3;
+    }
+    out[0] = (char)(0xF0 | (cp >> 18));
+    out[1] = (char)(0x80 | ((cp >> 12) & 0x3F));
+    out[2] = (char)(0x80 | ((cp >> 6) & 0x3F));
+    out[3] = (char)(0x80 | (cp & 0x3F));
+    return 4;
+}
+
+static uint32_t json_scan_hex4(const char *s) {
+    uint32_t cp = 0;
+    for(size_t i = 0; i < 4; i++) {
+        char c = s[i];
+        cp <<= 4;
+        if(c >= '0' && c <= '9') cp |= c - '0';
+        else if(c >= 'a' && c <= 'f') cp |= c - 'a' + 10;
+        else cp |= c - 'A' + 10;
+    }
+    return cp;
+}
+
+// decode one (possibly escaped) character at *p into out (up to 4 bytes)
+static size_t json_scan_unescape_next(const char **p, const char *e, char *out) {
+    const char *s = *p;
+
+    if(*s != '\\') {
+        out[0] = *s;
+        *p = s + 1;
+        return 1;
+    }
+
+    s++;
+    size_t len = 1;
+    switch(*s) {
+        case 'b': out[0] = '\b'; break;
+        case 'f': out[0] = '\f'; break;
+        case 'n': out[0] = '\n'; break;
+        case 'r': out[0] = '\r'; break;
+        case 't': out[0] = '\t'; break;
+
+        case 'u': {
+            uint32_t cp = json_scan_hex4(s + 1);
+            s += 4;
+
+            // a surrogate pair
+            if(cp >= 0xD800 && cp <= 0xDBFF && e - s >= 7 && s[1] == '\\' && s[2] == 'u') {
+                uint32_t low = json_scan_hex4(s + 3);
+                if(low >= 0xDC00 && low <= 0xDFFF) {
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                    s += 6;
+                }
+            }
+
+            len = json_scan_utf8_encode(cp, out);
+            break;
+        }
+
+        default:
+            // quote, backslash and slash are themselves
+            out[0] = *s;
+            break;
+    }
+
+    *p = s + 1;
+    return len;
+}
+
+bool json_scan_string_equals(const JSON_SCAN_VALUE *value, const char *str) {
+    if(value->type != JSON_SCAN_STRING)
+        return false;
+
+    size_t len = strlen(str);
+
+    if(!value->escaped)
+        return value->len == len && memcmp(value->s, str, len) == 0;
+
+    const char *s = value->s, *e = value->s + value->len;
+    size_t pos = 0;
+    char tmp[4];
+    while(s < e) {
+        size_t n = json_scan_unescape_next(&s, e, tmp);
+        if(pos + n > len || memcmp(&str[pos], tmp, n) != 0)
+            return false;
+
+        pos += n;
+    }
+
+    return pos == len;
+}
+
+size_t json_scan_string_copy(const JSON_SCAN_VALUE *value, char *dst, size_t dst_size) {
+    if(!dst_size)
+        return 0;
+
+    if(value->type != JSON_SCAN_STRING) {
+        dst[0] = '\0';
+        return 0;
+    }
+
+    if(!value->escaped) {
+        size_t len = MIN(value->len, dst_size - 1);
+        memcpy(dst, value->s, len);
+        dst[len] = '\0';
+        return len;
+    }
+
+    const char *s = value->s, *e = value->s + value->len;
+    size_t pos = 0;
+    char tmp[4];
+    while(s < e) {
+        size_t n = json_scan_unescape_next(&s, e, tmp);
+        if(pos + n > dst_size - 1)
+            break;
+
+        memcpy(&dst[pos], tmp, n);
+        pos += n;
+    }
+
+    dst[pos] = '\0';
+    return pos;
+}
+
+static void json_scan_number_copy(const JSON_SCAN_VALUE *value, char *dst, size_t dst_size, bool *integer) {
+    size_t len = MIN(value->len, dst_size - 1);
+    memcpy(dst, value->s, len);
+    dst[len] = '\0';
+
+    *integer = (strpbrk(dst, ".eE") == NULL);
+}
+
+// the conversions follow json_object_get_int64(), json_object_get_double()
+// and json_object_get_boolean() of json-c, so that callers moved from json-c
+// see the same values: strings are parsed, booleans are 0 and 1
+
+static int64_t json_scan_double_to_int64(NETDATA_DOUBLE d) {
+    // json-c saturates, instead of overflowing
+    if(isnan(d))
+        return 0;
+
+    if(d >= (NETDATA_DOUBLE)INT64_MAX)
+        return INT64_MAX;
+
+    if(d <= (NETDATA_DOUBLE)INT64_MIN)
+        return INT64_MIN;
+
+    return (int64_t)d;
+}
+
+int64_t json_scan_int64(const JSON_SCAN_VALUE *value, int64_t def) {
+    char buf[64];
+    bool integer;
+
+    switch(value->type) {
+        case JSON_SCAN_NUMBER:
+            json_scan_number_copy(value, buf, sizeof(buf), &integer);
+            if(integer)
+                return str2ll(buf, NULL);
+
+            return json_scan_double_to_int64(str2ndd(buf, NULL));
+
+        case JSON_SCAN_STRING: {
+            // like json-c: a leading integer is enough, "200" and "200 OK" are 200
+            json_scan_string_copy(value, buf, sizeof(buf));
+            char *end;
+            long long v = strtoll(buf, &end, 10);   // saturates, like json-c
+            if(end == buf)
+                return def;
+
+            return (int64_t)v;
+        }
+
+        case JSON_SCAN_TRUE:
+            return 1;
+
+        case JSON_SCAN_FALSE:
+            return 0;
+
+        default:
+            return def;
+    }
+}
+
+NETDATA_DOUBLE json_scan_double(const JSON_SCAN_VALUE *value, NETDATA_DOUBLE def) {
+    char buf[64];
+    bool integer;
+
+    switch(value->type) {
+        case JSON_SCAN_NUMBER:
+            json_scan_number_copy(value, buf, sizeof(buf), &integer);
+            return str2ndd(buf, NULL);
+
+        case JSON_SCAN_STRING: {
+            // like json-c: the whole string has to be a number
+            if(value->len >= sizeof(buf))
+                return def;
+
+            json_scan_string_copy(value, buf, sizeof(buf));
+            char *end;
+            errno_clear();
+            NETDATA_DOUBLE v = strtondd(buf, &end);
+            if(end == buf || *end || errno)
+                return def;
+
+            return v;
+        }
+
+        case JSON_SCAN_TRUE:
+            return 1.0;
+
+        case JSON_SCAN_FALSE:
+            return 0.0;
+
+        default:
+            return def;
+    }
+}
+
+bool json_scan_bool(const JSON_SCAN_VALUE *value, bool def) {
+    switch(value->type) {
+        case JSON_SCAN_TRUE:
+            return true;
+
+        case JSON_SCAN_FALSE:
+            return false;
+
+        case JSON_SCAN_NUMBER:
+            // like json-c, 0.5 is true
+            return json_scan_double(value, 0) != 0;
+
+        case JSON_SCAN_STRING:
+            // like json-c, any non-empty string is true, even "false"
+            return value->len != 0;
+
+        default:
+            return def;
+    }
+}
+
+// ----------------------------------------------------------------------------
+// unittest
+
+static int json_scan_unittest_validation(void) {
+    static const char *valid[] = {
+        "{}", "[]", "0", "-0.5e+10", "\"\"", "true", "false", "null",
+        " { \"a\" : [ 1, 2.5, -3e2, \"x\\\"y\", {\"b\":null} ] , \"c\":true } ",
+        "\"\\u00e9\\ud83d\\ude00 \\/\\\\\\b\\f\\n\\r\\t\"",
+        "[[[[[[[[[[]]]]]]]]]]",
+        "\"a string longer than eight bytes, to use the word-at-a-time path\"",
+        NULL,
+    };
+
+    static const char *invalid[] = {
+        "", " ", "{", "[", "}", "{\"a\"}", "{\"a\":}", "{\"a\":1,}", "[1,]", "[1 2]",
+        "01", "1.", "-", "1e", ".5", "tru", "nulls", "\"abc", "\"\\x\"", "\"\\u12g4\"",
+        "\"tab\there\"", "{} {}", "[1]]", "{1:2}",
+        NULL,
+    };
+
+    int errors = 0;
+    JSON_SCAN_VALUE v;
+
+    for(size_t i = 0; valid[i]; i++) {
+        const char *error_at = NULL;
+        if(!json_scan(valid[i], strlen(valid[i]), &v, &error_at)) {
+            fprintf(stderr, "JSON SCAN: valid document '%s' failed at '%s'\n", valid[i], error_at ? error_at : "(null)");
+            errors++;
+        }
+    }
+
+    for(size_t i = 0; invalid[i]; i++) {
+        if(json_scan(invalid[i], strlen(invalid[i]), &v, NULL)) {
+            fprintf(stderr, "JSON SCAN: invalid document '%s' was accepted\n", invalid[i]);
+            errors++;
+        }
+    }
+
+    // too deep
+    char deep[JSON_SCAN_MAX_DEPTH * 2 + 3];
+    memset(deep, '[', JSON_SCAN_MAX_DEPTH + 1);
+    memset(&deep[JSON_SCAN_MAX_DEPTH + 1], ']', JSON_SCAN_MAX_DEPTH + 1);
+    if(json_scan(deep, (JSON_SCAN_MAX_DEPTH + 1) * 2, &v, NULL)) {
+        fprintf(stderr, "JSON SCAN: a document deeper than %d levels was accepted\n", JSON_SCAN_MAX_DEPTH);
+        errors++;
+    }
+
+    return errors;
+}
+
+static int json_scan_unittest_navigation(void) {
+    const char *json =
+        "{\n"
+        "  \"type\": \"table\",\n"
+        "  \"status\": 200,\n"
+        "  \"has_history\": true,\n"
+        "  \"update_every\": 1.5,\n"
+        "  \"help\": \"a \\\"quoted\\\" help with a {brace} and a [bracket]\",\n"
+        "  \"columns\": { \"a\": { \"index\": 0 }, \"b\": { \"index\": 1 } },\n"
+        "  \"data\": [ [1, \"x\"], [2, \"y\"], [3, \"z\"] ],\n"
+        "  \"k\\u00e9y\": -42,\n"
+        "  \"status\": 404\n"
+        "}";
+
+    int errors = 0;
+    JSON_SCAN_VALUE root, v;
+    char buf[128];
+
+    if(!json_scan(json, strlen(json), &root, NULL) || root.type != JSON_SCAN_OBJECT) {
+        fprintf(stderr, "JSON SCAN: navigation document failed to parse\n");
+        return 1;
+    }
+
+    if(!json_scan_object_get(&root, "type", &v) || !json_scan_string_equals(&v, "table")) {
+        fprintf(stderr, "JSON SCAN: 'type' is wrong\n");
+        errors++;
+    }
+
+    // the last duplicate wins
+    if(!json_scan_object_get(&root, "status", &v) || json_scan_int64(&v, 0) != 404) {
+        fprintf(stderr, "JSON SCAN: 'status' is wrong\n");
+        errors++;
+    }
+
+    if(!json_scan_object_get(&root, "has_history", &v) || !json_scan_bool(&v, false)) {
+        fprintf(stderr, "JSON SCAN: 'has_history' is wrong\n");
+        errors++;
+    }
+
+    if(!json_scan_object_get(&root, "update_every", &v) || json_scan_double(&v, 0) != 1.5 || json_scan_int64(&v, 0) != 1) {
+        fprintf(stderr, "JSON SCAN: 'update_every' is wrong\n");
+        errors++;
+    }
+
+    if(!json_scan_object_get(&root, "help", &v) ||
+        json_scan_string_copy(&v, buf, sizeof(buf)) != strlen("a \"quoted\" help with a {brace} and a [bracket]") ||
+        strcmp(buf, "a \"quoted\" help with a {brace} and a [bracket]") != 0) {
+        fprintf(stderr, "JSON SCAN: 'help' is wrong\n");
+        errors++;
+    }
+
+    if(!json_scan_object_get(&root, "k\xc3\xa9y", &v) || json_scan_int64(&v, 0) != -42) {
+        fprintf(stderr, "JSON SCAN: escaped key lookup failed\n");
+        errors++;
+    }
+
+    if(json_scan_object_get(&root, "missing", &v)) {
+        fprintf(stderr, "JSON SCAN: a missing key was found\n");
+        errors++;
+    }
+
+    if(!json_scan_object_get(&root, "columns", &v) || json_scan_length(&v) != 2) {
+        fprintf(stderr, "JSON SCAN: 'columns' is wrong\n");
+        errors++;
+    }
+
+    if(!json_scan_object_get(&root, "data", &v) || json_scan_length(&v) != 3) {
+        fprintf(stderr, "JSON SCAN: 'data' is wrong\n");
+        errors++;
+    }
+    else {
+        JSON_SCAN_ITERATOR it;
+        JSON_SCAN_VALUE row, cell;
+        int64_t sum = 0;
+
+        json_scan_iterator_init(&it, &v);
+        while(json_scan_array_next(&it, &row)) {
+            JSON_SCAN_ITERATOR it2;
+            json_scan_iterator_init(&it2, &row);
+            if(json_scan_array_next(&it2, &cell))
+                sum += json_scan_int64(&cell, 0);
+        }
+
+        if(sum != 6) {
+            fprintf(stderr, "JSON SCAN: iterating 'data' gave %"PRId64", expected 6\n", sum);
+            errors++;
+        }
+    }
+
+    // truncation keeps the string terminated
+    if(!json_scan_object_get(&root, "help", &v) || json_scan_string_copy(&v, buf, 4) != 3 || strcmp(buf, "a \"") != 0) {
+        fprintf(stderr, "JSON SCAN: truncated copy is wrong\n");
+        errors++;
+    }
+
+    // the conversions of json-c
+    {
+        struct {
+            const char *json;
+            int64_t i;
+            NETDATA_DOUBLE d;
+            bool b;
+        } conversions[] = {
+            { "\"200\"",      200,       200.0,  true  },
+            { "\"200 OK\"",   200,       -1.0,   true  },
+            { "\"abc\"",      -1,        -1.0,   true  },
+            { "\"\"",         -1,        -1.0,   false },
+            { "\"false\"",    -1,        -1.0,   true  },
+            { "\"-1.5\"",     -1,        -1.5,   true  },
+            { "true",       1,         1.0,    true  },
+            { "false",      0,         0.0,    false },
+            { "0",          0,         0.0,    false },
+            { "0.5",        0,         0.5,    true  },
+            { "1e19",       INT64_MAX, 1e19,   true  },
+            { "null",       -1,        -1.0,   false },
+            { "[]",         -1,        -1.0,   false },
+        };
+
+        for(size_t i = 0; i < _countof(conversions); i++) {
+            if(!json_scan(conversions[i].json, strlen(conversions[i].json), &v, NULL)) {
+                fprintf(stderr, "JSON SCAN: conversion document '%s' failed to parse\n", conversions[i].json);
+                errors++;
+                continue;
+            }
+
+            int64_t ii = json_scan_int64(&v, -1);
+            NETDATA_DOUBLE dd = json_scan_double(&v, -1.0);
+            bool bb = json_scan_bool(&v, false);
+            if(ii != conversions[i].i || fabsndd(dd - conversions[i].d) > fabsndd(conversions[i].d) * 1e-12 ||
+                bb != conversions[i].b) {
+                fprintf(stderr, "JSON SCAN: '%s' converted to %"PRId64", %f, %s - expected %"PRId64", %f, %s\n",
+                        conversions[i].json, ii, (double)dd, bb ? "true" : "false",
+                        conversions[i].i, (double)conversions[i].d, conversions[i].b ? "true" : "false");
+                errors++;
+            }
+        }
+    }
+
+    const char *surrogates = "\"\\ud83d\\ude00\"";
+    if(!json_scan(surrogates, strlen(surrogates), &v, NULL) || !json_scan_string_equals(&v, "\xf0\x9f\x98\x80")) {
+        fprintf(stderr, "JSON SCAN: surrogate pairs are not decoded\n");
+        errors++;
+    }
+
+    return errors;
+}
+
+static int json_scan_unittest_benchmark(void) {
+    // something like a large function response: a few members and a big data array
+    CLEAN_BUFFER *wb = buffer_create(0, NULL);
+    buffer_json_initialize(wb, "\"", "\"", 0, true, BUFFER_JSON_OPTIONS_MINIFY);
+    buffer_json_member_add_uint64(wb, "status", 200);
+    buffer_json_member_add_string(wb, "type", "table");
+    buffer_json_member_add_boolean(wb, "has_history", false);
+    buffer_json_member_add_array(wb, "data");
+    for(size_t i = 0; i < 100000; i++) {
+        buffer_json_add_array_item_array(wb);
+        buffer_json_add_array_item_uint64(wb, i);
+        buffer_json_add_array_item_string(wb, "a \"quoted\" value, long enough to be realistic");
+        buffer_json_add_array_item_double(wb, (NETDATA_DOUBLE)i / 3.0);
+        buffer_json_array_close(wb);
+    }
+    buffer_json_array_close(wb);
+    buffer_json_finalize(wb);
+
+    const char *json = buffer_tostring(wb);
+    size_t len = buffer_strlen(wb);
+
+    usec_t started_ut = now_monotonic_usec();
+    JSON_SCAN_VALUE root, v;
+    bool ok = json_scan(json, len, &root, NULL) &&
+              json_scan_object_get(&root, "type", &v) && json_scan_string_equals(&v, "table");
+    usec_t scan_ut = now_monotonic_usec() - started_ut;
+
+    started_ut = now_monotonic_usec();
+    struct json_object *jobj = json_tokener_parse(json);
+    usec_t jsonc_ut = now_monotonic_usec() - started_ut;
+    json_object_put(jobj);
+
+    fprintf(stderr, "JSON SCAN: %zu bytes, validated and looked up in %"PRIu64" usec, json-c DOM built in %"PRIu64" usec\n",
+            len, scan_ut, jsonc_ut);
+
+    if(!ok) {
+        fprintf(stderr, "JSON SCAN: the benchmark document failed\n");
+        return 1;
+    }
+
+    return 0;
+}
+
+int json_scan_unittest(void) {
+    int errors = 0;
+
+    errors += json_scan_unittest_validation();
+    errors += json_scan_unittest_navigation();
+    errors += json_scan_unittest_benchmark();
+
+    fprintf(stderr, "JSON SCAN: %d errors\n", errors);
+    return errors;
+}
@@ -0,0 +1,70 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef NETDATA_JSON_SCAN_H
+#define NETDATA_JSON_SCAN_H
+
+#include "../libnetdata.h"
+
+// An on-demand JSON scanner.
+//
+// json_scan() validates a document in a single pass, without allocating anything.
+// The values it returns point inside the original text, so members and array items
+// can then be looked up and converted on demand, without building a DOM.
+//
+// Use it when only a few members of a (possibly large) document are needed.
+// When the whole document has to be walked or modified, json-c is still the way to go.
+
+#define JSON_SCAN_MAX_DEPTH 512
+
+typedef enum __attribute__((packed)) {
+    JSON_SCAN_INVALID = 0,
+    JSON_SCAN_OBJECT,
+    JSON_SCAN_ARRAY,
+    JSON_SCAN_STRING,
+    JSON_SCAN_NUMBER,
+    JSON_SCAN_TRUE,
+    JSON_SCAN_FALSE,
+    JSON_SCAN_NULL,
+} JSON_SCAN_TYPE;
+
+typedef struct json_scan_value {
+    JSON_SCAN_TYPE type;
+    bool escaped;           // strings only: the string has escape sequences
+    const char *s;          // the first byte of the value (strings: after the opening quote)
+    size_t len;             // the bytes of the value (strings: without the quotes, still escaped)
+} JSON_SCAN_VALUE;
+
+typedef struct json_scan_iterator {
+    const char *pos;
+    const char *end;
+    size_t index;
+} JSON_SCAN_ITERATOR;
+
+// validate a complete document and return its root value
+// on failure, *error_at (if given) points to the offending byte
+bool json_scan(const char *json, size_t len, JSON_SCAN_VALUE *root, const char **error_at);
+
+// the values given to the following must have been returned by json_scan() or by them
+
+// find a member of an object - the last one wins, like json-c does
+bool json_scan_object_get(const JSON_SCAN_VALUE *obj, const char *key, JSON_SCAN_VALUE *value);
+
+// walk through the members of an object or the items of an array
+void json_scan_iterator_init(JSON_SCAN_ITERATOR *it, const JSON_SCAN_VALUE *container);
+bool json_scan_object_next(JSON_SCAN_ITERATOR *it, JSON_SCAN_VALUE *key, JSON_SCAN_VALUE *value);
+bool json_scan_array_next(JSON_SCAN_ITERATOR *it, JSON_SCAN_VALUE *value);
+
+// the number of members or items of a container
+size_t json_scan_length(const JSON_SCAN_VALUE *container);
+
+// conversions - like json-c, strings are parsed as numbers, booleans are 0 and 1 and
+// non-empty strings are true - the default is returned when the value cannot be converted
+bool json_scan_string_equals(const JSON_SCAN_VALUE *value, const char *str);
+size_t json_scan_string_copy(const JSON_SCAN_VALUE *value, char *dst, size_t dst_size);
+int64_t json_scan_int64(const JSON_SCAN_VALUE *value, int64_t def);
+NETDATA_DOUBLE json_scan_double(const JSON_SCAN_VALUE *value, NETDATA_DOUBLE def);
+bool json_scan_bool(const JSON_SCAN_VALUE *value, bool def);
+
+int json_scan_unittest(void);
+
+#endif //NETDATA_JSON_SCAN_H
@@ -77,9 +77,11 @@ extern const char *netdata_configured_host_prefix;
 #include "parsers/parsers.h"
 
 #include "threads/threads.h"
+#include "threads/thread-pool.h"
 #include "locks/locks.h"
 #include "locks/spinlock.h"
 #include "locks/rw-spinlock.h"
+#include "locks/lock-profiling.h"
 #include "completion/completion.h"
 #include "libnetdata/locks/waitq.h"
 #include "clocks/clocks.h"
@@ -105,6 +107,7 @@ extern const char *netdata_configured_host_prefix;
 #include "ringbuffer/ringbuffer.h"
 #include "circular_buffer/circular_buffer.h"
 #include "buffered_reader/buffered_reader.h"
+#include "shm_ring/shm_ring.h"
 #include "datetime/iso8601.h"
 #include "datetime/rfc3339.h"
 #include "datetime/rfc7231.h"
@@ -121,10 +124,12 @@ extern const char *netdata_configured_host_prefix;
 
 #include "eval/eval.h"
 #include "statistical/statistical.h"
+#include "statistical/ddsketch.h"
 #include "adaptive_resortable_list/adaptive_resortable_list.h"
 #include "url/url.h"
 #include "json/json.h"
 #include "json/json-c-parser-inline.h"
+#include "json/json-scan.h"
 #include "string/utf8.h"
 #include "libnetdata/aral/aral.h"
 #include "onewayalloc/onewayalloc.h"
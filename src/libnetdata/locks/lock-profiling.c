@@ -0,0 +1,435 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "libnetdata/libnetdata.h"
+
+// the number of lock sites each thread can track (power of 2)
+#define LOCK_PROFILE_THREAD_SITES 128
+
+bool lock_profiling_enabled = false;
+
+// Each thread gets its own table of lock sites. Only the owner thread writes
+// to it, so updates are plain (relaxed) stores without any read-modify-write.
+// Readers (the function / pulse) load the counters relaxed, so they may see
+// a site slightly behind, but never a torn value.
+//
+// Tables are never freed: when a thread exits, its table is released and it is
+// reused by the next thread that needs one. This keeps the counters monotonic
+// (the history of exited threads is preserved) and allows walking the list of
+// tables without any locking.
+
+struct lock_profile_thread {
+    bool in_use;
+    uint64_t dropped;
+    struct lock_profile_thread *next;
+    LOCK_PROFILE_SITE sites[LOCK_PROFILE_THREAD_SITES];
+};
+
+static struct {
+    struct lock_profile_thread *head;
+    pthread_key_t key;
+    pthread_once_t once;
+} lock_profile_globals = {
+    .head = NULL,
+    .once = PTHREAD_ONCE_INIT,
+};
+
+static __thread struct lock_profile_thread *lock_profile_thread = NULL;
+static __thread bool lock_profile_recursion = false;
+static __thread bool lock_profile_thread_exiting = false;
+
+#define lp_add(var, value) __atomic_store_n(&(var), (var) + (value), __ATOMIC_RELAXED)
+#define lp_load(var) __atomic_load_n(&(var), __ATOMIC_RELAXED)
+
+void lock_profiling_enable(bool enabled) {
+    __atomic_store_n(&lock_profiling_enabled, enabled, __ATOMIC_RELAXED);
+}
+
+const char *lock_profile_type_to_string(LOCK_PROFILE_TYPE type) {
+    switch(type) {
+        case LOCK_PROFILE_SPINLOCK:
+            return "spinlock";
+
+        case LOCK_PROFILE_RW_READ:
+            return "rw-spinlock read";
+
+        case LOCK_PROFILE_RW_WRITE:
+            return "rw-spinlock write";
+
+        default:
+            return "unknown";
+    }
+}
+
+uint64_t lock_profile_histogram_bucket_max_ut(size_t bucket) {
+    if(bucket == 0)
+        return 0;
+
+    if(bucket >= LOCK_PROFILE_HISTOGRAM_BUCKETS - 1)
+        return UINT64_MAX;
+
+    return 1ULL << (bucket - 1);
+}
+
+static ALWAYS_INLINE size_t lock_profile_histogram_bucket(bool contended, usec_t wait_ut) {
+    if(!contended)
+        return 0;
+
+    if(wait_ut <= 1)
+        return 1;
+
+    size_t bucket = 1 + (64 - __builtin_clzll(wait_ut - 1));
+    return bucket < LOCK_PROFILE_HISTOGRAM_BUCKETS ? bucket : LOCK_PROFILE_HISTOGRAM_BUCKETS - 1;
+}
+
+static ALWAYS_INLINE uint64_t lock_profile_site_hash(const char *func, const char *file, uint32_t line, LOCK_PROFILE_TYPE type) {
+    uint64_t h = (uint64_t)(uintptr_t)func * 0x9E3779B97F4A7C15ULL;
+    h ^= (uint64_t)(uintptr_t)file;
+    h ^= ((uint64_t)line << 2) | (uint64_t)type;
+    h ^= h >> 29;
+    h *= 0xBF58476D1CE4E5B9ULL;
+    h ^= h >> 32;
+    return h;
+}
+
+// ----------------------------------------------------------------------------
+// per thread tables
+
+static void lock_profile_thread_release(void *ptr) {
+    struct lock_profile_thread *t = ptr;
+
+    // the locks taken by the other destructors of this thread are not profiled,
+    // so that the table is not used after it is given to another thread
+    lock_profile_thread_exiting = true;
+    lock_profile_thread = NULL;
+
+    if(t)
+        __atomic_store_n(&t->in_use, false, __ATOMIC_RELEASE);
+}
+
+static void lock_profile_key_create(void) {
+    pthread_key_create(&lock_profile_globals.key, lock_profile_thread_release);
+}
+
+static struct lock_profile_thread *lock_profile_thread_get(void) {
+    if(likely(lock_profile_thread))
+        return lock_profile_thread;
+
+    if(unlikely(lock_profile_thread_exiting))
+        return NULL;
+
+    pthread_once(&lock_profile_globals.once, lock_profile_key_create);
+
+    // reuse the table of a thread that has exited
+    struct lock_profile_thread *t;
+    for(t = __atomic_load_n(&lock_profile_globals.head, __ATOMIC_ACQUIRE); t; t = t->next) {
+        bool expected = false;
+        if(!__atomic_load_n(&t->in_use, __ATOMIC_RELAXED) &&
+            __atomic_compare_exchange_n(&t->in_use, &expected, true, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+            break;
+    }
+
+    if(!t) {
+        t = callocz(1, sizeof(*t));
+        t->in_use = true;
+        t->next = __atomic_load_n(&lock_profile_globals.head, __ATOMIC_RELAXED);
+        while(!__atomic_compare_exchange_n(&lock_profile_globals.head, &t->next, t, true, __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+            ;
+    }
+
+    pthread_setspecific(lock_profile_globals.key, t);
+    lock_profile_thread = t;
+    return t;
+}
+
+void lock_profiling_record(LOCK_PROFILE_TYPE type, const char *func, const char *file, uint32_t line, size_t spins, usec_t wait_ut) {
+    // allocating the table of the thread may use locks
+    if(unlikely(lock_profile_recursion))
+        return;
+
+    lock_profile_recursion = true;
+    struct lock_profile_thread *t = lock_profile_thread_get();
+    lock_profile_recursion = false;
+
+    if(unlikely(!t))
+        return;
+
+    if(!func) func = "";
+    if(!file) file = "";
+
+    uint64_t hash = lock_profile_site_hash(func, file, line, type);
+    LOCK_PROFILE_SITE *s = NULL;
+
+    for(size_t i = 0; i < LOCK_PROFILE_THREAD_SITES; i++) {
+        LOCK_PROFILE_SITE *c = &t->sites[(hash + i) & (LOCK_PROFILE_THREAD_SITES - 1)];
+
+        if(likely(c->func == func && c->file == file && c->line == line && c->type == type)) {
+            s = c;
+            break;
+        }
+
+        if(!c->func) {
+            // a new site - publish it after its key is set
+            c->file = file;
+            c->line = line;
+            c->type = type;
+            __atomic_store_n(&c->func, func, __ATOMIC_RELEASE);
+            s = c;
+            break;
+        }
+    }
+
+    if(unlikely(!s)) {
+        lp_add(t->dropped, 1);
+        return;
+    }
+
+    bool contended = spins > 0;
+
+    lp_add(s->acquisitions, 1);
+    lp_add(s->histogram[lock_profile_histogram_bucket(contended, wait_ut)], 1);
+
+    if(contended) {
+        lp_add(s->contended, 1);
+        lp_add(s->spins, spins);
+        lp_add(s->wait_ut, wait_ut);
+
+        if(wait_ut > s->max_wait_ut)
+            __atomic_store_n(&s->max_wait_ut, wait_ut, __ATOMIC_RELAXED);
+    }
+}
+
+// ----------------------------------------------------------------------------
+// reading
+
+static void lock_profile_site_merge(LOCK_PROFILE_SITE *dst, LOCK_PROFILE_SITE *src) {
+    dst->acquisitions += lp_load(src->acquisitions);
+    dst->contended += lp_load(src->contended);
+    dst->spins += lp_load(src->spins);
+    dst->wait_ut += lp_load(src->wait_ut);
+
+    uint64_t max_wait_ut = lp_load(src->max_wait_ut);
+    if(max_wait_ut > dst->max_wait_ut)
+        dst->max_wait_ut = max_wait_ut;
+
+    for(size_t b = 0; b < LOCK_PROFILE_HISTOGRAM_BUCKETS; b++)
+        dst->histogram[b] += lp_load(src->histogram[b]);
+}
+
+LOCK_PROFILE_SITE *lock_profiling_sites(size_t *entries) {
+    struct lock_profile_thread *head = __atomic_load_n(&lock_profile_globals.head, __ATOMIC_ACQUIRE);
+
+    size_t threads = 0;
+    for(struct lock_profile_thread *t = head; t; t = t->next)
+        threads++;
+
+    // an open addressing table, large enough for all the sites of all threads
+    size_t size = 16;
+    while(size < threads * LOCK_PROFILE_THREAD_SITES * 2)
+        size <<= 1;
+
+    LOCK_PROFILE_SITE *merged = callocz(size, sizeof(*merged));
+    size_t used = 0;
+
+    for(struct lock_profile_thread *t = head; t; t = t->next) {
+        for(size_t i = 0; i < LOCK_PROFILE_THREAD_SITES; i++) {
+            LOCK_PROFILE_SITE *s = &t->sites[i];
+            const char *func = __atomic_load_n(&s->func, __ATOMIC_ACQUIRE);
+            if(!func)
+                continue;
+
+            uint64_t hash = lock_profile_site_hash(func, s->file, s->line, s->type);
+            for(size_t p = 0; p < size; p++) {
+                LOCK_PROFILE_SITE *m = &merged[(hash + p) & (size - 1)];
+
+                if(!m->func) {
+                    m->func = func;
+                    m->file = s->file;
+                    m->line = s->line;
+                    m->type = s->type;
+                    used++;
+                }
+                else if(m->func != func || m->file != s->file || m->line != s->line || m->type != s->type)
+                    continue;
+
+                lock_profile_site_merge(m, s);
+                break;
+            }
+        }
+    }
+
+    // compact it
+    size_t n = 0;
+    for(size_t i = 0; i < size && n < used; i++) {
+        if(merged[i].func) {
+            if(i != n)
+                merged[n] = merged[i];
+            n++;
+        }
+    }
+
+    *entries = n;
+    return merged;
+}
+
+void lock_profiling_totals(LOCK_PROFILE_TOTALS *totals) {
+    memset(totals, 0, sizeof(*totals));
+
+    for(struct lock_profile_thread *t = __atomic_load_n(&lock_profile_globals.head, __ATOMIC_ACQUIRE); t; t = t->next) {
+        if(__atomic_load_n(&t->in_use, __ATOMIC_RELAXED))
+            totals->threads++;
+
+        totals->dropped += lp_load(t->dropped);
+
+        for(size_t i = 0; i < LOCK_PROFILE_THREAD_SITES; i++) {
+            LOCK_PROFILE_SITE *s = &t->sites[i];
+            if(!__atomic_load_n(&s->func, __ATOMIC_ACQUIRE))
+                continue;
+
+            totals->acquisitions += lp_load(s->acquisitions);
+            totals->contended += lp_load(s->contended);
+            totals->spins += lp_load(s->spins);
+            totals->wait_ut += lp_load(s->wait_ut);
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------
+// unittest
+
+#define LOCK_PROFILE_UNITTEST_THREADS 4
+#define LOCK_PROFILE_UNITTEST_LOOPS 100000
+
+struct lock_profile_unittest {
+    SPINLOCK spinlock;
+    RW_SPINLOCK rw_spinlock;
+    uint64_t spinlock_counter;
+    uint64_t rw_spinlock_counter;
+};
+
+static void lock_profiling_unittest_thread(void *ptr) {
+    struct lock_profile_unittest *ut = ptr;
+
+    for(size_t i = 0; i < LOCK_PROFILE_UNITTEST_LOOPS; i++) {
+        spinlock_lock(&ut->spinlock);
+        ut->spinlock_counter++;
+        spinlock_unlock(&ut->spinlock);
+
+        rw_spinlock_write_lock(&ut->rw_spinlock);
+        ut->rw_spinlock_counter++;
+        rw_spinlock_write_unlock(&ut->rw_spinlock);
+
+        rw_spinlock_read_lock(&ut->rw_spinlock);
+        (void)__atomic_load_n(&ut->rw_spinlock_counter, __ATOMIC_RELAXED);
+        rw_spinlock_read_unlock(&ut->rw_spinlock);
+    }
+}
+
+// adds (sign > 0) or subtracts (sign < 0) the acquisitions of the unittest lock sites
+// and, when adding, validates and prints them
+static int lock_profiling_unittest_acquisitions(uint64_t acquisitions[LOCK_PROFILE_TYPE_MAX], int sign) {
+    int errors = 0;
+
+    size_t entries = 0;
+    LOCK_PROFILE_SITE *sites = lock_profiling_sites(&entries);
+
+    for(size_t i = 0; i < entries; i++) {
+        LOCK_PROFILE_SITE *s = &sites[i];
+        if(strcmp(s->func, "lock_profiling_unittest_thread") != 0)
+            continue;
+
+        if(sign < 0) {
+            acquisitions[s->type] -= s->acquisitions;
+            continue;
+        }
+
+        uint64_t histogram = 0;
+        for(size_t b = 0; b < LOCK_PROFILE_HISTOGRAM_BUCKETS; b++)
+            histogram += s->histogram[b];
+
+        if(histogram != s->acquisitions) {
+            fprintf(stderr, " > ERROR: site %s:%u has %"PRIu64" acquisitions, but its histogram has %"PRIu64"\n",
+                    s->file, s->line, s->acquisitions, histogram);
+            errors++;
+        }
+
+        if(s->contended > s->acquisitions || s->histogram[0] != s->acquisitions - s->contended) {
+            fprintf(stderr, " > ERROR: site %s:%u has %"PRIu64" contended out of %"PRIu64" acquisitions, "
+                            "and %"PRIu64" uncontended in its histogram\n",
+                    s->file, s->line, s->contended, s->acquisitions, s->histogram[0]);
+            errors++;
+        }
+
+        fprintf(stderr, "   %-20s at %s:%u, acquisitions %"PRIu64", contended %"PRIu64", spins %"PRIu64", wait %"PRIu64" usec, max wait %"PRIu64" usec\n",
+                lock_profile_type_to_string(s->type), s->file, s->line,
+                s->acquisitions, s->contended, s->spins, s->wait_ut, s->max_wait_ut);
+
+        acquisitions[s->type] += s->acquisitions;
+    }
+    freez(sites);
+
+    return errors;
+}
+
+int lock_profiling_unittest(void) {
+    int errors = 0;
+    bool was_enabled = lock_profiling_is_enabled();
+
+    fprintf(stderr, "\nTesting lock contention profiling with %d threads...\n", LOCK_PROFILE_UNITTEST_THREADS);
+
+    struct lock_profile_unittest ut = {
+        .spinlock = SPINLOCK_INITIALIZER,
+        .rw_spinlock = RW_SPINLOCK_INITIALIZER,
+        .spinlock_counter = 0,
+        .rw_spinlock_counter = 0,
+    };
+
+    // the tables of threads are reused, so compare against what is already there
+    uint64_t acquisitions[LOCK_PROFILE_TYPE_MAX] = { 0 };
+    lock_profiling_unittest_acquisitions(acquisitions, -1);
+
+    LOCK_PROFILE_TOTALS before;
+    lock_profiling_totals(&before);
+
+    lock_profiling_enable(true);
+
+    ND_THREAD *threads[LOCK_PROFILE_UNITTEST_THREADS];
+    for(size_t i = 0; i < LOCK_PROFILE_UNITTEST_THREADS; i++) {
+        char tag[ND_THREAD_TAG_MAX + 1];
+        snprintfz(tag, sizeof(tag), "LOCKPROF%zu", i);
+        threads[i] = nd_thread_create(tag, NETDATA_THREAD_OPTION_DONT_LOG, lock_profiling_unittest_thread, &ut);
+    }
+
+    for(size_t i = 0; i < LOCK_PROFILE_UNITTEST_THREADS; i++)
+        nd_thread_join(threads[i]);
+
+    lock_profiling_enable(was_enabled);
+
+    uint64_t expected = (uint64_t)LOCK_PROFILE_UNITTEST_THREADS * LOCK_PROFILE_UNITTEST_LOOPS;
+
+    if(ut.spinlock_counter != expected || ut.rw_spinlock_counter != expected) {
+        fprintf(stderr, " > ERROR: the protected counters are %"PRIu64" and %"PRIu64", expected %"PRIu64"\n",
+                ut.spinlock_counter, ut.rw_spinlock_counter, expected);
+        errors++;
+    }
+
+    errors += lock_profiling_unittest_acquisitions(acquisitions, 1);
+
+    for(size_t type = 0; type < LOCK_PROFILE_TYPE_MAX; type++) {
+        if(acquisitions[type] != expected) {
+            fprintf(stderr, " > ERROR: %s has %"PRIu64" acquisitions, expected %"PRIu64"\n",
+                    lock_profile_type_to_string(type), acquisitions[type], expected);
+            errors++;
+        }
+    }
+
+    LOCK_PROFILE_TOTALS after;
+    lock_profiling_totals(&after);
+    if(after.acquisitions - before.acquisitions < expected * LOCK_PROFILE_TYPE_MAX) {
+        fprintf(stderr, " > ERROR: the totals have %"PRIu64" new acquisitions, expected at least %"PRIu64"\n",
+                after.acquisitions - before.acquisitions, expected * LOCK_PROFILE_TYPE_MAX);
+        errors++;
+    }
+
+    fprintf(stderr, "lock contention profiling %s\n", errors ? "FAILED" : "OK");
+    return errors;
+}
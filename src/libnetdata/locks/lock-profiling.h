@@ -0,0 +1,77 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef NETDATA_LOCK_PROFILING_H
+#define NETDATA_LOCK_PROFILING_H
+
+#include "libnetdata/common.h"
+
+// Lock contention profiling.
+//
+// When enabled, every SPINLOCK and RW_SPINLOCK acquisition is accounted to its
+// lock site (function, file and line of the caller). Each thread keeps its own
+// table of sites, so the lock paths never share cache lines with other threads.
+// The time is measured only when the lock is contended, so uncontended
+// acquisitions cost just a lookup in the thread's table.
+//
+// It is disabled by default; when disabled, the lock paths only check a flag.
+
+typedef enum __attribute__((packed)) {
+    LOCK_PROFILE_SPINLOCK = 0,
+    LOCK_PROFILE_RW_READ,
+    LOCK_PROFILE_RW_WRITE,
+
+    // terminator
+    LOCK_PROFILE_TYPE_MAX,
+} LOCK_PROFILE_TYPE;
+
+// wait time histogram: bucket 0 is "did not wait",
+// then bucket N counts waits up to 2^(N-1) microseconds
+// and the last bucket counts everything above that
+#define LOCK_PROFILE_HISTOGRAM_BUCKETS 16
+
+typedef struct lock_profile_site {
+    const char *func;
+    const char *file;
+    uint32_t line;
+    LOCK_PROFILE_TYPE type;
+
+    uint64_t acquisitions;
+    uint64_t contended;
+    uint64_t spins;
+    uint64_t wait_ut;
+    uint64_t max_wait_ut;
+    uint64_t histogram[LOCK_PROFILE_HISTOGRAM_BUCKETS];
+} LOCK_PROFILE_SITE;
+
+typedef struct lock_profile_totals {
+    uint64_t acquisitions;
+    uint64_t contended;
+    uint64_t spins;
+    uint64_t wait_ut;
+    uint64_t dropped;           // acquisitions not accounted, because a thread's table was full
+    size_t threads;
+} LOCK_PROFILE_TOTALS;
+
+extern bool lock_profiling_enabled;
+
+static inline bool lock_profiling_is_enabled(void) {
+    return __atomic_load_n(&lock_profiling_enabled, __ATOMIC_RELAXED);
+}
+
+void lock_profiling_enable(bool enabled);
+
+// called by the locks after acquiring - wait_ut is zero when the lock was not contended
+void lock_profiling_record(LOCK_PROFILE_TYPE type, const char *func, const char *file, uint32_t line, size_t spins, usec_t wait_ut);
+
+// the sites of all threads (past and present), merged by site
+// the caller has to freez() the returned array
+LOCK_PROFILE_SITE *lock_profiling_sites(size_t *entries);
+
+void lock_profiling_totals(LOCK_PROFILE_TOTALS *totals);
+
+const char *lock_profile_type_to_string(LOCK_PROFILE_TYPE type);
+uint64_t lock_profile_histogram_bucket_max_ut(size_t bucket);
+
+int lock_profiling_unittest(void);
+
+#endif //NETDATA_LOCK_PROFILING_H
@@ -7,6 +7,61 @@
 #define WRITER_BIT (1U << 31)
 #define READER_MASK (~WRITER_BIT)
 
+// ----------------------------------------------------------------------------
+// adaptive spin-then-park
+//
+// A contended lock first busy-waits (with a cpu pause and without writing to
+// the lock) for a per-thread budget of iterations, and only then it falls back
+// to sleeping with exponential backoff.
+//
+// The budget adapts to what happens: it grows every time spinning acquires
+// the lock and it is halved every time spinning fails and the thread has to
+// sleep. When the system is oversubscribed the lock holders are frequently
+// descheduled, so spinning keeps failing and the threads quickly converge to
+// sleeping, leaving the CPUs to the threads that hold the locks.
+// On single cpu systems there is no spinning at all.
+
+#define RW_SPIN_BUDGET_MIN 4
+#define RW_SPIN_BUDGET_MAX 1024
+#define RW_SPIN_BUDGET_INITIAL 64
+
+static __thread uint32_t rw_spin_budget = RW_SPIN_BUDGET_INITIAL;
+
+static ALWAYS_INLINE void rw_spin_pause(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ __volatile__("yield" ::: "memory");
+#else
+    __asm__ __volatile__("" ::: "memory");
+#endif
+}
+
+static ALWAYS_INLINE uint32_t rw_spin_budget_get(void) {
+    // -1 = not checked yet, 0 = disabled, 1 = enabled
+    static int8_t spinning = -1;
+
+    int8_t s = __atomic_load_n(&spinning, __ATOMIC_RELAXED);
+    if(unlikely(s < 0)) {
+        // with just one cpu, the lock holder cannot run while we spin
+#if defined(_SC_NPROCESSORS_ONLN)
+        s = sysconf(_SC_NPROCESSORS_ONLN) > 1 ? 1 : 0;
+#else
+        s = 1;
+#endif
+        __atomic_store_n(&spinning, s, __ATOMIC_RELAXED);
+    }
+
+    return s ? rw_spin_budget : 0;
+}
+
+static ALWAYS_INLINE void rw_spin_budget_adapt(bool slept) {
+    if(slept)
+        rw_spin_budget = MAX(rw_spin_budget / 2, RW_SPIN_BUDGET_MIN);
+    else
+        rw_spin_budget = MIN(rw_spin_budget + (rw_spin_budget >> 2), RW_SPIN_BUDGET_MAX);
+}
+
 // ----------------------------------------------------------------------------
 // rw_spinlock implementation
 
@@ -32,10 +87,13 @@ ALWAYS_INLINE bool rw_spinlock_tryread_lock_with_trace(RW_SPINLOCK *rw_spinlock,
     return true;
 }
 
-ALWAYS_INLINE void rw_spinlock_read_lock_with_trace(RW_SPINLOCK *rw_spinlock, const char *func) {
+ALWAYS_INLINE void rw_spinlock_read_lock_with_trace(RW_SPINLOCK *rw_spinlock, const char *func, const char *file, uint32_t line) {
     size_t spins = 0;
     usec_t usec = 1;
     usec_t deadlock_timestamp = 0;
+    usec_t wait_started_ut = 0;
+    uint32_t spin_budget = 0;
+    bool slept = false;
 
     while (true) {
         // Optimistically increment reader count
@@ -44,21 +102,42 @@ ALWAYS_INLINE void rw_spinlock_read_lock_with_trace(RW_SPINLOCK *rw_spinlock, co
         // Check if a writer holds the lock
         if (!(val & WRITER_BIT)) {
             // no writer, we are in
+            if(spins)
+                rw_spin_budget_adapt(slept);
+
             worker_spinlock_contention(func, spins);
             nd_thread_rwspinlock_read_locked();
+
+            if(unlikely(lock_profiling_is_enabled()))
+                lock_profiling_record(LOCK_PROFILE_RW_READ, func, file, line, spins,
+                                      wait_started_ut ? now_monotonic_high_precision_usec() - wait_started_ut : 0);
             return;
         }
 
         // Undo our increment and retry
         __atomic_sub_fetch(&rw_spinlock->counter, 1, __ATOMIC_RELEASE);
 
-        spins++;
-        
+        if(!spins++) {
+            spin_budget = rw_spin_budget_get();
+
+            if(unlikely(lock_profiling_is_enabled()))
+                wait_started_ut = now_monotonic_high_precision_usec();
+        }
+
         // Check for deadlock every SPINS_BEFORE_DEADLOCK_CHECK iterations
         if ((spins % SPINS_BEFORE_DEADLOCK_CHECK) == 0) {
             spinlock_deadlock_detect(&deadlock_timestamp, "rw-spinlock read lock", func);
         }
-        
+
+        if(spin_budget) {
+            // spin while the writer is inside
+            do {
+                rw_spin_pause();
+            } while(--spin_budget && (__atomic_load_n(&rw_spinlock->counter, __ATOMIC_RELAXED) & WRITER_BIT));
+            continue;
+        }
+
+        slept = true;
         microsleep(usec);
         usec = usec >= MAX_USEC ? MAX_USEC : usec * 2;
     }
@@ -92,10 +171,13 @@ ALWAYS_INLINE bool rw_spinlock_trywrite_lock_with_trace(RW_SPINLOCK *rw_spinlock
     return false;
 }
 
-ALWAYS_INLINE void rw_spinlock_write_lock_with_trace(RW_SPINLOCK *rw_spinlock, const char *func) {
+ALWAYS_INLINE void rw_spinlock_write_lock_with_trace(RW_SPINLOCK *rw_spinlock, const char *func, const char *file, uint32_t line) {
     size_t spins = 0;
     usec_t usec = 1;
     usec_t deadlock_timestamp = 0;
+    usec_t wait_started_ut = 0;
+    uint32_t spin_budget = 0;
+    bool slept = false;
 
     while (1) {
         // Optimistically set writer bit
@@ -104,8 +186,16 @@ ALWAYS_INLINE void rw_spinlock_write_lock_with_trace(RW_SPINLOCK *rw_spinlock, c
         // Check if we were the only one
         if (old == 0) {
             rw_spinlock->writer = gettid_cached();
+
+            if(spins)
+                rw_spin_budget_adapt(slept);
+
             worker_spinlock_contention(func, spins);
             nd_thread_rwspinlock_write_locked();
+
+            if(unlikely(lock_profiling_is_enabled()))
+                lock_profiling_record(LOCK_PROFILE_RW_WRITE, func, file, line, spins,
+                                      wait_started_ut ? now_monotonic_high_precision_usec() - wait_started_ut : 0);
             return;
         }
 
@@ -118,13 +208,27 @@ ALWAYS_INLINE void rw_spinlock_write_lock_with_trace(RW_SPINLOCK *rw_spinlock, c
             __atomic_and_fetch(&rw_spinlock->counter, ~WRITER_BIT, __ATOMIC_RELEASE);
         }
 
-        spins++;
-        
+        if(!spins++) {
+            spin_budget = rw_spin_budget_get();
+
+            if(unlikely(lock_profiling_is_enabled()))
+                wait_started_ut = now_monotonic_high_precision_usec();
+        }
+
         // Check for deadlock every SPINS_BEFORE_DEADLOCK_CHECK iterations
         if ((spins % SPINS_BEFORE_DEADLOCK_CHECK) == 0) {
             spinlock_deadlock_detect(&deadlock_timestamp, "rw-spinlock write lock", func);
         }
-        
+
+        if(spin_budget) {
+            // spin while there are readers or a writer inside
+            do {
+                rw_spin_pause();
+            } while(--spin_budget && __atomic_load_n(&rw_spinlock->counter, __ATOMIC_RELAXED));
+            continue;
+        }
+
+        slept = true;
         microsleep(usec);
         usec = usec >= MAX_USEC ? MAX_USEC : usec * 2;
     }
@@ -14,18 +14,18 @@ typedef struct netdata_rw_spinlock {
 #define RW_SPINLOCK_INITIALIZER { .counter = 0, .writer = 0, }
 
 void rw_spinlock_init_with_trace(RW_SPINLOCK *rw_spinlock, const char *func);
-void rw_spinlock_read_lock_with_trace(RW_SPINLOCK *rw_spinlock, const char *func);
+void rw_spinlock_read_lock_with_trace(RW_SPINLOCK *rw_spinlock, const char *func, const char *file, uint32_t line);
 void rw_spinlock_read_unlock_with_trace(RW_SPINLOCK *rw_spinlock, const char *func);
-void rw_spinlock_write_lock_with_trace(RW_SPINLOCK *rw_spinlock, const char *func);
+void rw_spinlock_write_lock_with_trace(RW_SPINLOCK *rw_spinlock, const char *func, const char *file, uint32_t line);
 void rw_spinlock_write_unlock_with_trace(RW_SPINLOCK *rw_spinlock, const char *func);
 bool rw_spinlock_tryread_lock_with_trace(RW_SPINLOCK *rw_spinlock, const char *func);
 bool rw_spinlock_trywrite_lock_with_trace(RW_SPINLOCK *rw_spinlock, const char *func);
 
 
 #define rw_spinlock_init(rw_spinlock) rw_spinlock_init_with_trace(rw_spinlock, __FUNCTION__)
-#define rw_spinlock_read_lock(rw_spinlock) rw_spinlock_read_lock_with_trace(rw_spinlock, __FUNCTION__)
+#define rw_spinlock_read_lock(rw_spinlock) rw_spinlock_read_lock_with_trace(rw_spinlock, __FUNCTION__, __FILE__, __LINE__)
 #define rw_spinlock_read_unlock(rw_spinlock) rw_spinlock_read_unlock_with_trace(rw_spinlock, __FUNCTION__)
-#define rw_spinlock_write_lock(rw_spinlock) rw_spinlock_write_lock_with_trace(rw_spinlock, __FUNCTION__)
+#define rw_spinlock_write_lock(rw_spinlock) rw_spinlock_write_lock_with_trace(rw_spinlock, __FUNCTION__, __FILE__, __LINE__)
 #define rw_spinlock_write_unlock(rw_spinlock) rw_spinlock_write_unlock_with_trace(rw_spinlock, __FUNCTION__)
 #define rw_spinlock_tryread_lock(rw_spinlock) rw_spinlock_tryread_lock_with_trace(rw_spinlock, __FUNCTION__)
 #define rw_spinlock_trywrite_lock(rw_spinlock) rw_spinlock_trywrite_lock_with_trace(rw_spinlock, __FUNCTION__)
@@ -32,10 +32,11 @@ ALWAYS_INLINE void spinlock_init_with_trace(SPINLOCK *spinlock, const char *func
     memset(spinlock, 0, sizeof(SPINLOCK));
 }
 
-ALWAYS_INLINE void spinlock_lock_with_trace(SPINLOCK *spinlock, const char *func) {
+ALWAYS_INLINE void spinlock_lock_with_trace(SPINLOCK *spinlock, const char *func, const char *file, uint32_t line) {
     size_t spins = 0;
     usec_t usec = 1;
     usec_t deadlock_timestamp = 0;
+    usec_t wait_started_ut = 0;
 
     while (true) {
         if (!__atomic_load_n(&spinlock->locked, __ATOMIC_RELAXED) &&
@@ -45,7 +46,8 @@ ALWAYS_INLINE void spinlock_lock_with_trace(SPINLOCK *spinlock, const char *func
         }
 
         // Backoff strategy with exponential growth
-        spins++;
+        if(unlikely(!spins++ && lock_profiling_is_enabled()))
+            wait_started_ut = now_monotonic_high_precision_usec();
         
         // Check for deadlock every SPINS_BEFORE_DEADLOCK_CHECK iterations
         if ((spins % SPINS_BEFORE_DEADLOCK_CHECK) == 0) {
@@ -63,6 +65,10 @@ ALWAYS_INLINE void spinlock_lock_with_trace(SPINLOCK *spinlock, const char *func
 
     nd_thread_spinlock_locked();
     worker_spinlock_contention(func, spins);
+
+    if(unlikely(lock_profiling_is_enabled()))
+        lock_profiling_record(LOCK_PROFILE_SPINLOCK, func, file, line, spins,
+                              wait_started_ut ? now_monotonic_high_precision_usec() - wait_started_ut : 0);
 }
 
 ALWAYS_INLINE void spinlock_unlock_with_trace(SPINLOCK *spinlock, const char *func __maybe_unused) {
@@ -44,8 +44,8 @@ void spinlock_deadlock_detect(usec_t *timestamp, const char *type, const char *f
 void spinlock_init_with_trace(SPINLOCK *spinlock, const char *func);
 #define spinlock_init(spinlock) spinlock_init_with_trace(spinlock, __FUNCTION__)
 
-void spinlock_lock_with_trace(SPINLOCK *spinlock, const char *func);
-#define spinlock_lock(spinlock) spinlock_lock_with_trace(spinlock, __FUNCTION__)
+void spinlock_lock_with_trace(SPINLOCK *spinlock, const char *func, const char *file, uint32_t line);
+#define spinlock_lock(spinlock) spinlock_lock_with_trace(spinlock, __FUNCTION__, __FILE__, __LINE__)
 
 void spinlock_unlock_with_trace(SPINLOCK *spinlock, const char *func __maybe_unused);
 #define spinlock_unlock(spinlock) spinlock_unlock_with_trace(spinlock, __FUNCTION__)
@@ -0,0 +1,62 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "../libnetdata.h"
+
+// how many calls to os_numa_node_current() use the cached node of the thread
+#define OS_NUMA_NODE_REFRESH_EVERY 1024
+
+size_t os_numa_nodes(void) {
+    static size_t nodes = 0;
+
+    if(likely(nodes))
+        return nodes;
+
+    size_t n = 1;
+
+#if defined(OS_LINUX)
+    DIR *dir = opendir("/sys/devices/system/node");
+    if(dir) {
+        size_t max = 0;
+        bool found = false;
+
+        struct dirent *de;
+        while((de = readdir(dir))) {
+            if(strncmp(de->d_name, "node", 4) != 0 || !isdigit((uint8_t)de->d_name[4]))
+                continue;
+
+            size_t id = str2u(&de->d_name[4]);
+            if(!found || id > max)
+                max = id;
+
+            found = true;
+        }
+        closedir(dir);
+
+        if(found)
+            n = max + 1;
+    }
+#endif
+
+    __atomic_store_n(&nodes, n, __ATOMIC_RELAXED);
+    return n;
+}
+
+static __thread struct {
+    size_t node;
+    uint32_t calls;
+} os_numa_thread = { 0 };
+
+size_t os_numa_node_current(void) {
+    if(likely(os_numa_nodes() == 1))
+        return 0;
+
+    if(unlikely(os_numa_thread.calls++ % OS_NUMA_NODE_REFRESH_EVERY == 0)) {
+#if defined(OS_LINUX) && defined(SYS_getcpu)
+        unsigned cpu = 0, node = 0;
+        if(syscall(SYS_getcpu, &cpu, &node, NULL) == 0)
+            os_numa_thread.node = node;
+#endif
+    }
+
+    return os_numa_thread.node;
+}
@@ -0,0 +1,15 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef NETDATA_OS_NUMA_H
+#define NETDATA_OS_NUMA_H
+
+#include "../libnetdata.h"
+
+// the number of NUMA nodes of the system (1 when the system is not NUMA)
+size_t os_numa_nodes(void);
+
+// the NUMA node the calling thread runs on
+// it is cached per thread and refreshed periodically, since threads rarely migrate across nodes
+size_t os_numa_node_current(void);
+
+#endif //NETDATA_OS_NUMA_H
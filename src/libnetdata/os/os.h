@@ -20,6 +20,7 @@
 #include "get_pid_max.h"
 #include "get_system_cpus.h"
 #include "get_system_pagesize.h"
+#include "numa.h"
 #include "sleep.h"
 #include "uuid_generate.h"
 #include "setenv.h"
@@ -151,6 +151,53 @@ static inline void procfile_lines_free(pflines *fl) {
 }
 
 
+// ----------------------------------------------------------------------------
+// The state of each line
+
+NEVERNULL
+static inline pflinestates *procfile_linestates_create(size_t size) {
+    pflinestates *new = mallocz(sizeof(pflinestates) + size * sizeof(pflinestate));
+    new->len = 0;
+    new->size = size;
+    return new;
+}
+
+static inline void procfile_linestates_free(pflinestates *fs) {
+    freez(fs);
+}
+
+// called when a line ends, with the bytes of the line (without its newline)
+// the parser has already terminated the words of the line in place, but it does
+// so in the same way for the same input, so identical lines give identical hashes
+static inline void procfile_linestate_update(procfile *ff, const char *start, const char *end) {
+    pflinestates *fs = ff->linestates;
+    size_t line = ff->lines->len - 1;
+
+    if(unlikely(line >= fs->size)) {
+        size_t minimum = PFLINES_INCREASE_STEP;
+        size_t optimal = fs->size / 2;
+        size_t wanted = (optimal > minimum)?optimal:minimum;
+
+        ff->linestates = fs = reallocz(fs, sizeof(pflinestates) + (fs->size + wanted) * sizeof(pflinestate));
+        fs->size += wanted;
+        ff->stats.memory += wanted * sizeof(pflinestate);
+        ff->stats.resizes++;
+    }
+
+    uint64_t hash = XXH3_64bits(start, end - start);
+    pflinestate *ls = &fs->lines[line];
+
+    // fs->len is still the number of lines of the previous read
+    ls->changed = (line >= fs->len || ls->hash != hash);
+    ls->hash = hash;
+
+    if(ls->changed)
+        ff->stats.lines_changed++;
+    else
+        ff->stats.lines_unchanged++;
+}
+
+
 // ----------------------------------------------------------------------------
 // The procfile
 
@@ -162,6 +209,7 @@ void procfile_close(procfile *ff) {
     freez(ff->filename);
     procfile_lines_free(ff->lines);
     procfile_words_free(ff->words);
+    procfile_linestates_free(ff->linestates);
 
     if(likely(ff->fd != -1)) close(ff->fd);
     freez(ff);
@@ -173,13 +221,15 @@ static void procfile_parser(procfile *ff) {
 
     char  *s = ff->data                 // our current position
         , *e = &ff->data[ff->len]       // the terminating null
-        , *t = ff->data;                // the first character of a word (or quoted / parenthesized string)
+        , *t = ff->data                 // the first character of a word (or quoted / parenthesized string)
+        , *l = ff->data;                // the first character of the current line
 
                                         // the look up array to find our type of character
     PF_CHAR_TYPE *separators = ff->separators;
 
     char quote = 0;                     // the quote character - only when in quoted string
     size_t opened = 0;                  // counts the number of open parenthesis
+    bool track = ff->linestates != NULL; // hash the lines to find the ones changed
 
     uint32_t *line_words = procfile_lines_add(ff);
 
@@ -217,7 +267,11 @@ static void procfile_parser(procfile *ff) {
             *s = '\0';
             procfile_words_add(ff, t);
             (*line_words)++;
-            t = ++s;
+
+            if(unlikely(track))
+                procfile_linestate_update(ff, l, s);
+
+            l = t = ++s;
 
             // netdata_log_debug(D_PROCFILE, PF_PREFIX ":   ended line %d with %d words", l, ff->lines->lines[l].words);
 
@@ -277,6 +331,9 @@ static void procfile_parser(procfile *ff) {
             fatal("Internal Error: procfile_readall() does not handle all the cases.");
     }
 
+    if(unlikely(track))
+        procfile_linestate_update(ff, l, e);
+
     if(likely(s > t && t < e)) {
         // the last word
         if(unlikely(ff->len >= ff->size)) {
@@ -291,10 +348,10 @@ static void procfile_parser(procfile *ff) {
     }
 }
 
-procfile *procfile_readall(procfile *ff) {
-    if(!ff) return NULL;
-
-    // netdata_log_debug(D_PROCFILE, PF_PREFIX ": Reading file '%s'.", ff->filename);
+// read the whole file into ff->data
+// with pread(), the file position is not used, so there is no need to rewind it
+static bool procfile_read_data(procfile **ffp, int fd, bool positional) {
+    procfile *ff = *ffp;
 
     ff->len = 0;    // zero the used size
     ssize_t r = 1;  // read at least once
@@ -316,13 +373,17 @@ procfile *procfile_readall(procfile *ff) {
 
         // netdata_log_info("Reading file '%s', from position %zd with length %zd", procfile_filename(ff), s, (ssize_t)(ff->size - s));
         ff->stats.reads++;
-        r = read(ff->fd, &ff->data[s], ff->size - s);
+        if(positional)
+            r = pread(fd, &ff->data[s], ff->size - s, s);
+        else
+            r = read(fd, &ff->data[s], ff->size - s);
+
         if(unlikely(r == -1)) {
-            if(unlikely(!(ff->flags & PROCFILE_FLAG_NO_ERROR_ON_FILE_IO))) collector_error(PF_PREFIX ": Cannot read from file '%s' on fd %d", procfile_filename(ff), ff->fd);
+            if(unlikely(!(ff->flags & PROCFILE_FLAG_NO_ERROR_ON_FILE_IO))) collector_error(PF_PREFIX ": Cannot read from file '%s' on fd %d", procfile_filename(ff), fd);
             else if(unlikely(ff->flags & PROCFILE_FLAG_ERROR_ON_ERROR_LOG))
-                netdata_log_error(PF_PREFIX ": Cannot read from file '%s' on fd %d", procfile_filename(ff), ff->fd);
-            procfile_close(ff);
-            return NULL;
+                netdata_log_error(PF_PREFIX ": Cannot read from file '%s' on fd %d", procfile_filename(ff), fd);
+            *ffp = ff;
+            return false;
         }
 
         if((ssize_t)ff->stats.max_read_size < r)
@@ -331,19 +392,35 @@ procfile *procfile_readall(procfile *ff) {
         ff->len += r;
     }
 
+    *ffp = ff;
+
+    if(positional)
+        return true;
+
     // netdata_log_debug(D_PROCFILE, "Rewinding file '%s'", ff->filename);
-    if(unlikely(lseek(ff->fd, 0, SEEK_SET) == -1)) {
+    if(unlikely(lseek(fd, 0, SEEK_SET) == -1)) {
         if(unlikely(!(ff->flags & PROCFILE_FLAG_NO_ERROR_ON_FILE_IO))) collector_error(PF_PREFIX ": Cannot rewind on file '%s'.", procfile_filename(ff));
         else if(unlikely(ff->flags & PROCFILE_FLAG_ERROR_ON_ERROR_LOG))
             netdata_log_error(PF_PREFIX ": Cannot rewind on file '%s'.", procfile_filename(ff));
-        procfile_close(ff);
-        return NULL;
+        return false;
+    }
+
+    return true;
+}
+
+static void procfile_parse_data(procfile *ff) {
+    if(unlikely((ff->flags & PROCFILE_FLAG_LINES_CHANGED) && !ff->linestates)) {
+        ff->linestates = procfile_linestates_create(ff->lines->size);
+        ff->stats.memory += sizeof(pflinestates) + ff->linestates->size * sizeof(pflinestate);
     }
 
     procfile_lines_reset(ff->lines);
     procfile_words_reset(ff->words);
     procfile_parser(ff);
 
+    if(unlikely(ff->linestates))
+        ff->linestates->len = ff->lines->len;
+
     if(unlikely(procfile_adaptive_initial_allocation)) {
         if(unlikely(ff->len > procfile_max_allocation)) procfile_max_allocation = ff->len;
         if(unlikely(ff->lines->len > procfile_max_lines)) procfile_max_lines = ff->lines->len;
@@ -362,9 +439,37 @@ procfile *procfile_readall(procfile *ff) {
     ff->stats.total_read_bytes += ff->len;
 
     // netdata_log_debug(D_PROCFILE, "File '%s' updated.", ff->filename);
+}
+
+procfile *procfile_readall(procfile *ff) {
+    if(!ff) return NULL;
+
+    // netdata_log_debug(D_PROCFILE, PF_PREFIX ": Reading file '%s'.", ff->filename);
+
+    if(unlikely(!procfile_read_data(&ff, ff->fd, false))) {
+        procfile_close(ff);
+        return NULL;
+    }
+
+    procfile_parse_data(ff);
     return ff;
 }
 
+bool procfile_readall_fd(procfile **ffp, int fd) {
+    if(!ffp || !*ffp || fd == -1) return false;
+
+    if(unlikely(!procfile_read_data(ffp, fd, true))) {
+        procfile *ff = *ffp;
+        ff->len = 0;
+        procfile_lines_reset(ff->lines);
+        procfile_words_reset(ff->words);
+        return false;
+    }
+
+    procfile_parse_data(*ffp);
+    return true;
+}
+
 static PF_CHAR_TYPE procfile_default_separators[256];
 __attribute__((constructor)) void procfile_initialize_default_separators(void) {
     int i = 256;
@@ -438,24 +543,7 @@ void procfile_set_open_close(procfile *ff, const char *open, const char *close)
         ffs[(int)*s++] = PF_CHAR_IS_CLOSE;
 }
 
-procfile *procfile_open(const char *filename, const char *separators, uint32_t flags) {
-    netdata_log_debug(D_PROCFILE, PF_PREFIX ": Opening file '%s'", filename);
-
-    int fd = open(filename, procfile_open_flags, 0666);
-    if(unlikely(fd == -1)) {
-        if (unlikely(flags & PROCFILE_FLAG_ERROR_ON_ERROR_LOG))
-            netdata_log_error(PF_PREFIX ": Cannot open file '%s'", filename);
-        else if (unlikely(!(flags & PROCFILE_FLAG_NO_ERROR_ON_FILE_IO))) {
-            if (errno == ENOENT)
-                collector_info(PF_PREFIX ": Cannot open file '%s'", filename);
-            else
-                collector_error(PF_PREFIX ": Cannot open file '%s'", filename);
-        }
-        return NULL;
-    }
-
-    // netdata_log_info("PROCFILE: opened '%s' on fd %d", filename, fd);
-
+static procfile *procfile_allocate(int fd, const char *separators, uint32_t flags) {
     size_t size = (unlikely(procfile_adaptive_initial_allocation)) ? procfile_max_allocation : PROCFILE_INCREMENT_BUFFER;
     procfile *ff = mallocz(sizeof(procfile) + size);
 
@@ -469,9 +557,11 @@ procfile *procfile_open(const char *filename, const char *separators, uint32_t f
     ff->stats.reads = ff->stats.resizes = 0;
     ff->stats.max_lines = ff->stats.max_words = ff->stats.max_source_bytes = 0;
     ff->stats.total_read_bytes = ff->stats.max_read_size = 0;
+    ff->stats.lines_changed = ff->stats.lines_unchanged = 0;
 
     ff->lines = procfile_lines_create();
     ff->words = procfile_words_create();
+    ff->linestates = NULL; // created on the first read, if needed
 
     ff->stats.memory = sizeof(procfile) + size +
                        (sizeof(pflines) + ff->lines->size * sizeof(ffline)) +
@@ -479,10 +569,39 @@ procfile *procfile_open(const char *filename, const char *separators, uint32_t f
 
     procfile_set_separators(ff, separators);
 
+    return ff;
+}
+
+procfile *procfile_open(const char *filename, const char *separators, uint32_t flags) {
+    netdata_log_debug(D_PROCFILE, PF_PREFIX ": Opening file '%s'", filename);
+
+    int fd = open(filename, procfile_open_flags, 0666);
+    if(unlikely(fd == -1)) {
+        if (unlikely(flags & PROCFILE_FLAG_ERROR_ON_ERROR_LOG))
+            netdata_log_error(PF_PREFIX ": Cannot open file '%s'", filename);
+        else if (unlikely(!(flags & PROCFILE_FLAG_NO_ERROR_ON_FILE_IO))) {
+            if (errno == ENOENT)
+                collector_info(PF_PREFIX ": Cannot open file '%s'", filename);
+            else
+                collector_error(PF_PREFIX ": Cannot open file '%s'", filename);
+        }
+        return NULL;
+    }
+
+    // netdata_log_info("PROCFILE: opened '%s' on fd %d", filename, fd);
+
+    procfile *ff = procfile_allocate(fd, separators, flags);
+
     netdata_log_debug(D_PROCFILE, "File '%s' opened.", filename);
     return ff;
 }
 
+procfile *procfile_create(const char *separators, uint32_t flags) {
+    procfile *ff = procfile_allocate(-1, separators, flags);
+    ff->stats.opens = 0;
+    return ff;
+}
+
 procfile *procfile_reopen(procfile *ff, const char *filename, const char *separators, uint32_t flags) {
     if(unlikely(!ff)) return procfile_open(filename, separators, flags);
 
@@ -505,6 +624,13 @@ procfile *procfile_reopen(procfile *ff, const char *filename, const char *separa
     ff->filename = NULL;
     ff->flags = flags;
 
+    // this is another file - all its lines are new
+    if(ff->linestates) {
+        ff->stats.memory -= sizeof(pflinestates) + ff->linestates->size * sizeof(pflinestate);
+        procfile_linestates_free(ff->linestates);
+        ff->linestates = NULL;
+    }
+
     // do not do the separators again if NULL is given
     if(likely(separators)) procfile_set_separators(ff, separators);
 
@@ -30,12 +30,28 @@ typedef struct {
 } pflines;
 
 
+// ----------------------------------------------------------------------------
+// The state of each line, to detect changes between reads
+
+typedef struct {
+    uint64_t hash;  // the hash of the line contents
+    bool changed;   // the line differs from the same line of the previous read
+} pflinestate;
+
+typedef struct {
+    size_t len;     // used entries
+    size_t size;    // capacity
+    pflinestate lines[];
+} pflinestates;
+
+
 // ----------------------------------------------------------------------------
 // The procfile
 
 #define PROCFILE_FLAG_DEFAULT             0x00000000 // To store inside `collector.log`
 #define PROCFILE_FLAG_NO_ERROR_ON_FILE_IO 0x00000001 // Do not log anything
 #define PROCFILE_FLAG_ERROR_ON_ERROR_LOG  0x00000002 // Store inside `error.log`
+#define PROCFILE_FLAG_LINES_CHANGED       0x00000004 // Track which lines changed since the previous read
 
 typedef enum __attribute__ ((__packed__)) procfile_separator {
     PF_CHAR_IS_SEPARATOR,
@@ -56,6 +72,8 @@ struct procfile_stats {
     size_t max_lines;
     size_t max_words;
     size_t max_read_size;
+    size_t lines_changed;
+    size_t lines_unchanged;
 };
 
 
@@ -69,6 +87,7 @@ typedef struct procfile {
     size_t size;                    // the bytes we have allocated for data
     pflines *lines;
     pfwords *words;
+    pflinestates *linestates;       // only with PROCFILE_FLAG_LINES_CHANGED
     PF_CHAR_TYPE separators[256];
     struct procfile_stats stats;
     char data[];                    // allocated buffer to keep file contents
@@ -87,6 +106,15 @@ procfile *procfile_open(const char *filename, const char *separators, uint32_t f
 // if separators == NULL, the last separators are used
 procfile *procfile_reopen(procfile *ff, const char *filename, const char *separators, uint32_t flags);
 
+// create a procfile that is not attached to any file, to parse files
+// the caller keeps open, with procfile_readall_fd()
+procfile *procfile_create(const char *separators, uint32_t flags);
+
+// (re)read and parse fd, with pread() from its beginning - fd remains owned by the caller
+// the procfile may be reallocated, so *ffp is updated
+// on failure, false is returned and the procfile is kept, empty
+bool procfile_readall_fd(procfile **ffp, int fd);
+
 // example walk-through a procfile parsed file
 void procfile_print(procfile *ff);
 
@@ -118,6 +146,10 @@ void procfile_set_adaptive_allocation(bool enable, size_t bytes, size_t lines, s
 // return the Nth word of the current line
 #define procfile_lineword(ff, line, word) (((line) < procfile_lines(ff) && (word) < procfile_linewords((ff), (line))) ? procfile_word((ff), (ff)->lines->lines[(line)].first + (word)) : "")
 
+// true when the Nth line differs from the same line of the previous read
+// always true without PROCFILE_FLAG_LINES_CHANGED, or for lines that did not exist before
+#define procfile_line_changed(ff, line) (!(ff)->linestates || (line) >= (ff)->linestates->len || (ff)->linestates->lines[(line)].changed)
+
 // Open file without logging file IO error if any
 #define procfile_open_no_log(filename, separators, flags) procfile_open(filename, separators, flags | PROCFILE_FLAG_NO_ERROR_ON_FILE_IO)
 
@@ -0,0 +1,527 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "shm_ring.h"
+
+#if defined(OS_LINUX)
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+#define SHM_RING_MAGIC 0x4E445352   // "NDSR"
+#define SHM_RING_VERSION 1
+
+// how long the producer sleeps on a full ring, before checking the consumer is still there
+#define SHM_RING_PRODUCER_WAIT_MS 1000
+
+// the buffer of the stdout FILE, when redirected to the ring
+#define SHM_RING_STDOUT_BUFFER (64 * 1024)
+
+struct shm_ring_header {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t size;                  // the bytes of data, a power of 2
+
+    // written by the producer
+    uint64_t head __attribute__((aligned(64)));
+    uint32_t producer_waiting;      // the producer sleeps on read_seq, for space
+
+    // written by the consumer
+    uint64_t tail __attribute__((aligned(64)));
+    uint32_t consumer_waiting;      // the consumer waits on the doorbell, for data
+    uint32_t read_seq;              // futex - incremented when space is freed for a sleeping producer
+
+    char data[] __attribute__((aligned(64)));
+};
+
+struct shm_ring {
+    struct shm_ring_header *hdr;
+    size_t mapped;
+    size_t mask;
+    bool consumer;
+    char name[NAME_MAX + 1];
+};
+
+static inline void shm_ring_futex_wait(uint32_t *addr, uint32_t expected, int timeout_ms) {
+    struct timespec ts = {
+        .tv_sec = timeout_ms / 1000,
+        .tv_nsec = (timeout_ms % 1000) * NSEC_PER_MSEC,
+    };
+    syscall(SYS_futex, addr, FUTEX_WAIT, expected, &ts, NULL, 0);
+}
+
+static inline void shm_ring_futex_wake(uint32_t *addr) {
+    syscall(SYS_futex, addr, FUTEX_WAKE, 1, NULL, NULL, 0);
+}
+
+static SHM_RING *shm_ring_map(const char *name, int fd, size_t mapped, bool consumer) {
+    struct shm_ring_header *hdr = nd_mmap(NULL, mapped, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if(!hdr)
+        return NULL;
+
+    SHM_RING *ring = callocz(1, sizeof(*ring));
+    ring->hdr = hdr;
+    ring->mapped = mapped;
+    ring->consumer = consumer;
+    strncpyz(ring->name, name, sizeof(ring->name) - 1);
+    return ring;
+}
+
+SHM_RING *shm_ring_create(const char *name, size_t size) {
+    size_t pow2 = 4096;
+    while(pow2 < size)
+        pow2 <<= 1;
+
+    size_t mapped = sizeof(struct shm_ring_header) + pow2;
+
+    int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC, 0600);
+    if(fd == -1 && errno == EEXIST) {
+        // left behind by a previous instance of the agent
+        shm_unlink(name);
+        fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC, 0600);
+    }
+
+    if(fd == -1) {
+        nd_log(NDLS_DAEMON, NDLP_ERR, "SHM RING: cannot create shared memory '%s'", name);
+        return NULL;
+    }
+
+    if(ftruncate(fd, (off_t)mapped) != 0) {
+        nd_log(NDLS_DAEMON, NDLP_ERR, "SHM RING: cannot set the size of shared memory '%s' to %zu bytes", name, mapped);
+        close(fd);
+        shm_unlink(name);
+        return NULL;
+    }
+
+    SHM_RING *ring = shm_ring_map(name, fd, mapped, true);
+    close(fd);
+
+    if(!ring) {
+        nd_log(NDLS_DAEMON, NDLP_ERR, "SHM RING: cannot map shared memory '%s'", name);
+        shm_unlink(name);
+        return NULL;
+    }
+
+    ring->hdr->size = pow2;
+    ring->hdr->version = SHM_RING_VERSION;
+    __atomic_store_n(&ring->hdr->magic, SHM_RING_MAGIC, __ATOMIC_RELEASE);
+    ring->mask = pow2 - 1;
+
+    return ring;
+}
+
+SHM_RING *shm_ring_attach(const char *name) {
+    // The name comes from the environment, and plugins may run with elevated
+    // privileges, so we only use objects created by the user that runs us,
+    // and we never remove them - the agent does, when it closes the ring.
+
+    int fd = shm_open(name, O_RDWR | O_CLOEXEC | O_NOFOLLOW, 0);
+    if(fd == -1)
+        return NULL;
+
+    struct stat st;
+    if(fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_uid != getuid() ||
+        (size_t)st.st_size <= sizeof(struct shm_ring_header)) {
+        close(fd);
+        return NULL;
+    }
+
+    SHM_RING *ring = shm_ring_map(name, fd, (size_t)st.st_size, false);
+    close(fd);
+
+    if(!ring)
+        return NULL;
+
+    struct shm_ring_header *hdr = ring->hdr;
+    if(__atomic_load_n(&hdr->magic, __ATOMIC_ACQUIRE) != SHM_RING_MAGIC ||
+        hdr->version != SHM_RING_VERSION ||
+        hdr->size != ring->mapped - sizeof(struct shm_ring_header) ||
+        (hdr->size & (hdr->size - 1))) {
+        nd_munmap(hdr, ring->mapped);
+        freez(ring);
+        return NULL;
+    }
+
+    ring->mask = hdr->size - 1;
+    return ring;
+}
+
+void shm_ring_close(SHM_RING *ring) {
+    if(!ring) return;
+
+    if(ring->consumer)
+        shm_unlink(ring->name);
+
+    nd_munmap(ring->hdr, ring->mapped);
+    freez(ring);
+}
+
+const char *shm_ring_name(SHM_RING *ring) {
+    return ring->name;
+}
+
+size_t shm_ring_size(SHM_RING *ring) {
+    return ring->hdr->size;
+}
+
+// ----------------------------------------------------------------------------
+// consumer
+
+size_t shm_ring_read(SHM_RING *ring, void *dst, size_t size) {
+    struct shm_ring_header *hdr = ring->hdr;
+
+    uint64_t tail = hdr->tail;
+    uint64_t head = __atomic_load_n(&hdr->head, __ATOMIC_ACQUIRE);
+
+    size_t bytes = MIN((size_t)(head - tail), size);
+    if(!bytes)
+        return 0;
+
+    size_t offset = tail & ring->mask;
+    size_t first = MIN(bytes, hdr->size - offset);
+    memcpy(dst, &hdr->data[offset], first);
+    if(first < bytes)
+        memcpy((char *)dst + first, &hdr->data[0], bytes - first);
+
+    __atomic_store_n(&hdr->tail, tail + bytes, __ATOMIC_SEQ_CST);
+
+    if(__atomic_load_n(&hdr->producer_waiting, __ATOMIC_SEQ_CST)) {
+        __atomic_add_fetch(&hdr->read_seq, 1, __ATOMIC_SEQ_CST);
+        shm_ring_futex_wake(&hdr->read_seq);
+    }
+
+    return bytes;
+}
+
+bool shm_ring_consumer_wait_begin(SHM_RING *ring) {
+    struct shm_ring_header *hdr = ring->hdr;
+
+    __atomic_store_n(&hdr->consumer_waiting, 1, __ATOMIC_SEQ_CST);
+
+    // the producer may have written something before seeing the flag
+    if(__atomic_load_n(&hdr->head, __ATOMIC_SEQ_CST) != hdr->tail) {
+        __atomic_store_n(&hdr->consumer_waiting, 0, __ATOMIC_RELAXED);
+        return false;
+    }
+
+    return true;
+}
+
+void shm_ring_consumer_wait_end(SHM_RING *ring) {
+    __atomic_store_n(&ring->hdr->consumer_waiting, 0, __ATOMIC_RELAXED);
+}
+
+// ----------------------------------------------------------------------------
+// producer
+
+static bool shm_ring_consumer_is_gone(int doorbell_fd) {
+    struct pollfd pfd = {
+        .fd = doorbell_fd,
+        .events = 0,
+    };
+
+    return poll(&pfd, 1, 0) == 1 && (pfd.revents & (POLLERR | POLLHUP | POLLNVAL));
+}
+
+bool shm_ring_write(SHM_RING *ring, const void *data, size_t size, int doorbell_fd) {
+    struct shm_ring_header *hdr = ring->hdr;
+    const char *src = data;
+
+    while(size) {
+        uint64_t head = hdr->head;
+        size_t available = hdr->size - (size_t)(head - __atomic_load_n(&hdr->tail, __ATOMIC_ACQUIRE));
+
+        if(!available) {
+            __atomic_store_n(&hdr->producer_waiting, 1, __ATOMIC_SEQ_CST);
+            uint32_t seq = __atomic_load_n(&hdr->read_seq, __ATOMIC_SEQ_CST);
+
+            // the consumer may have freed space before seeing the flag
+            if(__atomic_load_n(&hdr->tail, __ATOMIC_SEQ_CST) == head - hdr->size)
+                shm_ring_futex_wait(&hdr->read_seq, seq, SHM_RING_PRODUCER_WAIT_MS);
+
+            __atomic_store_n(&hdr->producer_waiting, 0, __ATOMIC_RELAXED);
+
+            if(shm_ring_consumer_is_gone(doorbell_fd))
+                return false;
+
+            continue;
+        }
+
+        size_t bytes = MIN(available, size);
+        size_t offset = head & ring->mask;
+        size_t first = MIN(bytes, hdr->size - offset);
+        memcpy(&hdr->data[offset], src, first);
+        if(first < bytes)
+            memcpy(&hdr->data[0], src + first, bytes - first);
+
+        __atomic_store_n(&hdr->head, head + bytes, __ATOMIC_SEQ_CST);
+
+        // ring the doorbell, only when the consumer waits for it
+        if(__atomic_load_n(&hdr->consumer_waiting, __ATOMIC_SEQ_CST) &&
+            __atomic_exchange_n(&hdr->consumer_waiting, 0, __ATOMIC_SEQ_CST)) {
+            if(write(doorbell_fd, "\n", 1) != 1 && errno != EAGAIN)
+                return false;
+        }
+
+        src += bytes;
+        size -= bytes;
+    }
+
+    return true;
+}
+
+static ssize_t shm_ring_stdout_write(void *cookie, const char *buf, size_t size) {
+    if(!shm_ring_write(cookie, buf, size, STDOUT_FILENO)) {
+        errno = EPIPE;
+        return -1;
+    }
+
+    return (ssize_t)size;
+}
+
+static int shm_ring_stdout_close(void *cookie) {
+    shm_ring_close(cookie);
+    return 0;
+}
+
+bool shm_ring_stdout(void) {
+    const char *name = getenv(SHM_RING_ENV);
+    if(!name || !*name)
+        return false;
+
+    SHM_RING *ring = shm_ring_attach(name);
+
+    // our children should not see it
+    unsetenv(SHM_RING_ENV);
+
+    if(!ring)
+        return false;
+
+    cookie_io_functions_t io = {
+        .write = shm_ring_stdout_write,
+        .close = shm_ring_stdout_close,
+    };
+
+    FILE *fp = fopencookie(ring, "w", io);
+    if(!fp) {
+        shm_ring_close(ring);
+        return false;
+    }
+    setvbuf(fp, NULL, _IOFBF, SHM_RING_STDOUT_BUFFER);
+
+    // from now on, the pipe carries only the doorbell
+    fprintf(stdout, SHM_RING_ACTIVE_MARKER "\n");
+    fflush(stdout);
+
+    stdout = fp;
+    return true;
+}
+
+// ----------------------------------------------------------------------------
+// unittest
+
+struct shm_ring_unittest_producer {
+    SHM_RING *ring;
+    int doorbell_fd;
+    size_t bytes;
+    bool failed;
+};
+
+static void shm_ring_unittest_producer_thread(void *arg) {
+    struct shm_ring_unittest_producer *p = arg;
+    char buf[4096 + 7];
+    size_t sent = 0, chunk = 1;
+
+    while(sent < p->bytes) {
+        size_t len = MIN(chunk, p->bytes - sent);
+        for(size_t i = 0; i < len; i++)
+            buf[i] = (char)((sent + i) % 251);
+
+        if(!shm_ring_write(p->ring, buf, len, p->doorbell_fd)) {
+            p->failed = true;
+            return;
+        }
+
+        sent += len;
+        chunk = (chunk * 7 + 3) % sizeof(buf) + 1;
+    }
+}
+
+static int shm_ring_unittest_run(size_t ring_size, size_t bytes) {
+    char name[NAME_MAX + 1];
+    snprintfz(name, sizeof(name), "/netdata-shm-ring-unittest-%d", getpid());
+
+    SHM_RING *consumer = shm_ring_create(name, ring_size);
+    if(!consumer) {
+        fprintf(stderr, "SHM RING: cannot create ring '%s'\n", name);
+        return 1;
+    }
+
+    SHM_RING *producer = shm_ring_attach(name);
+    if(!producer) {
+        fprintf(stderr, "SHM RING: cannot attach to ring '%s'\n", name);
+        shm_ring_close(consumer);
+        return 1;
+    }
+
+    int pipefds[2];
+    if(pipe(pipefds) != 0) {
+        shm_ring_close(producer);
+        shm_ring_close(consumer);
+        return 1;
+    }
+
+    struct shm_ring_unittest_producer p = {
+        .ring = producer,
+        .doorbell_fd = pipefds[1],
+        .bytes = bytes,
+    };
+
+    usec_t started = now_monotonic_usec();
+    ND_THREAD *thread = nd_thread_create("SHMRING", NETDATA_THREAD_OPTION_DONT_LOG, shm_ring_unittest_producer_thread, &p);
+
+    int errors = 0;
+    size_t received = 0, wakeups = 0;
+    char buf[16384];
+    while(received < bytes && !errors) {
+        size_t got = shm_ring_read(consumer, buf, sizeof(buf));
+        if(got) {
+            for(size_t i = 0; i < got; i++) {
+                if(buf[i] != (char)((received + i) % 251)) {
+                    fprintf(stderr, "SHM RING: wrong byte at offset %zu\n", received + i);
+                    errors++;
+                    break;
+                }
+            }
+            received += got;
+            continue;
+        }
+
+        if(p.failed)
+            break;
+
+        if(shm_ring_consumer_wait_begin(consumer)) {
+            struct pollfd pfd = { .fd = pipefds[0], .events = POLLIN, };
+            if(poll(&pfd, 1, 1000) == 1 && (pfd.revents & POLLIN)) {
+                char doorbell[128];
+                if(read(pipefds[0], doorbell, sizeof(doorbell)) > 0)
+                    wakeups++;
+            }
+            shm_ring_consumer_wait_end(consumer);
+        }
+    }
+    usec_t ended = now_monotonic_usec();
+
+    nd_thread_join(thread);
+
+    if(p.failed || received != bytes) {
+        fprintf(stderr, "SHM RING: received %zu of %zu bytes%s\n", received, bytes, p.failed ? " (producer failed)" : "");
+        errors++;
+    }
+
+    fprintf(stderr, "SHM RING: %zu bytes through a %zu bytes ring in %0.2f ms (%0.2f MiB/s), %zu wakeups\n",
+            received, shm_ring_size(consumer),
+            (double)(ended - started) / (double)USEC_PER_MS,
+            (double)received / 1024.0 / 1024.0 / ((double)MAX(ended - started, 1) / (double)USEC_PER_SEC),
+            wakeups);
+
+    close(pipefds[0]);
+    close(pipefds[1]);
+    shm_ring_close(producer);
+    shm_ring_close(consumer);
+
+    return errors;
+}
+
+// attaching must not remove the shared memory object, whether it is a ring or not
+static int shm_ring_unittest_attach(void) {
+    char name[NAME_MAX + 1];
+    snprintfz(name, sizeof(name), "/netdata-shm-ring-unittest-other-%d", getpid());
+    int errors = 0;
+
+    int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC, 0600);
+    if(fd == -1 || ftruncate(fd, 8192) != 0) {
+        fprintf(stderr, "SHM RING: cannot create shared memory '%s'\n", name);
+        if(fd != -1) close(fd);
+        shm_unlink(name);
+        return 1;
+    }
+    close(fd);
+
+    SHM_RING *ring = shm_ring_attach(name);
+    if(ring) {
+        fprintf(stderr, "SHM RING: attached to '%s', which is not a ring\n", name);
+        shm_ring_close(ring);
+        errors++;
+    }
+
+    fd = shm_open(name, O_RDWR | O_CLOEXEC, 0);
+    if(fd == -1) {
+        fprintf(stderr, "SHM RING: attaching removed '%s'\n", name);
+        errors++;
+    }
+    else
+        close(fd);
+
+    shm_unlink(name);
+
+    snprintfz(name, sizeof(name), "/netdata-shm-ring-unittest-%d", getpid());
+    SHM_RING *consumer = shm_ring_create(name, 4096);
+    SHM_RING *producer = consumer ? shm_ring_attach(name) : NULL;
+    if(!producer) {
+        fprintf(stderr, "SHM RING: cannot attach to ring '%s'\n", name);
+        errors++;
+    }
+    else {
+        fd = shm_open(name, O_RDWR | O_CLOEXEC, 0);
+        if(fd == -1) {
+            fprintf(stderr, "SHM RING: attaching removed ring '%s'\n", name);
+            errors++;
+        }
+        else
+            close(fd);
+    }
+
+    shm_ring_close(producer);
+    shm_ring_close(consumer);
+
+    // the consumer removes it
+    fd = shm_open(name, O_RDWR | O_CLOEXEC, 0);
+    if(fd != -1) {
+        fprintf(stderr, "SHM RING: closing the consumer did not remove ring '%s'\n", name);
+        close(fd);
+        shm_unlink(name);
+        errors++;
+    }
+
+    return errors;
+}
+
+int shm_ring_unittest(void) {
+    int errors = 0;
+
+    errors += shm_ring_unittest_attach();
+
+    // a small ring, to wrap around and fill up all the time
+    errors += shm_ring_unittest_run(4096, 16 * 1024 * 1024);
+    errors += shm_ring_unittest_run(SHM_RING_DEFAULT_SIZE, 256 * 1024 * 1024);
+
+    fprintf(stderr, "SHM RING: %s\n", errors ? "FAILED" : "OK");
+    return errors;
+}
+
+#else // !OS_LINUX
+
+SHM_RING *shm_ring_create(const char *name __maybe_unused, size_t size __maybe_unused) { return NULL; }
+size_t shm_ring_read(SHM_RING *ring __maybe_unused, void *dst __maybe_unused, size_t size __maybe_unused) { return 0; }
+bool shm_ring_consumer_wait_begin(SHM_RING *ring __maybe_unused) { return false; }
+void shm_ring_consumer_wait_end(SHM_RING *ring __maybe_unused) { ; }
+SHM_RING *shm_ring_attach(const char *name __maybe_unused) { return NULL; }
+bool shm_ring_write(SHM_RING *ring __maybe_unused, const void *data __maybe_unused, size_t size __maybe_unused, int doorbell_fd __maybe_unused) { return false; }
+bool shm_ring_stdout(void) { return false; }
+void shm_ring_close(SHM_RING *ring __maybe_unused) { ; }
+const char *shm_ring_name(SHM_RING *ring __maybe_unused) { return ""; }
+size_t shm_ring_size(SHM_RING *ring __maybe_unused) { return 0; }
+int shm_ring_unittest(void) { return 0; }
+
+#endif
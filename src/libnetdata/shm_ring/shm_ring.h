@@ -0,0 +1,64 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef NETDATA_SHM_RING_H
+#define NETDATA_SHM_RING_H 1
+
+#include "../libnetdata.h"
+
+// A single-producer, single-consumer byte ring in POSIX shared memory,
+// used by external plugins to send their output to the agent without a pipe.
+//
+// The agent (consumer) creates the ring before spawning the plugin and gives
+// its name to the plugin in the environment variable SHM_RING_ENV.
+// A plugin that supports it (producer) attaches to the ring, sends the line
+// SHM_RING_ACTIVE_MARKER over its stdout pipe, and from then on writes
+// everything else to the ring.
+//
+// The stdout pipe of the plugin remains open. It tells the agent the plugin
+// is alive and it carries the wakeups: when the agent has consumed everything
+// and waits for more, the plugin writes a single newline to the pipe.
+// So while data are flowing, there are no system calls at all.
+//
+// Linux only - on other systems creating and attaching fail, and the plugins
+// keep writing to their pipes.
+
+#define SHM_RING_ENV "NETDATA_PLUGIN_SHM_RING"
+#define SHM_RING_ACTIVE_MARKER "SHM_RING_ACTIVE"
+#define SHM_RING_DEFAULT_SIZE (1 * 1024 * 1024)
+
+typedef struct shm_ring SHM_RING;
+
+// consumer (agent)
+
+// size is rounded up to a power of 2
+SHM_RING *shm_ring_create(const char *name, size_t size);
+
+// copies up to size bytes out of the ring, returns the bytes copied
+size_t shm_ring_read(SHM_RING *ring, void *dst, size_t size);
+
+// call before waiting for the doorbell - returns false when data are already available
+bool shm_ring_consumer_wait_begin(SHM_RING *ring);
+void shm_ring_consumer_wait_end(SHM_RING *ring);
+
+// producer (plugin)
+
+SHM_RING *shm_ring_attach(const char *name);
+
+// blocks while the ring is full - returns false when the consumer is gone
+bool shm_ring_write(SHM_RING *ring, const void *data, size_t size, int doorbell_fd);
+
+// attach to the ring offered by the agent (if any) and redirect stdout to it
+// call it before starting any threads that write to stdout
+bool shm_ring_stdout(void);
+
+// both
+
+// the consumer also removes the shared memory segment
+void shm_ring_close(SHM_RING *ring);
+
+const char *shm_ring_name(SHM_RING *ring);
+size_t shm_ring_size(SHM_RING *ring);
+
+int shm_ring_unittest(void);
+
+#endif //NETDATA_SHM_RING_H
@@ -2,6 +2,18 @@
 
 #include "../libnetdata.h"
 
+// patterns with at least this many terms are compiled
+#define SP_COMPILE_MIN_TERMS 4
+
+// patterns with at least this many terms with inner asterisks (which are not indexed)
+// remember their results per STRING
+#define SP_MEMO_MIN_COMPLEX_TERMS 8
+#define SP_MEMO_SLOTS 256
+
+#define SP_NO_TERM UINT32_MAX
+
+struct simple_pattern_compiled;
+
 struct simple_pattern {
     const char *match;
     uint32_t len;
@@ -12,8 +24,282 @@ struct simple_pattern {
 
     struct simple_pattern *child;
     struct simple_pattern *next;
+
+    struct simple_pattern_compiled *compiled; // only on the first term of a list
+};
+
+// ----------------------------------------------------------------------------
+// compiled patterns
+//
+// The terms of a list are evaluated in order and the first one matching decides
+// the result. When compiled, the terms without inner asterisks are indexed by
+// their position in the list:
+//
+//  - exact and prefix terms are stored in a trie
+//  - suffix terms are stored in a trie of their reversed text
+//  - substring terms are stored in an Aho-Corasick automaton
+//
+// so that a single pass over the string (per kind of term) finds the first term
+// that matches. The terms with inner asterisks are evaluated one by one, but only
+// when they are before the best match found in the indexes.
+
+typedef struct sp_edge {
+    uint8_t c;
+    uint32_t node;
+} SP_EDGE;
+
+typedef struct sp_node {
+    SP_EDGE *edges;         // sorted by c
+    uint32_t edges_count;
+    uint32_t fail;          // Aho-Corasick only
+    uint32_t term;          // the first prefix, suffix or substring term ending at this node
+    uint32_t exact;         // the first exact term ending at this node
+} SP_NODE;
+
+typedef struct sp_trie {
+    SP_NODE *nodes;
+    uint32_t used;
+    uint32_t size;
+} SP_TRIE;
+
+struct sp_complex_term {
+    uint32_t term;
+    struct simple_pattern *m;
 };
 
+struct sp_memo {
+    SPINLOCK spinlock;
+    struct {
+        STRING *str;        // we hold a reference, so that the pointer cannot be reused by another string
+        SIMPLE_PATTERN_RESULT result;
+    } slots[SP_MEMO_SLOTS];
+};
+
+struct simple_pattern_compiled {
+    uint8_t map[256];       // lowercases the input, when not case sensitive
+
+    uint32_t terms;
+    bool *negative;         // per term
+
+    uint32_t always;        // the first term matching everything
+
+    SP_TRIE forward;        // exact and prefix terms
+    SP_TRIE reverse;        // suffix terms
+    SP_TRIE substring;      // substring terms
+
+    uint32_t complex_count;
+    struct sp_complex_term *complex;
+
+    struct sp_memo *memo;
+};
+
+static void sp_trie_init(SP_TRIE *t) {
+    t->size = 16;
+    t->used = 1;
+    t->nodes = callocz(t->size, sizeof(SP_NODE));
+    t->nodes[0].term = t->nodes[0].exact = SP_NO_TERM;
+}
+
+static void sp_trie_free(SP_TRIE *t) {
+    for(uint32_t i = 0; i < t->used ; i++)
+        freez(t->nodes[i].edges);
+
+    freez(t->nodes);
+}
+
+ALWAYS_INLINE
+static uint32_t sp_trie_child(const SP_TRIE *t, uint32_t node, uint8_t c) {
+    const SP_NODE *n = &t->nodes[node];
+    uint32_t lo = 0, hi = n->edges_count;
+
+    while(lo < hi) {
+        uint32_t mid = (lo + hi) / 2;
+        if(n->edges[mid].c < c)
+            lo = mid + 1;
+        else if(n->edges[mid].c > c)
+            hi = mid;
+        else
+            return n->edges[mid].node;
+    }
+
+    return 0;
+}
+
+static uint32_t sp_trie_add_child(SP_TRIE *t, uint32_t node, uint8_t c) {
+    uint32_t child = sp_trie_child(t, node, c);
+    if(child)
+        return child;
+
+    if(t->used == t->size) {
+        t->nodes = reallocz(t->nodes, t->size * 2 * sizeof(SP_NODE));
+        memset(&t->nodes[t->size], 0, t->size * sizeof(SP_NODE));
+        t->size *= 2;
+    }
+
+    child = t->used++;
+    t->nodes[child].term = t->nodes[child].exact = SP_NO_TERM;
+
+    SP_NODE *n = &t->nodes[node];
+    uint32_t pos = 0;
+    while(pos < n->edges_count && n->edges[pos].c < c)
+        pos++;
+
+    n->edges = reallocz(n->edges, (n->edges_count + 1) * sizeof(SP_EDGE));
+    memmove(&n->edges[pos + 1], &n->edges[pos], (n->edges_count - pos) * sizeof(SP_EDGE));
+    n->edges[pos].c = c;
+    n->edges[pos].node = child;
+    n->edges_count++;
+
+    return child;
+}
+
+static uint32_t sp_trie_insert(SP_TRIE *t, const uint8_t *map, const char *str, size_t len, bool reversed) {
+    uint32_t node = 0;
+
+    for(size_t i = 0; i < len ; i++) {
+        uint8_t c = map[(uint8_t)str[reversed ? len - 1 - i : i]];
+        node = sp_trie_add_child(t, node, c);
+    }
+
+    return node;
+}
+
+// set the failure links and propagate the first term of each node to the ones failing to it
+static void sp_trie_build_aho_corasick(SP_TRIE *t) {
+    uint32_t *queue = mallocz(t->used * sizeof(uint32_t));
+    uint32_t head = 0, tail = 0;
+
+    SP_NODE *root = &t->nodes[0];
+    for(uint32_t e = 0; e < root->edges_count ; e++) {
+        uint32_t child = root->edges[e].node;
+        t->nodes[child].fail = 0;
+        queue[tail++] = child;
+    }
+
+    while(head < tail) {
+        uint32_t node = queue[head++];
+        SP_NODE *n = &t->nodes[node];
+
+        for(uint32_t e = 0; e < n->edges_count ; e++) {
+            uint8_t c = n->edges[e].c;
+            uint32_t child = n->edges[e].node;
+
+            uint32_t f = n->fail;
+            while(f && !sp_trie_child(t, f, c))
+                f = t->nodes[f].fail;
+
+            uint32_t fail = sp_trie_child(t, f, c);
+            if(fail == child)
+                fail = 0;
+
+            t->nodes[child].fail = fail;
+
+            // the failure node is shallower, so it is already final
+            if(t->nodes[fail].term < t->nodes[child].term)
+                t->nodes[child].term = t->nodes[fail].term;
+
+            queue[tail++] = child;
+        }
+    }
+
+    freez(queue);
+}
+
+static void simple_pattern_compiled_free(struct simple_pattern_compiled *c) {
+    if(!c) return;
+
+    if(c->memo) {
+        for(size_t i = 0; i < SP_MEMO_SLOTS ; i++)
+            string_freez(c->memo->slots[i].str);
+
+        freez(c->memo);
+    }
+
+    sp_trie_free(&c->forward);
+    sp_trie_free(&c->reverse);
+    sp_trie_free(&c->substring);
+    freez(c->complex);
+    freez(c->negative);
+    freez(c);
+}
+
+static struct simple_pattern_compiled *simple_pattern_compile(struct simple_pattern *root) {
+    uint32_t terms = 0;
+    for(struct simple_pattern *m = root; m ; m = m->next)
+        terms++;
+
+    if(terms < SP_COMPILE_MIN_TERMS)
+        return NULL;
+
+    struct simple_pattern_compiled *c = callocz(1, sizeof(*c));
+    c->terms = terms;
+    c->negative = callocz(terms, sizeof(bool));
+    c->complex = callocz(terms, sizeof(struct sp_complex_term));
+    c->always = SP_NO_TERM;
+
+    for(size_t i = 0; i < 256 ; i++)
+        c->map[i] = root->case_sensitive ? (uint8_t)i : (uint8_t)tolower((int)i);
+
+    sp_trie_init(&c->forward);
+    sp_trie_init(&c->reverse);
+    sp_trie_init(&c->substring);
+
+    uint32_t term = 0;
+    for(struct simple_pattern *m = root; m ; m = m->next, term++) {
+        c->negative[term] = m->negative;
+
+        if(m->child) {
+            c->complex[c->complex_count].term = term;
+            c->complex[c->complex_count].m = m;
+            c->complex_count++;
+            continue;
+        }
+
+        if(!m->len) {
+            if(c->always == SP_NO_TERM)
+                c->always = term;
+            continue;
+        }
+
+        uint32_t node;
+        switch(m->mode) {
+            default:
+            case SIMPLE_PATTERN_EXACT:
+                node = sp_trie_insert(&c->forward, c->map, m->match, m->len, false);
+                if(c->forward.nodes[node].exact == SP_NO_TERM)
+                    c->forward.nodes[node].exact = term;
+                break;
+
+            case SIMPLE_PATTERN_PREFIX:
+                node = sp_trie_insert(&c->forward, c->map, m->match, m->len, false);
+                if(c->forward.nodes[node].term == SP_NO_TERM)
+                    c->forward.nodes[node].term = term;
+                break;
+
+            case SIMPLE_PATTERN_SUFFIX:
+                node = sp_trie_insert(&c->reverse, c->map, m->match, m->len, true);
+                if(c->reverse.nodes[node].term == SP_NO_TERM)
+                    c->reverse.nodes[node].term = term;
+                break;
+
+            case SIMPLE_PATTERN_SUBSTRING:
+                node = sp_trie_insert(&c->substring, c->map, m->match, m->len, false);
+                if(c->substring.nodes[node].term == SP_NO_TERM)
+                    c->substring.nodes[node].term = term;
+                break;
+        }
+    }
+
+    sp_trie_build_aho_corasick(&c->substring);
+
+    if(c->complex_count >= SP_MEMO_MIN_COMPLEX_TERMS) {
+        c->memo = callocz(1, sizeof(*c->memo));
+        spinlock_init(&c->memo->spinlock);
+    }
+
+    return c;
+}
+
 static struct simple_pattern *parse_pattern(char *str, SIMPLE_PREFIX_MODE default_mode, size_t count) {
     if(unlikely(count >= 1000))
         return NULL;
@@ -165,6 +451,10 @@ SIMPLE_PATTERN *simple_pattern_create(const char *list, const char *separators,
     }
 
     freez(buf);
+
+    if(root)
+        root->compiled = simple_pattern_compile(root);
+
     return (SIMPLE_PATTERN *)root;
 }
 
@@ -282,7 +572,7 @@ static bool match_pattern(struct simple_pattern *m, const char *str, size_t len,
 }
 
 ALWAYS_INLINE
-static SIMPLE_PATTERN_RESULT simple_pattern_matches_extract_with_length(SIMPLE_PATTERN *list, const char *str, size_t len, char *wildcarded, size_t wildcarded_size) {
+static SIMPLE_PATTERN_RESULT simple_pattern_matches_list(SIMPLE_PATTERN *list, const char *str, size_t len, char *wildcarded, size_t wildcarded_size) {
     struct simple_pattern *m, *root = (struct simple_pattern *)list;
 
     for(m = root; m ; m = m->next) {
@@ -299,6 +589,93 @@ static SIMPLE_PATTERN_RESULT simple_pattern_matches_extract_with_length(SIMPLE_P
     return SP_NOT_MATCHED;
 }
 
+static SIMPLE_PATTERN_RESULT simple_pattern_matches_compiled(struct simple_pattern_compiled *c, const char *str, size_t len) {
+    const uint8_t *map = c->map;
+    uint32_t best = c->always;
+
+    // exact and prefix terms
+    if(c->forward.used > 1 && best) {
+        const SP_TRIE *t = &c->forward;
+        uint32_t node = 0;
+        size_t i;
+        for(i = 0; i < len ; i++) {
+            node = sp_trie_child(t, node, map[(uint8_t)str[i]]);
+            if(!node)
+                break;
+
+            if(t->nodes[node].term < best)
+                best = t->nodes[node].term;
+        }
+
+        if(i == len && t->nodes[node].exact < best)
+            best = t->nodes[node].exact;
+    }
+
+    // suffix terms
+    if(c->reverse.used > 1 && best) {
+        const SP_TRIE *t = &c->reverse;
+        uint32_t node = 0;
+        for(size_t i = len; i > 0 ; i--) {
+            node = sp_trie_child(t, node, map[(uint8_t)str[i - 1]]);
+            if(!node)
+                break;
+
+            if(t->nodes[node].term < best)
+                best = t->nodes[node].term;
+        }
+    }
+
+    // substring terms
+    if(c->substring.used > 1 && best) {
+        const SP_TRIE *t = &c->substring;
+        uint32_t node = 0;
+        for(size_t i = 0; i < len ; i++) {
+            uint8_t ch = map[(uint8_t)str[i]];
+
+            uint32_t next;
+            while(!(next = sp_trie_child(t, node, ch)) && node)
+                node = t->nodes[node].fail;
+
+            node = next;
+            if(t->nodes[node].term < best)
+                best = t->nodes[node].term;
+        }
+    }
+
+    // terms with inner asterisks, only when they are before the best match
+    for(uint32_t i = 0; i < c->complex_count && c->complex[i].term < best ; i++) {
+        size_t wss = 0;
+        if(match_pattern(c->complex[i].m, str, len, NULL, &wss)) {
+            best = c->complex[i].term;
+            break;
+        }
+    }
+
+    if(best == SP_NO_TERM)
+        return SP_NOT_MATCHED;
+
+    return c->negative[best] ? SP_MATCHED_NEGATIVE : SP_MATCHED_POSITIVE;
+}
+
+ALWAYS_INLINE
+static SIMPLE_PATTERN_RESULT simple_pattern_matches_extract_with_length(SIMPLE_PATTERN *list, const char *str, size_t len, char *wildcarded, size_t wildcarded_size) {
+    struct simple_pattern *root = (struct simple_pattern *)list;
+
+    // the compiled pattern does not know which parts were matched by asterisks
+    if(root->compiled && !wildcarded)
+        return simple_pattern_matches_compiled(root->compiled, str, len);
+
+    return simple_pattern_matches_list(list, str, len, wildcarded, wildcarded_size);
+}
+
+static ALWAYS_INLINE size_t sp_memo_slot(STRING *str) {
+    uint64_t h = (uint64_t)(uintptr_t)str;
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    return h & (SP_MEMO_SLOTS - 1);
+}
+
 SIMPLE_PATTERN_RESULT simple_pattern_matches_buffer_extract(SIMPLE_PATTERN *list, BUFFER *str, char *wildcarded, size_t wildcarded_size) {
     if(!list || !str || buffer_strlen(str)) return SP_NOT_MATCHED;
     return simple_pattern_matches_extract_with_length(list, buffer_tostring(str), buffer_strlen(str), wildcarded, wildcarded_size);
@@ -306,7 +683,37 @@ SIMPLE_PATTERN_RESULT simple_pattern_matches_buffer_extract(SIMPLE_PATTERN *list
 
 SIMPLE_PATTERN_RESULT simple_pattern_matches_string_extract(SIMPLE_PATTERN *list, STRING *str, char *wildcarded, size_t wildcarded_size) {
     if(!list || !str) return SP_NOT_MATCHED;
-    return simple_pattern_matches_extract_with_length(list, string2str(str), string_strlen(str), wildcarded, wildcarded_size);
+
+    struct simple_pattern_compiled *c = ((struct simple_pattern *)list)->compiled;
+    if(!c || !c->memo || wildcarded)
+        return simple_pattern_matches_extract_with_length(list, string2str(str), string_strlen(str), wildcarded, wildcarded_size);
+
+    // STRINGs are unique, so the same pointer always gives the same result
+    struct sp_memo *memo = c->memo;
+    size_t slot = sp_memo_slot(str);
+
+    if(spinlock_trylock(&memo->spinlock)) {
+        bool found = (memo->slots[slot].str == str);
+        SIMPLE_PATTERN_RESULT result = memo->slots[slot].result;
+        spinlock_unlock(&memo->spinlock);
+
+        if(found)
+            return result;
+    }
+
+    SIMPLE_PATTERN_RESULT result = simple_pattern_matches_compiled(c, string2str(str), string_strlen(str));
+
+    // when busy, another thread is using the memo - do not wait for it
+    if(spinlock_trylock(&memo->spinlock)) {
+        STRING *old = memo->slots[slot].str;
+        memo->slots[slot].str = string_dup(str);
+        memo->slots[slot].result = result;
+        spinlock_unlock(&memo->spinlock);
+
+        string_freez(old);
+    }
+
+    return result;
 }
 
 SIMPLE_PATTERN_RESULT simple_pattern_matches_extract(SIMPLE_PATTERN *list, const char *str, char *wildcarded, size_t wildcarded_size) {
@@ -331,6 +738,7 @@ static inline void free_pattern(struct simple_pattern *m) {
 void simple_pattern_free(SIMPLE_PATTERN *list) {
     if(!list) return;
 
+    simple_pattern_compiled_free(((struct simple_pattern *)list)->compiled);
     free_pattern(((struct simple_pattern *)list));
 }
 
@@ -405,6 +813,16 @@ extern int simple_pattern_is_potential_name(SIMPLE_PATTERN *p)
     return (alpha || wildcards) && !colon;
 }
 
+const char *simple_pattern_exact_literal(SIMPLE_PATTERN *p)
+{
+    struct simple_pattern *root = (struct simple_pattern *)p;
+    if(!root || root->next || root->child || root->negative || !root->case_sensitive ||
+        root->mode != SIMPLE_PATTERN_EXACT || !root->match)
+        return NULL;
+
+    return root->match;
+}
+
 char *simple_pattern_iterate(SIMPLE_PATTERN **p)
 {
     struct simple_pattern *root = (struct simple_pattern *) *p;
@@ -457,3 +875,163 @@ bool simple_pattern_contains_wildcards(const char *str, const char *separators)
 
     return false;
 }
+
+// ----------------------------------------------------------------------------
+// unittest
+
+static void simple_pattern_unittest_random_text(char *dst, size_t max, const char *alphabet, size_t alphabet_len) {
+    size_t len = os_random(max + 1);
+    for(size_t i = 0; i < len ; i++)
+        dst[i] = alphabet[os_random(alphabet_len)];
+    dst[len] = '\0';
+}
+
+static int simple_pattern_unittest_equivalence(void) {
+    static const SIMPLE_PREFIX_MODE modes[] = {
+        SIMPLE_PATTERN_EXACT, SIMPLE_PATTERN_PREFIX, SIMPLE_PATTERN_SUFFIX, SIMPLE_PATTERN_SUBSTRING,
+    };
+
+    const char *pattern_alphabet = "abcA**";
+    const char *string_alphabet = "abcAB";
+    int errors = 0;
+
+    for(size_t round = 0; round < 2000 ; round++) {
+        char list[1024] = "";
+        size_t terms = SP_COMPILE_MIN_TERMS + os_random(SP_MEMO_MIN_COMPLEX_TERMS * 4);
+        for(size_t t = 0; t < terms ; t++) {
+            char term[16];
+            simple_pattern_unittest_random_text(term, 6, pattern_alphabet, strlen(pattern_alphabet));
+            if(!*term)
+                continue;
+
+            size_t len = strlen(list);
+            snprintfz(&list[len], sizeof(list) - len, "%s%s ", os_random(4) ? "" : "!", term);
+        }
+
+        SIMPLE_PREFIX_MODE mode = modes[os_random(_countof(modes))];
+        bool case_sensitive = os_random(2);
+        SIMPLE_PATTERN *p = simple_pattern_create(list, NULL, mode, case_sensitive);
+        if(!p)
+            continue;
+
+        struct simple_pattern *root = (struct simple_pattern *)p;
+        for(size_t i = 0; i < 200 ; i++) {
+            char str[16];
+            simple_pattern_unittest_random_text(str, 10, string_alphabet, strlen(string_alphabet));
+
+            SIMPLE_PATTERN_RESULT expected = simple_pattern_matches_list(p, str, strlen(str), NULL, 0);
+            SIMPLE_PATTERN_RESULT got = simple_pattern_matches_length_extract(p, str, strlen(str), NULL, 0);
+            if(!*str)
+                got = expected; // empty strings are not matched by the public API
+
+            if(got != expected) {
+                fprintf(stderr, "SIMPLE PATTERN: '%s' (mode %d, case %s) on '%s': compiled %d, expected %d\n",
+                        list, (int)mode, case_sensitive ? "sensitive" : "insensitive", str, (int)got, (int)expected);
+                errors++;
+            }
+
+            if(root->compiled && root->compiled->memo && *str) {
+                STRING *s = string_strdupz(str);
+                got = simple_pattern_matches_string_extract(p, s, NULL, 0);  // fills the memo
+                SIMPLE_PATTERN_RESULT again = simple_pattern_matches_string_extract(p, s, NULL, 0);
+                string_freez(s);
+
+                if(got != expected || again != expected) {
+                    fprintf(stderr, "SIMPLE PATTERN: '%s' on STRING '%s': got %d and %d, expected %d\n",
+                            list, str, (int)got, (int)again, (int)expected);
+                    errors++;
+                }
+            }
+
+            if(errors > 10)
+                break;
+        }
+
+        simple_pattern_free(p);
+
+        if(errors > 10)
+            break;
+    }
+
+    return errors;
+}
+
+static int simple_pattern_unittest_benchmark(void) {
+    const size_t ids = 1000000;
+    const size_t families = 500;
+
+    // a list of 160 terms of all kinds, like a long 'send charts matching'
+    CLEAN_BUFFER *wb = buffer_create(0, NULL);
+    for(size_t i = 0; i < 32 ; i++) {
+        buffer_sprintf(wb, "!app%zu.cpu_%zu ", i * 7, i);
+        buffer_sprintf(wb, "disk%zu.* ", i);
+        buffer_sprintf(wb, "*.net_%zu ", i * 3);
+        buffer_sprintf(wb, "*cgroup_%zu* ", i * 11);
+        buffer_sprintf(wb, "system.*_%zu_mem ", i * 13);
+    }
+
+    SIMPLE_PATTERN *p = simple_pattern_create(buffer_tostring(wb), NULL, SIMPLE_PATTERN_EXACT, true);
+
+    STRING **strings = mallocz(ids * sizeof(STRING *));
+    for(size_t i = 0; i < ids ; i++) {
+        char id[100];
+        switch(i % 4) {
+            case 0: snprintfz(id, sizeof(id), "app%zu.cpu_%zu", i % families, i % 50); break;
+            case 1: snprintfz(id, sizeof(id), "disk%zu.io_%zu", i % families, i); break;
+            case 2: snprintfz(id, sizeof(id), "if%zu.net_%zu", i, i % families); break;
+            default: snprintfz(id, sizeof(id), "system.cgroup_%zu_mem", i % families); break;
+        }
+        strings[i] = string_strdupz(id);
+    }
+
+    size_t matched_list = 0, matched_compiled = 0, matched_memo = 0, expected_memo = 0;
+
+    usec_t started_ut = now_monotonic_usec();
+    for(size_t i = 0; i < ids ; i++)
+        matched_list += simple_pattern_matches_list(p, string2str(strings[i]), string_strlen(strings[i]), NULL, 0) == SP_MATCHED_POSITIVE;
+    usec_t list_ut = now_monotonic_usec() - started_ut;
+
+    started_ut = now_monotonic_usec();
+    for(size_t i = 0; i < ids ; i++)
+        matched_compiled += simple_pattern_matches(p, string2str(strings[i]));
+    usec_t compiled_ut = now_monotonic_usec() - started_ut;
+
+    // the same ids are matched again and again by queries, so the memo is warm
+    for(size_t i = 0; i < ids ; i++)
+        (void)simple_pattern_matches_string(p, strings[i % SP_MEMO_SLOTS]);
+
+    started_ut = now_monotonic_usec();
+    for(size_t i = 0; i < ids ; i++)
+        matched_memo += simple_pattern_matches_string(p, strings[i % SP_MEMO_SLOTS]);
+    usec_t memo_ut = now_monotonic_usec() - started_ut;
+
+    fprintf(stderr, "SIMPLE PATTERN: 160 terms against %zu ids: list %"PRIu64" usec, compiled %"PRIu64" usec, "
+                    "compiled with a warm STRING memo %"PRIu64" usec\n",
+            ids, list_ut, compiled_ut, memo_ut);
+
+    for(size_t i = 0; i < ids ; i++)
+        expected_memo += simple_pattern_matches_list(p, string2str(strings[i % SP_MEMO_SLOTS]), string_strlen(strings[i % SP_MEMO_SLOTS]), NULL, 0) == SP_MATCHED_POSITIVE;
+
+    for(size_t i = 0; i < ids ; i++)
+        string_freez(strings[i]);
+    freez(strings);
+    simple_pattern_free(p);
+
+    if(matched_list != matched_compiled || matched_memo != expected_memo) {
+        fprintf(stderr, "SIMPLE PATTERN: matches differ: list %zu, compiled %zu, memo %zu (expected %zu)\n",
+                matched_list, matched_compiled, matched_memo, expected_memo);
+        return 1;
+    }
+
+    return 0;
+}
+
+int simple_pattern_unittest(void) {
+    int errors = 0;
+
+    errors += simple_pattern_unittest_equivalence();
+    errors += simple_pattern_unittest_benchmark();
+
+    fprintf(stderr, "SIMPLE PATTERN: %d errors\n", errors);
+    return errors;
+}
@@ -49,9 +49,15 @@ void simple_pattern_dump(uint64_t debug_type, SIMPLE_PATTERN *p) ;
 int simple_pattern_is_potential_name(SIMPLE_PATTERN *p) ;
 char *simple_pattern_iterate(SIMPLE_PATTERN **p);
 
+// when the pattern matches only one string (a single, positive, case-sensitive, exact term)
+// return that string, otherwise NULL
+const char *simple_pattern_exact_literal(SIMPLE_PATTERN *p);
+
 // check if string contains pattern wildcards (*, ! prefix, or separators)
 bool simple_pattern_contains_wildcards(const char *str, const char *separators);
 
+int simple_pattern_unittest(void);
+
 #define SIMPLE_PATTERN_DEFAULT_WEB_SEPARATORS ",|\t\r\n\f\v"
 
 #define is_valid_sp(x) ((x) && *(x) && !((x)[0] == '*' && (x)[1] == '\0'))
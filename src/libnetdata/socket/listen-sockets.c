@@ -117,7 +117,7 @@ static int create_listen_socket_unix(const char *path, int listen_backlog) {
     return sock;
 }
 
-static int create_listen_socket4(int socktype, const char *ip, uint16_t port, int listen_backlog) {
+static int create_listen_socket4(int socktype, const char *ip, uint16_t port, int listen_backlog, bool reuse_port) {
     int sock;
 
     sock = socket(AF_INET, socktype | DEFAULT_SOCKET_FLAGS, 0);
@@ -134,7 +134,13 @@ static int create_listen_socket4(int socktype, const char *ip, uint16_t port, in
                "LISTENER: IPv4 socket on ip '%s' port %d, socktype %d failed to enable reuse address.",
                ip, port, socktype);
 
-    if(sock_setreuse_port(sock, false) == 1) // -1 means not supported
+    if(reuse_port) {
+        if(sock_setreuse_port(sock, true) != 1)
+            nd_log(NDLS_DAEMON, NDLP_ERR,
+                   "LISTENER: IPv4 socket on ip '%s' port %d, socktype %d failed to enable reuse port.",
+                   ip, port, socktype);
+    }
+    else if(sock_setreuse_port(sock, false) == 1) // -1 means not supported
         nd_log(NDLS_DAEMON, NDLP_ERR,
                "LISTENER: IPv4 socket on ip '%s' port %d, socktype %d failed to disable reuse port.",
                ip, port, socktype);
@@ -191,7 +197,7 @@ static int create_listen_socket4(int socktype, const char *ip, uint16_t port, in
     return sock;
 }
 
-static int create_listen_socket6(int socktype, uint32_t scope_id, const char *ip, int port, int listen_backlog) {
+static int create_listen_socket6(int socktype, uint32_t scope_id, const char *ip, int port, int listen_backlog, bool reuse_port) {
     int sock;
     int ipv6only = 1;
 
@@ -209,7 +215,13 @@ static int create_listen_socket6(int socktype, uint32_t scope_id, const char *ip
                "LISTENER: IPv6 socket on ip '%s' port %d, socktype %d failed to set reuse address.",
                ip, port, socktype);
 
-    if(sock_setreuse_port(sock, false) == 1) // -1 means not supported
+    if(reuse_port) {
+        if(sock_setreuse_port(sock, true) != 1)
+            nd_log(NDLS_DAEMON, NDLP_ERR,
+                   "LISTENER: IPv6 socket on ip '%s' port %d, socktype %d failed to enable reuse port.",
+                   ip, port, socktype);
+    }
+    else if(sock_setreuse_port(sock, false) == 1) // -1 means not supported
         nd_log(NDLS_DAEMON, NDLP_ERR,
                "LISTENER: IPv6 socket on ip '%s' port %d, socktype %d failed to disable reuse port.",
                ip, port, socktype);
@@ -482,7 +494,7 @@ static inline int bind_to_this(LISTEN_SOCKETS *sockets, const char *definition,
                 struct sockaddr_in *sin = (struct sockaddr_in *) rp->ai_addr;
                 inet_ntop(AF_INET, &sin->sin_addr, rip, INET_ADDRSTRLEN);
                 rport = ntohs(sin->sin_port);
-                fd = create_listen_socket4(socktype, rip, rport, listen_backlog);
+                fd = create_listen_socket4(socktype, rip, rport, listen_backlog, sockets->reuse_port);
                 break;
             }
 
@@ -490,7 +502,7 @@ static inline int bind_to_this(LISTEN_SOCKETS *sockets, const char *definition,
                 struct sockaddr_in6 *sin6 = (struct sockaddr_in6 *) rp->ai_addr;
                 inet_ntop(AF_INET6, &sin6->sin6_addr, rip, INET6_ADDRSTRLEN);
                 rport = ntohs(sin6->sin6_port);
-                fd = create_listen_socket6(socktype, scope_id, rip, rport, listen_backlog);
+                fd = create_listen_socket6(socktype, scope_id, rip, rport, listen_backlog, sockets->reuse_port);
                 break;
             }
 
@@ -520,6 +532,64 @@ static inline int bind_to_this(LISTEN_SOCKETS *sockets, const char *definition,
     return added;
 }
 
+int listen_sockets_clone_reuse_port(LISTEN_SOCKETS *dst, LISTEN_SOCKETS *src) {
+    listen_sockets_init(dst);
+    dst->backlog = src->backlog;
+    dst->reuse_port = true;
+
+    if(!src->reuse_port)
+        return 0;
+
+    size_t i;
+    for(i = 0; i < src->opened ;i++) {
+        int family = src->fds_families[i];
+        if(family != AF_INET && family != AF_INET6)
+            continue;
+
+        struct sockaddr_storage ss;
+        socklen_t len = sizeof(ss);
+        if(getsockname(src->fds[i], (struct sockaddr *)&ss, &len) != 0) {
+            nd_log(NDLS_DAEMON, NDLP_ERR,
+                   "LISTENER: cannot get the address of listening socket %s to clone it.",
+                   src->fds_names[i]);
+
+            dst->failed++;
+            continue;
+        }
+
+        int socktype = src->fds_types[i];
+        const char *protocol_str = (socktype == SOCK_DGRAM) ? "udp" : "tcp";
+        char ip[INET6_ADDRSTRLEN] = "INVALID";
+        uint16_t port;
+        int fd;
+
+        if(family == AF_INET) {
+            struct sockaddr_in *sin = (struct sockaddr_in *)&ss;
+            inet_ntop(AF_INET, &sin->sin_addr, ip, sizeof(ip));
+            port = ntohs(sin->sin_port);
+            fd = create_listen_socket4(socktype, ip, port, dst->backlog, true);
+        }
+        else {
+            struct sockaddr_in6 *sin6 = (struct sockaddr_in6 *)&ss;
+            inet_ntop(AF_INET6, &sin6->sin6_addr, ip, sizeof(ip));
+            port = ntohs(sin6->sin6_port);
+            fd = create_listen_socket6(socktype, sin6->sin6_scope_id, ip, port, dst->backlog, true);
+        }
+
+        if(fd == -1) {
+            nd_log(NDLS_DAEMON, NDLP_ERR,
+                   "LISTENER: Cannot clone listening socket %s",
+                   src->fds_names[i]);
+
+            dst->failed++;
+        }
+        else
+            listen_sockets_add(dst, fd, family, socktype, protocol_str, ip, port, src->fds_acl_flags[i]);
+    }
+
+    return (int)dst->opened;
+}
+
 int listen_sockets_setup(LISTEN_SOCKETS *sockets) {
     listen_sockets_init(sockets);
 
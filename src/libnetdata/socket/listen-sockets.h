@@ -15,6 +15,7 @@ typedef struct listen_sockets {
     const char *default_bind_to;        // the default bind to configuration string
     uint16_t default_port;              // the default port to use
     int backlog;                        // the default listen backlog to use
+    bool reuse_port;                    // set SO_REUSEPORT on inet sockets, to allow cloning them
 
     size_t opened;                      // the number of sockets opened
     size_t failed;                      // the number of sockets attempted to open, but failed
@@ -28,4 +29,9 @@ typedef struct listen_sockets {
 int listen_sockets_setup(LISTEN_SOCKETS *sockets);
 void listen_sockets_close(LISTEN_SOCKETS *sockets);
 
+// open new sockets in dst, bound to the same addresses as the inet sockets of src
+// src must have been set up with reuse_port, so that the kernel distributes the
+// packets and connections among all the clones of each socket
+int listen_sockets_clone_reuse_port(LISTEN_SOCKETS *dst, LISTEN_SOCKETS *src);
+
 #endif //NETDATA_LISTEN_SOCKETS_H
@@ -83,6 +83,22 @@ void poll_process_remove_from_poll(POLLINFO *pi) {
         pi->flags |= POLLINFO_FLAG_REMOVED_FROM_POLL;
 }
 
+bool poll_process_add_to_poll(POLLINFO *pi, nd_poll_event_t events) {
+    if(!(pi->flags & POLLINFO_FLAG_REMOVED_FROM_POLL))
+        return true;
+
+    pi->events = events;
+    pi->events_we_wait_for = events;
+
+    if(!nd_poll_add(pi->p->ndpl, pi->fd, events, pi)) {
+        nd_log(NDLS_DAEMON, NDLP_ERR, "Failed to add socket %d back to nd_poll", pi->fd);
+        return false;
+    }
+
+    pi->flags &= ~POLLINFO_FLAG_REMOVED_FROM_POLL;
+    return true;
+}
+
 static inline void poll_close_fd(POLLINFO *pi, const char *func) {
     POLLJOB *p = pi->p;
 
@@ -113,6 +129,10 @@ static inline void poll_close_fd(POLLINFO *pi, const char *func) {
     p->used--;
 }
 
+void poll_process_close(POLLINFO *pi) {
+    poll_close_fd(pi, __FUNCTION__ );
+}
+
 void *poll_default_add_callback(POLLINFO *pi __maybe_unused, nd_poll_event_t *events __maybe_unused, void *data __maybe_unused) {
     return NULL;
 }
@@ -545,7 +565,8 @@ void poll_events(LISTEN_SOCKETS *sockets
             for(pi = p.ll; pi ; pi = next) {
                 next = pi->next;
 
-                if(likely(pi->flags & POLLINFO_FLAG_CLIENT_SOCKET)) {
+                // sockets temporarily removed from poll are handled elsewhere
+                if(likely((pi->flags & (POLLINFO_FLAG_CLIENT_SOCKET | POLLINFO_FLAG_REMOVED_FROM_POLL)) == POLLINFO_FLAG_CLIENT_SOCKET)) {
                     if (unlikely(pi->send_count == 0 && p.complete_request_timeout > 0 && (now - pi->connected_t) >= p.complete_request_timeout)) {
                         nd_log(NDLS_DAEMON, NDLP_DEBUG,
                                "POLLFD: LISTENER: client slot %zu (fd %d) from %s port %s has not sent a complete request in %zu seconds - closing it. "
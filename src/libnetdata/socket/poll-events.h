@@ -82,6 +82,8 @@ void poll_default_del_callback(POLLINFO *pi);
 void *poll_default_add_callback(POLLINFO *pi, nd_poll_event_t *events, void *data);
 
 void poll_process_remove_from_poll(POLLINFO *pi);
+bool poll_process_add_to_poll(POLLINFO *pi, nd_poll_event_t events);
+void poll_process_close(POLLINFO *pi);
 
 POLLINFO *poll_add_fd(POLLJOB *p
                       , int fd
@@ -0,0 +1,434 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "ddsketch.h"
+
+// the number of buckets allocated the first time a store is used
+#define DDSKETCH_STORE_INITIAL_SIZE 64
+
+// values closer to zero than this are counted as zero
+#define DDSKETCH_MIN_INDEXABLE_VALUE 1e-100
+
+// ----------------------------------------------------------------------------
+// stores
+
+static void ddsketch_store_relocate(DDSKETCH_STORE *st, int32_t offset, uint32_t size) {
+    uint64_t *counts = callocz(size, sizeof(*counts));
+    uint32_t min_index = UINT32_MAX, max_index = 0;
+
+    if(st->count) {
+        for(uint32_t i = st->min_index; i <= st->max_index; i++) {
+            if(!st->counts[i])
+                continue;
+
+            // keys below the new offset are collapsed into the first bucket
+            int64_t index = (int64_t)st->offset + i - offset;
+            if(index < 0)
+                index = 0;
+
+            counts[index] += st->counts[i];
+
+            if((uint32_t)index < min_index) min_index = (uint32_t)index;
+            if((uint32_t)index > max_index) max_index = (uint32_t)index;
+        }
+    }
+
+    freez(st->counts);
+    st->counts = counts;
+    st->offset = offset;
+    st->size = size;
+    st->min_index = st->count ? min_index : 0;
+    st->max_index = st->count ? max_index : 0;
+}
+
+static void ddsketch_store_add(DDSKETCH_STORE *st, int32_t key, uint64_t weight, uint32_t max_buckets) {
+    int64_t index = (int64_t)key - st->offset;
+
+    if(unlikely(!st->counts || index < 0 || index >= st->size)) {
+        int64_t lo = key, hi = key;
+        if(st->count) {
+            lo = MIN(lo, (int64_t)st->offset + st->min_index);
+            hi = MAX(hi, (int64_t)st->offset + st->max_index);
+        }
+
+        if(hi - lo + 1 > max_buckets) {
+            // too wide - the lowest keys will be collapsed
+            lo = hi - max_buckets + 1;
+            if(key < lo)
+                key = (int32_t)lo;
+        }
+
+        index = (int64_t)key - st->offset;
+        if(!st->counts || index < 0 || index >= st->size || lo < st->offset) {
+            uint32_t needed = (uint32_t)(hi - lo + 1);
+            uint32_t size = st->size ? st->size : DDSKETCH_STORE_INITIAL_SIZE;
+            while(size < needed)
+                size *= 2;
+
+            if(size > max_buckets)
+                size = max_buckets;
+
+            // center the keys in the new window, to leave room for growth on both sides
+            ddsketch_store_relocate(st, (int32_t)(lo - (int64_t)(size - needed) / 2), size);
+            index = (int64_t)key - st->offset;
+        }
+    }
+
+    st->counts[index] += weight;
+
+    if(!st->count) {
+        st->min_index = st->max_index = (uint32_t)index;
+    }
+    else {
+        if((uint32_t)index < st->min_index) st->min_index = (uint32_t)index;
+        if((uint32_t)index > st->max_index) st->max_index = (uint32_t)index;
+    }
+
+    st->count += weight;
+}
+
+static void ddsketch_store_reset(DDSKETCH_STORE *st) {
+    if(st->count)
+        memset(&st->counts[st->min_index], 0, (st->max_index - st->min_index + 1) * sizeof(*st->counts));
+
+    st->count = 0;
+    st->min_index = st->max_index = 0;
+}
+
+// ----------------------------------------------------------------------------
+// sketch
+
+static ALWAYS_INLINE int32_t ddsketch_key(const DDSKETCH *sk, NETDATA_DOUBLE value) {
+    return (int32_t)ceil(log((double)value) * (double)sk->multiplier);
+}
+
+static ALWAYS_INLINE NETDATA_DOUBLE ddsketch_key_value(const DDSKETCH *sk, int32_t key) {
+    // the value in the middle of the bucket, in relative terms
+    return (NETDATA_DOUBLE)(exp((double)key / (double)sk->multiplier) * 2.0 / (1.0 + (double)sk->gamma));
+}
+
+void ddsketch_init(DDSKETCH *sk, NETDATA_DOUBLE relative_accuracy, uint32_t max_buckets) {
+    memset(sk, 0, sizeof(*sk));
+
+    if(!(relative_accuracy > 0.0 && relative_accuracy < 1.0))
+        relative_accuracy = DDSKETCH_DEFAULT_RELATIVE_ACCURACY;
+
+    if(max_buckets < DDSKETCH_STORE_INITIAL_SIZE)
+        max_buckets = DDSKETCH_STORE_INITIAL_SIZE;
+
+    sk->gamma = (1.0 + relative_accuracy) / (1.0 - relative_accuracy);
+    sk->multiplier = 1.0 / log((double)sk->gamma);
+    sk->max_buckets = max_buckets;
+}
+
+void ddsketch_destroy(DDSKETCH *sk) {
+    freez(sk->positive.counts);
+    freez(sk->negative.counts);
+    memset(sk, 0, sizeof(*sk));
+}
+
+void ddsketch_reset(DDSKETCH *sk) {
+    ddsketch_store_reset(&sk->positive);
+    ddsketch_store_reset(&sk->negative);
+    sk->zero = 0;
+    sk->count = 0;
+    sk->min = sk->max = sk->sum = sk->mean = sk->m2 = 0.0;
+}
+
+static void ddsketch_stats_add(DDSKETCH *sk, uint64_t count, NETDATA_DOUBLE min, NETDATA_DOUBLE max,
+                               NETDATA_DOUBLE sum, NETDATA_DOUBLE mean, NETDATA_DOUBLE m2) {
+    if(!sk->count) {
+        sk->min = min;
+        sk->max = max;
+    }
+    else {
+        if(min < sk->min) sk->min = min;
+        if(max > sk->max) sk->max = max;
+    }
+
+    // merge the running means and the squared deviations (Chan et al.)
+    uint64_t n = sk->count + count;
+    NETDATA_DOUBLE delta = mean - sk->mean;
+    sk->mean += delta * (NETDATA_DOUBLE)count / (NETDATA_DOUBLE)n;
+    sk->m2 += m2 + delta * delta * (NETDATA_DOUBLE)sk->count * (NETDATA_DOUBLE)count / (NETDATA_DOUBLE)n;
+
+    sk->sum += sum;
+    sk->count = n;
+}
+
+void ddsketch_add(DDSKETCH *sk, NETDATA_DOUBLE value, uint64_t weight) {
+    if(unlikely(!weight || !netdata_double_isnumber(value)))
+        return;
+
+    if(value >= DDSKETCH_MIN_INDEXABLE_VALUE)
+        ddsketch_store_add(&sk->positive, ddsketch_key(sk, value), weight, sk->max_buckets);
+    else if(value <= -DDSKETCH_MIN_INDEXABLE_VALUE)
+        ddsketch_store_add(&sk->negative, ddsketch_key(sk, -value), weight, sk->max_buckets);
+    else
+        sk->zero += weight;
+
+    ddsketch_stats_add(sk, weight, value, value, value * (NETDATA_DOUBLE)weight, value, 0.0);
+}
+
+static void ddsketch_store_merge(DDSKETCH_STORE *dst, const DDSKETCH_STORE *src, uint32_t max_buckets) {
+    if(!src->count)
+        return;
+
+    for(uint32_t i = src->min_index; i <= src->max_index; i++) {
+        if(src->counts[i])
+            ddsketch_store_add(dst, (int32_t)(src->offset + (int64_t)i), src->counts[i], max_buckets);
+    }
+}
+
+bool ddsketch_merge(DDSKETCH *dst, const DDSKETCH *src) {
+    if(!considered_equal_ndd(dst->gamma, src->gamma))
+        return false;
+
+    if(!src->count)
+        return true;
+
+    ddsketch_store_merge(&dst->positive, &src->positive, dst->max_buckets);
+    ddsketch_store_merge(&dst->negative, &src->negative, dst->max_buckets);
+    dst->zero += src->zero;
+
+    ddsketch_stats_add(dst, src->count, src->min, src->max, src->sum, src->mean, src->m2);
+    return true;
+}
+
+NETDATA_DOUBLE ddsketch_quantile(const DDSKETCH *sk, NETDATA_DOUBLE q) {
+    if(!sk->count)
+        return NAN;
+
+    if(q <= 0.0) return sk->min;
+    if(q >= 1.0) return sk->max;
+
+    // the rank of the value we are looking for (0-based)
+    NETDATA_DOUBLE rank = q * (NETDATA_DOUBLE)(sk->count - 1);
+    NETDATA_DOUBLE value = sk->max;
+    uint64_t n = 0;
+
+    // the negative values, from the most negative up
+    const DDSKETCH_STORE *st = &sk->negative;
+    if(st->count) {
+        for(int64_t i = st->max_index; i >= (int64_t)st->min_index; i--) {
+            n += st->counts[i];
+            if((NETDATA_DOUBLE)n > rank) {
+                value = -ddsketch_key_value(sk, (int32_t)(st->offset + i));
+                goto done;
+            }
+        }
+    }
+
+    n += sk->zero;
+    if((NETDATA_DOUBLE)n > rank) {
+        value = 0.0;
+        goto done;
+    }
+
+    st = &sk->positive;
+    if(st->count) {
+        for(uint32_t i = st->min_index; i <= st->max_index; i++) {
+            n += st->counts[i];
+            if((NETDATA_DOUBLE)n > rank) {
+                value = ddsketch_key_value(sk, (int32_t)(st->offset + (int64_t)i));
+                goto done;
+            }
+        }
+    }
+
+done:
+    // the exact min and max are better than any estimation
+    if(value < sk->min) value = sk->min;
+    if(value > sk->max) value = sk->max;
+    return value;
+}
+
+size_t ddsketch_memory(const DDSKETCH *sk) {
+    return sizeof(*sk) + (sk->positive.size + sk->negative.size) * sizeof(uint64_t);
+}
+
+// ----------------------------------------------------------------------------
+// unittest
+
+static int ddsketch_unittest_check_quantiles(DDSKETCH *sk, NETDATA_DOUBLE *series, size_t entries, NETDATA_DOUBLE accuracy, const char *name) {
+    static const NETDATA_DOUBLE quantiles[] = { 0.0, 0.01, 0.1, 0.25, 0.5, 0.75, 0.9, 0.95, 0.99, 0.999, 1.0 };
+    int errors = 0;
+
+    sort_series(series, entries);
+
+    for(size_t i = 0; i < _countof(quantiles); i++) {
+        NETDATA_DOUBLE expected = series[(size_t)(quantiles[i] * (NETDATA_DOUBLE)(entries - 1))];
+        NETDATA_DOUBLE got = ddsketch_quantile(sk, quantiles[i]);
+        NETDATA_DOUBLE error = expected != 0.0 ? fabsndd((got - expected) / expected) : fabsndd(got);
+
+        if(error > accuracy * 1.0001) {
+            fprintf(stderr, " > ERROR: %s: quantile %0.3Lf is %0.6Lf, expected %0.6Lf (relative error %0.4Lf%%)\n",
+                    name, (long double)quantiles[i], (long double)got, (long double)expected, (long double)(error * 100.0));
+            errors++;
+        }
+    }
+
+    if(ddsketch_count(sk) != entries) {
+        fprintf(stderr, " > ERROR: %s: count is %"PRIu64", expected %zu\n", name, ddsketch_count(sk), entries);
+        errors++;
+    }
+
+    NETDATA_DOUBLE avg = average(series, entries);
+    NETDATA_DOUBLE stddev = standard_deviation(series, entries);
+    if(fabsndd(ddsketch_average(sk) - avg) > fabsndd(avg) * 1e-9 + 1e-9 ||
+        fabsndd(ddsketch_stddev(sk) - stddev) > fabsndd(stddev) * 1e-6 + 1e-9) {
+        fprintf(stderr, " > ERROR: %s: average %0.6Lf and stddev %0.6Lf, expected %0.6Lf and %0.6Lf\n",
+                name, (long double)ddsketch_average(sk), (long double)ddsketch_stddev(sk), (long double)avg, (long double)stddev);
+        errors++;
+    }
+
+    fprintf(stderr, "   %-30s: %zu values, p50 %0.4Lf, p99 %0.4Lf, %zu bytes %s\n",
+            name, entries, (long double)ddsketch_quantile(sk, 0.5), (long double)ddsketch_quantile(sk, 0.99),
+            ddsketch_memory(sk), errors ? "FAILED" : "OK");
+
+    return errors;
+}
+
+static NETDATA_DOUBLE ddsketch_unittest_random(void) {
+    return (NETDATA_DOUBLE)os_random(UINT32_MAX) / (NETDATA_DOUBLE)UINT32_MAX;
+}
+
+int ddsketch_unittest(void) {
+    int errors = 0;
+    const NETDATA_DOUBLE accuracy = 0.01;
+    const size_t entries = 100000;
+    NETDATA_DOUBLE *series = mallocz(entries * sizeof(*series));
+
+    fprintf(stderr, "\nTesting DDSketch...\n");
+
+    // log-uniform positive values, over 9 orders of magnitude
+    {
+        DDSKETCH sk;
+        ddsketch_init(&sk, accuracy, DDSKETCH_DEFAULT_MAX_BUCKETS);
+        for(size_t i = 0; i < entries; i++) {
+            series[i] = powndd(10.0, ddsketch_unittest_random() * 9.0 - 3.0);
+            ddsketch_add(&sk, series[i], 1);
+        }
+        errors += ddsketch_unittest_check_quantiles(&sk, series, entries, accuracy, "log-uniform");
+        ddsketch_destroy(&sk);
+    }
+
+    // negative, zero and positive values
+    {
+        DDSKETCH sk;
+        ddsketch_init(&sk, accuracy, DDSKETCH_DEFAULT_MAX_BUCKETS);
+        for(size_t i = 0; i < entries; i++) {
+            NETDATA_DOUBLE r = ddsketch_unittest_random();
+            series[i] = (r < 0.1) ? 0.0 : (ddsketch_unittest_random() - 0.5) * 2000.0;
+            ddsketch_add(&sk, series[i], 1);
+        }
+        errors += ddsketch_unittest_check_quantiles(&sk, series, entries, accuracy, "signed");
+        ddsketch_destroy(&sk);
+    }
+
+    // weights and merging give the same results as adding every value
+    {
+        DDSKETCH a, b, all;
+        ddsketch_init(&a, accuracy, DDSKETCH_DEFAULT_MAX_BUCKETS);
+        ddsketch_init(&b, accuracy, DDSKETCH_DEFAULT_MAX_BUCKETS);
+        ddsketch_init(&all, accuracy, DDSKETCH_DEFAULT_MAX_BUCKETS);
+
+        size_t n = 0;
+        for(size_t i = 0; n + 4 <= entries; i++) {
+            NETDATA_DOUBLE v = 1.0 + ddsketch_unittest_random() * 1000.0;
+            uint64_t weight = 1 + (i % 4);
+            ddsketch_add((i % 2) ? &a : &b, v, weight);
+            for(uint64_t w = 0; w < weight; w++)
+                series[n++] = v;
+
+            ddsketch_add(&all, v, weight);
+        }
+
+        if(!ddsketch_merge(&a, &b)) {
+            fprintf(stderr, " > ERROR: sketches with the same accuracy cannot be merged\n");
+            errors++;
+        }
+
+        errors += ddsketch_unittest_check_quantiles(&a, series, n, accuracy, "weighted and merged");
+
+        for(NETDATA_DOUBLE q = 0.0; q <= 1.0; q += 0.05) {
+            if(!considered_equal_ndd(ddsketch_quantile(&a, q), ddsketch_quantile(&all, q))) {
+                fprintf(stderr, " > ERROR: merged quantile %0.2Lf differs from the single sketch\n", (long double)q);
+                errors++;
+            }
+        }
+
+        ddsketch_destroy(&a);
+        ddsketch_destroy(&b);
+        ddsketch_destroy(&all);
+    }
+
+    // memory is bounded - the lowest buckets are collapsed, the high quantiles remain accurate
+    // (with 1% accuracy, 1024 buckets span about 9 orders of magnitude)
+    {
+        const uint32_t max_buckets = 1024;
+        DDSKETCH sk;
+        ddsketch_init(&sk, accuracy, max_buckets);
+        for(size_t i = 0; i < entries; i++) {
+            series[i] = powndd(10.0, ddsketch_unittest_random() * 600.0 - 300.0);
+            ddsketch_add(&sk, series[i], 1);
+        }
+
+        if(sk.positive.size > max_buckets) {
+            fprintf(stderr, " > ERROR: the sketch has %u buckets, but it is limited to %u\n", sk.positive.size, max_buckets);
+            errors++;
+        }
+
+        sort_series(series, entries);
+        NETDATA_DOUBLE expected = series[(size_t)(0.99 * (NETDATA_DOUBLE)(entries - 1))];
+        NETDATA_DOUBLE got = ddsketch_quantile(&sk, 0.99);
+        if(fabsndd((got - expected) / expected) > accuracy * 1.0001) {
+            fprintf(stderr, " > ERROR: collapsed sketch p99 is %Le, expected %Le\n", (long double)got, (long double)expected);
+            errors++;
+        }
+
+        fprintf(stderr, "   %-30s: %zu values, %u buckets, %zu bytes %s\n",
+                "bounded", entries, sk.positive.size, ddsketch_memory(&sk), errors ? "FAILED" : "OK");
+        ddsketch_destroy(&sk);
+    }
+
+    // reset keeps working
+    {
+        DDSKETCH sk;
+        ddsketch_init(&sk, accuracy, DDSKETCH_DEFAULT_MAX_BUCKETS);
+        for(size_t i = 0; i < 1000; i++)
+            ddsketch_add(&sk, (NETDATA_DOUBLE)(i + 1), 1);
+
+        ddsketch_reset(&sk);
+        for(size_t i = 0; i < entries; i++) {
+            series[i] = 50.0 + ddsketch_unittest_random() * 10.0;
+            ddsketch_add(&sk, series[i], 1);
+        }
+        errors += ddsketch_unittest_check_quantiles(&sk, series, entries, accuracy, "after reset");
+        ddsketch_destroy(&sk);
+    }
+
+    // insert speed
+    {
+        DDSKETCH sk;
+        ddsketch_init(&sk, accuracy, DDSKETCH_DEFAULT_MAX_BUCKETS);
+        for(size_t i = 0; i < entries; i++)
+            series[i] = 1.0 + ddsketch_unittest_random() * 1000.0;
+
+        const size_t loops = 100;
+        usec_t started_ut = now_monotonic_usec();
+        for(size_t l = 0; l < loops; l++)
+            for(size_t i = 0; i < entries; i++)
+                ddsketch_add(&sk, series[i], 1);
+        usec_t ended_ut = now_monotonic_usec();
+
+        fprintf(stderr, "   %-30s: %zu values in %0.2f ms, %0.2f ns per value\n",
+                "insert speed", loops * entries, (double)(ended_ut - started_ut) / 1000.0,
+                (double)(ended_ut - started_ut) * 1000.0 / (double)(loops * entries));
+        ddsketch_destroy(&sk);
+    }
+
+    freez(series);
+
+    fprintf(stderr, "DDSketch %s\n", errors ? "FAILED" : "OK");
+    return errors;
+}
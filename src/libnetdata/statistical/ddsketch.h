@@ -0,0 +1,82 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef NETDATA_DDSKETCH_H
+#define NETDATA_DDSKETCH_H 1
+
+#include "../libnetdata.h"
+
+// A DDSketch: a mergeable quantile sketch with bounded relative error.
+//
+// Values are counted in logarithmic buckets, so that any quantile is returned
+// with a relative error of at most the relative accuracy given (e.g. 1%).
+// Adding a value is O(1), and memory is bounded by max_buckets per sign:
+// when the values span more buckets than that, the smallest ones (in absolute
+// value) are collapsed together, so the accuracy of the higher quantiles is
+// preserved.
+//
+// Count, min, max, sum, average and standard deviation are exact.
+//
+// The sketch is not thread safe - the caller has to lock it.
+
+#define DDSKETCH_DEFAULT_RELATIVE_ACCURACY 0.01
+#define DDSKETCH_DEFAULT_MAX_BUCKETS 2048
+
+typedef struct ddsketch_store {
+    int32_t offset;             // the key of counts[0]
+    uint32_t size;              // the number of allocated counts
+    uint32_t min_index;         // the lowest used index (when count > 0)
+    uint32_t max_index;         // the highest used index (when count > 0)
+    uint64_t count;
+    uint64_t *counts;
+} DDSKETCH_STORE;
+
+typedef struct ddsketch {
+    NETDATA_DOUBLE gamma;
+    NETDATA_DOUBLE multiplier;  // 1 / ln(gamma)
+    uint32_t max_buckets;
+
+    DDSKETCH_STORE positive;
+    DDSKETCH_STORE negative;    // keyed by the absolute value
+    uint64_t zero;
+
+    uint64_t count;
+    NETDATA_DOUBLE min;
+    NETDATA_DOUBLE max;
+    NETDATA_DOUBLE sum;
+    NETDATA_DOUBLE mean;        // running mean and sum of squared deviations,
+    NETDATA_DOUBLE m2;          // for the standard deviation
+} DDSKETCH;
+
+void ddsketch_init(DDSKETCH *sk, NETDATA_DOUBLE relative_accuracy, uint32_t max_buckets);
+void ddsketch_destroy(DDSKETCH *sk);
+
+// forget all values, but keep the memory allocated
+void ddsketch_reset(DDSKETCH *sk);
+
+// add a value, weight times
+void ddsketch_add(DDSKETCH *sk, NETDATA_DOUBLE value, uint64_t weight);
+
+// add all the values of src to dst - both must have the same relative accuracy
+bool ddsketch_merge(DDSKETCH *dst, const DDSKETCH *src);
+
+// q is 0.0 to 1.0 - returns NAN when the sketch is empty
+NETDATA_DOUBLE ddsketch_quantile(const DDSKETCH *sk, NETDATA_DOUBLE q);
+
+static inline uint64_t ddsketch_count(const DDSKETCH *sk) { return sk->count; }
+static inline NETDATA_DOUBLE ddsketch_min(const DDSKETCH *sk) { return sk->count ? sk->min : NAN; }
+static inline NETDATA_DOUBLE ddsketch_max(const DDSKETCH *sk) { return sk->count ? sk->max : NAN; }
+static inline NETDATA_DOUBLE ddsketch_sum(const DDSKETCH *sk) { return sk->count ? sk->sum : NAN; }
+static inline NETDATA_DOUBLE ddsketch_average(const DDSKETCH *sk) { return sk->count ? sk->mean : NAN; }
+
+// population standard deviation, like standard_deviation()
+static inline NETDATA_DOUBLE ddsketch_stddev(const DDSKETCH *sk) {
+    if(!sk->count) return NAN;
+    if(sk->count == 1) return sk->mean;
+    return sqrtndd(sk->m2 / (NETDATA_DOUBLE)sk->count);
+}
+
+size_t ddsketch_memory(const DDSKETCH *sk);
+
+int ddsketch_unittest(void);
+
+#endif //NETDATA_DDSKETCH_H
@@ -8,8 +8,18 @@
 
 #define STRING_PARTITION_SHIFTS (0)
 #define STRING_PARTITIONS (256 >> STRING_PARTITION_SHIFTS)
-#define string_partition_str(str) ((uint8_t)((str)[0]) >> STRING_PARTITION_SHIFTS)
-#define string_partition(string) (string_partition_str((string)->str))
+
+// strings are partitioned by their hash, not by their first character,
+// since most of the names share a few prefixes (system., net., cgroup_, etc)
+#define string_hash(str, length) ((uint64_t)XXH3_64bits(str, (length) - 1))
+#define string_partition_hash(hash) ((uint8_t)((hash) >> 56) >> STRING_PARTITION_SHIFTS)
+
+// the partition is kept in the string, so that releasing it does not hash it again
+#define string_partition(string) ((string)->partition)
+
+// every thread keeps a reference to the strings it looked up recently,
+// so that finding them again does not need the partition locks
+#define STRING_THREAD_CACHE_SIZE 256 // must be a power of 2
 
 struct netdata_string {
     uint32_t length;    // the string length including the terminating '\0'
@@ -17,7 +27,9 @@ struct netdata_string {
     REFCOUNT refcount;  // how many times this string is used
                         // We use a signed number to be able to detect duplicate frees of a string.
                         // If at any point this goes below zero, we have a duplicate free.
-                        
+
+    uint8_t partition;  // the partition of the index this string is in
+
 #ifdef FSANITIZE_ADDRESS
     STACKTRACE_ARRAY stacktraces;   // stack traces from all acquisition points
 #endif
@@ -59,6 +71,27 @@ static struct string_partition {
 
 } string_base[STRING_PARTITIONS] = { 0 };
 
+static struct {
+    uint32_t generation;        // incremented by string_destroy(), to invalidate all thread caches
+    bool disabled;              // used by the unittest, to compare with and without the thread caches
+    pthread_key_t key;          // releases the caches of threads not created with nd_thread_create()
+    pthread_once_t once;
+} string_thread_caches = {
+    .generation = 0,
+    .disabled = false,
+    .once = PTHREAD_ONCE_INIT,
+};
+
+#define string_thread_caches_enabled() (!__atomic_load_n(&string_thread_caches.disabled, __ATOMIC_RELAXED))
+
+static __thread struct {
+    uint32_t generation;
+    bool registered;            // the key destructor will release this cache
+    size_t entries;
+    size_t hits;                // the number of lookups served by this cache
+    STRING *strings[STRING_THREAD_CACHE_SIZE];
+} string_thread_cache = { 0 };
+
 #ifdef NETDATA_INTERNAL_CHECKS
 #define string_stats_atomic_increment(partition, var) __atomic_add_fetch(&string_base[partition].atomic.var, 1, __ATOMIC_RELAXED)
 #define string_stats_atomic_decrement(partition, var) __atomic_sub_fetch(&string_base[partition].atomic.var, 1, __ATOMIC_RELAXED)
@@ -134,10 +167,10 @@ STRING *string_dup(STRING *string) {
 }
 
 // Search the index and return an ACQUIRED string entry, or NULL
-static STRING *string_index_search(const char *str, size_t length) {
+static STRING *string_index_search(const char *str, size_t length, uint64_t hash) {
     STRING *string;
 
-    uint8_t partition = string_partition_str(str);
+    uint8_t partition = string_partition_hash(hash);
 
     // Find the string in the index
     // With a read-lock so that multiple readers can use the index concurrently.
@@ -177,10 +210,10 @@ static STRING *string_index_search(const char *str, size_t length) {
 // The returned entry is ACQUIRED, and it can either be:
 //   1. a new item inserted, or
 //   2. an item found in the index that is not currently deleted
-static STRING *string_index_insert(const char *str, size_t length) {
+static STRING *string_index_insert(const char *str, size_t length, uint64_t hash) {
     STRING *string;
 
-    uint8_t partition = string_partition_str(str);
+    uint8_t partition = string_partition_hash(hash);
 
     rw_spinlock_write_lock(&string_base[partition].spinlock);
 
@@ -213,6 +246,7 @@ static STRING *string_index_insert(const char *str, size_t length) {
         strcpy((char *)string->str, str);
         string->length = length;
         string->refcount = 1;
+        string->partition = partition;
         
 #ifdef FSANITIZE_ADDRESS
         // Initialize stacktrace tracking
@@ -302,26 +336,130 @@ static void string_index_delete(STRING *string) {
     rw_spinlock_write_unlock(&string_base[partition].spinlock);
 }
 
-ALWAYS_INLINE
-STRING *string_strdupz(const char *str) {
-    if(unlikely(!str || !*str)) return NULL;
+// ----------------------------------------------------------------------------
+// per thread cache of recently used strings
+
+// The cache holds a reference on each string it has, so the strings in it cannot
+// be deleted, and they can be acquired without looking them up in the index.
+
+static inline void string_thread_cache_check_generation(void) {
+    uint32_t generation = __atomic_load_n(&string_thread_caches.generation, __ATOMIC_RELAXED);
+    if(unlikely(string_thread_cache.generation != generation)) {
+        // string_destroy() has run - the strings we have are not in the index anymore
+        memset(string_thread_cache.strings, 0, sizeof(string_thread_cache.strings));
+        string_thread_cache.entries = 0;
+        string_thread_cache.generation = generation;
+    }
+}
 
-#ifdef NETDATA_INTERNAL_CHECKS
-    uint8_t partition = string_partition_str(str);
-#endif
+static inline STRING *string_thread_cache_get(const char *str, size_t length, uint64_t hash) {
+    string_thread_cache_check_generation();
 
-    size_t length = strlen(str) + 1;
-    STRING *string = string_index_search(str, length);
+    STRING *string = string_thread_cache.strings[hash & (STRING_THREAD_CACHE_SIZE - 1)];
+    if(likely(string && string->length == length && memcmp(string->str, str, length - 1) == 0)) {
+        // the cache holds a reference, so this cannot fail
+        refcount_acquire(&string->refcount);
+        string_thread_cache.hits++;
+        return string;
+    }
+
+    return NULL;
+}
+
+static void string_thread_cache_key_destructor(void *ptr __maybe_unused) {
+    // the other destructors may still use strings, so register again if they do
+    string_thread_cache.registered = false;
+    string_thread_cache_release();
+}
+
+static void string_thread_cache_key_create(void) {
+    pthread_key_create(&string_thread_caches.key, string_thread_cache_key_destructor);
+}
+
+static void string_thread_cache_register(void) {
+    pthread_once(&string_thread_caches.once, string_thread_cache_key_create);
+
+    // the value is not used, it only has to be non-NULL for the destructor to run
+    pthread_setspecific(string_thread_caches.key, &string_thread_cache);
+    string_thread_cache.registered = true;
+}
+
+static inline void string_thread_cache_put(STRING *string, uint64_t hash) {
+    if(unlikely(!string_thread_cache.registered))
+        string_thread_cache_register();
+
+    STRING **slot = &string_thread_cache.strings[hash & (STRING_THREAD_CACHE_SIZE - 1)];
+    if(*slot == string)
+        return;
+
+    STRING *old = *slot;
+
+    // the reference of the cache - it is released with string_freez(), which accounts it
+    refcount_acquire(&string->refcount);
+    string_stats_atomic_increment(string_partition(string), active_references);
+    *slot = string;
+
+    if(old)
+        string_freez(old);
+    else
+        string_thread_cache.entries++;
+}
+
+void string_thread_cache_release(void) {
+    string_thread_cache_check_generation();
+
+    for(size_t i = 0; string_thread_cache.entries && i < STRING_THREAD_CACHE_SIZE ; i++) {
+        STRING *string = string_thread_cache.strings[i];
+        if(!string)
+            continue;
+
+        string_thread_cache.strings[i] = NULL;
+        string_thread_cache.entries--;
+        string_freez(string);
+    }
+}
+
+static inline STRING *string_acquire(const char *str, size_t length) {
+    uint64_t hash = string_hash(str, length);
+
+    STRING *string = NULL;
+    if(likely(string_thread_caches_enabled())) {
+        string = string_thread_cache_get(str, length, hash);
+        if(likely(string))
+            return string;
+    }
+
+    string = string_index_search(str, length, hash);
+    if(string) {
+        // found in the index - it is used by others too, so it is worth caching
+        if(likely(string_thread_caches_enabled()))
+            string_thread_cache_put(string, hash);
+
+        return string;
+    }
 
     while(!string) {
         // The search above did not find anything,
         // We loop here, because during insert we may find an entry that is being deleted by another thread.
         // So, we have to let it go and retry to insert it again.
 
-        string = string_index_insert(str, length);
+        string = string_index_insert(str, length, hash);
     }
 
+    return string;
+}
+
+ALWAYS_INLINE
+STRING *string_strdupz(const char *str) {
+    if(unlikely(!str || !*str)) return NULL;
+
+    size_t length = strlen(str) + 1;
+    STRING *string = string_acquire(str, length);
+
     // statistics
+#ifdef NETDATA_INTERNAL_CHECKS
+    uint8_t partition = string_partition(string);
+#endif
     string_stats_atomic_increment(partition, active_references);
 
 #ifdef FSANITIZE_ADDRESS
@@ -336,18 +474,15 @@ ALWAYS_INLINE
 STRING *string_strndupz(const char *str, size_t len) {
     if(unlikely(!str || !*str || !len)) return NULL;
 
-#ifdef NETDATA_INTERNAL_CHECKS
-    uint8_t partition = string_partition_str(str);
-#endif
-
     char buf[len + 1];
     memcpy(buf, str, len);
     buf[len] = '\0';
 
-    STRING *string = string_index_search(buf, len + 1);
-    while(!string)
-        string = string_index_insert(buf, len + 1);
+    STRING *string = string_acquire(buf, len + 1);
 
+#ifdef NETDATA_INTERNAL_CHECKS
+    uint8_t partition = string_partition(string);
+#endif
     string_stats_atomic_increment(partition, active_references);
 
 #ifdef FSANITIZE_ADDRESS
@@ -506,6 +641,26 @@ static void string_thread(void *arg) {
     }
 }
 
+struct string_benchmark_thread {
+    bool *stop;
+    char **names;
+    size_t names_count;
+    size_t operations;
+};
+
+static void string_benchmark_thread(void *arg) {
+    struct string_benchmark_thread *bt = arg;
+
+    while(!__atomic_load_n(bt->stop, __ATOMIC_RELAXED)) {
+        for(size_t i = 0; i < bt->names_count ; i++) {
+            STRING *s = string_strdupz(bt->names[i]);
+            string_freez(s);
+        }
+
+        bt->operations += bt->names_count;
+    }
+}
+
 static char **string_unittest_generate_names(size_t entries) {
     char **names = mallocz(sizeof(char *) * entries);
     for(size_t i = 0; i < entries ;i++) {
@@ -539,6 +694,10 @@ size_t string_destroy(void) {
     string_freez(string_2way_merge_X);
     string_2way_merge_X = NULL;
 
+    // release the strings cached by this thread, and invalidate the caches of all the others
+    string_thread_cache_release();
+    __atomic_add_fetch(&string_thread_caches.generation, 1, __ATOMIC_RELAXED);
+
 #ifdef FSANITIZE_ADDRESS
     // Create JudyL array for tracking stats by stacktrace
     Pvoid_t string_counts = NULL;    // JudyL array to count strings per stacktrace
@@ -744,6 +903,13 @@ static size_t unittest_string_spins(void) {
 
 #endif // NETDATA_INTERNAL_CHECKS
 
+static void *string_unittest_foreign_thread(void *arg) {
+    // found in the index, so it is added to the cache of this thread
+    STRING *s = string_strdupz(arg);
+    string_freez(s);
+    return NULL;
+}
+
 int string_unittest(size_t entries) {
     size_t errors = 0;
 
@@ -773,6 +939,9 @@ int string_unittest(size_t entries) {
         else
             fprintf(stderr, "OK: cloning string are deduplicated\n");
 
+        // the second lookup cached the string in this thread, with a reference of its own
+        string_thread_cache_release();
+
         if(s1->refcount != 3) {
             errors++;
             fprintf(stderr, "ERROR: string refcount is not 3\n");
@@ -835,6 +1004,8 @@ int string_unittest(size_t entries) {
 
         freez(strings);
 
+        string_thread_cache_release();
+
         if(unittest_string_entries() != entries_starting + 2) {
             errors++;
             fprintf(stderr, "ERROR: strings dictionary should have %ld items but it has %ld\n",
@@ -883,6 +1054,124 @@ int string_unittest(size_t entries) {
         }
     }
 
+    // check the thread cache
+    {
+        fprintf(stderr, "\nChecking the thread cache of strings...\n");
+
+        STRING *s1 = string_strdupz("thread cache unittest");
+        size_t hits = string_thread_cache.hits;
+        STRING *s2 = string_strdupz("thread cache unittest");   // found in the index, it is cached
+        STRING *s3 = string_strdupz("thread cache unittest");   // found in the cache
+
+        if(s1 != s2 || s1 != s3) {
+            errors++;
+            fprintf(stderr, "ERROR: the thread cache returned a different string\n");
+        }
+        else if(string_thread_cache.hits != hits + 1) {
+            errors++;
+            fprintf(stderr, "ERROR: the thread cache did not serve the string\n");
+        }
+        else
+            fprintf(stderr, "OK: the thread cache serves recently used strings\n");
+
+        STRING *s4 = string_strndupz("thread cache unittest - not this", 21);
+        if(s4 != s1) {
+            errors++;
+            fprintf(stderr, "ERROR: the thread cache does not match strings by length\n");
+        }
+        else
+            fprintf(stderr, "OK: the thread cache matches strings by length\n");
+
+        string_freez(s1);
+        string_freez(s2);
+        string_freez(s3);
+        string_freez(s4);
+
+        long entries_before = unittest_string_entries();
+        string_thread_cache_release();
+        if(unittest_string_entries() != entries_before - 1) {
+            errors++;
+            fprintf(stderr, "ERROR: releasing the thread cache did not free the string\n");
+        }
+        else
+            fprintf(stderr, "OK: releasing the thread cache frees the strings\n");
+
+        // a thread not created with nd_thread_create() releases its cache when it exits
+        STRING *held = string_strdupz("thread cache unittest - foreign thread");
+        pthread_t thread;
+        if(pthread_create(&thread, NULL, string_unittest_foreign_thread, (void *)string2str(held)) != 0 ||
+            pthread_join(thread, NULL) != 0) {
+            errors++;
+            fprintf(stderr, "ERROR: cannot run a pthread\n");
+        }
+        else if(__atomic_load_n(&held->refcount, __ATOMIC_RELAXED) != 1) {
+            errors++;
+            fprintf(stderr, "ERROR: a pthread left %d references in its thread cache\n", held->refcount - 1);
+        }
+        else
+            fprintf(stderr, "OK: pthreads release their thread caches when they exit\n");
+
+        if(string_partition(held) != string_partition_hash(string_hash(held->str, held->length))) {
+            errors++;
+            fprintf(stderr, "ERROR: the partition kept in the string is wrong\n");
+        }
+
+        string_freez(held);
+    }
+
+    // multi-threaded benchmark, with and without the thread caches
+    {
+        size_t threads_to_create = 4, hot_names = 200;
+        if(hot_names > entries) hot_names = entries;
+        time_t seconds_to_run = 2;
+
+        fprintf(stderr, "\nBenchmarking %zu threads looking up %zu strings, for %lld seconds each...\n",
+                threads_to_create, hot_names, (long long)seconds_to_run);
+
+        // the strings are referenced by someone else, like the names of charts and dimensions are
+        STRING **held = mallocz(hot_names * sizeof(STRING *));
+        for(size_t i = 0; i < hot_names ; i++)
+            held[i] = string_strdupz(names[i]);
+
+        for(int cached = 0; cached < 2 ; cached++) {
+            __atomic_store_n(&string_thread_caches.disabled, !cached, __ATOMIC_RELAXED);
+
+            bool stop = false;
+            struct string_benchmark_thread bt[threads_to_create];
+            ND_THREAD *threads[threads_to_create];
+            for(size_t i = 0; i < threads_to_create ; i++) {
+                bt[i] = (struct string_benchmark_thread) {
+                    .stop = &stop,
+                    .names = names,
+                    .names_count = hot_names,
+                    .operations = 0,
+                };
+
+                char buf[100 + 1];
+                snprintf(buf, 100, "strbench%zu", i);
+                threads[i] = nd_thread_create(buf, NETDATA_THREAD_OPTION_DONT_LOG, string_benchmark_thread, &bt[i]);
+            }
+
+            sleep_usec(seconds_to_run * USEC_PER_SEC);
+            __atomic_store_n(&stop, true, __ATOMIC_RELAXED);
+
+            size_t operations = 0;
+            for(size_t i = 0; i < threads_to_create ; i++) {
+                nd_thread_join(threads[i]);
+                operations += bt[i].operations;
+            }
+
+            fprintf(stderr, "%s thread caches: %zu lookups/s (%zu per thread)\n",
+                    cached ? "with" : "without",
+                    operations / seconds_to_run, operations / seconds_to_run / threads_to_create);
+        }
+        __atomic_store_n(&string_thread_caches.disabled, false, __ATOMIC_RELAXED);
+
+        for(size_t i = 0; i < hot_names ; i++)
+            string_freez(held[i]);
+        freez(held);
+    }
+
     // threads testing of string
     {
         struct thread_unittest tu = {
@@ -929,6 +1218,12 @@ int string_unittest(size_t entries) {
                 inserts - oinserts, deletes - odeletes, searches - osearches, sentries - oentries, references - oreferences, memory - omemory, duplications - oduplications, releases - oreleases);
 
 #ifdef NETDATA_INTERNAL_CHECKS
+        // the threads have released their caches, so all their references are gone
+        if(references != oreferences) {
+            fprintf(stderr, "ERROR: the threads left %ld active references\n", (long)(references - oreferences));
+            errors++;
+        }
+
         size_t found_deleted_on_search = unittest_string_found_deleted_on_search(),
                found_available_on_search = unittest_string_found_available_on_search(),
                found_deleted_on_insert = unittest_string_found_deleted_on_insert(),
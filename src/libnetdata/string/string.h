@@ -46,6 +46,9 @@ int string_unittest(size_t entries);
 
 void string_init(void);
 
+// release the references the calling thread keeps on recently used strings
+void string_thread_cache_release(void);
+
 static inline void cleanup_string_pp(STRING **stringpp) {
     if(stringpp)
         string_freez(*stringpp);
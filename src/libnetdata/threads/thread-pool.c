@@ -0,0 +1,189 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "libnetdata/libnetdata.h"
+
+struct nd_thread_pool {
+    size_t threads;                 // the threads of the pool, in addition to the calling thread
+    ND_THREAD **thread;
+    void (*thread_init)(void);
+    size_t worker_job;
+
+    netdata_mutex_t mutex;
+    netdata_cond_t start_cond;      // the threads wait here for the next run
+    netdata_cond_t done_cond;       // the calling thread waits here for the threads
+    size_t iteration;
+    size_t running;                 // the threads still working on this run
+    bool stop;
+
+    // the current run
+    size_t items;
+    size_t batch;
+    nd_thread_pool_work_t work;
+    void *data;
+    size_t next;                    // atomic, the first item of the next batch
+};
+
+static void nd_thread_pool_run_batches(ND_THREAD_POOL *pool) {
+    while(true) {
+        size_t first = __atomic_fetch_add(&pool->next, pool->batch, __ATOMIC_RELAXED);
+        if(first >= pool->items)
+            break;
+
+        size_t last = MIN(first + pool->batch, pool->items);
+        for(size_t i = first; i < last ; i++)
+            pool->work(i, pool->data);
+    }
+}
+
+static void nd_thread_pool_thread(void *ptr) {
+    ND_THREAD_POOL *pool = ptr;
+
+    if(pool->thread_init)
+        pool->thread_init();
+
+    size_t iteration = 0;
+
+    while(true) {
+        worker_is_idle();
+
+        netdata_mutex_lock(&pool->mutex);
+        while(!pool->stop && pool->iteration == iteration)
+            netdata_cond_wait(&pool->start_cond, &pool->mutex);
+
+        bool stop = pool->stop;
+        iteration = pool->iteration;
+        netdata_mutex_unlock(&pool->mutex);
+
+        if(stop)
+            break;
+
+        worker_is_busy(pool->worker_job);
+        nd_thread_pool_run_batches(pool);
+
+        netdata_mutex_lock(&pool->mutex);
+        if(--pool->running == 0)
+            netdata_cond_signal(&pool->done_cond);
+        netdata_mutex_unlock(&pool->mutex);
+    }
+}
+
+ND_THREAD_POOL *nd_thread_pool_create(const char *tag, size_t threads, void (*thread_init)(void), size_t worker_job) {
+    ND_THREAD_POOL *pool = callocz(1, sizeof(*pool));
+    pool->thread_init = thread_init;
+    pool->worker_job = worker_job;
+
+    if(!threads)
+        return pool;
+
+    netdata_mutex_init(&pool->mutex);
+    netdata_cond_init(&pool->start_cond);
+    netdata_cond_init(&pool->done_cond);
+
+    pool->thread = callocz(threads, sizeof(ND_THREAD *));
+    for(size_t i = 0; i < threads ; i++) {
+        char thread_tag[ND_THREAD_TAG_MAX + 1];
+        snprintfz(thread_tag, ND_THREAD_TAG_MAX, "%s[%zu]", tag, i);
+        pool->thread[i] = nd_thread_create(thread_tag, NETDATA_THREAD_OPTION_DEFAULT, nd_thread_pool_thread, pool);
+        if(!pool->thread[i]) {
+            nd_log(NDLS_DAEMON, NDLP_ERR, "THREAD POOL: cannot create thread %zu of pool '%s'", i, tag);
+            break;
+        }
+        pool->threads++;
+    }
+
+    return pool;
+}
+
+void nd_thread_pool_destroy(ND_THREAD_POOL *pool) {
+    if(!pool)
+        return;
+
+    if(pool->thread) {
+        netdata_mutex_lock(&pool->mutex);
+        pool->stop = true;
+        netdata_cond_broadcast(&pool->start_cond);
+        netdata_mutex_unlock(&pool->mutex);
+
+        for(size_t i = 0; i < pool->threads ; i++)
+            nd_thread_join(pool->thread[i]);
+
+        netdata_cond_destroy(&pool->done_cond);
+        netdata_cond_destroy(&pool->start_cond);
+        netdata_mutex_destroy(&pool->mutex);
+        freez(pool->thread);
+    }
+
+    freez(pool);
+}
+
+size_t nd_thread_pool_threads(ND_THREAD_POOL *pool) {
+    return pool ? pool->threads : 0;
+}
+
+void nd_thread_pool_run(ND_THREAD_POOL *pool, size_t items, size_t batch, nd_thread_pool_work_t work, void *data) {
+    if(!pool->threads) {
+        for(size_t i = 0; i < items ; i++)
+            work(i, data);
+        return;
+    }
+
+    // the threads are waiting, so the run can be set without the lock
+    pool->items = items;
+    pool->batch = batch ? batch : 1;
+    pool->work = work;
+    pool->data = data;
+    __atomic_store_n(&pool->next, 0, __ATOMIC_RELAXED);
+
+    netdata_mutex_lock(&pool->mutex);
+    pool->running = pool->threads;
+    pool->iteration++;
+    netdata_cond_broadcast(&pool->start_cond);
+    netdata_mutex_unlock(&pool->mutex);
+
+    nd_thread_pool_run_batches(pool);
+
+    netdata_mutex_lock(&pool->mutex);
+    while(pool->running)
+        netdata_cond_wait(&pool->done_cond, &pool->mutex);
+    netdata_mutex_unlock(&pool->mutex);
+}
+
+// ----------------------------------------------------------------------------
+// unittest
+
+static void nd_thread_pool_unittest_work(size_t item, void *data) {
+    size_t *runs = data;
+    __atomic_add_fetch(&runs[item], 1, __ATOMIC_RELAXED);
+}
+
+int nd_thread_pool_unittest(void) {
+    int errors = 0;
+
+    fprintf(stderr, "\nTesting thread pools...\n");
+
+    size_t runs[1000];
+    for(size_t threads = 0; threads <= 3 ; threads += 3) {
+        ND_THREAD_POOL *pool = nd_thread_pool_create("TPTEST", threads, NULL, WORKER_UTILIZATION_MAX_JOB_TYPES);
+        if(nd_thread_pool_threads(pool) != threads) {
+            fprintf(stderr, "THREAD POOL: the pool has %zu threads, expected %zu\n", nd_thread_pool_threads(pool), threads);
+            errors++;
+        }
+
+        memset(runs, 0, sizeof(runs));
+        for(size_t iteration = 0; iteration < 10 ; iteration++)
+            nd_thread_pool_run(pool, _countof(runs), 7, nd_thread_pool_unittest_work, runs);
+
+        for(size_t i = 0; i < _countof(runs) ; i++) {
+            if(runs[i] != 10) {
+                fprintf(stderr, "THREAD POOL: with %zu threads, item %zu run %zu times, expected 10\n", threads, i, runs[i]);
+                errors++;
+                break;
+            }
+        }
+
+        nd_thread_pool_destroy(pool);
+    }
+
+    fprintf(stderr, "THREAD POOL: %d errors\n", errors);
+    return errors;
+}
@@ -0,0 +1,33 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef NETDATA_THREAD_POOL_H
+#define NETDATA_THREAD_POOL_H
+
+#include "libnetdata/common.h"
+
+// A fixed set of threads that work together with the calling thread.
+//
+// On every run, the items 0 to items - 1 are picked in batches by the threads of
+// the pool and the calling thread, and the run returns when all of them are done.
+// Each item is run by exactly one thread, so the items need no locking, as long as
+// they are independent of each other.
+// A pool with no threads runs all the items on the calling thread.
+
+typedef struct nd_thread_pool ND_THREAD_POOL;
+
+typedef void (*nd_thread_pool_work_t)(size_t item, void *data);
+
+// the threads are named tag[N]
+// thread_init is called once by each thread of the pool (e.g. to register it as a worker)
+// the threads of the pool are busy with worker_job while running items (WORKER_UTILIZATION_MAX_JOB_TYPES for none)
+ND_THREAD_POOL *nd_thread_pool_create(const char *tag, size_t threads, void (*thread_init)(void), size_t worker_job);
+void nd_thread_pool_destroy(ND_THREAD_POOL *pool);
+
+// the threads of the pool, in addition to the calling thread
+size_t nd_thread_pool_threads(ND_THREAD_POOL *pool);
+
+void nd_thread_pool_run(ND_THREAD_POOL *pool, size_t items, size_t batch, nd_thread_pool_work_t work, void *data);
+
+int nd_thread_pool_unittest(void);
+
+#endif //NETDATA_THREAD_POOL_H
@@ -330,6 +330,8 @@ static void nd_thread_exit(ND_THREAD *nti) {
     thread_cache_destroy();
     service_exits();
     worker_unregister();
+    string_thread_cache_release();
+    aral_thread_cache_release();
 
     nd_thread_status_set(nti, NETDATA_THREAD_STATUS_FINISHED);
 
@@ -238,11 +238,15 @@ fail_cleanup:
 
 inline bool
 url_is_request_complete_and_extract_payload(const char *begin, const char *end, size_t length, BUFFER **post_payload) {
-    if (begin == end || length < 4)
+    if (length < 4)
         return false;
 
+    // search for the header end a few bytes before the new data;
+    // when end == begin the whole request is searched
+    const char *search = (end - begin > 4) ? end - 4 : begin;
+
     if(likely(strncmp(begin, "GET ", 4)) == 0) {
-        return strstr(end - 4, "\r\n\r\n");
+        return strstr(search, "\r\n\r\n");
     }
     else if(unlikely(strncmp(begin, "POST ", 5) == 0 || strncmp(begin, "PUT ", 4) == 0)) {
         const char *cl = strcasestr(begin, "Content-Length: ");
@@ -257,11 +261,12 @@ url_is_request_complete_and_extract_payload(const char *begin, const char *end,
 
         size_t payload_length = length - (payload - begin);
 
-        if(payload_length == content_length) {
+        // with pipelining, the next request may follow the payload
+        if(payload_length >= content_length) {
             if(!*post_payload)
-                *post_payload = buffer_create(payload_length + 1, NULL);
+                *post_payload = buffer_create(content_length + 1, NULL);
 
-            buffer_contents_replace(*post_payload, payload, payload_length);
+            buffer_contents_replace(*post_payload, payload, content_length);
 
             // parse the content type
             const char *ct = strcasestr(begin, "Content-Type: ");
@@ -287,7 +292,7 @@ url_is_request_complete_and_extract_payload(const char *begin, const char *end,
         return false;
     }
     else {
-        return strstr(end - 4, "\r\n\r\n");
+        return strstr(search, "\r\n\r\n");
     }
 }
 
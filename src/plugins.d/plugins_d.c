@@ -130,10 +130,26 @@ static void pluginsd_worker_thread(void *arg) {
     size_t count = 0;
 
     while(service_running(SERVICE_COLLECTORS)) {
-        cd->unsafe.pi = spawn_popen_run(string2str(cd->cmd));
+        const char *cmd = string2str(cd->cmd);
+        char cmd_with_ring[PLUGINSD_CMD_MAX + NAME_MAX + sizeof(SHM_RING_ENV) + 3];
+
+        if(cd->shm_ring_size) {
+            // offer the plugin a shared memory ring - plugins that do not support it ignore it
+            char name[NAME_MAX + 1];
+            snprintfz(name, sizeof(name), "/netdata-%d-%s", getpid(), string2str(cd->filename));
+            cd->shm_ring = shm_ring_create(name, cd->shm_ring_size);
+            if(cd->shm_ring) {
+                snprintfz(cmd_with_ring, sizeof(cmd_with_ring), SHM_RING_ENV "=%s %s", name, cmd);
+                cmd = cmd_with_ring;
+            }
+        }
+
+        cd->unsafe.pi = spawn_popen_run(cmd);
         if(!cd->unsafe.pi) {
             netdata_log_error("PLUGINSD: 'host:%s', cannot popen(\"%s\", \"r\").",
-                              rrdhost_hostname(cd->host), string2str(cd->cmd));
+                              rrdhost_hostname(cd->host), cmd);
+            shm_ring_close(cd->shm_ring);
+            cd->shm_ring = NULL;
             break;
         }
         cd->unsafe.pid = spawn_popen_pid(cd->unsafe.pi);
@@ -171,6 +187,9 @@ static void pluginsd_worker_thread(void *arg) {
         int worker_ret_code = spawn_popen_kill(cd->unsafe.pi, 3 * MSEC_PER_SEC);
         cd->unsafe.pi = NULL;
 
+        shm_ring_close(cd->shm_ring);
+        cd->shm_ring = NULL;
+
         if(likely(worker_ret_code == 0))
             pluginsd_worker_thread_handle_success(cd);
         else
@@ -383,6 +402,9 @@ void *pluginsd_main(void *ptr) {
                     cd->unsafe.running = false;
 
                     cd->update_every = (int)inicfg_get_duration_seconds(&netdata_config, string2str(cd->id), "update every", localhost->rrd_update_every);
+
+                    if(inicfg_get_boolean(&netdata_config, string2str(cd->id), "shared memory transport", CONFIG_BOOLEAN_YES))
+                        cd->shm_ring_size = (size_t)inicfg_get_size_bytes(&netdata_config, string2str(cd->id), "shared memory transport buffer", SHM_RING_DEFAULT_SIZE);
                     cd->started_t = now_realtime_sec();
 
                     {
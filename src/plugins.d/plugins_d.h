@@ -28,6 +28,9 @@ struct plugind {
     struct rrdhost *host;               // the host the plugin collects data for
     int update_every;                   // the plugin default data collection frequency
 
+    size_t shm_ring_size;               // the shared memory transport offered to the plugin, 0 = disabled
+    SHM_RING *shm_ring;                 // the shared memory ring of the running plugin
+
     struct {
         SPINLOCK spinlock;
         bool running;                  // do not touch this structure after setting this to 1
@@ -37,9 +37,9 @@ static inline RRDSET *pluginsd_get_scope_chart(PARSER *parser) {
     return parser->user.st;
 }
 
-static inline void rrdset_data_collection_lock_with_trace(PARSER *parser, const char *func) {
+static inline void rrdset_data_collection_lock_with_trace(PARSER *parser, const char *func, const char *file, uint32_t line) {
     if(parser->user.st && !parser->user.v2.locked_data_collection) {
-        spinlock_lock_with_trace(&parser->user.st->data_collection_lock, func);
+        spinlock_lock_with_trace(&parser->user.st->data_collection_lock, func, file, line);
         parser->user.v2.locked_data_collection = true;
     }
 }
@@ -54,7 +54,7 @@ static inline bool rrdset_data_collection_unlock_with_trace(PARSER *parser, cons
     return false;
 }
 
-#define rrdset_data_collection_lock(parser) rrdset_data_collection_lock_with_trace(parser, __FUNCTION__)
+#define rrdset_data_collection_lock(parser) rrdset_data_collection_lock_with_trace(parser, __FUNCTION__, __FILE__, __LINE__)
 #define rrdset_data_collection_unlock(parser) rrdset_data_collection_unlock_with_trace(parser, __FUNCTION__)
 
 static ALWAYS_INLINE void rrdset_previous_scope_chart_unlock(PARSER *parser, const char *keyword, bool stale) {
@@ -191,7 +191,7 @@ static ALWAYS_INLINE RRDDIM *pluginsd_acquire_dimension(RRDHOST *host, RRDSET *s
         rd = prd->rd;
         if(likely(rd)) {
 #ifdef NETDATA_INTERNAL_CHECKS
-            if(strcmp(prd->id, dimension) != 0) {
+            if(strcmp(prd->id, dimension) != 0 && !rrddim_option_check(rd, RRDDIM_OPTION_AGGREGATED)) {
                 ssize_t t;
                 for(t = 0; t < st->pluginsd.size ;t++) {
                     if (strcmp(st->pluginsd.prd_array[t].id, dimension) == 0)
@@ -238,6 +238,11 @@ static ALWAYS_INLINE RRDDIM *pluginsd_acquire_dimension(RRDHOST *host, RRDSET *s
     // we need to find the dimension and set it to prd
 
     RRDDIM_ACQUIRED *rda = rrddim_find_and_acquire(st, dimension, true);
+
+    // the dimension may have been aggregated, over the plugin's budget
+    if (unlikely(!rda && __atomic_load_n(&st->cost.dimensions_aggregated, __ATOMIC_RELAXED)))
+        rda = rrddim_find_and_acquire(st, RRDDIM_BUDGET_OVERFLOW_ID, true);
+
     if (unlikely(!rda)) {
         netdata_log_error("PLUGINSD: 'host:%s/chart:%s/dim:%s' got a %s but dimension does not exist.",
                           rrdhost_hostname(host), rrdset_id(st), dimension, cmd);
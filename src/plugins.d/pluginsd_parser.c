@@ -501,6 +501,13 @@ static inline PARSER_RC pluginsd_dimension(char **words, size_t num_words, PARSE
     if (unlikely(!rd))
         return PLUGINSD_DISABLE_PLUGIN(parser, PLUGINSD_KEYWORD_DIMENSION, "failed to create dimension");
 
+    // the dimension is aggregated over the plugin's budget: the aggregated dimension
+    // is shared by all its members, so the options of this one do not apply to it
+    if (unlikely(rrddim_option_check(rd, RRDDIM_OPTION_AGGREGATED))) {
+        pluginsd_rrddim_put_to_slot(parser, st, rd, slot, false);
+        return PARSER_RC_OK;
+    }
+
     int unhide_dimension = 1;
 
     rrddim_option_clear(rd, RRDDIM_OPTION_DONT_DETECT_RESETS_OR_OVERFLOWS);
@@ -1235,6 +1242,75 @@ bool parser_reconstruct_context(BUFFER *wb, void *ptr) {
     return true;
 }
 
+// get more data from the shared memory ring of the plugin
+// when it is empty, wait for the doorbell on the pipe - this also detects the plugin exiting
+static buffered_reader_ret_t pluginsd_shm_ring_read(PARSER *parser, SHM_RING *ring, struct buffered_reader *reader) {
+    while(true) {
+        ssize_t available = (ssize_t)sizeof(reader->read_buffer) - reader->read_len - 1;
+        if(unlikely(available <= 0))
+            return BUFFERED_READER_READ_BUFFER_FULL;
+
+        size_t bytes = shm_ring_read(ring, &reader->read_buffer[reader->read_len], available);
+        if(likely(bytes)) {
+            reader->read_len += (ssize_t)bytes;
+            reader->read_buffer[reader->read_len] = '\0';
+            return BUFFERED_READER_READ_OK;
+        }
+
+        if(!shm_ring_consumer_wait_begin(ring))
+            continue;
+
+        buffered_reader_ret_t ret = buffered_reader_read_timeout(
+                &parser->reader, parser->fd_input,
+                2 * 60 * MSEC_PER_SEC, true);
+
+        shm_ring_consumer_wait_end(ring);
+
+        // the pipe carries only doorbells now
+        buffered_reader_init(&parser->reader);
+
+        if(unlikely(ret != BUFFERED_READER_READ_OK))
+            return ret;
+    }
+}
+
+// get the next line of the plugin, from its pipe or from its shared memory ring
+// *line is NULL when more data had to be read - call it again
+// when the plugin sends the marker, ring_reader is allocated and the ring is read from then on
+static buffered_reader_ret_t pluginsd_read_line(PARSER *parser, SHM_RING *ring, struct buffered_reader **ring_reader, BUFFER *buffer, char **line) {
+    struct buffered_reader *reader = *ring_reader ? *ring_reader : &parser->reader;
+
+    if(unlikely(!buffered_reader_next_line_inplace(reader, buffer, line))) {
+        *line = NULL;
+
+        if(*ring_reader)
+            return pluginsd_shm_ring_read(parser, ring, *ring_reader);
+
+        return buffered_reader_read_timeout(
+                &parser->reader, parser->fd_input,
+                2 * 60 * MSEC_PER_SEC, true);
+    }
+
+    if(unlikely(ring && !*ring_reader && **line == SHM_RING_ACTIVE_MARKER[0] &&
+                 strcmp(*line, SHM_RING_ACTIVE_MARKER "\n") == 0)) {
+        nd_log(NDLS_COLLECTORS, NDLP_DEBUG,
+               "PLUGINSD: plugin switched to the shared memory transport (%zu bytes)",
+               shm_ring_size(ring));
+
+        *ring_reader = mallocz(sizeof(**ring_reader));
+        buffered_reader_init(*ring_reader);
+
+        // anything after the marker on the pipe is a doorbell
+        buffered_reader_init(&parser->reader);
+
+        buffer->len = 0;
+        buffer->buffer[0] = '\0';
+        *line = NULL;
+    }
+
+    return BUFFERED_READER_READ_OK;
+}
+
 inline size_t pluginsd_process(RRDHOST *host, struct plugind *cd, int fd_input, int fd_output, int trust_durations)
 {
     int enabled = cd->unsafe.enabled;
@@ -1274,24 +1350,26 @@ inline size_t pluginsd_process(RRDHOST *host, struct plugind *cd, int fd_input,
     buffered_reader_init(&parser->reader);
     CLEAN_BUFFER *buffer = buffer_create(sizeof(parser->reader.read_buffer) + 2, NULL);
     bool send_quit = true;
-    while(likely(service_running(SERVICE_COLLECTORS))) {
+    char *line;
 
-        if(unlikely(!buffered_reader_next_line(&parser->reader, buffer))) {
-            buffered_reader_ret_t ret = buffered_reader_read_timeout(
-                    &parser->reader, parser->fd_input,
-                    2 * 60 * MSEC_PER_SEC, true);
+    // when the plugin switches to the shared memory ring,
+    // the lines are read from it, into ring_reader
+    SHM_RING *ring = cd->shm_ring;
+    struct buffered_reader *ring_reader = NULL;
 
-            if(unlikely(ret != BUFFERED_READER_READ_OK)) {
-                nd_log(NDLS_COLLECTORS, NDLP_INFO, "PLUGINSD: buffered reader not OK (%d)", ret);
-                if(ret == BUFFERED_READER_READ_POLLERR || ret == BUFFERED_READER_READ_POLLHUP)
-                    send_quit = false;
-                break;
-            }
+    while(likely(service_running(SERVICE_COLLECTORS))) {
+        buffered_reader_ret_t ret = pluginsd_read_line(parser, ring, &ring_reader, buffer, &line);
+        if(unlikely(ret != BUFFERED_READER_READ_OK)) {
+            nd_log(NDLS_COLLECTORS, NDLP_INFO, "PLUGINSD: buffered reader not OK (%d)", ret);
+            if(ret == BUFFERED_READER_READ_POLLERR || ret == BUFFERED_READER_READ_POLLHUP)
+                send_quit = false;
+            break;
+        }
 
+        if(!line)
             continue;
-        }
 
-        if(unlikely(parser_action(parser, buffer->buffer)))
+        if(unlikely(parser_action(parser, line)))
             break;
 
         buffer->len = 0;
@@ -1306,6 +1384,8 @@ inline size_t pluginsd_process(RRDHOST *host, struct plugind *cd, int fd_input,
         send_to_plugin(PLUGINSD_CALL_QUIT, parser, STREAM_TRAFFIC_TYPE_METADATA);
     }
 
+    freez(ring_reader);
+
     cd->unsafe.enabled = parser->user.enabled;
     count = parser->user.data_collections_count;
 
@@ -1444,6 +1524,223 @@ void parser_init_repertoire(PARSER *parser, PARSER_REPERTOIRE repertoire) {
     }
 }
 
+// simulate read() on the reader, from an in-memory stream
+static size_t pluginsd_parser_unittest_feed(struct buffered_reader *reader, const char *stream, size_t stream_len, size_t *offset, size_t chunk) {
+    size_t available = sizeof(reader->read_buffer) - reader->read_len - 1;
+    size_t bytes = MIN(MIN(chunk, available), stream_len - *offset);
+    memcpy(&reader->read_buffer[reader->read_len], &stream[*offset], bytes);
+    reader->read_len += (ssize_t)bytes;
+    reader->read_buffer[reader->read_len] = '\0';
+    *offset += bytes;
+    return bytes;
+}
+
+static int pluginsd_parser_unittest_reader(void) {
+    const char *lines =
+            "BEGIN2 abcdefghijklmnopqr 123\n"
+            "SET2 abcdefg 0x12345678 0 0\n"
+            "SET2 hijklmnoqr 0x12345678 0 0\n"
+            "SET2 stuvwxyz 0x12345678 0 0\n"
+            "END2\n";
+
+    size_t lines_len = strlen(lines);
+    size_t long_line_len = PLUGINSD_LINE_MAX + 100;
+    size_t stream_size = 64 * 1024 * 1024;
+    char *stream = mallocz(stream_size + long_line_len + 2);
+
+    size_t stream_len = 0;
+    while(stream_len + lines_len <= stream_size) {
+        memcpy(&stream[stream_len], lines, lines_len);
+        stream_len += lines_len;
+    }
+
+    // a line that does not fit in the read buffer
+    memset(&stream[stream_len], 'x', long_line_len);
+    stream_len += long_line_len;
+    stream[stream_len++] = '\n';
+    stream[stream_len] = '\0';
+
+    struct {
+        const char *name;
+        bool inplace;
+        size_t lines;
+        size_t bytes;
+        uint32_t checksum;
+        usec_t ut;
+    } runs[] = {
+            { .name = "copy", .inplace = false, },
+            { .name = "in-place", .inplace = true, },
+    };
+
+    struct buffered_reader reader;
+    CLEAN_BUFFER *buffer = buffer_create(sizeof(reader.read_buffer) + 2, NULL);
+
+    for(size_t r = 0; r < _countof(runs); r++) {
+        buffered_reader_init(&reader);
+        buffer_flush(buffer);
+
+        size_t offset = 0;
+        usec_t started = now_monotonic_usec();
+        while(true) {
+            char *line;
+            bool got_line;
+
+            if(runs[r].inplace)
+                got_line = buffered_reader_next_line_inplace(&reader, buffer, &line);
+            else {
+                got_line = buffered_reader_next_line(&reader, buffer);
+                line = buffer->buffer;
+            }
+
+            if(!got_line) {
+                // odd sized chunks, to have lines split across reads
+                if(!pluginsd_parser_unittest_feed(&reader, stream, stream_len, &offset, 65521))
+                    break;
+                continue;
+            }
+
+            size_t len = strlen(line);
+            runs[r].lines++;
+            runs[r].bytes += len;
+            runs[r].checksum = runs[r].checksum * 31 + (uint32_t)len + (uint8_t)line[0] + (uint8_t)line[len - 1];
+
+            buffer->len = 0;
+            buffer->buffer[0] = '\0';
+        }
+        runs[r].ut = now_monotonic_usec() - started;
+
+        netdata_log_info("Read %zu lines (%zu bytes) with the %s reader in %0.2f secs, %0.2f MiB/sec",
+             runs[r].lines, runs[r].bytes, runs[r].name,
+             (double)runs[r].ut / (double)USEC_PER_SEC,
+             (double)runs[r].bytes / 1024.0 / 1024.0 / ((double)MAX(runs[r].ut, 1) / (double)USEC_PER_SEC));
+    }
+
+    freez(stream);
+
+    int errors = 0;
+    for(size_t r = 0; r < _countof(runs); r++) {
+        if(runs[r].bytes != stream_len || runs[r].lines != runs[0].lines || runs[r].checksum != runs[0].checksum) {
+            netdata_log_error("The %s reader returned %zu lines, %zu bytes, checksum %u - expected %zu lines, %zu bytes, checksum %u",
+                              runs[r].name, runs[r].lines, runs[r].bytes, runs[r].checksum,
+                              runs[0].lines, stream_len, runs[0].checksum);
+            errors++;
+        }
+    }
+
+    return errors;
+}
+
+#if defined(OS_LINUX)
+#define PLUGINSD_SHM_RING_UNITTEST_LINES 200000
+
+// a plugin in a child process: one line on the pipe, then the switch to the ring,
+// then all the other lines on the ring, through a ring small enough to wrap and fill up
+static void pluginsd_parser_unittest_shm_ring_plugin(int fd, const char *name) {
+    if(dup2(fd, STDOUT_FILENO) == -1)
+        _exit(1);
+
+    setenv(SHM_RING_ENV, name, 1);
+
+    fprintf(stdout, "BEFORE\n");
+    fflush(stdout);
+
+    if(!shm_ring_stdout() || getenv(SHM_RING_ENV))
+        _exit(1);
+
+    for(size_t i = 0; i < PLUGINSD_SHM_RING_UNITTEST_LINES; i++)
+        fprintf(stdout, "LINE %zu\n", i);
+
+    fflush(stdout);
+    _exit(0);
+}
+
+static int pluginsd_parser_unittest_shm_ring(void) {
+    char name[NAME_MAX + 1];
+    snprintfz(name, sizeof(name), "/netdata-pluginsd-unittest-%d", getpid());
+
+    SHM_RING *ring = shm_ring_create(name, 4096);
+    if(!ring) {
+        netdata_log_error("PLUGINSD: cannot create shared memory ring '%s'", name);
+        return 1;
+    }
+
+    int pipefds[2];
+    if(pipe(pipefds) != 0) {
+        shm_ring_close(ring);
+        return 1;
+    }
+
+    fflush(stdout);
+    pid_t pid = fork();
+    if(pid == 0) {
+        close(pipefds[0]);
+        pluginsd_parser_unittest_shm_ring_plugin(pipefds[1], name);
+    }
+    close(pipefds[1]);
+
+    int errors = 0;
+    if(pid == -1) {
+        netdata_log_error("PLUGINSD: cannot fork the shared memory ring plugin");
+        errors++;
+    }
+
+    PARSER *parser = parser_init(NULL, pipefds[0], -1, PARSER_INPUT_SPLIT, NULL);
+    buffered_reader_init(&parser->reader);
+    CLEAN_BUFFER *buffer = buffer_create(sizeof(parser->reader.read_buffer) + 2, NULL);
+    struct buffered_reader *ring_reader = NULL;
+    size_t lines = 0, ring_lines = 0;
+    char expected[100];
+
+    while(pid > 0 && !errors) {
+        char *line;
+        buffered_reader_ret_t ret = pluginsd_read_line(parser, ring, &ring_reader, buffer, &line);
+        if(ret != BUFFERED_READER_READ_OK)
+            break;
+
+        if(!line)
+            continue;
+
+        if(!lines)
+            strncpyz(expected, "BEFORE\n", sizeof(expected) - 1);
+        else
+            snprintfz(expected, sizeof(expected), "LINE %zu\n", lines - 1);
+
+        if(strcmp(line, expected) != 0) {
+            netdata_log_error("PLUGINSD: expected line '%s', got '%s'", expected, line);
+            errors++;
+        }
+
+        if(ring_reader)
+            ring_lines++;
+
+        lines++;
+        buffer->len = 0;
+        buffer->buffer[0] = '\0';
+    }
+
+    // the plugin sees the agent is gone, when it is blocked on a full ring
+    close(pipefds[0]);
+
+    int status = 0;
+    if(pid > 0 && (waitpid(pid, &status, 0) != pid || !WIFEXITED(status) || WEXITSTATUS(status) != 0)) {
+        netdata_log_error("PLUGINSD: the shared memory ring plugin failed");
+        errors++;
+    }
+
+    if(lines != PLUGINSD_SHM_RING_UNITTEST_LINES + 1 || ring_lines != PLUGINSD_SHM_RING_UNITTEST_LINES) {
+        netdata_log_error("PLUGINSD: got %zu lines, %zu of them on the ring - expected %d lines, %d on the ring",
+                          lines, ring_lines, PLUGINSD_SHM_RING_UNITTEST_LINES + 1, PLUGINSD_SHM_RING_UNITTEST_LINES);
+        errors++;
+    }
+
+    freez(ring_reader);
+    parser_destroy(parser);
+    shm_ring_close(ring);
+
+    return errors;
+}
+#endif
+
 int pluginsd_parser_unittest(void) {
     PARSER *p = parser_init(NULL, -1, -1, PARSER_INPUT_SPLIT, NULL);
     pluginsd_keywords_init(p, PARSER_INIT_PLUGINSD | PARSER_INIT_STREAMING);
@@ -1481,5 +1778,10 @@ int pluginsd_parser_unittest(void) {
          (double)count / ((double)(ended - started) / (double)USEC_PER_SEC) / 1000.0);
 
     parser_destroy(p);
-    return 0;
+
+    int errors = pluginsd_parser_unittest_reader();
+#if defined(OS_LINUX)
+    errors += pluginsd_parser_unittest_shm_ring();
+#endif
+    return errors;
 }
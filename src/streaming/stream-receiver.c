@@ -594,6 +594,7 @@ stream_receive_and_process(struct stream_thread *sth, struct receiver_state *rpt
     *removed = false;
 
     ssize_t rc;
+    char *line;
     if(rpt->thread.compressed.enabled) {
         rc = receiver_read_compressed(rpt);
         if(unlikely(rc <= 0))
@@ -613,8 +614,8 @@ stream_receive_and_process(struct stream_thread *sth, struct receiver_state *rpt
                     if (likely(decompress_rc == DECOMPRESS_OK)) {
                         // loop through all the complete lines found in the uncompressed buffer
 
-                        while (buffered_reader_next_line(&rpt->thread.uncompressed, rpt->thread.line_buffer)) {
-                            if (unlikely(parser_action(parser, rpt->thread.line_buffer->buffer))) {
+                        while (buffered_reader_next_line_inplace(&rpt->thread.uncompressed, rpt->thread.line_buffer, &line)) {
+                            if (unlikely(parser_action(parser, line))) {
                                 stream_receiver_remove(sth, rpt, STREAM_HANDSHAKE_RCV_DISCONNECT_PARSER_FAILED);
                                 *removed = true;
                                 return -1;
@@ -654,8 +655,8 @@ stream_receive_and_process(struct stream_thread *sth, struct receiver_state *rpt
         if(rc <= 0)
             return rc;
 
-        while(buffered_reader_next_line(&rpt->thread.uncompressed, rpt->thread.line_buffer)) {
-            if(unlikely(parser_action(parser, rpt->thread.line_buffer->buffer))) {
+        while(buffered_reader_next_line_inplace(&rpt->thread.uncompressed, rpt->thread.line_buffer, &line)) {
+            if(unlikely(parser_action(parser, line))) {
                 stream_receiver_remove(sth, rpt, STREAM_HANDSHAKE_RCV_DISCONNECT_PARSER_FAILED);
                 *removed = true;
                 return -1;
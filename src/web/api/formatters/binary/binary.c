@@ -0,0 +1,165 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "binary.h"
+
+// the layout of the output is described in README.md - all numbers are little endian
+// and every column starts at an offset that is a multiple of 8 bytes, so that clients
+// can map the columns directly to typed arrays (the buffer itself may not be aligned,
+// so we always store with memcpy())
+
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+#define binary_le16(x) __builtin_bswap16(x)
+#define binary_le32(x) __builtin_bswap32(x)
+#define binary_le64(x) __builtin_bswap64(x)
+#else
+#define binary_le16(x) (x)
+#define binary_le32(x) (x)
+#define binary_le64(x) (x)
+#endif
+
+struct binary_writer {
+    BUFFER *wb;
+
+    // the total bytes written so far - the buffer may be drained while
+    // we generate the output, so its length cannot be used for alignment
+    size_t offset;
+};
+
+static inline void *binary_reserve(struct binary_writer *bw, size_t bytes) {
+    buffer_need_bytes(bw->wb, bytes);
+    void *p = &bw->wb->buffer[bw->wb->len];
+    bw->wb->len += bytes;
+    bw->offset += bytes;
+    return p;
+}
+
+static inline void binary_add_u16(struct binary_writer *bw, uint16_t v) {
+    v = binary_le16(v);
+    memcpy(binary_reserve(bw, sizeof(v)), &v, sizeof(v));
+}
+
+static inline void binary_add_u32(struct binary_writer *bw, uint32_t v) {
+    v = binary_le32(v);
+    memcpy(binary_reserve(bw, sizeof(v)), &v, sizeof(v));
+}
+
+static inline void binary_add_i64(struct binary_writer *bw, int64_t v) {
+    uint64_t u = binary_le64((uint64_t)v);
+    memcpy(binary_reserve(bw, sizeof(u)), &u, sizeof(u));
+}
+
+static inline void binary_add_string(struct binary_writer *bw, STRING *s) {
+    size_t len = string_strlen(s);
+    if(len > UINT16_MAX) len = UINT16_MAX;
+
+    binary_add_u16(bw, (uint16_t)len);
+    if(len)
+        memcpy(binary_reserve(bw, len), string2str(s), len);
+}
+
+static inline void binary_align(struct binary_writer *bw) {
+    size_t pad = (8 - (bw->offset & 7)) & 7;
+    if(pad)
+        memset(binary_reserve(bw, pad), 0, pad);
+}
+
+static inline bool binary_checkpoint(struct binary_writer *bw) {
+    binary_align(bw);
+    return buffer_drain_checkpoint(bw->wb);
+}
+
+void rrdr2binary(RRDR *r, BUFFER *wb, RRDR_OPTIONS options) {
+    struct binary_writer bw = { .wb = wb, .offset = 0 };
+
+    const long rows = rrdr_rows(r);
+    const long used = (long)r->d;
+
+    long start = 0, end = rows, step = 1;
+    if(!(options & RRDR_OPTION_REVERSED)) {
+        start = rows - 1;
+        end = -1;
+        step = -1;
+    }
+
+    uint32_t dimensions = 0;
+    for(long d = 0; d < used ; d++)
+        if(rrdr_dimension_should_be_exposed(r->od[d], options))
+            dimensions++;
+
+    uint16_t flags = 0;
+    if(!(options & RRDR_OPTION_REVERSED))
+        flags |= RRDR_BINARY_FLAG_NEWEST_FIRST;
+    if(options & RRDR_OPTION_NULL2ZERO)
+        flags |= RRDR_BINARY_FLAG_NULL2ZERO;
+
+    // the header
+    memcpy(binary_reserve(&bw, 4), RRDR_BINARY_MAGIC, 4);
+    binary_add_u16(&bw, RRDR_BINARY_VERSION);
+    binary_add_u16(&bw, flags);
+    binary_add_u32(&bw, dimensions);
+    binary_add_u32(&bw, (uint32_t)rows);
+    binary_add_i64(&bw, r->view.after);
+    binary_add_i64(&bw, r->view.before);
+    binary_add_i64(&bw, r->view.update_every);
+
+    // the dimensions table
+    for(long d = 0; d < used ; d++) {
+        if(!rrdr_dimension_should_be_exposed(r->od[d], options))
+            continue;
+
+        binary_add_string(&bw, r->di[d]);
+        binary_add_string(&bw, r->dn[d]);
+    }
+
+    if(unlikely(!binary_checkpoint(&bw)))
+        return;
+
+    // the timestamps column
+    {
+        uint8_t *t = binary_reserve(&bw, rows * sizeof(uint64_t));
+        for(long i = start; i != end ; i += step, t += sizeof(uint64_t)) {
+            uint64_t u = binary_le64((uint64_t)r->t[i]);
+            memcpy(t, &u, sizeof(u));
+        }
+
+        if(unlikely(!binary_checkpoint(&bw)))
+            return;
+    }
+
+    // the columns of each dimension: values, anomaly rates, point annotations
+    for(long d = 0; d < used ; d++) {
+        if(!rrdr_dimension_should_be_exposed(r->od[d], options))
+            continue;
+
+        uint8_t *v = binary_reserve(&bw, rows * sizeof(uint64_t));
+        for(long i = start; i != end ; i += step, v += sizeof(uint64_t)) {
+            NETDATA_DOUBLE n = r->v[i * used + d];
+
+            if(r->o[i * used + d] & RRDR_VALUE_EMPTY)
+                n = (options & RRDR_OPTION_NULL2ZERO) ? 0.0 : NAN;
+
+            double dbl = (double)n;
+            uint64_t u;
+            memcpy(&u, &dbl, sizeof(u));
+            u = binary_le64(u);
+            memcpy(v, &u, sizeof(u));
+        }
+
+        uint8_t *ar = binary_reserve(&bw, rows * sizeof(uint32_t));
+        for(long i = start; i != end ; i += step, ar += sizeof(uint32_t)) {
+            float f = (float)r->ar[i * used + d];
+            uint32_t u;
+            memcpy(&u, &f, sizeof(u));
+            u = binary_le32(u);
+            memcpy(ar, &u, sizeof(u));
+        }
+        binary_align(&bw);
+
+        uint8_t *o = binary_reserve(&bw, rows * sizeof(uint8_t));
+        for(long i = start; i != end ; i += step)
+            *o++ = (uint8_t)r->o[i * used + d];
+
+        if(unlikely(!binary_checkpoint(&bw)))
+            return;
+    }
+}
@@ -0,0 +1,18 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef NETDATA_API_FORMATTER_BINARY_H
+#define NETDATA_API_FORMATTER_BINARY_H
+
+#include "../rrd2json.h"
+
+#define RRDR_BINARY_MAGIC "NDCB"
+#define RRDR_BINARY_VERSION 1
+
+typedef enum __attribute__((packed)) {
+    RRDR_BINARY_FLAG_NEWEST_FIRST       = (1 << 0), // rows are ordered newer to older
+    RRDR_BINARY_FLAG_NULL2ZERO          = (1 << 1), // empty points have a zero value, instead of NaN
+} RRDR_BINARY_FLAGS;
+
+void rrdr2binary(RRDR *r, BUFFER *wb, RRDR_OPTIONS options);
+
+#endif //NETDATA_API_FORMATTER_BINARY_H
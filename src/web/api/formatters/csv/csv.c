@@ -104,6 +104,9 @@ void rrdr2csv(RRDR *r, BUFFER *wb, uint32_t format, RRDR_OPTIONS options, const
         }
 
         buffer_strcat(wb, endline);
+
+        if(unlikely(!buffer_drain_checkpoint(wb)))
+            break;
     }
     //netdata_log_info("RRD2CSV(): %s: END", r->st->id);
 }
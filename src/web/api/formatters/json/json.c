@@ -151,10 +151,12 @@ void rrdr2json(RRDR *r, BUFFER *wb, RRDR_OPTIONS options, int datatable) {
 
     // pre-allocate a large enough buffer for us
     // this does not need to be accurate - it is just a hint to avoid multiple realloc().
-    buffer_need_bytes(wb,
-                      ( 20 * rrdr_rows(r)) // timestamp + json overhead
-                    + ( (pre_value_len + post_value_len + 4) * total_number_of_dimensions * rrdr_rows(r) ) // number
-                      );
+    // when the buffer is drained while being generated, it never holds the whole output
+    if(!buffer_drain_enabled(wb))
+        buffer_need_bytes(wb,
+                          ( 20 * rrdr_rows(r)) // timestamp + json overhead
+                        + ( (pre_value_len + post_value_len + 4) * total_number_of_dimensions * rrdr_rows(r) ) // number
+                          );
 
     // for each line in the array
     for(i = start; i != end ;i += step) {
@@ -257,6 +259,9 @@ void rrdr2json(RRDR *r, BUFFER *wb, RRDR_OPTIONS options, int datatable) {
         }
 
         buffer_fast_strcat(wb, post_line, post_line_len);
+
+        if(unlikely(!buffer_drain_checkpoint(wb)))
+            break;
     }
 
     buffer_strcat(wb, finish);
@@ -362,6 +367,9 @@ void rrdr2json_v2(RRDR *r, BUFFER *wb) {
             }
 
             buffer_json_array_close(wb); // row
+
+            if(unlikely(!buffer_drain_checkpoint(wb)))
+                break;
         }
     }
 
@@ -346,6 +346,12 @@ int data_query_execute(ONEWAYALLOC *owa, BUFFER *wb, QUERY_TARGET *qt, time_t *l
         rrdr2json_v2(r, wb);
         wrapper_end(r, wb);
         break;
+
+    case DATASOURCE_BINARY:
+        // a columnar binary encoding - there is no json to wrap it in
+        wb->content_type = CT_APPLICATION_OCTET_STREAM;
+        rrdr2binary(r, wb, options);
+        break;
     }
 
     rrdr_free(owa, r);
@@ -0,0 +1,428 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "function-collection-cost.h"
+#include "database/rrd.h"
+
+struct cost {
+    STRING *node;           // by chart only
+    STRING *chart;          // by chart only
+    STRING *context;        // by chart only
+    STRING *plugin;
+    STRING *module;         // by chart only
+
+    size_t charts;
+    size_t dimensions;
+
+    uint64_t updates;
+    usec_t time_ut;
+    uint64_t points_stored;
+    uint64_t bytes_streamed;
+
+    uint64_t dimensions_added;
+    uint64_t dimensions_deleted;
+    uint64_t dimensions_aggregated;
+    uint64_t dimensions_refused;
+};
+
+static void cost_delete_cb(const DICTIONARY_ITEM *item __maybe_unused, void *value, void *data __maybe_unused) {
+    struct cost *c = value;
+    string_freez(c->node);
+    string_freez(c->chart);
+    string_freez(c->context);
+    string_freez(c->plugin);
+    string_freez(c->module);
+}
+
+static void cost_add(struct cost *dst, const struct cost *src) {
+    dst->charts += src->charts;
+    dst->dimensions += src->dimensions;
+    dst->updates += src->updates;
+    dst->time_ut += src->time_ut;
+    dst->points_stored += src->points_stored;
+    dst->bytes_streamed += src->bytes_streamed;
+    dst->dimensions_added += src->dimensions_added;
+    dst->dimensions_deleted += src->dimensions_deleted;
+    dst->dimensions_aggregated += src->dimensions_aggregated;
+    dst->dimensions_refused += src->dimensions_refused;
+}
+
+static void cost_max(struct cost *dst, const struct cost *src) {
+    dst->charts = MAX(dst->charts, src->charts);
+    dst->dimensions = MAX(dst->dimensions, src->dimensions);
+    dst->updates = MAX(dst->updates, src->updates);
+    dst->time_ut = MAX(dst->time_ut, src->time_ut);
+    dst->points_stored = MAX(dst->points_stored, src->points_stored);
+    dst->bytes_streamed = MAX(dst->bytes_streamed, src->bytes_streamed);
+    dst->dimensions_added = MAX(dst->dimensions_added, src->dimensions_added);
+    dst->dimensions_deleted = MAX(dst->dimensions_deleted, src->dimensions_deleted);
+    dst->dimensions_aggregated = MAX(dst->dimensions_aggregated, src->dimensions_aggregated);
+    dst->dimensions_refused = MAX(dst->dimensions_refused, src->dimensions_refused);
+}
+
+int function_collection_cost(BUFFER *wb, const char *function __maybe_unused, BUFFER *payload __maybe_unused, const char *source __maybe_unused) {
+    buffer_flush(wb);
+    wb->content_type = CT_APPLICATION_JSON;
+    buffer_json_initialize(wb, "\"", "\"", 0, true, BUFFER_JSON_OPTIONS_DEFAULT);
+
+    buffer_json_member_add_string(wb, "hostname", rrdhost_hostname(localhost));
+    buffer_json_member_add_uint64(wb, "status", HTTP_RESP_OK);
+    buffer_json_member_add_string(wb, "type", "table");
+    buffer_json_member_add_time_t(wb, "update_every", 10);
+    buffer_json_member_add_boolean(wb, "has_history", false);
+    buffer_json_member_add_string(wb, "help", RRDFUNCTIONS_COLLECTION_COST_HELP);
+
+    buffer_json_member_add_array(wb, "accepted_params");
+    {
+        buffer_json_add_array_item_string(wb, "group");
+    }
+    buffer_json_array_close(wb);
+
+    buffer_json_member_add_array(wb, "required_params");
+    {
+        buffer_json_add_array_item_object(wb);
+        {
+            buffer_json_member_add_string(wb, "id", "group");
+            buffer_json_member_add_string(wb, "name", "Grouping");
+            buffer_json_member_add_string(wb, "help", "Select how to group the charts");
+            buffer_json_member_add_boolean(wb, "unique_view", true);
+            buffer_json_member_add_string(wb, "type", "select");
+            buffer_json_member_add_array(wb, "options");
+            {
+                buffer_json_add_array_item_object(wb);
+                {
+                    buffer_json_member_add_string(wb, "id", "by-chart");
+                    buffer_json_member_add_string(wb, "name", "Group by Chart");
+                }
+                buffer_json_object_close(wb);
+                buffer_json_add_array_item_object(wb);
+                {
+                    buffer_json_member_add_string(wb, "id", "by-plugin");
+                    buffer_json_member_add_string(wb, "name", "Group by Plugin");
+                }
+                buffer_json_object_close(wb);
+            }
+            buffer_json_array_close(wb);
+        }
+        buffer_json_object_close(wb);
+    }
+    buffer_json_array_close(wb);
+
+    // Parse function parameters
+    bool by_plugin = false;
+    {
+        char function_copy[strlen(function) + 1];
+        memcpy(function_copy, function, sizeof(function_copy));
+        char *words[1024];
+        size_t num_words = quoted_strings_splitter_whitespace(function_copy, words, 1024);
+        for (size_t i = 1; i < num_words; i++) {
+            char *param = get_word(words, num_words, i);
+            if (strcmp(param, "group:by-plugin") == 0) {
+                by_plugin = true;
+            } else if (strcmp(param, "group:by-chart") == 0) {
+                by_plugin = false;
+            } else if (strcmp(param, "info") == 0) {
+                buffer_json_finalize(wb);
+                return HTTP_RESP_OK;
+            }
+        }
+    }
+
+    DICTIONARY *costs_dict = dictionary_create(DICT_OPTION_SINGLE_THREADED|DICT_OPTION_DONT_OVERWRITE_VALUE);
+    dictionary_register_delete_callback(costs_dict, cost_delete_cb, NULL);
+
+    struct cost all = { 0 };
+
+    // Collect the cost of each chart across all nodes
+    RRDHOST *host;
+    dfe_start_read(rrdhost_root_index, host) {
+        RRDSET *st;
+        rrdset_foreach_read(st, host) {
+            struct cost c = {
+                .charts = 1,
+                .dimensions = dictionary_entries(st->rrddim_root_index),
+                .updates = st->cost.done,
+                .time_ut = st->cost.done_ut,
+                .points_stored = st->cost.points_stored,
+                .bytes_streamed = st->cost.bytes_streamed,
+                .dimensions_added = __atomic_load_n(&st->cost.dimensions_added, __ATOMIC_RELAXED),
+                .dimensions_deleted = __atomic_load_n(&st->cost.dimensions_deleted, __ATOMIC_RELAXED),
+                .dimensions_aggregated = __atomic_load_n(&st->cost.dimensions_aggregated, __ATOMIC_RELAXED),
+                .dimensions_refused = __atomic_load_n(&st->cost.dimensions_refused, __ATOMIC_RELAXED),
+            };
+
+            char key[RRD_ID_LENGTH_MAX * 2 + 2];
+            if(by_plugin)
+                strncpyz(key, rrdset_plugin_name(st), sizeof(key) - 1);
+            else
+                snprintfz(key, sizeof(key) - 1, "%s/%s", rrdhost_hostname(host), rrdset_id(st));
+
+            struct cost *cc = dictionary_get(costs_dict, key);
+            if(cc)
+                cost_add(cc, &c);
+            else {
+                cc = dictionary_set(costs_dict, key, &c, sizeof(c));
+                cc->plugin = string_dup(st->plugin_name);
+                if(!by_plugin) {
+                    cc->node = string_dup(host->hostname);
+                    cc->chart = string_dup(st->id);
+                    cc->context = string_dup(st->context);
+                    cc->module = string_dup(st->module_name);
+                }
+            }
+
+            // keep track of the total
+            cost_add(&all, &c);
+        }
+        rrdset_foreach_done(st);
+    }
+    dfe_done(host);
+
+    struct cost max = { 0 };
+
+    buffer_json_member_add_array(wb, "data");
+
+    // Output collected costs
+    struct cost *c;
+    dfe_start_read(costs_dict, c) {
+        buffer_json_add_array_item_array(wb);
+        {
+            buffer_json_add_array_item_string(wb, c_dfe.name);
+
+            if(by_plugin) {
+                buffer_json_add_array_item_uint64(wb, c->charts);
+            }
+            else {
+                buffer_json_add_array_item_string(wb, string2str(c->chart));
+                buffer_json_add_array_item_string(wb, string2str(c->node));
+                buffer_json_add_array_item_string(wb, string2str(c->plugin));
+                buffer_json_add_array_item_string(wb, string2str(c->module));
+                buffer_json_add_array_item_string(wb, string2str(c->context));
+            }
+
+            buffer_json_add_array_item_uint64(wb, c->dimensions);
+            buffer_json_add_array_item_uint64(wb, c->updates);
+            buffer_json_add_array_item_double(wb, (double)c->time_ut / USEC_PER_MS);
+
+            double time_per_update = (c->updates) ? (double)c->time_ut / (double)c->updates : 0.0;
+            buffer_json_add_array_item_double(wb, time_per_update);
+
+            double time_percentage = (all.time_ut) ? ((double)c->time_ut * 100.0) / (double)all.time_ut : 0.0;
+            buffer_json_add_array_item_double(wb, time_percentage);
+
+            buffer_json_add_array_item_uint64(wb, c->points_stored);
+            buffer_json_add_array_item_uint64(wb, c->bytes_streamed);
+            buffer_json_add_array_item_uint64(wb, c->dimensions_added);
+            buffer_json_add_array_item_uint64(wb, c->dimensions_deleted);
+            buffer_json_add_array_item_uint64(wb, c->dimensions_aggregated);
+            buffer_json_add_array_item_uint64(wb, c->dimensions_refused);
+        }
+        buffer_json_array_close(wb);
+
+        cost_max(&max, c);
+    }
+    dfe_done(c);
+
+    buffer_json_array_close(wb); // data
+
+    buffer_json_member_add_object(wb, "columns");
+    {
+        size_t field_id = 0;
+
+        if(by_plugin) {
+            buffer_rrdf_table_add_field(wb, field_id++, "Plugin", "Plugin Name",
+                                        RRDF_FIELD_TYPE_STRING, RRDF_FIELD_VISUAL_VALUE, RRDF_FIELD_TRANSFORM_NONE,
+                                        0, NULL, NAN, RRDF_FIELD_SORT_ASCENDING, NULL,
+                                        RRDF_FIELD_SUMMARY_COUNT, RRDF_FIELD_FILTER_NONE,
+                                        RRDF_FIELD_OPTS_FULL_WIDTH | RRDF_FIELD_OPTS_UNIQUE_KEY | RRDF_FIELD_OPTS_VISIBLE,
+                                        NULL);
+
+            buffer_rrdf_table_add_field(wb, field_id++, "Charts", "Number of Charts",
+                                        RRDF_FIELD_TYPE_INTEGER, RRDF_FIELD_VISUAL_VALUE, RRDF_FIELD_TRANSFORM_NUMBER,
+                                        0, "charts", (double)max.charts, RRDF_FIELD_SORT_DESCENDING, NULL,
+                                        RRDF_FIELD_SUMMARY_SUM, RRDF_FIELD_FILTER_RANGE,
+                                        RRDF_FIELD_OPTS_VISIBLE,
+                                        NULL);
+        }
+        else {
+            buffer_rrdf_table_add_field(wb, field_id++, "ID", "Node and Chart",
+                                        RRDF_FIELD_TYPE_STRING, RRDF_FIELD_VISUAL_VALUE, RRDF_FIELD_TRANSFORM_NONE,
+                                        0, NULL, NAN, RRDF_FIELD_SORT_ASCENDING, NULL,
+                                        RRDF_FIELD_SUMMARY_COUNT, RRDF_FIELD_FILTER_NONE,
+                                        RRDF_FIELD_OPTS_UNIQUE_KEY,
+                                        NULL);
+
+            buffer_rrdf_table_add_field(wb, field_id++, "Chart", "Chart ID",
+                                        RRDF_FIELD_TYPE_STRING, RRDF_FIELD_VISUAL_VALUE, RRDF_FIELD_TRANSFORM_NONE,
+                                        0, NULL, NAN, RRDF_FIELD_SORT_ASCENDING, NULL,
+                                        RRDF_FIELD_SUMMARY_COUNT, RRDF_FIELD_FILTER_NONE,
+                                        RRDF_FIELD_OPTS_FULL_WIDTH | RRDF_FIELD_OPTS_STICKY | RRDF_FIELD_OPTS_VISIBLE,
+                                        NULL);
+
+            buffer_rrdf_table_add_field(wb, field_id++, "Node", "Hostname",
+                                        RRDF_FIELD_TYPE_STRING, RRDF_FIELD_VISUAL_VALUE, RRDF_FIELD_TRANSFORM_NONE,
+                                        0, NULL, NAN, RRDF_FIELD_SORT_ASCENDING, NULL,
+                                        RRDF_FIELD_SUMMARY_COUNT, RRDF_FIELD_FILTER_MULTISELECT,
+                                        RRDF_FIELD_OPTS_VISIBLE,
+                                        NULL);
+
+            buffer_rrdf_table_add_field(wb, field_id++, "Plugin", "Plugin Name",
+                                        RRDF_FIELD_TYPE_STRING, RRDF_FIELD_VISUAL_VALUE, RRDF_FIELD_TRANSFORM_NONE,
+                                        0, NULL, NAN, RRDF_FIELD_SORT_ASCENDING, NULL,
+                                        RRDF_FIELD_SUMMARY_COUNT, RRDF_FIELD_FILTER_MULTISELECT,
+                                        RRDF_FIELD_OPTS_VISIBLE,
+                                        NULL);
+
+            buffer_rrdf_table_add_field(wb, field_id++, "Module", "Plugin Module Name",
+                                        RRDF_FIELD_TYPE_STRING, RRDF_FIELD_VISUAL_VALUE, RRDF_FIELD_TRANSFORM_NONE,
+                                        0, NULL, NAN, RRDF_FIELD_SORT_ASCENDING, NULL,
+                                        RRDF_FIELD_SUMMARY_COUNT, RRDF_FIELD_FILTER_MULTISELECT,
+                                        RRDF_FIELD_OPTS_NONE,
+                                        NULL);
+
+            buffer_rrdf_table_add_field(wb, field_id++, "Context", "Context Name",
+                                        RRDF_FIELD_TYPE_STRING, RRDF_FIELD_VISUAL_VALUE, RRDF_FIELD_TRANSFORM_NONE,
+                                        0, NULL, NAN, RRDF_FIELD_SORT_ASCENDING, NULL,
+                                        RRDF_FIELD_SUMMARY_COUNT, RRDF_FIELD_FILTER_MULTISELECT,
+                                        RRDF_FIELD_OPTS_NONE,
+                                        NULL);
+        }
+
+        buffer_rrdf_table_add_field(wb, field_id++, "Dimensions", "Number of Dimensions",
+                                    RRDF_FIELD_TYPE_INTEGER, RRDF_FIELD_VISUAL_VALUE, RRDF_FIELD_TRANSFORM_NUMBER,
+                                    0, "dimensions", (double)max.dimensions, RRDF_FIELD_SORT_DESCENDING, NULL,
+                                    RRDF_FIELD_SUMMARY_SUM, RRDF_FIELD_FILTER_RANGE,
+                                    RRDF_FIELD_OPTS_VISIBLE,
+                                    NULL);
+
+        buffer_rrdf_table_add_field(wb, field_id++, "Updates", "Number of Data Collections",
+                                    RRDF_FIELD_TYPE_INTEGER, RRDF_FIELD_VISUAL_VALUE, RRDF_FIELD_TRANSFORM_NUMBER,
+                                    0, "updates", (double)max.updates, RRDF_FIELD_SORT_DESCENDING, NULL,
+                                    RRDF_FIELD_SUMMARY_SUM, RRDF_FIELD_FILTER_RANGE,
+                                    RRDF_FIELD_OPTS_NONE,
+                                    NULL);
+
+        buffer_rrdf_table_add_field(wb, field_id++, "Time", "Total Time Spent in Storing the Collected Samples",
+                                    RRDF_FIELD_TYPE_BAR_WITH_INTEGER, RRDF_FIELD_VISUAL_BAR, RRDF_FIELD_TRANSFORM_NUMBER,
+                                    2, "ms", (double)max.time_ut / USEC_PER_MS, RRDF_FIELD_SORT_DESCENDING, NULL,
+                                    RRDF_FIELD_SUMMARY_SUM, RRDF_FIELD_FILTER_RANGE,
+                                    RRDF_FIELD_OPTS_VISIBLE,
+                                    NULL);
+
+        buffer_rrdf_table_add_field(wb, field_id++, "Time per Update", "Average Time Spent per Data Collection",
+                                    RRDF_FIELD_TYPE_INTEGER, RRDF_FIELD_VISUAL_VALUE, RRDF_FIELD_TRANSFORM_NUMBER,
+                                    2, "us", NAN, RRDF_FIELD_SORT_DESCENDING, NULL,
+                                    RRDF_FIELD_SUMMARY_MAX, RRDF_FIELD_FILTER_RANGE,
+                                    RRDF_FIELD_OPTS_VISIBLE,
+                                    NULL);
+
+        buffer_rrdf_table_add_field(wb, field_id++, "Time %", "Percentage of the Time of the row vs the sum of Time across all rows",
+                                    RRDF_FIELD_TYPE_INTEGER, RRDF_FIELD_VISUAL_BAR, RRDF_FIELD_TRANSFORM_NUMBER,
+                                    2, "%", 100.0, RRDF_FIELD_SORT_DESCENDING, NULL,
+                                    RRDF_FIELD_SUMMARY_MAX, RRDF_FIELD_FILTER_RANGE,
+                                    RRDF_FIELD_OPTS_VISIBLE,
+                                    NULL);
+
+        buffer_rrdf_table_add_field(wb, field_id++, "Points", "Number of Points Stored in Tier 0",
+                                    RRDF_FIELD_TYPE_INTEGER, RRDF_FIELD_VISUAL_VALUE, RRDF_FIELD_TRANSFORM_NUMBER,
+                                    0, "points", (double)max.points_stored, RRDF_FIELD_SORT_DESCENDING, NULL,
+                                    RRDF_FIELD_SUMMARY_SUM, RRDF_FIELD_FILTER_RANGE,
+                                    RRDF_FIELD_OPTS_VISIBLE,
+                                    NULL);
+
+        buffer_rrdf_table_add_field(wb, field_id++, "Streamed", "Bytes of Collected Data Streamed to the Parent",
+                                    RRDF_FIELD_TYPE_INTEGER, RRDF_FIELD_VISUAL_VALUE, RRDF_FIELD_TRANSFORM_NUMBER,
+                                    0, "bytes", (double)max.bytes_streamed, RRDF_FIELD_SORT_DESCENDING, NULL,
+                                    RRDF_FIELD_SUMMARY_SUM, RRDF_FIELD_FILTER_RANGE,
+                                    RRDF_FIELD_OPTS_VISIBLE,
+                                    NULL);
+
+        buffer_rrdf_table_add_field(wb, field_id++, "Added Dimensions", "Number of Dimensions Created",
+                                    RRDF_FIELD_TYPE_INTEGER, RRDF_FIELD_VISUAL_VALUE, RRDF_FIELD_TRANSFORM_NUMBER,
+                                    0, "dimensions", (double)max.dimensions_added, RRDF_FIELD_SORT_DESCENDING, NULL,
+                                    RRDF_FIELD_SUMMARY_SUM, RRDF_FIELD_FILTER_RANGE,
+                                    RRDF_FIELD_OPTS_VISIBLE,
+                                    NULL);
+
+        buffer_rrdf_table_add_field(wb, field_id++, "Deleted Dimensions", "Number of Dimensions Deleted",
+                                    RRDF_FIELD_TYPE_INTEGER, RRDF_FIELD_VISUAL_VALUE, RRDF_FIELD_TRANSFORM_NUMBER,
+                                    0, "dimensions", (double)max.dimensions_deleted, RRDF_FIELD_SORT_DESCENDING, NULL,
+                                    RRDF_FIELD_SUMMARY_SUM, RRDF_FIELD_FILTER_RANGE,
+                                    RRDF_FIELD_OPTS_VISIBLE,
+                                    NULL);
+
+        buffer_rrdf_table_add_field(wb, field_id++, "Aggregated Dimensions", "Number of Dimensions Aggregated Over the Plugin's Budget",
+                                    RRDF_FIELD_TYPE_INTEGER, RRDF_FIELD_VISUAL_VALUE, RRDF_FIELD_TRANSFORM_NUMBER,
+                                    0, "dimensions", (double)max.dimensions_aggregated, RRDF_FIELD_SORT_DESCENDING, NULL,
+                                    RRDF_FIELD_SUMMARY_SUM, RRDF_FIELD_FILTER_RANGE,
+                                    RRDF_FIELD_OPTS_NONE,
+                                    NULL);
+
+        buffer_rrdf_table_add_field(wb, field_id++, "Refused Dimensions", "Number of Dimensions Over the Plugin's Budget that could not be Aggregated",
+                                    RRDF_FIELD_TYPE_INTEGER, RRDF_FIELD_VISUAL_VALUE, RRDF_FIELD_TRANSFORM_NUMBER,
+                                    0, "dimensions", (double)max.dimensions_refused, RRDF_FIELD_SORT_DESCENDING, NULL,
+                                    RRDF_FIELD_SUMMARY_SUM, RRDF_FIELD_FILTER_RANGE,
+                                    RRDF_FIELD_OPTS_NONE,
+                                    NULL);
+    }
+    buffer_json_object_close(wb); // columns
+
+    buffer_json_member_add_string(wb, "default_sort_column", "Time");
+
+    buffer_json_member_add_object(wb, "charts");
+    {
+        buffer_json_member_add_object(wb, "Time");
+        {
+            buffer_json_member_add_array(wb, "columns");
+            buffer_json_add_array_item_string(wb, "Time");
+            buffer_json_array_close(wb);
+
+            buffer_json_member_add_string(wb, "name", "Time");
+            buffer_json_member_add_string(wb, "type", "stacked-bar");
+        }
+        buffer_json_object_close(wb);
+
+        buffer_json_member_add_object(wb, "Dimensions Churn");
+        {
+            buffer_json_member_add_array(wb, "columns");
+            buffer_json_add_array_item_string(wb, "Added Dimensions");
+            buffer_json_add_array_item_string(wb, "Deleted Dimensions");
+            buffer_json_array_close(wb);
+
+            buffer_json_member_add_string(wb, "name", "Dimensions Churn");
+            buffer_json_member_add_string(wb, "type", "stacked-bar");
+        }
+        buffer_json_object_close(wb);
+    }
+    buffer_json_object_close(wb); // charts
+
+    buffer_json_member_add_array(wb, "default_charts");
+    {
+        buffer_json_add_array_item_array(wb);
+        buffer_json_add_array_item_string(wb, "Time");
+        buffer_json_add_array_item_string(wb, "Plugin");
+        buffer_json_array_close(wb);
+    }
+    buffer_json_array_close(wb); // default_charts
+
+    buffer_json_member_add_object(wb, "group_by");
+    {
+        buffer_json_member_add_object(wb, "Plugin");
+        {
+            buffer_json_member_add_string(wb, "name", "Plugin");
+            buffer_json_member_add_array(wb, "columns");
+            {
+                buffer_json_add_array_item_string(wb, "Plugin");
+            }
+            buffer_json_array_close(wb);
+        }
+        buffer_json_object_close(wb);
+    }
+    buffer_json_object_close(wb); // group_by
+
+    buffer_json_member_add_time_t(wb, "expires", now_realtime_sec() + 1);
+    buffer_json_finalize(wb);
+
+    dictionary_destroy(costs_dict);
+
+    return HTTP_RESP_OK;
+}
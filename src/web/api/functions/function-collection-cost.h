@@ -0,0 +1,12 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef NETDATA_FUNCTION_COLLECTION_COST_H
+#define NETDATA_FUNCTION_COLLECTION_COST_H
+
+#include "libnetdata/libnetdata.h"
+
+#define RRDFUNCTIONS_COLLECTION_COST_HELP "Displays the cost of collecting each chart: the time spent in storing its samples, the points stored, the bytes streamed to the parent and the churn of its dimensions. To change grouping, append parameter to function name: 'netdata-collection-cost' (default, group by chart) or 'netdata-collection-cost group:by-plugin' (group by plugin)."
+
+int function_collection_cost(BUFFER *wb, const char *function, BUFFER *payload, const char *source);
+
+#endif //NETDATA_FUNCTION_COLLECTION_COST_H
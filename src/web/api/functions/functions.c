@@ -52,4 +52,16 @@ void global_functions_add(void) {
         "top",
         HTTP_ACCESS_ANONYMOUS_DATA,
         function_metrics_cardinality);
+
+    rrd_function_add_inline(
+        localhost,
+        NULL,
+        "netdata-collection-cost",
+        10,
+        RRDFUNCTIONS_PRIORITY_DEFAULT + 1,
+        RRDFUNCTIONS_VERSION_DEFAULT,
+        RRDFUNCTIONS_COLLECTION_COST_HELP,
+        "top",
+        HTTP_ACCESS_ANONYMOUS_DATA,
+        function_collection_cost);
 }
@@ -6,6 +6,7 @@
 #include "database/rrd.h"
 
 #include "function-metrics-cardinality.h"
+#include "function-collection-cost.h"
 #include "function-streaming.h"
 #include "function-progress.h"
 #include "function-bearer_get_token.h"
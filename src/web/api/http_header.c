@@ -134,8 +134,16 @@ static void http_header_host(struct web_client *w, const char *v, size_t len) {
 }
 
 static void http_header_accept_encoding(struct web_client *w, const char *v, size_t len __maybe_unused) {
+    WEB_ENCODING encodings = web_encodings_accepted(v) & web_encodings_enabled();
+
+    if(encodings & WEB_ENCODING_BROTLI)
+        web_client_flag_set(w, WEB_CLIENT_ENCODING_BROTLI);
+
+    if(encodings & WEB_ENCODING_ZSTD)
+        web_client_flag_set(w, WEB_CLIENT_ENCODING_ZSTD);
+
     if(web_enable_gzip) {
-        if(strcasestr(v, "gzip"))
+        if(encodings & WEB_ENCODING_GZIP)
             web_client_enable_deflate(w, true);
 
         // does not seem to work
@@ -144,6 +152,11 @@ static void http_header_accept_encoding(struct web_client *w, const char *v, siz
     }
 }
 
+static void http_header_if_none_match(struct web_client *w, const char *v, size_t len __maybe_unused) {
+    freez(w->if_none_match);
+    w->if_none_match = strdupz(v);
+}
+
 static void http_header_x_forwarded_host(struct web_client *w, const char *v, size_t len) {
     char buffer[NI_MAXHOST];
     strncpyz(buffer, v, (len < sizeof(buffer) - 1 ? len : sizeof(buffer) - 1));
@@ -345,6 +358,7 @@ struct {
     { .hash = 0, .key = "X-Auth-Token",          .cb = http_header_x_auth_token },
     { .hash = 0, .key = "Host",                  .cb = http_header_host },
     { .hash = 0, .key = "Accept-Encoding",       .cb = http_header_accept_encoding },
+    { .hash = 0, .key = "If-None-Match",         .cb = http_header_if_none_match },
     { .hash = 0, .key = "X-Forwarded-Host",      .cb = http_header_x_forwarded_host },
     { .hash = 0, .key = "X-Forwarded-For",       .cb = http_header_x_forwarded_for },
     { .hash = 0, .key = "X-Transaction-Id",      .cb = http_header_x_transaction_id },
@@ -52,6 +52,7 @@ static struct {
     , {"ssvcomma"     , 0 , DATASOURCE_SSV_COMMA}
     , {"csvjsonarray" , 0 , DATASOURCE_CSV_JSON_ARRAY}
     , {"markdown"     , 0 , DATASOURCE_CSV_MARKDOWN}
+    , {"binary"       , 0 , DATASOURCE_BINARY}
 
     // terminator
     , {NULL, 0, 0}
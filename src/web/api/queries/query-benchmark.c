@@ -0,0 +1,435 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "query-internal.h"
+#include "weights.h"
+#include "database/contexts/rrdcontext-internal.h"
+
+// ----------------------------------------------------------------------------
+// query engine micro-benchmark
+//
+// populates in-memory hosts with synthetic data and runs representative
+// queries against them, reporting latency percentiles, points/sec and the
+// memory allocated per query - run it with:
+//
+//     netdata -W querybench=NODES,CONTEXTS,INSTANCES,DIMENSIONS,POINTS,ITERATIONS
+//
+// the same parameters produce the same dataset, so that the results can be
+// compared across builds
+
+#define QUERY_BENCHMARK_UPDATE_EVERY 1
+#define QUERY_BENCHMARK_LABEL_GROUPS 4
+#define QUERY_BENCHMARK_RESULT_POINTS 500
+
+struct query_benchmark {
+    size_t nodes;
+    size_t contexts;
+    size_t instances;
+    size_t dimensions;
+    size_t points;
+    size_t iterations;
+
+    time_t after;
+    time_t before;
+
+    RRDHOST **hosts;
+    usec_t *durations_ut;
+};
+
+struct query_benchmark_stats {
+    size_t queries;
+    size_t failed;
+    size_t db_points;
+    size_t result_points;
+    size_t allocated_bytes;
+    bool allocated_bytes_unknown;   // the workload cannot measure its allocations
+    usec_t total_ut;
+};
+
+// ----------------------------------------------------------------------------
+// dataset
+
+static inline collected_number query_benchmark_value(size_t node, size_t context, size_t instance, size_t dimension, size_t point) {
+    // a deterministic, slowly changing pattern, with a different phase per metric
+    size_t phase = (node * 7 + context * 13 + instance * 17 + dimension * 19) % 360;
+    size_t step = (point + phase) % 360;
+    return (collected_number)(1000 + ((step < 180) ? step : 360 - step) * 10 + dimension);
+}
+
+static inline void query_benchmark_rrddim_set(RRDDIM *rd, collected_number value, time_t now) {
+    rd->collector.last_collected_time.tv_sec = now;
+    rd->collector.last_collected_time.tv_usec = 0;
+    rd->collector.collected_value = value;
+    rrddim_set_updated(rd);
+
+    rd->collector.counter++;
+
+    collected_number v = (value >= 0) ? value : -value;
+    if(unlikely(v > rd->collector.collected_value_max)) rd->collector.collected_value_max = v;
+}
+
+static RRDHOST *query_benchmark_host_create(struct query_benchmark *qb, size_t node) {
+    char hostname[RRD_ID_LENGTH_MAX + 1];
+    snprintfz(hostname, sizeof(hostname) - 1, "bench-node-%zu", node);
+
+    nd_uuid_t uuid;
+    uuid_generate(uuid);
+    char guid[UUID_STR_LEN];
+    uuid_unparse_lower(uuid, guid);
+
+    return rrdhost_find_or_create(
+        hostname,
+        hostname,
+        guid,
+        os_type,
+        netdata_configured_timezone,
+        netdata_configured_abbrev_timezone,
+        netdata_configured_utc_offset,
+        program_name,
+        NETDATA_VERSION,
+        QUERY_BENCHMARK_UPDATE_EVERY,
+        (long)qb->points + 1,
+        RRD_DB_MODE_ALLOC,
+        false,
+        false,
+        NULL,
+        NULL,
+        NULL,
+        false,
+        0,
+        0,
+        NULL,
+        0
+    );
+}
+
+static void query_benchmark_populate_host(struct query_benchmark *qb, RRDHOST *host, size_t node) {
+    char id[RRD_ID_LENGTH_MAX + 1], context[RRD_ID_LENGTH_MAX + 1], value[RRD_ID_LENGTH_MAX + 1];
+
+    RRDSET **st = callocz(qb->contexts * qb->instances, sizeof(RRDSET *));
+    RRDDIM **rd = callocz(qb->contexts * qb->instances * qb->dimensions, sizeof(RRDDIM *));
+
+    for(size_t c = 0; c < qb->contexts ;c++) {
+        snprintfz(context, sizeof(context) - 1, "bench.context%zu", c);
+
+        for(size_t i = 0; i < qb->instances ;i++) {
+            size_t s = c * qb->instances + i;
+
+            snprintfz(id, sizeof(id) - 1, "context%zu_instance%zu", c, i);
+            st[s] = rrdset_create(host, "bench", id, NULL, "bench", context, "Query Benchmark", "value", "benchmark",
+                                  NULL, 1 + c, QUERY_BENCHMARK_UPDATE_EVERY, RRDSET_TYPE_LINE);
+
+            snprintfz(value, sizeof(value) - 1, "group%zu", i % QUERY_BENCHMARK_LABEL_GROUPS);
+            rrdlabels_add(st[s]->rrdlabels, "bench_group", value, RRDLABEL_SRC_AUTO);
+
+            snprintfz(value, sizeof(value) - 1, "%zu", node);
+            rrdlabels_add(st[s]->rrdlabels, "bench_node", value, RRDLABEL_SRC_AUTO);
+
+            for(size_t d = 0; d < qb->dimensions ;d++) {
+                snprintfz(id, sizeof(id) - 1, "dim%zu", d);
+                rd[s * qb->dimensions + d] = rrddim_add(st[s], id, NULL, 1, 1, RRD_ALGORITHM_ABSOLUTE);
+            }
+
+            // start collecting just before the first point, so that
+            // the values are stored as-is, without interpolation
+            st[s]->last_collected_time.tv_sec = st[s]->last_updated.tv_sec = qb->after - QUERY_BENCHMARK_UPDATE_EVERY;
+            st[s]->last_collected_time.tv_usec = st[s]->last_updated.tv_usec = 0;
+            for(size_t d = 0; d < qb->dimensions ;d++) {
+                rd[s * qb->dimensions + d]->collector.last_collected_time.tv_sec = qb->after - QUERY_BENCHMARK_UPDATE_EVERY;
+                rd[s * qb->dimensions + d]->collector.last_collected_time.tv_usec = 0;
+            }
+        }
+    }
+
+    time_t now = qb->after;
+    for(size_t p = 0; p < qb->points ;p++, now += QUERY_BENCHMARK_UPDATE_EVERY) {
+        for(size_t s = 0; s < qb->contexts * qb->instances ;s++) {
+            st[s]->usec_since_last_update = USEC_PER_SEC * QUERY_BENCHMARK_UPDATE_EVERY;
+
+            for(size_t d = 0; d < qb->dimensions ;d++)
+                query_benchmark_rrddim_set(rd[s * qb->dimensions + d],
+                                           query_benchmark_value(node, s / qb->instances, s % qb->instances, d, p),
+                                           now);
+
+            rrdset_timed_done(st[s], (struct timeval){ .tv_sec = now, .tv_usec = 0 }, false);
+        }
+    }
+
+    freez(rd);
+    freez(st);
+
+    // the retention of the contexts is normally updated by the rrdcontext worker,
+    // which is not running - update it now, so that all metrics are queryable
+    RRDCONTEXT *rc;
+    dfe_start_read(host->rrdctx.contexts, rc) {
+        rrdcontext_initial_processing_after_loading(rc);
+    }
+    dfe_done(rc);
+}
+
+// ----------------------------------------------------------------------------
+// reporting
+
+static int query_benchmark_compar_usec(const void *a, const void *b) {
+    usec_t ua = *(const usec_t *)a;
+    usec_t ub = *(const usec_t *)b;
+    return (ua < ub) ? -1 : (ua > ub) ? 1 : 0;
+}
+
+static inline double query_benchmark_percentile_ms(usec_t *durations_ut, size_t entries, double percentile) {
+    if(!entries)
+        return 0.0;
+
+    size_t slot = (size_t)((double)(entries - 1) * percentile / 100.0 + 0.5);
+    return (double)durations_ut[slot] / (double)USEC_PER_MS;
+}
+
+static void query_benchmark_report_header(void) {
+    fprintf(stderr, "\n%-40s %8s %6s %9s %9s %9s %9s %14s %12s %12s\n",
+            "WORKLOAD", "QUERIES", "FAILED", "P50 ms", "P90 ms", "P99 ms", "MAX ms",
+            "POINTS/sec", "RESULT PTS", "ALLOC/query");
+}
+
+static void query_benchmark_report(struct query_benchmark *qb, const char *workload, struct query_benchmark_stats *s) {
+    size_t entries = s->queries - s->failed;
+    qsort(qb->durations_ut, entries, sizeof(usec_t), query_benchmark_compar_usec);
+
+    double seconds = (double)s->total_ut / (double)USEC_PER_SEC;
+
+    char allocated[32];
+    if(s->allocated_bytes_unknown)
+        strncpyz(allocated, "n/a", sizeof(allocated) - 1);
+    else
+        snprintfz(allocated, sizeof(allocated), "%zu", entries ? s->allocated_bytes / entries : 0);
+
+    fprintf(stderr, "%-40s %8zu %6zu %9.3f %9.3f %9.3f %9.3f %14.0f %12zu %12s\n",
+            workload, s->queries, s->failed,
+            query_benchmark_percentile_ms(qb->durations_ut, entries, 50),
+            query_benchmark_percentile_ms(qb->durations_ut, entries, 90),
+            query_benchmark_percentile_ms(qb->durations_ut, entries, 99),
+            query_benchmark_percentile_ms(qb->durations_ut, entries, 100),
+            seconds > 0 ? (double)s->db_points / seconds : 0.0,
+            entries ? s->result_points / entries : 0,
+            allocated);
+}
+
+// ----------------------------------------------------------------------------
+// workloads
+
+static void query_benchmark_data(struct query_benchmark *qb, const char *workload, QUERY_TARGET_REQUEST *qtr) {
+    struct query_benchmark_stats s = { 0 };
+
+    for(size_t it = 0; it < qb->iterations ;it++) {
+        s.queries++;
+
+        size_t owa_before = onewayalloc_allocated_memory();
+        usec_t started_ut = now_monotonic_usec();
+
+        qtr->received_ut = now_realtime_usec();
+        QUERY_TARGET *qt = query_target_create(qtr);
+        ONEWAYALLOC *owa = onewayalloc_create(0);
+        RRDR *r = qt ? rrd2rrdr(owa, qt) : NULL;
+
+        usec_t ended_ut = now_monotonic_usec();
+
+        if(r) {
+            for(size_t tier = 0; tier < nd_profile.storage_tiers ;tier++)
+                s.db_points += qt->db.tiers[tier].points;
+
+            s.result_points += rrdr_rows(r) * r->d;
+            s.allocated_bytes += onewayalloc_allocated_memory() - owa_before;
+            s.total_ut += ended_ut - started_ut;
+            qb->durations_ut[s.queries - s.failed - 1] = ended_ut - started_ut;
+        }
+        else
+            s.failed++;
+
+        rrdr_free(owa, r);
+        onewayalloc_destroy(owa);
+        query_target_release(qt);
+    }
+
+    query_benchmark_report(qb, workload, &s);
+}
+
+static void query_benchmark_weights(struct query_benchmark *qb, const char *workload, QUERY_WEIGHTS_REQUEST *qwr) {
+    // the weights queries allocate from per-query arenas that are freed
+    // before web_api_v12_weights() returns, so there is nothing to measure
+    struct query_benchmark_stats s = { .allocated_bytes_unknown = true };
+    BUFFER *wb = buffer_create(0, NULL);
+
+    for(size_t it = 0; it < qb->iterations ;it++) {
+        s.queries++;
+        buffer_flush(wb);
+
+        usec_t started_ut = now_monotonic_usec();
+        int ret = web_api_v12_weights(wb, qwr);
+        usec_t ended_ut = now_monotonic_usec();
+
+        if(ret == HTTP_RESP_OK) {
+            s.result_points += qwr->stats.result_points;
+            s.db_points += qwr->stats.db_points;
+            s.total_ut += ended_ut - started_ut;
+            qb->durations_ut[s.queries - s.failed - 1] = ended_ut - started_ut;
+        }
+        else
+            s.failed++;
+    }
+
+    buffer_free(wb);
+    query_benchmark_report(qb, workload, &s);
+}
+
+static QUERY_TARGET_REQUEST query_benchmark_request(struct query_benchmark *qb) {
+    QUERY_TARGET_REQUEST qtr = {
+        .version = 2,
+        .scope_nodes = "bench-node-*",
+        .scope_contexts = "bench.*",
+        .after = qb->after,
+        .before = qb->before,
+        .points = QUERY_BENCHMARK_RESULT_POINTS,
+        .format = DATASOURCE_JSON2,
+        .options = RRDR_OPTION_VIRTUAL_POINTS | RRDR_OPTION_JSON_WRAP | RRDR_OPTION_RETURN_JWAR,
+        .time_group_method = RRDR_GROUPING_AVERAGE,
+        .query_source = QUERY_SOURCE_UNITTEST,
+        .priority = STORAGE_PRIORITY_NORMAL,
+        .group_by = {
+            [0] = {
+                .group_by = RRDR_GROUP_BY_DIMENSION,
+                .aggregation = RRDR_GROUP_BY_FUNCTION_AVERAGE,
+            },
+        },
+    };
+
+    return qtr;
+}
+
+static void query_benchmark_run(struct query_benchmark *qb) {
+    char workload[100];
+
+    query_benchmark_report_header();
+
+    // every time grouping
+    for(RRDR_TIME_GROUPING tg = RRDR_GROUPING_AVERAGE; tg <= RRDR_GROUPING_EXTREMES ;tg++) {
+        QUERY_TARGET_REQUEST qtr = query_benchmark_request(qb);
+        qtr.time_group_method = tg;
+        snprintfz(workload, sizeof(workload) - 1, "time-group %s", time_grouping_id2txt(tg));
+        query_benchmark_data(qb, workload, &qtr);
+    }
+
+    // every group by
+    static const struct {
+        const char *name;
+        RRDR_GROUP_BY group_by;
+        const char *label;
+    } group_by[] = {
+        { "selected",   RRDR_GROUP_BY_SELECTED,  NULL },
+        { "dimension",  RRDR_GROUP_BY_DIMENSION, NULL },
+        { "instance",   RRDR_GROUP_BY_INSTANCE,  NULL },
+        { "node",       RRDR_GROUP_BY_NODE,      NULL },
+        { "context",    RRDR_GROUP_BY_CONTEXT,   NULL },
+        { "units",      RRDR_GROUP_BY_UNITS,     NULL },
+        { "label",      RRDR_GROUP_BY_LABEL,     "bench_group" },
+        { "percentage-of-instance", RRDR_GROUP_BY_PERCENTAGE_OF_INSTANCE, NULL },
+    };
+    for(size_t i = 0; i < _countof(group_by) ;i++) {
+        QUERY_TARGET_REQUEST qtr = query_benchmark_request(qb);
+        qtr.group_by[0].group_by = group_by[i].group_by;
+        qtr.group_by[0].group_by_label = (char *)group_by[i].label;
+        snprintfz(workload, sizeof(workload) - 1, "group-by %s", group_by[i].name);
+        query_benchmark_data(qb, workload, &qtr);
+    }
+
+    // label filters
+    {
+        QUERY_TARGET_REQUEST qtr = query_benchmark_request(qb);
+        qtr.labels = "bench_group:group1";
+        query_benchmark_data(qb, "labels bench_group:group1", &qtr);
+
+        qtr = query_benchmark_request(qb);
+        qtr.scope_labels = "bench_group:group1|bench_group:group2";
+        query_benchmark_data(qb, "scope-labels 2 groups", &qtr);
+
+        qtr = query_benchmark_request(qb);
+        qtr.labels = "bench_node:0";
+        query_benchmark_data(qb, "labels bench_node:0", &qtr);
+    }
+
+    // weights
+    static const WEIGHTS_METHOD methods[] = {
+        WEIGHTS_METHOD_MC_KS2,
+        WEIGHTS_METHOD_MC_VOLUME,
+        WEIGHTS_METHOD_ANOMALY_RATE,
+        WEIGHTS_METHOD_VALUE,
+    };
+    time_t middle = qb->after + (qb->before - qb->after) / 2;
+    for(size_t i = 0; i < _countof(methods) ;i++) {
+        QUERY_WEIGHTS_REQUEST qwr = {
+            .version = 2,
+            .scope_nodes = "bench-node-*",
+            .scope_contexts = "bench.*",
+            .method = methods[i],
+            .format = WEIGHTS_FORMAT_CONTEXTS,
+            .time_group_method = RRDR_GROUPING_AVERAGE,
+            .baseline_after = qb->after,
+            .baseline_before = middle,
+            .after = middle,
+            .before = qb->before,
+            .points = QUERY_BENCHMARK_RESULT_POINTS,
+            .options = RRDR_OPTION_NOT_ALIGNED | RRDR_OPTION_NULL2ZERO | RRDR_OPTION_NONZERO,
+            .group_by = {
+                .group_by = RRDR_GROUP_BY_DIMENSION,
+                .aggregation = RRDR_GROUP_BY_FUNCTION_AVERAGE,
+            },
+        };
+        snprintfz(workload, sizeof(workload) - 1, "weights %s", weights_method_to_string(methods[i]));
+        query_benchmark_weights(qb, workload, &qwr);
+    }
+
+    fprintf(stderr, "\n");
+}
+
+int query_benchmark(size_t nodes, size_t contexts, size_t instances, size_t dimensions, size_t points, size_t iterations) {
+    struct query_benchmark qb = {
+        .nodes = nodes ? nodes : 1,
+        .contexts = contexts ? contexts : 10,
+        .instances = instances ? instances : 10,
+        .dimensions = dimensions ? dimensions : 5,
+        .points = points ? points : 3600,
+        .iterations = iterations ? iterations : 10,
+    };
+
+    qb.before = now_realtime_sec() - QUERY_BENCHMARK_UPDATE_EVERY;
+    qb.before -= qb.before % QUERY_BENCHMARK_UPDATE_EVERY;
+    qb.after = qb.before - (time_t)(qb.points - 1) * QUERY_BENCHMARK_UPDATE_EVERY;
+
+    fprintf(stderr, "\nQUERY BENCHMARK: %zu nodes, %zu contexts, %zu instances per context, %zu dimensions per instance, "
+                    "%zu points per metric (%zu metrics, %zu points in total), %zu iterations per workload\n",
+            qb.nodes, qb.contexts, qb.instances, qb.dimensions, qb.points,
+            qb.nodes * qb.contexts * qb.instances * qb.dimensions,
+            qb.nodes * qb.contexts * qb.instances * qb.dimensions * qb.points,
+            qb.iterations);
+
+    qb.hosts = callocz(qb.nodes, sizeof(RRDHOST *));
+    qb.durations_ut = callocz(qb.iterations, sizeof(usec_t));
+
+    usec_t started_ut = now_monotonic_usec();
+    for(size_t n = 0; n < qb.nodes ;n++) {
+        qb.hosts[n] = query_benchmark_host_create(&qb, n);
+        if(!qb.hosts[n]) {
+            fprintf(stderr, "QUERY BENCHMARK: failed to create host No %zu\n", n);
+            freez(qb.durations_ut);
+            freez(qb.hosts);
+            return 1;
+        }
+
+        query_benchmark_populate_host(&qb, qb.hosts[n], n);
+    }
+    fprintf(stderr, "QUERY BENCHMARK: dataset created in %0.3f seconds\n",
+            (double)(now_monotonic_usec() - started_ut) / (double)USEC_PER_SEC);
+
+    query_benchmark_run(&qb);
+
+    freez(qb.durations_ut);
+    freez(qb.hosts);
+    return 0;
+}
@@ -1,9 +1,17 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 
 #include "database/rrd.h"
+#include "database/contexts/rrdcontext-internal.h"
 #include "KolmogorovSmirnovDist.h"
 
 #define MAX_POINTS 10000
+
+// metric correlations are executed in parallel by up to this many threads
+#define WEIGHTS_MAX_WORKERS 8
+
+// do not start a thread for less than this many candidate metrics
+#define WEIGHTS_MIN_CANDIDATES_PER_WORKER 32
+#define WEIGHTS_NO_WORKER SIZE_MAX
 int metric_correlations_version = 1;
 
 typedef struct weights_stats {
@@ -301,6 +309,23 @@ static size_t registered_results_to_json_contexts(DICTIONARY *results, BUFFER *w
     return total_dimensions;
 }
 
+// a metric to be correlated, collected while walking the scope
+// and executed later by the workers - the items are acquired
+struct weights_candidate {
+    RRDHOST *host;
+    RRDCONTEXT_ACQUIRED *rca;
+    RRDINSTANCE_ACQUIRED *ria;
+    RRDMETRIC_ACQUIRED *rma;
+
+    size_t order;                   // the position of the candidate in the scope walk
+    size_t worker;                  // the worker that executed it, WEIGHTS_NO_WORKER when it was not executed
+
+    // filled by the top-K pre-pass
+    bool has_averages;
+    NETDATA_DOUBLE bound;           // the relative change of the highlighted average vs the baseline one
+    QUERY_VALUE averages[2];        // [0] is the baseline, [1] is the highlight
+};
+
 struct query_weights_data {
     QUERY_WEIGHTS_REQUEST *qwr;
 
@@ -334,6 +359,15 @@ struct query_weights_data {
     uint32_t shifts;
 
     struct query_versions versions;
+
+    struct {
+        struct weights_candidate *array;
+        size_t used;
+        size_t size;
+
+        size_t next;                // the next candidate to be picked by a worker
+        bool stop;                  // set by any worker, on timeout or interruption
+    } candidates;
 };
 
 #define AGGREGATED_WEIGHT_EMPTY (struct aggregated_weight) {        \
@@ -1431,25 +1465,34 @@ static void rrdset_metric_correlations_volume(
         time_t after, time_t before,
         RRDR_OPTIONS options, RRDR_TIME_GROUPING time_group_method, const char *time_group_options,
         size_t tier,
-        WEIGHTS_STATS *stats, bool register_zero) {
+        WEIGHTS_STATS *stats, bool register_zero,
+        QUERY_VALUE *averages) {
 
     options |= RRDR_OPTION_MATCH_IDS | RRDR_OPTION_ABSOLUTE | RRDR_OPTION_NATURAL_POINTS;
 
-    QUERY_VALUE baseline_average = rrdmetric2value(host, rca, ria, rma, baseline_after, baseline_before,
-                                                   options, time_group_method, time_group_options, tier, 0,
-                                                   QUERY_SOURCE_API_WEIGHTS, STORAGE_PRIORITY_SYNCHRONOUS_FIRST);
-    merge_query_value_to_stats(&baseline_average, stats, 1);
+    QUERY_VALUE baseline_average, highlight_average;
+    if(averages) {
+        // the averages have already been queried (and accounted) by the top-K pre-pass
+        baseline_average = averages[0];
+        highlight_average = averages[1];
+    }
+    else {
+        baseline_average = rrdmetric2value(host, rca, ria, rma, baseline_after, baseline_before,
+                                           options, time_group_method, time_group_options, tier, 0,
+                                           QUERY_SOURCE_API_WEIGHTS, STORAGE_PRIORITY_SYNCHRONOUS_FIRST);
+        merge_query_value_to_stats(&baseline_average, stats, 1);
+
+        highlight_average = rrdmetric2value(host, rca, ria, rma, after, before,
+                                            options, time_group_method, time_group_options, tier, 0,
+                                            QUERY_SOURCE_API_WEIGHTS, STORAGE_PRIORITY_SYNCHRONOUS_FIRST);
+        merge_query_value_to_stats(&highlight_average, stats, 1);
+    }
 
     if(!netdata_double_isnumber(baseline_average.value)) {
         // this means no data for the baseline window, but we may have data for the highlighted one - assume zero
         baseline_average.value = 0.0;
     }
 
-    QUERY_VALUE highlight_average = rrdmetric2value(host, rca, ria, rma, after, before,
-                                                    options, time_group_method, time_group_options, tier, 0,
-                                                    QUERY_SOURCE_API_WEIGHTS, STORAGE_PRIORITY_SYNCHRONOUS_FIRST);
-    merge_query_value_to_stats(&highlight_average, stats, 1);
-
     if(!netdata_double_isnumber(highlight_average.value))
         return;
 
@@ -1875,6 +1918,265 @@ static size_t registered_results_to_json_mcp(
     return state.count;
 }
 
+// ----------------------------------------------------------------------------
+// Parallel execution of metric correlations
+
+static void weights_candidate_add(struct query_weights_data *qwd, RRDHOST *host, RRDCONTEXT_ACQUIRED *rca, RRDINSTANCE_ACQUIRED *ria, RRDMETRIC_ACQUIRED *rma) {
+    if(qwd->candidates.used == qwd->candidates.size) {
+        qwd->candidates.size = qwd->candidates.size ? qwd->candidates.size * 2 : 1024;
+        qwd->candidates.array = reallocz(qwd->candidates.array, qwd->candidates.size * sizeof(struct weights_candidate));
+    }
+
+    qwd->candidates.array[qwd->candidates.used] = (struct weights_candidate) {
+        .order = qwd->candidates.used,
+        .worker = WEIGHTS_NO_WORKER,
+        .host = host,
+        .rca = rrdcontext_acquired_dup(rca),
+        .ria = rrdinstance_acquired_dup(ria),
+        .rma = rrdmetric_acquired_dup(rma),
+        .has_averages = false,
+        .bound = 0.0,
+    };
+    qwd->candidates.used++;
+}
+
+static void weights_candidates_release(struct query_weights_data *qwd, size_t from) {
+    for(size_t i = from; i < qwd->candidates.used ; i++) {
+        struct weights_candidate *c = &qwd->candidates.array[i];
+        rrdmetric_release(c->rma);
+        rrdinstance_release(c->ria);
+        rrdcontext_release(c->rca);
+    }
+
+    if(from < qwd->candidates.used)
+        qwd->candidates.used = from;
+}
+
+static void weights_candidates_free(struct query_weights_data *qwd) {
+    weights_candidates_release(qwd, 0);
+    freez(qwd->candidates.array);
+    qwd->candidates.array = NULL;
+    qwd->candidates.size = 0;
+}
+
+static void weights_stats_merge(WEIGHTS_STATS *dst, WEIGHTS_STATS *src) {
+    if(src->max_base_high_ratio > dst->max_base_high_ratio)
+        dst->max_base_high_ratio = src->max_base_high_ratio;
+
+    dst->db_points += src->db_points;
+    dst->result_points += src->result_points;
+    dst->db_queries += src->db_queries;
+    dst->binary_searches += src->binary_searches;
+    for(size_t tier = 0; tier < nd_profile.storage_tiers; tier++)
+        dst->db_points_per_tier[tier] += src->db_points_per_tier[tier];
+}
+
+// the top-K pre-pass: query the averages of the two windows (single point queries,
+// so the planner picks the cheapest tier) and use their relative change as the
+// bound for ranking the candidates - volume reuses these averages as-is
+static void weights_candidate_prepass(struct query_weights_data *qwd, struct weights_candidate *c, WEIGHTS_STATS *stats) {
+    QUERY_WEIGHTS_REQUEST *qwr = qwd->qwr;
+    RRDR_OPTIONS options = qwr->options | RRDR_OPTION_MATCH_IDS | RRDR_OPTION_ABSOLUTE | RRDR_OPTION_NATURAL_POINTS;
+
+    c->averages[0] = rrdmetric2value(c->host, c->rca, c->ria, c->rma, qwr->baseline_after, qwr->baseline_before,
+                                     options, qwr->time_group_method, qwr->time_group_options, qwr->tier, 0,
+                                     QUERY_SOURCE_API_WEIGHTS, STORAGE_PRIORITY_SYNCHRONOUS_FIRST);
+    merge_query_value_to_stats(&c->averages[0], stats, 1);
+
+    c->averages[1] = rrdmetric2value(c->host, c->rca, c->ria, c->rma, qwr->after, qwr->before,
+                                     options, qwr->time_group_method, qwr->time_group_options, qwr->tier, 0,
+                                     QUERY_SOURCE_API_WEIGHTS, STORAGE_PRIORITY_SYNCHRONOUS_FIRST);
+    merge_query_value_to_stats(&c->averages[1], stats, 1);
+
+    c->has_averages = true;
+
+    NETDATA_DOUBLE base = netdata_double_isnumber(c->averages[0].value) ? c->averages[0].value : 0.0;
+    NETDATA_DOUBLE high = c->averages[1].value;
+
+    if(!netdata_double_isnumber(high))
+        // no data in the highlighted window - nothing to correlate
+        c->bound = 0.0;
+    else if(netdata_double_is_zero(base))
+        c->bound = fabsndd(high);
+    else
+        c->bound = fabsndd(high - base) / fabsndd(base);
+}
+
+static void weights_candidate_execute(struct query_weights_data *qwd, struct weights_candidate *c, DICTIONARY *results, WEIGHTS_STATS *stats) {
+    QUERY_WEIGHTS_REQUEST *qwr = qwd->qwr;
+
+    switch(qwr->method) {
+        case WEIGHTS_METHOD_MC_VOLUME:
+            rrdset_metric_correlations_volume(
+                    c->host, c->rca, c->ria, c->rma,
+                    results,
+                    qwr->baseline_after, qwr->baseline_before,
+                    qwr->after, qwr->before,
+                    qwr->options, qwr->time_group_method, qwr->time_group_options, qwr->tier,
+                    stats, qwd->register_zero,
+                    c->has_averages ? c->averages : NULL
+            );
+            break;
+
+        default:
+        case WEIGHTS_METHOD_MC_KS2:
+            rrdset_metric_correlations_ks2(
+                    c->host, c->rca, c->ria, c->rma,
+                    results,
+                    qwr->baseline_after, qwr->baseline_before,
+                    qwr->after, qwr->before, qwr->points,
+                    qwr->options, qwr->time_group_method, qwr->time_group_options, qwr->tier, qwd->shifts,
+                    stats, qwd->register_zero
+            );
+            break;
+    }
+}
+
+struct weights_worker {
+    struct query_weights_data *qwd;
+    ND_THREAD *thread;
+    size_t id;
+    bool prepass;
+    bool main;                      // the thread of the request - the only one calling the interrupt callback
+    DICTIONARY *results;
+    WEIGHTS_STATS stats;
+};
+
+static void weights_worker_run(struct weights_worker *ww) {
+    struct query_weights_data *qwd = ww->qwd;
+    QUERY_WEIGHTS_REQUEST *qwr = qwd->qwr;
+
+    while(!__atomic_load_n(&qwd->candidates.stop, __ATOMIC_RELAXED)) {
+        size_t i = __atomic_fetch_add(&qwd->candidates.next, 1, __ATOMIC_RELAXED);
+        if(i >= qwd->candidates.used)
+            break;
+
+        if(ww->main && qwr->interrupt_callback && qwr->interrupt_callback(qwr->interrupt_callback_data)) {
+            qwd->interrupted = true;
+            __atomic_store_n(&qwd->candidates.stop, true, __ATOMIC_RELAXED);
+            break;
+        }
+
+        struct weights_candidate *c = &qwd->candidates.array[i];
+        if(ww->prepass)
+            weights_candidate_prepass(qwd, c, &ww->stats);
+        else {
+            weights_candidate_execute(qwd, c, ww->results, &ww->stats);
+            c->worker = ww->id;
+        }
+
+        if(now_monotonic_usec() - qwd->timings.received_ut > qwd->timeout_us) {
+            __atomic_store_n(&qwd->timed_out, true, __ATOMIC_RELAXED);
+            __atomic_store_n(&qwd->candidates.stop, true, __ATOMIC_RELAXED);
+            break;
+        }
+
+        if(!ww->prepass)
+            query_progress_done_step(qwr->transaction, 1);
+    }
+}
+
+static void weights_worker_thread(void *ptr) {
+    weights_worker_run(ptr);
+}
+
+static void weights_candidates_run(struct query_weights_data *qwd, bool prepass) {
+    size_t workers = qwd->candidates.used / WEIGHTS_MIN_CANDIDATES_PER_WORKER;
+    size_t cpus = os_get_system_cpus();
+    if(workers > cpus) workers = cpus;
+    if(workers > WEIGHTS_MAX_WORKERS) workers = WEIGHTS_MAX_WORKERS;
+    if(!workers) workers = 1;
+
+    qwd->candidates.next = 0;
+
+    struct weights_worker ww[workers];
+    for(size_t w = 0; w < workers ; w++) {
+        ww[w] = (struct weights_worker) {
+                .qwd = qwd,
+                .id = w,
+                .prepass = prepass,
+                .main = (w == 0),
+                .results = prepass ? NULL : register_result_init(),
+                .stats = {},
+        };
+
+        if(w) {
+            // if the thread cannot be created, the other workers will pick up its share
+            char tag[15 + 1];
+            snprintfz(tag, sizeof(tag) - 1, "WEIGHTS[%zu]", w);
+            ww[w].thread = nd_thread_create(tag, NETDATA_THREAD_OPTION_DONT_LOG, weights_worker_thread, &ww[w]);
+        }
+    }
+
+    weights_worker_run(&ww[0]);
+
+    for(size_t w = 0; w < workers ; w++) {
+        if(ww[w].thread)
+            nd_thread_join(ww[w].thread);
+
+        weights_stats_merge(&qwd->stats, &ww[w].stats);
+    }
+
+    if(prepass)
+        return;
+
+    // The workers pick candidates in any order, but the output groups the metrics
+    // of each instance and context together, opening a JSON object whenever they
+    // change. So the results are merged in the order the scope was walked.
+    for(size_t i = 0; i < qwd->candidates.used ; i++) {
+        struct weights_candidate *c = &qwd->candidates.array[i];
+        if(c->worker == WEIGHTS_NO_WORKER)
+            continue;
+
+        char key[20 + 1];
+        ssize_t len = snprintfz(key, sizeof(key) - 1, "%p", c->rma);
+        struct register_result *t = dictionary_get_advanced(ww[c->worker].results, key, len);
+        if(t)
+            dictionary_set_advanced(qwd->results, key, len, t, sizeof(*t), NULL);
+    }
+
+    for(size_t w = 0; w < workers ; w++)
+        register_result_destroy(ww[w].results);
+}
+
+static int weights_candidates_bound_compare(const void *a, const void *b) {
+    const struct weights_candidate *c1 = a, *c2 = b;
+
+    if(c1->bound > c2->bound) return -1;
+    if(c1->bound < c2->bound) return 1;
+    return 0;
+}
+
+static int weights_candidates_order_compare(const void *a, const void *b) {
+    const struct weights_candidate *c1 = a, *c2 = b;
+
+    if(c1->order < c2->order) return -1;
+    if(c1->order > c2->order) return 1;
+    return 0;
+}
+
+static void weights_candidates_execute(struct query_weights_data *qwd) {
+    size_t top_k = qwd->qwr->top_k;
+
+    if(top_k && qwd->candidates.used > top_k) {
+        // rank all candidates by their cheap volume bound
+        // and keep only the top-K for the expensive pass
+        weights_candidates_run(qwd, true);
+        if(__atomic_load_n(&qwd->candidates.stop, __ATOMIC_RELAXED))
+            return;
+
+        qsort(qwd->candidates.array, qwd->candidates.used, sizeof(struct weights_candidate), weights_candidates_bound_compare);
+        query_progress_done_step(qwd->qwr->transaction, qwd->candidates.used - top_k);
+        weights_candidates_release(qwd, top_k);
+
+        // the ranking only selects the candidates, the output keeps the scope order
+        qsort(qwd->candidates.array, qwd->candidates.used, sizeof(struct weights_candidate), weights_candidates_order_compare);
+    }
+
+    weights_candidates_run(qwd, false);
+    qwd->timings.executed_ut = now_monotonic_usec();
+}
+
 // ----------------------------------------------------------------------------
 // The main function
 
@@ -1912,27 +2214,12 @@ static ssize_t weights_for_rrdmetric(void *data, RRDHOST *host, RRDCONTEXT_ACQUI
             break;
 
         case WEIGHTS_METHOD_MC_VOLUME:
-            rrdset_metric_correlations_volume(
-                    host, rca, ria, rma,
-                    qwd->results,
-                    qwr->baseline_after, qwr->baseline_before,
-                    qwr->after, qwr->before,
-                    qwr->options, qwr->time_group_method, qwr->time_group_options, qwr->tier,
-                    &qwd->stats, qwd->register_zero
-            );
-            break;
-
         default:
         case WEIGHTS_METHOD_MC_KS2:
-            rrdset_metric_correlations_ks2(
-                    host, rca, ria, rma,
-                    qwd->results,
-                    qwr->baseline_after, qwr->baseline_before,
-                    qwr->after, qwr->before, qwr->points,
-                    qwr->options, qwr->time_group_method, qwr->time_group_options, qwr->tier, qwd->shifts,
-                    &qwd->stats, qwd->register_zero
-            );
-            break;
+            // metric correlations are executed in parallel,
+            // once all the candidate metrics have been collected
+            weights_candidate_add(qwd, host, rca, ria, rma);
+            return 1;
     }
 
     qwd->timings.executed_ut = now_monotonic_usec();
@@ -2144,6 +2431,9 @@ int web_api_v12_weights(BUFFER *wb, QUERY_WEIGHTS_REQUEST *qwr) {
         }
     }
 
+    if(qwd.candidates.used)
+        weights_candidates_execute(&qwd);
+
     if(!qwd.register_zero) {
         // put it back, to show it in the response
         qwr->options |= RRDR_OPTION_NONZERO;
@@ -2242,6 +2532,9 @@ int web_api_v12_weights(BUFFER *wb, QUERY_WEIGHTS_REQUEST *qwr) {
     }
 
 cleanup:
+    qwr->stats.db_points = qwd.stats.db_points;
+    qwr->stats.result_points = qwd.stats.result_points;
+
     simple_pattern_free(qwd.scope_nodes_sp);
     simple_pattern_free(qwd.scope_contexts_sp);
     simple_pattern_free(qwd.scope_instances_sp);
@@ -2258,6 +2551,7 @@ cleanup:
     pattern_array_free(qwd.labels_pa);
 
     register_result_destroy(qwd.results);
+    weights_candidates_free(&qwd);
 
     if(error) {
         buffer_flush(wb);
@@ -57,11 +57,17 @@ typedef struct query_weights_request {
     size_t tier;
     time_t timeout_ms;
     size_t cardinality_limit;
+    size_t top_k;               // ks2 and volume: correlate only the top-K metrics, ranked by their change of average
 
     weights_interrupt_callback_t interrupt_callback;
     void *interrupt_callback_data;
 
     nd_uuid_t *transaction;
+
+    struct {
+        size_t db_points;       // output: the points read from the database
+        size_t result_points;   // output: the points produced by the queries
+    } stats;
 } QUERY_WEIGHTS_REQUEST;
 
 int web_api_v12_weights(BUFFER *wb, QUERY_WEIGHTS_REQUEST *qwr);
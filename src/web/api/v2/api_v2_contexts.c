@@ -72,6 +72,7 @@ int api_v2_contexts_internal(RRDHOST *host __maybe_unused, struct web_client *w,
 
     buffer_flush(w->response.data);
     buffer_no_cacheable(w->response.data);
+    web_client_response_stream_enable(w);
     return rrdcontext_to_json_v2(w->response.data, &req, mode);
 }
 
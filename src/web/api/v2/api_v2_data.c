@@ -290,6 +290,10 @@ static int api_v23_data_internal(RRDHOST *host __maybe_unused, struct web_client
         buffer_strcat(w->response.data, "(");
     }
 
+    // the google datatable may need to replace the whole response after the query
+    if(format != DATASOURCE_DATATABLE_JSONP)
+        web_client_response_stream_enable(w);
+
     owa = onewayalloc_create(0);
     ret = data_query_execute(owa, w->response.data, qt, &last_timestamp_in_data);
 
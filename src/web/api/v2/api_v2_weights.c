@@ -13,6 +13,7 @@ int web_client_api_request_weights(RRDHOST *host, struct web_client *w, char *ur
     time_t timeout_ms = 0;
     size_t tier = 0;
     size_t cardinality_limit = 0;
+    size_t top_k = 0;
     const char *time_group_options = NULL, *scope_contexts = NULL, *scope_nodes = NULL, *scope_instances = NULL, *scope_labels = NULL, *scope_dimensions = NULL,
                *contexts = NULL, *nodes = NULL, *instances = NULL, *dimensions = NULL, *labels = NULL, *alerts = NULL;
 
@@ -54,6 +55,9 @@ int web_client_api_request_weights(RRDHOST *host, struct web_client *w, char *ur
         else if (!strcmp(name, "cardinality_limit"))
             cardinality_limit = str2ul(value);
 
+        else if (!strcmp(name, "top_k"))
+            top_k = str2ul(value);
+
         else if((api_version == 1 && !strcmp(name, "group")) || (api_version >= 2 && !strcmp(name, "time_group")))
             time_group_method = time_grouping_parse(value, RRDR_GROUPING_AVERAGE);
 
@@ -148,6 +152,7 @@ int web_client_api_request_weights(RRDHOST *host, struct web_client *w, char *ur
         .tier = tier,
         .timeout_ms = timeout_ms,
         .cardinality_limit = cardinality_limit,
+        .top_k = top_k,
 
         .interrupt_callback = web_client_interrupt_callback,
         .interrupt_callback_data = w,
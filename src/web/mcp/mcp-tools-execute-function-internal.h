@@ -162,7 +162,7 @@ void mcp_functions_data_init(MCP_FUNCTION_DATA *data);
 void mcp_functions_data_cleanup(MCP_FUNCTION_DATA *data);
 
 // Analyze the JSON response and determine its type
-MCP_FUNCTION_TYPE mcp_functions_analyze_response(struct json_object *json_obj, int *out_status);
+MCP_FUNCTION_TYPE mcp_functions_analyze_response(const char *json, size_t len, int *out_status);
 
 // Convert string operator to enum type
 OPERATOR_TYPE mcp_functions_string_to_operator(const char *op_str);
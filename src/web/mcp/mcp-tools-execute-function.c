@@ -7,7 +7,45 @@
 #include "database/rrdfunctions.h"
 
 // Analyze the JSON response and determine its type
-MCP_FUNCTION_TYPE mcp_functions_analyze_response(struct json_object *json_obj, int *out_status) {
+MCP_FUNCTION_TYPE mcp_functions_analyze_response(const char *json, size_t len, int *out_status) {
+    // validate and peek at the response, without building a DOM
+    JSON_SCAN_VALUE root, type_obj, has_history_obj, status_obj;
+    if (!json || !json_scan(json, len, &root, NULL)) return FN_TYPE_UNKNOWN;
+    
+    // Type is required
+    if (!json_scan_object_get(&root, "type", &type_obj)) {
+        return FN_TYPE_NOT_TABLE;
+    }
+    
+    if (!json_scan_string_equals(&type_obj, "table")) {
+        return FN_TYPE_NOT_TABLE;
+    }
+    
+    // has_history is optional - assume false if missing
+    bool has_history = false;
+    if (json_scan_object_get(&root, "has_history", &has_history_obj)) {
+        has_history = json_scan_bool(&has_history_obj, false);
+    }
+    
+    // Status is optional - assume 200 if missing
+    int status = 200;
+    if (json_scan_object_get(&root, "status", &status_obj)) {
+        status = (int)json_scan_int64(&status_obj, 0);
+    }
+    
+    if (out_status) *out_status = status;
+    
+    // Return appropriate type based on has_history
+    if (has_history) {
+        return FN_TYPE_TABLE_WITH_HISTORY;
+    } else {
+        return FN_TYPE_TABLE;
+    }
+}
+
+// Analyze a response parsed by json-c - for the responses json_scan() rejects,
+// but json-c accepts (raw control characters in strings, NaN / Infinity, deep nesting)
+static MCP_FUNCTION_TYPE mcp_functions_analyze_response_json_c(struct json_object *json_obj, int *out_status) {
     if (!json_obj) return FN_TYPE_UNKNOWN;
     
     struct json_object *type_obj = NULL;
@@ -38,12 +76,7 @@ MCP_FUNCTION_TYPE mcp_functions_analyze_response(struct json_object *json_obj, i
     
     if (out_status) *out_status = status;
     
-    // Return appropriate type based on has_history
-    if (has_history) {
-        return FN_TYPE_TABLE_WITH_HISTORY;
-    } else {
-        return FN_TYPE_TABLE;
-    }
+    return has_history ? FN_TYPE_TABLE_WITH_HISTORY : FN_TYPE_TABLE;
 }
 
 // Helper function to create a filtered copy of a column definition
@@ -1039,7 +1072,7 @@ static void mcp_process_table_result(MCP_FUNCTION_DATA *data, size_t max_size_th
     const char *json_str = buffer_tostring(data->input.json);
     size_t result_size = buffer_strlen(data->input.json);
 
-    if (!data->input.jobj) {
+    if (data->input.type == FN_TYPE_UNKNOWN || (!data->input.jobj && data->input.type != FN_TYPE_NOT_TABLE)) {
         buffer_strcat(data->output.result, json_str); // Return original if JSON is NULL
         data->output.status = MCP_TABLE_NOT_JSON;
         return;
@@ -2248,11 +2281,19 @@ static MCP_RETURN_CODE mcp_function_run(MCP_FUNCTION_DATA *data, BUFFER *payload
     
     // Store the result in data->input
     data->input.json = result_buffer;
-    data->input.jobj = json_tokener_parse(buffer_tostring(result_buffer));
     
     // Analyze the response type
     int status = 0;
-    data->input.type = mcp_functions_analyze_response(data->input.jobj, &status);
+    data->input.type = mcp_functions_analyze_response(buffer_tostring(result_buffer), buffer_strlen(result_buffer), &status);
+    
+    if (data->input.type == FN_TYPE_UNKNOWN) {
+        // json_scan() is stricter than json-c - let json-c decide, as it did before
+        data->input.jobj = json_tokener_parse(buffer_tostring(result_buffer));
+        data->input.type = mcp_functions_analyze_response_json_c(data->input.jobj, &status);
+    }
+    // only tables are processed - the rest are returned as-is, so they do not need a DOM
+    else if (data->input.type == FN_TYPE_TABLE || data->input.type == FN_TYPE_TABLE_WITH_HISTORY)
+        data->input.jobj = json_tokener_parse(buffer_tostring(result_buffer));
     
     return MCP_RC_OK;
 }
@@ -2268,7 +2309,7 @@ static MCP_RETURN_CODE mcp_functions_process_table(MCP_FUNCTION_DATA *data, MCP_
     // Start building content array for the result
     buffer_json_member_add_array(data->request.mcpc->result, "content");
     
-    if (!data->input.jobj) {
+    if (data->input.type == FN_TYPE_UNKNOWN || (!data->input.jobj && data->input.type != FN_TYPE_NOT_TABLE)) {
         // Not valid JSON - return raw output with message
         data->output.status = MCP_TABLE_NOT_JSON;
         buffer_strcat(data->output.result, buffer_tostring(data->input.json));
@@ -16,9 +16,10 @@ long web_client_streaming_rate_t = 0L;
 #define WORKER_JOB_RCV_DATA       6
 #define WORKER_JOB_SND_DATA       7
 #define WORKER_JOB_PROCESS        8
+#define WORKER_JOB_OFFLOADED      9
 
-#if (WORKER_UTILIZATION_MAX_JOB_TYPES < 9)
-#error Please increase WORKER_UTILIZATION_MAX_JOB_TYPES to at least 8
+#if (WORKER_UTILIZATION_MAX_JOB_TYPES < 10)
+#error Please increase WORKER_UTILIZATION_MAX_JOB_TYPES to at least 10
 #endif
 
 /*
@@ -74,6 +75,25 @@ struct web_server_static_threaded_worker {
     volatile size_t receptions;
     volatile size_t sends;
     volatile size_t max_concurrent;
+    volatile size_t offloaded;
+
+    // requests executed by the query executor
+    struct {
+        int pipe[2];                                    // the executor signals completions via this pipe
+        POLLINFO *pi;                                   // the read end of the pipe, in our poll
+
+        SPINLOCK spinlock;
+        struct web_server_offloaded_request *running;   // dispatched to the query executor
+        struct web_server_offloaded_request *completed; // completed, to be put back to our poll
+    } executor;
+};
+
+struct web_server_offloaded_request {
+    struct web_server_static_threaded_worker *worker;
+    POLLINFO *pi;
+    struct web_client *w;
+
+    struct web_server_offloaded_request *prev, *next;
 };
 
 static long long static_threaded_workers_count = 1;
@@ -148,9 +168,15 @@ cleanup:
 }
 
 // TCP client disconnected
+static void web_server_offloaded_request_wait(POLLINFO *pi);
+
 static void web_server_del_callback(POLLINFO *pi) {
     worker_is_busy(WORKER_JOB_DEL_COLLECTION);
 
+    // the client may still be used by the query executor (when shutting down)
+    if(unlikely(pi->flags & POLLINFO_FLAG_REMOVED_FROM_POLL))
+        web_server_offloaded_request_wait(pi);
+
     worker_private->disconnected++;
 
     struct web_client *w = (struct web_client *)pi->data;
@@ -174,6 +200,199 @@ void web_server_remove_current_socket_from_poll(void) {
     poll_process_remove_from_poll(current_thread_pollinfo);
 }
 
+// ----------------------------------------------------------------------------
+// offloading heavy queries to the query executor
+
+static int web_server_executor_pipe_callback(POLLINFO *pi, nd_poll_event_t *events);
+
+static void web_server_offloaded_request_execute(void *data) {
+    // runs on a query executor thread - the web server thread does not touch the client meanwhile
+    struct web_server_offloaded_request *r = data;
+
+    current_thread_pollinfo = r->pi;
+    web_client_process_request_from_web_server(r->w);
+    current_thread_pollinfo = NULL;
+}
+
+static void web_server_offloaded_request_complete(void *data) {
+    // runs on a query executor thread - hand the client back to its web server thread
+    struct web_server_offloaded_request *r = data;
+    struct web_server_static_threaded_worker *wp = r->worker;
+
+    spinlock_lock(&wp->executor.spinlock);
+    bool signal = !wp->executor.completed; // write to the pipe, only when the list was empty
+    DOUBLE_LINKED_LIST_REMOVE_ITEM_UNSAFE(wp->executor.running, r, prev, next);
+    DOUBLE_LINKED_LIST_APPEND_ITEM_UNSAFE(wp->executor.completed, r, prev, next);
+    spinlock_unlock(&wp->executor.spinlock);
+
+    if(signal && write(wp->executor.pipe[PIPE_WRITE], " ", 1) != 1) {
+        nd_log_limit_static_global_var(erl, 1, 0);
+        nd_log_limit(&erl, NDLS_DAEMON, NDLP_ERR, "WEB SERVER: cannot write to the query executor pipe");
+    }
+}
+
+static bool web_server_offload_request(POLLINFO *pi, struct web_client *w) {
+    struct web_server_static_threaded_worker *wp = worker_private;
+
+    WEB_QUERY_PRIORITY priority;
+    if(likely(!web_query_executor_enabled() || wp->executor.pipe[PIPE_READ] == -1 ||
+               !web_query_executor_classify(buffer_tostring(w->response.data), buffer_strlen(w->response.data), &priority)))
+        return false;
+
+    if(unlikely(!wp->executor.pi)) {
+        wp->executor.pi = poll_add_fd(pi->p
+                                      , wp->executor.pipe[PIPE_READ]
+                                      , SOCK_DGRAM
+                                      , HTTP_ACL_NONE
+                                      , POLLINFO_FLAG_SERVER_SOCKET | POLLINFO_FLAG_DONT_CLOSE
+                                      , "query executor"
+                                      , ""
+                                      , ""
+                                      , NULL
+                                      , NULL
+                                      , web_server_executor_pipe_callback
+                                      , NULL
+                                      , NULL
+        );
+
+        if(!wp->executor.pi)
+            return false;
+
+        wp->executor.pi->data = wp;
+    }
+
+    // the socket stays out of our poll while the query runs
+    if(!(pi->flags & POLLINFO_FLAG_REMOVED_FROM_POLL)) {
+        poll_process_remove_from_poll(pi);
+        if(!(pi->flags & POLLINFO_FLAG_REMOVED_FROM_POLL))
+            return false;
+    }
+
+    struct web_server_offloaded_request *r = callocz(1, sizeof(*r));
+    r->worker = wp;
+    r->pi = pi;
+    r->w = w;
+
+    spinlock_lock(&wp->executor.spinlock);
+    DOUBLE_LINKED_LIST_APPEND_ITEM_UNSAFE(wp->executor.running, r, prev, next);
+    spinlock_unlock(&wp->executor.spinlock);
+
+    if(!web_query_executor_dispatch(priority, web_server_offloaded_request_execute, web_server_offloaded_request_complete, r)) {
+        spinlock_lock(&wp->executor.spinlock);
+        DOUBLE_LINKED_LIST_REMOVE_ITEM_UNSAFE(wp->executor.running, r, prev, next);
+        spinlock_unlock(&wp->executor.spinlock);
+        freez(r);
+
+        // the caller will process it and update the events
+        return false;
+    }
+
+    wp->offloaded++;
+    netdata_log_debug(D_WEB_CLIENT, "%llu: offloaded %s request on fd %d to the query executor.",
+                      w->id, web_query_priority_2str(priority), pi->fd);
+
+    return true;
+}
+
+static void web_server_offloaded_request_wait(POLLINFO *pi) {
+    struct web_server_static_threaded_worker *wp = worker_private;
+
+    while(true) {
+        bool running = false;
+
+        spinlock_lock(&wp->executor.spinlock);
+        for(struct web_server_offloaded_request *r = wp->executor.running; r ; r = r->next) {
+            if(r->pi == pi) {
+                running = true;
+                break;
+            }
+        }
+
+        if(!running) {
+            for(struct web_server_offloaded_request *r = wp->executor.completed; r ; r = r->next) {
+                if(r->pi == pi) {
+                    DOUBLE_LINKED_LIST_REMOVE_ITEM_UNSAFE(wp->executor.completed, r, prev, next);
+                    freez(r);
+                    break;
+                }
+            }
+        }
+        spinlock_unlock(&wp->executor.spinlock);
+
+        if(!running)
+            break;
+
+        sleep_usec(1000);
+    }
+}
+
+// process the requests the client has already sent, while the previous response was in progress
+// returns true when a request has been offloaded to the query executor
+static bool web_server_process_pipelined_requests(POLLINFO *pi, struct web_client *w) {
+    while(w->fd == pi->fd && web_client_resume_pipelined_request(w)) {
+        if(web_server_offload_request(pi, w))
+            return true;
+
+        netdata_log_debug(D_WEB_CLIENT, "%llu: processing pipelined request on fd %d.", w->id, pi->fd);
+        worker_is_busy(WORKER_JOB_PROCESS);
+        current_thread_pollinfo = pi;
+        web_client_process_request_from_web_server(w);
+        current_thread_pollinfo = NULL;
+    }
+
+    return false;
+}
+
+static nd_poll_event_t web_server_client_events(POLLINFO *pi, struct web_client *w) {
+    nd_poll_event_t events = 0;
+
+    if(unlikely(w->fd == pi->fd && web_client_has_wait_receive(w)))
+        events |= ND_POLL_READ;
+
+    if(unlikely(w->fd == pi->fd && web_client_has_wait_send(w)))
+        events |= ND_POLL_WRITE;
+
+    return events;
+}
+
+static void web_server_offloaded_requests_resume(struct web_server_static_threaded_worker *wp) {
+    spinlock_lock(&wp->executor.spinlock);
+    struct web_server_offloaded_request *completed = wp->executor.completed;
+    wp->executor.completed = NULL;
+    spinlock_unlock(&wp->executor.spinlock);
+
+    while(completed) {
+        struct web_server_offloaded_request *r = completed;
+        DOUBLE_LINKED_LIST_REMOVE_ITEM_UNSAFE(completed, r, prev, next);
+
+        POLLINFO *pi = r->pi;
+        struct web_client *w = r->w;
+        freez(r);
+
+        worker_is_busy(WORKER_JOB_OFFLOADED);
+
+        if(web_server_process_pipelined_requests(pi, w))
+            continue;
+
+        if(web_server_check_client_status(w) == -1 || !poll_process_add_to_poll(pi, web_server_client_events(pi, w)))
+            poll_process_close(pi);
+    }
+}
+
+static int web_server_executor_pipe_callback(POLLINFO *pi, nd_poll_event_t *events) {
+    struct web_server_static_threaded_worker *wp = pi->data;
+    *events = ND_POLL_READ;
+
+    char buffer[1024];
+    while(read(pi->fd, buffer, sizeof(buffer)) > 0)
+        ;
+
+    web_server_offloaded_requests_resume(wp);
+
+    worker_is_idle();
+    return 0;
+}
+
 static int web_server_rcv_callback(POLLINFO *pi, nd_poll_event_t *events) {
     int ret = -1;
     worker_is_busy(WORKER_JOB_RCV_DATA);
@@ -191,11 +410,23 @@ static int web_server_rcv_callback(POLLINFO *pi, nd_poll_event_t *events) {
 
         netdata_log_debug(D_WEB_CLIENT, "%llu: processing received data on fd %d.", w->id, fd);
         worker_is_idle();
+
+        if(web_server_offload_request(pi, w)) {
+            // the client is not ours until the query executor completes it
+            ret = 0;
+            goto cleanup;
+        }
+
         worker_is_busy(WORKER_JOB_PROCESS);
         current_thread_pollinfo = pi;
         web_client_process_request_from_web_server(w);
         current_thread_pollinfo = NULL;
 
+        if(web_server_process_pipelined_requests(pi, w)) {
+            ret = 0;
+            goto cleanup;
+        }
+
         if (unlikely(w->mode == HTTP_REQUEST_MODE_STREAM)) {
             ssize_t rc = web_client_send(w);
             if(rc > 0)
@@ -232,9 +463,8 @@ static int web_server_snd_callback(POLLINFO *pi, nd_poll_event_t *events) {
     worker_private->sends++;
 
     struct web_client *w = (struct web_client *)pi->data;
-    int fd = pi->fd;
 
-    netdata_log_debug(D_WEB_CLIENT, "%llu: sending data on fd %d.", w->id, fd);
+    netdata_log_debug(D_WEB_CLIENT, "%llu: sending data on fd %d.", w->id, pi->fd);
 
     current_thread_pollinfo = pi;
     ssize_t ret = web_client_send(w);
@@ -247,11 +477,12 @@ static int web_server_snd_callback(POLLINFO *pi, nd_poll_event_t *events) {
 
     pulse_web_server_sent_bytes(ret);
 
-    if(unlikely(w->fd == fd && web_client_has_wait_receive(w)))
-        *events |= ND_POLL_READ;
+    if(web_server_process_pipelined_requests(pi, w)) {
+        retval = 0;
+        goto cleanup;
+    }
 
-    if(unlikely(w->fd == fd && web_client_has_wait_send(w)))
-        *events |= ND_POLL_WRITE;
+    *events |= web_server_client_events(pi, w);
 
     retval = web_server_check_client_status(w);
 
@@ -267,14 +498,23 @@ static void socket_listen_main_static_threaded_worker_cleanup(void *pptr) {
     worker_private = CLEANUP_FUNCTION_GET_PTR(pptr);
     if(!worker_private) return;
 
-    netdata_log_info("stopped after %zu connects, %zu disconnects (max concurrent %zu), %zu receptions and %zu sends",
+    netdata_log_info("stopped after %zu connects, %zu disconnects (max concurrent %zu), %zu receptions, %zu sends and %zu offloaded queries",
             worker_private->connected,
             worker_private->disconnected,
             worker_private->max_concurrent,
             worker_private->receptions,
-            worker_private->sends
+            worker_private->sends,
+            worker_private->offloaded
     );
 
+    for(int i = PIPE_READ; i <= PIPE_WRITE ; i++) {
+        if(worker_private->executor.pipe[i] != -1) {
+            close(worker_private->executor.pipe[i]);
+            worker_private->executor.pipe[i] = -1;
+        }
+    }
+    worker_private->executor.pi = NULL;
+
     worker_unregister();
 }
 
@@ -297,6 +537,18 @@ void socket_listen_main_static_threaded_worker(void *ptr) {
     worker_register_job_name(WORKER_JOB_RCV_DATA, "receive");
     worker_register_job_name(WORKER_JOB_SND_DATA, "send");
     worker_register_job_name(WORKER_JOB_PROCESS, "process");
+    worker_register_job_name(WORKER_JOB_OFFLOADED, "offloaded");
+
+    spinlock_init(&worker_private->executor.spinlock);
+    if(pipe(worker_private->executor.pipe) != 0) {
+        netdata_log_error("WEB SERVER: cannot create the query executor pipe - queries will not be offloaded.");
+        worker_private->executor.pipe[PIPE_READ] = -1;
+        worker_private->executor.pipe[PIPE_WRITE] = -1;
+    }
+    else {
+        sock_setnonblock(worker_private->executor.pipe[PIPE_READ], true);
+        sock_setnonblock(worker_private->executor.pipe[PIPE_WRITE], true);
+    }
 
     CLEANUP_FUNCTION_REGISTER(socket_listen_main_static_threaded_worker_cleanup) cleanup_ptr = worker_private;
     poll_events(&api_sockets
@@ -345,6 +597,10 @@ static void socket_listen_main_static_threaded_cleanup(void *pptr) {
         (void) nd_thread_join(static_workers_private_data[i].thread);
     }
 
+    // all web server threads have stopped, nothing is dispatched anymore
+    web_query_executor_destroy();
+    web_static_cache_destroy();
+
     static_thread->enabled = NETDATA_MAIN_THREAD_EXITED;
 }
 
@@ -363,6 +619,8 @@ void socket_listen_main_static_threaded(void *ptr) {
     netdata_ssl_initialize_ctx(NETDATA_SSL_WEB_SERVER_CTX);
 
     static_threaded_workers_count = netdata_conf_web_query_threads();
+    web_query_executor_init(netdata_conf_web_query_executor_threads());
+    web_static_cache_init(netdata_conf_web_static_cache_size());
 
     size_t max_sockets = (size_t)inicfg_get_number(&netdata_config, CONFIG_SECTION_WEB, "web server max sockets",
                                                    (long long int)(rlimit_nofile.rlim_cur / 4));
@@ -1,10 +1,16 @@
 // SPDX-License-Identifier: GPL-3.0-or-later
 
 #include "web_client.h"
+#include "web_client_cache.h"
+#include "web_static_cache.h"
 #include "web/websocket/websocket.h"
 #include "web/mcp/adapters/mcp-http.h"
 #include "web/mcp/adapters/mcp-sse.h"
 
+#if defined(OS_LINUX)
+#include <sys/sendfile.h>
+#endif
+
 // this is an async I/O implementation of the web server request parser
 // it is used by all netdata web servers
 
@@ -106,6 +112,16 @@ static inline char *strip_control_characters(char *url) {
     return url;
 }
 
+void web_client_response_file_close(struct web_client *w) {
+    if(!w->response.file.size)
+        return;
+
+    close(w->response.file.fd);
+    w->response.file.fd = -1;
+    w->response.file.size = 0;
+    w->response.file.sent = 0;
+}
+
 static void web_client_reset_allocations(struct web_client *w, bool free_all) {
 
     if(free_all) {
@@ -131,6 +147,9 @@ static void web_client_reset_allocations(struct web_client *w, bool free_all) {
 
         buffer_free(w->payload);
         w->payload = NULL;
+
+        buffer_free(w->pipelined);
+        w->pipelined = NULL;
     }
     else {
         // the web client is to be re-used
@@ -164,6 +183,15 @@ static void web_client_reset_allocations(struct web_client *w, bool free_all) {
 
     freez(w->auth_bearer_token);
     w->auth_bearer_token = NULL;
+
+    freez(w->if_none_match);
+    w->if_none_match = NULL;
+
+    // if we were sending a file, close it
+    web_client_response_file_close(w);
+
+    w->response.encoding = WEB_ENCODING_NONE;
+    w->response.identity_size = 0;
     
     // Free WebSocket resources
     freez(w->websocket.key);
@@ -192,7 +220,7 @@ static void web_client_reset_allocations(struct web_client *w, bool free_all) {
     memset(&w->user_auth, 0, sizeof(w->user_auth));
 
     web_client_reset_permissions(w);
-    web_client_flag_clear(w, WEB_CLIENT_ENCODING_GZIP|WEB_CLIENT_ENCODING_DEFLATE);
+    web_client_flag_clear(w, WEB_CLIENT_ENCODING_GZIP|WEB_CLIENT_ENCODING_DEFLATE|WEB_CLIENT_ENCODING_BROTLI|WEB_CLIENT_ENCODING_ZSTD);
     web_client_flag_clear(w, WEB_CLIENT_FLAG_ACCEPT_JSON |
                              WEB_CLIENT_FLAG_ACCEPT_SSE |
                              WEB_CLIENT_FLAG_ACCEPT_TEXT);
@@ -203,8 +231,10 @@ void web_client_log_completed_request(struct web_client *w, bool update_web_stat
     struct timeval tv;
     now_monotonic_high_precision_timeval(&tv);
 
-    size_t size = w->response.data->len;
+    size_t size = w->response.data->len + w->response.stream.size + w->response.file.size;
     size_t sent = w->response.zoutput ? (size_t)w->response.zstream.total_out : size;
+    if(w->response.encoding != WEB_ENCODING_NONE)
+        size = w->response.identity_size;
 
     usec_t prep_ut = w->timings.tv_ready.tv_sec ? dt_usec(&w->timings.tv_ready, &w->timings.tv_in) : 0;
     usec_t sent_ut = w->timings.tv_ready.tv_sec ? dt_usec(&tv, &w->timings.tv_ready) : 0;
@@ -258,13 +288,78 @@ void web_client_log_completed_request(struct web_client *w, bool update_web_stat
     }
 }
 
+static void web_client_response_buffer_recycle(struct web_client *w) {
+    // large response buffers are given back to the pool,
+    // so that idle keep-alive connections do not hold them
+    if(likely(w->response.data->size < WEB_CLIENT_BUFFER_POOL_MIN_SIZE))
+        return;
+
+    BUFFER *wb = w->response.data;
+    w->response.data = buffer_create(NETDATA_WEB_RESPONSE_INITIAL_SIZE, w->statistics.memory_accounting);
+
+    if(!web_client_buffer_pool_put(wb))
+        buffer_free(wb);
+}
+
+static void web_client_response_buffer_prepare(struct web_client *w) {
+    // the previous response on this connection was large,
+    // so start with a large pooled buffer to avoid growing it by reallocations
+    if(likely(w->response.size_hint < WEB_CLIENT_BUFFER_POOL_MIN_SIZE || w->response.data->size >= w->response.size_hint))
+        return;
+
+    BUFFER *wb = web_client_buffer_pool_get(w->response.size_hint);
+    if(!wb)
+        return;
+
+    // the handlers flush the buffer when they respond, but keep the request in it
+    buffer_contents_replace(wb, buffer_tostring(w->response.data), buffer_strlen(w->response.data));
+
+    BUFFER *old = w->response.data;
+    w->response.data = wb;
+
+    if(!web_client_buffer_pool_put(old))
+        buffer_free(old);
+}
+
+static void web_client_pipelined_request_split(struct web_client *w, size_t request_length) {
+    // keep the bytes of the next request(s) the client sent already,
+    // to be processed once the response of this one has been sent
+    size_t len = buffer_strlen(w->response.data);
+    if(likely(request_length >= len))
+        return;
+
+    if(!w->pipelined)
+        w->pipelined = buffer_create(len - request_length + 1, w->statistics.memory_accounting);
+
+    buffer_fast_strcat(w->pipelined, &w->response.data->buffer[request_length], len - request_length);
+
+    w->response.data->len = request_length;
+    w->response.data->buffer[request_length] = '\0';
+}
+
+bool web_client_resume_pipelined_request(struct web_client *w) {
+    if(likely(!w->pipelined || !buffer_strlen(w->pipelined)))
+        return false;
+
+    if(web_client_check_dead(w) || !web_client_has_wait_receive(w) || web_client_has_wait_send(w) ||
+        w->mode == HTTP_REQUEST_MODE_STREAM || w->mode == HTTP_REQUEST_MODE_WEBSOCKET)
+        return false;
+
+    buffer_fast_strcat(w->response.data, buffer_tostring(w->pipelined), buffer_strlen(w->pipelined));
+    buffer_flush(w->pipelined);
+    return true;
+}
+
 void web_client_request_done(struct web_client *w) {
     sock_setcork(w->fd, false);
 
     netdata_log_debug(D_WEB_CLIENT, "%llu: Resetting client.", w->id);
 
+    w->response.size_hint = w->response.data->len + w->response.stream.size;
+
     web_client_log_completed_request(w, true);
     web_client_reset_allocations(w, false);
+    web_client_response_buffer_recycle(w);
 
     w->mode = HTTP_REQUEST_MODE_GET;
 
@@ -282,6 +377,8 @@ void web_client_request_done(struct web_client *w) {
     w->response.sent = 0;
     w->response.code = 0;
     w->response.zoutput = false;
+    w->response.stream.started = false;
+    w->response.stream.size = 0;
 
     w->statistics.received_bytes = 0;
     w->statistics.sent_bytes = 0;
@@ -338,6 +435,27 @@ static int append_slash_to_url_and_redirect(struct web_client *w) {
     return HTTP_RESP_MOVED_PERM;
 }
 
+static void web_client_disable_deflate(struct web_client *w) {
+    // the zlib stream stays initialized, it is released when the request is done
+    w->response.zoutput = false;
+    web_client_flag_clear(w, WEB_CLIENT_CHUNKED_TRANSFER);
+}
+
+static WEB_ENCODING web_client_encodings_accepted(struct web_client *w) {
+    WEB_ENCODING encodings = WEB_ENCODING_NONE;
+
+    if(web_client_flag_check(w, WEB_CLIENT_ENCODING_GZIP))
+        encodings |= WEB_ENCODING_GZIP;
+
+    if(web_client_flag_check(w, WEB_CLIENT_ENCODING_BROTLI))
+        encodings |= WEB_ENCODING_BROTLI;
+
+    if(web_client_flag_check(w, WEB_CLIENT_ENCODING_ZSTD))
+        encodings |= WEB_ENCODING_ZSTD;
+
+    return encodings;
+}
+
 // Work around a bug in the CMocka library by removing this function during testing.
 #ifndef REMOVE_MYSENDFILE
 
@@ -434,6 +552,89 @@ static bool find_filename_to_serve(const char *filename, char *dst, size_t dst_l
     return true;
 }
 
+static bool web_client_etag_matches(const char *if_none_match, const char *etag) {
+    if(strcmp(if_none_match, "*") == 0)
+        return true;
+
+    // the header may have a list of entity tags, possibly weak ones (W/"...")
+    size_t len = strlen(etag);
+    for(const char *s = strstr(if_none_match, etag); s ; s = strstr(s + 1, etag)) {
+        if(s[len] == '\0' || s[len] == ',' || s[len] == ' ')
+            return true;
+    }
+
+    return false;
+}
+
+static inline bool web_client_can_sendfile(struct web_client *w __maybe_unused) {
+#if defined(OS_LINUX)
+    // sendfile() bypasses user space, so it cannot be used with TLS
+    return (web_client_check_conn_tcp(w) || web_client_check_conn_unix(w)) &&
+           !(netdata_ssl_web_server_ctx && SSL_connection(&w->ssl));
+#else
+    return false;
+#endif
+}
+
+static int web_server_static_file_load(struct web_client *w, const char *filename, const char *web_filename, struct stat *statbuf) {
+    bool compressible = web_content_type_is_compressible(contenttype_for_filename(web_filename));
+
+    // images, fonts and media are compressed already
+    if(w->response.zoutput && !compressible)
+        web_client_disable_deflate(w);
+
+    // large files that will be sent as-is, go directly from the page cache to the socket
+    if(!w->response.zoutput && statbuf->st_size >= WEB_CLIENT_SENDFILE_MIN_SIZE && web_client_can_sendfile(w) &&
+        (!compressible || !(web_client_encodings_accepted(w) & (WEB_ENCODING_BROTLI | WEB_ENCODING_ZSTD)))) {
+        int fd = open(web_filename, O_RDONLY | O_CLOEXEC);
+        if(fd != -1) {
+            w->response.file.fd = fd;
+            w->response.file.size = (size_t)statbuf->st_size;
+            w->response.file.sent = 0;
+            return HTTP_RESP_OK;
+        }
+    }
+
+    buffer_need_bytes(w->response.data, (size_t)statbuf->st_size);
+    w->response.data->len = (size_t)statbuf->st_size;
+
+    // open the file
+    int fd = open(web_filename, O_RDONLY | O_CLOEXEC);
+
+    // read the file
+    if(fd != -1 && read(fd, w->response.data->buffer, statbuf->st_size) != statbuf->st_size) {
+        // cannot read the whole file
+        nd_log(NDLS_DAEMON, NDLP_ERR, "Web server failed to read file '%s'", web_filename);
+        close(fd);
+        fd = -1;
+    }
+
+    // check for failures
+    if(fd == -1) {
+        buffer_flush(w->response.data);
+
+        if(errno == EBUSY || errno == EAGAIN) {
+            netdata_log_error("%llu: File '%s' is busy, sending 307 Moved Temporarily to force retry.", w->id, web_filename);
+            w->response.data->content_type = CT_TEXT_HTML;
+            buffer_sprintf(w->response.header, "Location: /%s\r\n", filename);
+            buffer_strcat(w->response.data, "File is currently busy, please try again later: ");
+            buffer_strcat_htmlescape(w->response.data, filename);
+            return HTTP_RESP_REDIR_TEMP;
+        }
+        else {
+            netdata_log_error("%llu: Cannot open file '%s'.", w->id, web_filename);
+            w->response.data->content_type = CT_TEXT_HTML;
+            buffer_strcat(w->response.data, "Cannot open file: ");
+            buffer_strcat_htmlescape(w->response.data, filename);
+            return HTTP_RESP_NOT_FOUND;
+        }
+    }
+    else
+        close(fd);
+
+    return HTTP_RESP_OK;
+}
+
 static int web_server_static_file(struct web_client *w, char *filename) {
     netdata_log_debug(D_WEB_CLIENT, "%llu: Looking for file '%s/%s'", w->id, netdata_configured_web_dir, filename);
 
@@ -479,46 +680,35 @@ static int web_server_static_file(struct web_client *w, char *filename) {
         return append_slash_to_url_and_redirect(w);
 
     buffer_flush(w->response.data);
-    buffer_need_bytes(w->response.data, (size_t)statbuf.st_size);
-    w->response.data->len = (size_t)statbuf.st_size;
 
-    // open the file
-    int fd = open(web_filename, O_RDONLY | O_CLOEXEC);
+    char etag[64];
+    web_static_cache_etag(&statbuf, etag, sizeof(etag));
 
-    // read the file
-    if(fd != -1 && read(fd, w->response.data->buffer, statbuf.st_size) != statbuf.st_size) {
-        // cannot read the whole file
-        nd_log(NDLS_DAEMON, NDLP_ERR, "Web server failed to read file '%s'", web_filename);
-        close(fd);
-        fd = -1;
-    }
+    int code = HTTP_RESP_OK;
+    WEB_ENCODING encoding = WEB_ENCODING_NONE;
 
-    // check for failures
-    if(fd == -1) {
-        buffer_flush(w->response.data);
-
-        if(errno == EBUSY || errno == EAGAIN) {
-            netdata_log_error("%llu: File '%s' is busy, sending 307 Moved Temporarily to force retry.", w->id, web_filename);
-            w->response.data->content_type = CT_TEXT_HTML;
-            buffer_sprintf(w->response.header, "Location: /%s\r\n", filename);
-            buffer_strcat(w->response.data, "File is currently busy, please try again later: ");
-            buffer_strcat_htmlescape(w->response.data, filename);
-            return HTTP_RESP_REDIR_TEMP;
-        }
-        else {
-            netdata_log_error("%llu: Cannot open file '%s'.", w->id, web_filename);
-            w->response.data->content_type = CT_TEXT_HTML;
-            buffer_strcat(w->response.data, "Cannot open file: ");
-            buffer_strcat_htmlescape(w->response.data, filename);
-            return HTTP_RESP_NOT_FOUND;
-        }
+    if(w->if_none_match && web_client_etag_matches(w->if_none_match, etag)) {
+        // the client has this version of the file already
+        web_client_disable_deflate(w);
+        code = HTTP_RESP_NOT_MODIFIED;
+    }
+    else if(web_static_cache_get(web_filename, &statbuf, web_client_encodings_accepted(w), w->response.data, &encoding)) {
+        // a compressed variant of the file is served from memory
+        web_client_disable_deflate(w);
+        w->response.encoding = encoding;
+        w->response.identity_size = (size_t)statbuf.st_size;
+    }
+    else {
+        code = web_server_static_file_load(w, filename, web_filename, &statbuf);
+        if(code != HTTP_RESP_OK)
+            return code;
     }
-    else
-        close(fd);
 
     w->response.data->content_type = contenttype_for_filename(web_filename);
     netdata_log_debug(D_WEB_CLIENT_ACCESS, "%llu: Sending file '%s' (%"PRId64" bytes, fd %d).", w->id, web_filename, (int64_t)statbuf.st_size, w->fd);
 
+    buffer_sprintf(w->response.header, "ETag: %s\r\n", etag);
+
     w->mode = HTTP_REQUEST_MODE_GET;
     web_client_enable_wait_send(w);
     web_client_disable_wait_receive(w);
@@ -532,7 +722,7 @@ static int web_server_static_file(struct web_client *w, char *filename) {
 
     buffer_cacheable(w->response.data);
 
-    return HTTP_RESP_OK;
+    return code;
 }
 #endif
 
@@ -705,9 +895,9 @@ HTTP_VALIDATION http_request_validate(struct web_client *w) {
 
         is_it_valid = 1;
     } else {
-        last_pos = w->header_parse_last_size;
+        // search the whole buffer - it may contain more than one pipelined request
         is_it_valid =
-            url_is_request_complete_and_extract_payload(s, &s[last_pos], w->header_parse_last_size, &w->payload);
+            url_is_request_complete_and_extract_payload(s, s, w->header_parse_last_size, &w->payload);
     }
 
     s = web_client_valid_method(w, s);
@@ -770,6 +960,15 @@ HTTP_VALIDATION http_request_validate(struct web_client *w) {
                 w->header_parse_tries = 0;
                 w->header_parse_last_size = 0;
                 web_client_disable_wait_receive(w);
+
+                if(likely(w->mode != HTTP_REQUEST_MODE_STREAM)) {
+                    size_t request_length = (s + 2) - buffer_tostring(w->response.data);
+                    if((w->mode == HTTP_REQUEST_MODE_POST || w->mode == HTTP_REQUEST_MODE_PUT) && w->payload)
+                        request_length += buffer_strlen(w->payload);
+
+                    web_client_pipelined_request_split(w, request_length);
+                }
+
                 return HTTP_VALIDATION_OK;
             }
 
@@ -897,16 +1096,27 @@ void web_client_build_http_header(struct web_client *w) {
         buffer_strcat(w->response.header_output, buffer_tostring(w->response.header));
 
     // headers related to the transfer method
-    if(likely(w->response.zoutput))
-        buffer_strcat(w->response.header_output, "Content-Encoding: gzip\r\n");
+    if(w->response.encoding != WEB_ENCODING_NONE)
+        buffer_sprintf(w->response.header_output, "Content-Encoding: %s\r\nVary: Accept-Encoding\r\n",
+                       web_encoding_2str(w->response.encoding));
+    else if(likely(w->response.zoutput))
+        buffer_strcat(w->response.header_output, "Content-Encoding: gzip\r\nVary: Accept-Encoding\r\n");
 
     if(likely(w->flags & WEB_CLIENT_CHUNKED_TRANSFER))
         buffer_strcat(w->response.header_output, "Transfer-Encoding: chunked\r\n");
     else {
-        if(likely(w->response.data->len)) {
+        if(unlikely(w->response.file.size)) {
+            // the file is sent with sendfile()
+            buffer_sprintf(w->response.header_output, "Content-Length: %zu\r\n", w->response.file.size);
+        }
+        else if(likely(w->response.data->len)) {
             // we know the content length, put it
             buffer_sprintf(w->response.header_output, "Content-Length: %zu\r\n", (size_t)w->response.data->len);
         }
+        else if(w->response.code == HTTP_RESP_NOT_MODIFIED) {
+            // no body, the connection can be reused
+            ;
+        }
         else {
             // we don't know the content length, disable keep-alive
             web_client_disable_keepalive(w);
@@ -987,6 +1197,126 @@ static inline void web_client_send_http_header(struct web_client *w) {
         w->statistics.sent_bytes += bytes;
 }
 
+// ----------------------------------------------------------------------------
+// response streaming
+// large responses are sent with chunked transfer encoding while they are being
+// generated; the producer blocks while the socket drains (backpressure)
+
+static bool web_client_send_all(struct web_client *w, const void *buf, size_t len) {
+    const char *s = buf;
+
+    while(len) {
+        ssize_t bytes = web_client_send_data(w, s, len, 0);
+        if(bytes <= 0) {
+            netdata_log_debug(D_WEB_CLIENT, "%llu: Failed to send streamed response data to client.", w->id);
+            WEB_CLIENT_IS_DEAD(w);
+            return false;
+        }
+
+        w->statistics.sent_bytes += bytes;
+        s += bytes;
+        len -= bytes;
+    }
+
+    return true;
+}
+
+static bool web_client_stream_send_chunk(struct web_client *w, const void *buf, size_t len) {
+    if(!len)
+        return true;
+
+    char header[24];
+    size_t header_len = snprintfz(header, sizeof(header) - 1, "%zX\r\n", len);
+
+    return web_client_send_all(w, header, header_len) &&
+           web_client_send_all(w, buf, len) &&
+           web_client_send_all(w, "\r\n", 2);
+}
+
+static bool web_client_stream_write(struct web_client *w, const char *buf, size_t len, bool finish) {
+    if(!w->response.zoutput)
+        return web_client_stream_send_chunk(w, buf, len);
+
+    // pass the data through the compressor, sending each block it produces as a chunk
+    w->response.zstream.next_in = (Bytef *)buf;
+    w->response.zstream.avail_in = (uInt)len;
+
+    do {
+        w->response.zstream.next_out = w->response.zbuffer;
+        w->response.zstream.avail_out = NETDATA_WEB_RESPONSE_ZLIB_CHUNK_SIZE;
+
+        if(deflate(&w->response.zstream, finish ? Z_FINISH : Z_NO_FLUSH) == Z_STREAM_ERROR) {
+            netdata_log_error("%llu: Compression of streamed response failed. Closing down client.", w->id);
+            WEB_CLIENT_IS_DEAD(w);
+            return false;
+        }
+
+        size_t have = NETDATA_WEB_RESPONSE_ZLIB_CHUNK_SIZE - w->response.zstream.avail_out;
+        if(!web_client_stream_send_chunk(w, w->response.zbuffer, have))
+            return false;
+
+    } while(w->response.zstream.avail_out == 0);
+
+    return true;
+}
+
+static bool web_client_response_stream_drain(BUFFER *wb, void *data) {
+    struct web_client *w = data;
+
+    if(web_client_check_dead(w))
+        return false;
+
+    if(!w->response.stream.started) {
+        // the response is already big - commit to a successful response and
+        // send the header now, switching to chunked transfer
+        w->response.code = HTTP_RESP_OK;
+        w->response.sent = 0;
+        web_client_flag_set(w, WEB_CLIENT_CHUNKED_TRANSFER);
+        web_client_send_http_header(w);
+        w->response.stream.started = true;
+
+        if(web_client_check_dead(w))
+            return false;
+    }
+
+    w->response.stream.size += buffer_strlen(wb);
+    bool ok = web_client_stream_write(w, buffer_tostring(wb), buffer_strlen(wb), false);
+    buffer_drained(wb);
+
+    return ok;
+}
+
+void web_client_response_stream_enable(struct web_client *w) {
+    // cloud and webrtc get the whole response at once
+    if(!web_client_check_conn_tcp(w) && !web_client_check_conn_unix(w))
+        return;
+
+    buffer_drain_set(w->response.data, web_client_response_stream_drain, w, NETDATA_WEB_RESPONSE_STREAM_CHUNK_SIZE);
+}
+
+// returns true when the response has been streamed, and the request is completed
+static bool web_client_response_stream_finalize(struct web_client *w) {
+    BUFFER *wb = w->response.data;
+    buffer_drain_set(wb, NULL, NULL, 0);
+
+    if(!w->response.stream.started)
+        return false;
+
+    w->response.stream.size += buffer_strlen(wb);
+    if(!web_client_check_dead(w) &&
+        web_client_stream_write(w, buffer_tostring(wb), buffer_strlen(wb), true))
+        web_client_send_all(w, "0\r\n\r\n", 5);
+
+    buffer_drained(wb);
+
+    if(web_client_check_dead(w) || !web_client_has_keepalive(w))
+        WEB_CLIENT_IS_DEAD(w);
+    else
+        web_client_request_done(w);
+
+    return true;
+}
+
 static inline int web_client_switch_host(RRDHOST *host, struct web_client *w, char *url, bool nodeid, int (*func)(RRDHOST *, struct web_client *, char *)) {
     static uint32_t hash_localhost = 0;
 
@@ -1294,6 +1624,35 @@ static bool web_server_log_transport(BUFFER *wb, void *ptr) {
     return true;
 }
 
+// compress the whole response in one go, with the best encoding the client accepts
+// (gzip is applied while sending, by web_client_send_deflate())
+static void web_client_response_compress(struct web_client *w) {
+    WEB_ENCODING accepted = web_client_encodings_accepted(w) & (WEB_ENCODING_BROTLI | WEB_ENCODING_ZSTD);
+    size_t len = buffer_strlen(w->response.data);
+
+    if(likely(!accepted) || w->response.encoding != WEB_ENCODING_NONE || w->response.file.size ||
+        len < WEB_COMPRESSION_MIN_SIZE || !web_content_type_is_compressible(w->response.data->content_type) ||
+        (!web_client_check_conn_tcp(w) && !web_client_check_conn_unix(w)))
+        return;
+
+    WEB_ENCODING encoding = web_encoding_select(accepted, false);
+    int level = (encoding == WEB_ENCODING_BROTLI) ? web_brotli_level : web_zstd_level;
+
+    BUFFER *wb = web_client_buffer_pool_get(len);
+    if(!wb)
+        wb = buffer_create(len, w->statistics.memory_accounting);
+
+    if(web_encoding_compress(encoding, level, buffer_tostring(w->response.data), len, wb) && buffer_strlen(wb) < len) {
+        buffer_contents_replace(w->response.data, buffer_tostring(wb), buffer_strlen(wb));
+        web_client_disable_deflate(w);
+        w->response.encoding = encoding;
+        w->response.identity_size = len;
+    }
+
+    if(!web_client_buffer_pool_put(wb))
+        buffer_free(wb);
+}
+
 void web_client_process_request_from_web_server(struct web_client *w) {
     // entry point for web server requests
 
@@ -1401,6 +1760,7 @@ void web_client_process_request_from_web_server(struct web_client *w) {
                     }
 
                     web_client_reset_path_flags(w);
+                    web_client_response_buffer_prepare(w);
 
                     // find if the URL path has a filename extension
                     char path[FILENAME_MAX + 1];
@@ -1499,13 +1859,19 @@ void web_client_process_request_from_web_server(struct web_client *w) {
     // keep track of the processing time
     web_client_timeout_checkpoint_response_ready(w, NULL);
 
+    if(web_client_response_stream_finalize(w))
+        return;
+
     w->response.sent = 0;
 
+    web_client_response_compress(w);
     web_client_send_http_header(w);
 
     // enable sending immediately if we have data
-    if(w->response.data->len) web_client_enable_wait_send(w);
-    else web_client_disable_wait_send(w);
+    if(w->response.data->len || w->response.file.size || w->response.code == HTTP_RESP_NOT_MODIFIED)
+        web_client_enable_wait_send(w);
+    else
+        web_client_disable_wait_send(w);
 
     switch(w->mode) {
         case HTTP_REQUEST_MODE_STREAM:
@@ -1717,8 +2083,56 @@ ssize_t web_client_send_deflate(struct web_client *w)
     return(len);
 }
 
+static ssize_t web_client_send_file(struct web_client *w) {
+    if(unlikely(w->response.file.sent >= w->response.file.size)) {
+        // the whole file has been sent
+
+        if(unlikely(!web_client_has_keepalive(w))) {
+            netdata_log_debug(D_WEB_CLIENT, "%llu: Closing (keep-alive is not enabled). %zu bytes sent.", w->id, w->response.file.sent);
+            WEB_CLIENT_IS_DEAD(w);
+            return 0;
+        }
+
+        web_client_request_done(w);
+        netdata_log_debug(D_WEB_CLIENT, "%llu: Done sending file on socket. Waiting for next request on the same socket.", w->id);
+        return 0;
+    }
+
+#if defined(OS_LINUX)
+    off_t offset = (off_t)w->response.file.sent;
+    ssize_t bytes;
+
+    do {
+        errno_clear();
+        bytes = sendfile(w->fd, w->response.file.fd, &offset, w->response.file.size - w->response.file.sent);
+    } while(bytes < 0 && errno == EINTR);
+
+    if(likely(bytes > 0)) {
+        w->statistics.sent_bytes += bytes;
+        w->response.file.sent += bytes;
+        netdata_log_debug(D_WEB_CLIENT, "%llu: Sent %zd bytes of file.", w->id, bytes);
+    }
+    else if(bytes < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        netdata_log_debug(D_WEB_CLIENT, "%llu: Did not send any bytes of file to the client.", w->id);
+        bytes = 0;
+    }
+    else {
+        // the file was truncated while being sent, or the socket failed
+        netdata_log_debug(D_WEB_CLIENT, "%llu: Failed to send file to client.", w->id);
+        WEB_CLIENT_IS_DEAD(w);
+        bytes = -1;
+    }
+
+    return bytes;
+#else
+    WEB_CLIENT_IS_DEAD(w);
+    return -1;
+#endif
+}
+
 ssize_t web_client_send(struct web_client *w) {
     if(likely(w->response.zoutput)) return web_client_send_deflate(w);
+    if(unlikely(w->response.file.size)) return web_client_send_file(w);
 
     ssize_t bytes;
 
@@ -1864,6 +2278,7 @@ void web_client_reuse_from_cache(struct web_client *w) {
     BUFFER *b5 = w->url_as_received;
     BUFFER *b6 = w->url_query_string_decoded;
     BUFFER *b7 = w->payload;
+    BUFFER *b8 = w->pipelined;
 
     NETDATA_SSL ssl = w->ssl;
 
@@ -1887,6 +2302,10 @@ void web_client_reuse_from_cache(struct web_client *w) {
     w->url_as_received = b5;
     w->url_query_string_decoded = b6;
     w->payload = b7;
+    w->pipelined = b8;
+
+    if(w->pipelined)
+        buffer_flush(w->pipelined);
 }
 
 struct web_client *web_client_create(size_t *statistics_memory_accounting) {
@@ -5,6 +5,7 @@
 
 #include "libnetdata/libnetdata.h"
 #include "../websocket/websocket.h"
+#include "web_compression.h"
 
 struct web_client;
 
@@ -70,6 +71,10 @@ typedef enum __attribute__((packed)) {
     WEB_CLIENT_FLAG_ACCEPT_SSE              = (1 << 26),
     WEB_CLIENT_FLAG_ACCEPT_TEXT             = (1 << 27),
     WEB_CLIENT_FLAG_MCP_PREVIEW_KEY         = (1 << 28), // Authorization header matched MCP preview key
+
+    // compression (one-shot, negotiated with Accept-Encoding)
+    WEB_CLIENT_ENCODING_BROTLI              = (1 << 29),
+    WEB_CLIENT_ENCODING_ZSTD                = (1 << 30),
 } WEB_CLIENT_FLAGS;
 
 #define WEB_CLIENT_FLAG_PATH_WITH_VERSION (WEB_CLIENT_FLAG_PATH_IS_V0|WEB_CLIENT_FLAG_PATH_IS_V1|WEB_CLIENT_FLAG_PATH_IS_V2|WEB_CLIENT_FLAG_PATH_IS_V3)
@@ -140,21 +145,47 @@ void web_client_set_conn_webrtc(struct web_client *w);
 
 #define NETDATA_WEB_RESPONSE_ZLIB_CHUNK_SIZE 16384
 
+// responses larger than this are streamed to the client with chunked
+// transfer encoding while they are being generated (when enabled by the api)
+#define NETDATA_WEB_RESPONSE_STREAM_CHUNK_SIZE (1024 * 1024)
+
 #define NETDATA_WEB_RESPONSE_HEADER_INITIAL_SIZE 4096
 #define NETDATA_WEB_RESPONSE_INITIAL_SIZE 8192
 #define NETDATA_WEB_REQUEST_INITIAL_SIZE 8192
 #define NETDATA_WEB_REQUEST_MAX_SIZE (128 * 1024)
 #define NETDATA_WEB_DECODED_URL_INITIAL_SIZE 512
 
+// response buffers that grow above this size are pooled across clients
+#define WEB_CLIENT_BUFFER_POOL_MIN_SIZE (64 * 1024)
+
+// uncompressed static files larger than this are sent with sendfile()
+#define WEB_CLIENT_SENDFILE_MIN_SIZE (64 * 1024)
+
 struct response {
     BUFFER *header;         // our response header
     BUFFER *header_output;  // internal use
     BUFFER *data;           // our response data buffer
     size_t sent;            // current data length sent to output
+    size_t size_hint;       // the size of the previous response on this connection
     short int code;         // the HTTP response code
     bool has_cookies;
     bool zoutput;           // if set to 1, web_client_send() will send compressed data
     bool zinitialized;
+
+    WEB_ENCODING encoding;  // the Content-Encoding of data (when not compressed by zlib while sending)
+    size_t identity_size;   // the size of data before it was encoded
+
+    struct {
+        int fd;                                          // the static file sent with sendfile()
+        size_t size;                                     // the size of the file - when set, data is not sent
+        size_t sent;                                     // the bytes of the file sent so far
+    } file;
+
+    struct {
+        bool started;                                    // the header and part of the data have been sent
+        size_t size;                                     // the uncompressed bytes streamed so far
+    } stream;
+
     z_stream zstream;                                    // zlib stream for sending compressed output to client
     size_t zsent;                                        // the compressed bytes we have sent to the client
     size_t zhave;                                        // the compressed bytes that we have received from zlib
@@ -195,6 +226,7 @@ struct web_client {
     char *forwarded_host;               // the X-Forwarded-Host: header
     char *origin;                       // the Origin: header
     char *user_agent;                   // the User-Agent: header
+    char *if_none_match;                // the If-None-Match: header
 
     // WebSocket related data - NEED TO BE FREED
     struct {
@@ -206,6 +238,7 @@ struct web_client {
     } websocket;
 
     BUFFER *payload;                    // when this request is a POST, this has the payload
+    BUFFER *pipelined;                  // data received after the end of the current request (HTTP pipelining)
 
     NETDATA_SSL ssl;
 
@@ -248,9 +281,12 @@ ssize_t web_client_send(struct web_client *w);
 ssize_t web_client_receive(struct web_client *w);
 
 void web_client_process_request_from_web_server(struct web_client *w);
+bool web_client_resume_pipelined_request(struct web_client *w);
 void web_client_request_done(struct web_client *w);
 
 void web_client_build_http_header(struct web_client *w);
+void web_client_response_stream_enable(struct web_client *w);
+void web_client_response_file_close(struct web_client *w);
 
 void web_client_reuse_from_cache(struct web_client *w);
 struct web_client *web_client_create(size_t *statistics_memory_accounting);
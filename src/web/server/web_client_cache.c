@@ -48,6 +48,124 @@ static struct clients_cache {
         },
 };
 
+// ----------------------------------------------------------------------------
+// response buffers pooling
+
+// Large responses grow the response buffer of the client serving them.
+// Instead of keeping these buffers attached to clients (where they sit idle
+// most of the time), or freeing them (only to grow new ones with a series of
+// reallocs on the next large response), grown buffers are returned to a shared
+// pool, organized in size classes, and they are handed back to clients that
+// are expected to produce large responses.
+//
+// The pool holds at most WEB_CLIENT_BUFFER_POOL_MAX_BYTES. Buffers of 4MiB or
+// more are rare enough not to be worth keeping; they are always freed.
+
+#define WEB_CLIENT_BUFFER_POOL_CLASSES 3            // 64KiB, 256KiB, 1MiB (up to 4MiB)
+#define WEB_CLIENT_BUFFER_POOL_PER_CLASS 16         // the max number of buffers kept per class
+#define WEB_CLIENT_BUFFER_POOL_MAX_BYTES (16 * 1024 * 1024) // the max memory kept in the pool, across all classes
+
+static struct {
+    SPINLOCK spinlock;
+
+    struct {
+        BUFFER *buffers[WEB_CLIENT_BUFFER_POOL_PER_CLASS];
+        size_t count;
+    } classes[WEB_CLIENT_BUFFER_POOL_CLASSES];
+
+    size_t bytes;                   // the memory of the buffers in the pool
+
+    size_t reused;                  // the number of buffers given to clients
+    size_t returned;                // the number of buffers returned to the pool
+    size_t freed;                   // the number of buffers freed, because the pool was full or they were too big
+} web_buffers_pool = {
+        .spinlock = SPINLOCK_INITIALIZER,
+};
+
+static inline size_t web_client_buffer_pool_class_size(size_t cls) {
+    return (size_t)WEB_CLIENT_BUFFER_POOL_MIN_SIZE << (2 * cls);
+}
+
+// the class of a buffer of the given size, or -1 if it is not to be pooled
+static inline int web_client_buffer_pool_class(size_t size) {
+    if(size < WEB_CLIENT_BUFFER_POOL_MIN_SIZE || size >= web_client_buffer_pool_class_size(WEB_CLIENT_BUFFER_POOL_CLASSES))
+        return -1;
+
+    int cls = 0;
+    while(cls + 1 < WEB_CLIENT_BUFFER_POOL_CLASSES && size >= web_client_buffer_pool_class_size(cls + 1))
+        cls++;
+
+    return cls;
+}
+
+BUFFER *web_client_buffer_pool_get(size_t size_hint) {
+    if(size_hint < WEB_CLIENT_BUFFER_POOL_MIN_SIZE)
+        return NULL;
+
+    int cls = web_client_buffer_pool_class(size_hint);
+    if(cls < 0)
+        cls = WEB_CLIENT_BUFFER_POOL_CLASSES - 1;
+
+    BUFFER *wb = NULL;
+
+    spinlock_lock(&web_buffers_pool.spinlock);
+
+    // the buffers of a class are at least as big as the class size, so the
+    // exact class of the hint may not fit it - prefer the next one; but do not
+    // go further, to avoid handing a huge buffer to a moderately large response
+    for(int c = MIN(cls + 1, WEB_CLIENT_BUFFER_POOL_CLASSES - 1); !wb && c >= cls ; c--) {
+        if(web_buffers_pool.classes[c].count)
+            wb = web_buffers_pool.classes[c].buffers[--web_buffers_pool.classes[c].count];
+    }
+
+    if(wb) {
+        web_buffers_pool.bytes -= wb->size;
+        web_buffers_pool.reused++;
+    }
+
+    spinlock_unlock(&web_buffers_pool.spinlock);
+
+    return wb;
+}
+
+bool web_client_buffer_pool_put(BUFFER *wb) {
+    int cls = web_client_buffer_pool_class(wb->size);
+    if(cls < 0)
+        return false;
+
+    buffer_reset(wb);
+
+    spinlock_lock(&web_buffers_pool.spinlock);
+    if(web_buffers_pool.classes[cls].count < WEB_CLIENT_BUFFER_POOL_PER_CLASS &&
+        web_buffers_pool.bytes + wb->size <= WEB_CLIENT_BUFFER_POOL_MAX_BYTES) {
+        web_buffers_pool.classes[cls].buffers[web_buffers_pool.classes[cls].count++] = wb;
+        web_buffers_pool.bytes += wb->size;
+        web_buffers_pool.returned++;
+        wb = NULL;
+    }
+    else
+        web_buffers_pool.freed++;
+    spinlock_unlock(&web_buffers_pool.spinlock);
+
+    buffer_free(wb);
+    return true;
+}
+
+static void web_client_buffer_pool_destroy(void) {
+    internal_error(true, "web_client_cache buffers pool reused %zu, returned %zu and freed %zu buffers.",
+                   web_buffers_pool.reused, web_buffers_pool.returned, web_buffers_pool.freed);
+
+    spinlock_lock(&web_buffers_pool.spinlock);
+    for(size_t c = 0; c < WEB_CLIENT_BUFFER_POOL_CLASSES ;c++) {
+        while(web_buffers_pool.classes[c].count)
+            buffer_free(web_buffers_pool.classes[c].buffers[--web_buffers_pool.classes[c].count]);
+    }
+    web_buffers_pool.bytes = 0;
+    spinlock_unlock(&web_buffers_pool.spinlock);
+}
+
+// ----------------------------------------------------------------------------
+
 // destroy the cache and free all the memory it uses
 void web_client_cache_destroy(void) {
     internal_error(true, "web_client_cache has %zu used and %zu available clients, allocated %zu, reused %zu (hit %zu%%)."
@@ -71,6 +189,8 @@ void web_client_cache_destroy(void) {
     web_clients_cache.avail.count = 0;
     spinlock_unlock(&web_clients_cache.avail.spinlock);
 
+    web_client_buffer_pool_destroy();
+
 // DO NOT FREE THEM IF THEY ARE USED
 //    spinlock_lock(&web_clients_cache.used.spinlock);
 //    w = web_clients_cache.used.head;
@@ -129,6 +249,9 @@ struct web_client *web_client_get_from_cache(void) {
 void web_client_release_to_cache(struct web_client *w) {
     netdata_ssl_close(&w->ssl);
 
+    // do not keep the file being sent open, while the client is in the cache
+    web_client_response_file_close(w);
+
     // unlink it from the used
     spinlock_lock(&web_clients_cache.used.spinlock);
     DOUBLE_LINKED_LIST_REMOVE_ITEM_UNSAFE(web_clients_cache.used.head, w, cache.prev, cache.next);
@@ -10,6 +10,9 @@ void web_client_release_to_cache(struct web_client *w);
 struct web_client *web_client_get_from_cache(void);
 void web_client_cache_destroy(void);
 
+BUFFER *web_client_buffer_pool_get(size_t size_hint);
+bool web_client_buffer_pool_put(BUFFER *wb);
+
 #include "web_server.h"
 
 #endif //NETDATA_WEB_CLIENT_CACHE_H
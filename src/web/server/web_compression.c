@@ -0,0 +1,227 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "web_compression.h"
+#include "web_client.h"
+
+#ifdef ENABLE_BROTLI
+#include <brotli/encode.h>
+#endif
+
+#ifdef ENABLE_ZSTD
+#include <zstd.h>
+#endif
+
+int web_enable_brotli = 1, web_brotli_level = 5;
+int web_enable_zstd = 1, web_zstd_level = 3;
+
+const char *web_encoding_2str(WEB_ENCODING encoding) {
+    switch(encoding) {
+        case WEB_ENCODING_GZIP:
+            return "gzip";
+
+        case WEB_ENCODING_BROTLI:
+            return "br";
+
+        case WEB_ENCODING_ZSTD:
+            return "zstd";
+
+        default:
+            return "identity";
+    }
+}
+
+WEB_ENCODING web_encodings_accepted(const char *accept_encoding) {
+    WEB_ENCODING encodings = WEB_ENCODING_NONE;
+
+    for(const char *s = accept_encoding; s && *s ;) {
+        while(*s == ' ' || *s == '\t' || *s == ',') s++;
+        if(!*s)
+            break;
+
+        const char *name = s;
+        while(*s && *s != ',' && *s != ';' && *s != ' ' && *s != '\t') s++;
+        size_t len = s - name;
+
+        // check the parameters of this encoding, for q=0
+        bool refused = false;
+        while(*s && *s != ',') {
+            if((*s == 'q' || *s == 'Q') && s[1] == '=') {
+                const char *q = &s[2];
+                refused = (*q == '0');
+                for(q++; refused && *q && *q != ',' && *q != ';' ; q++) {
+                    if(*q != '.' && *q != '0' && *q != ' ')
+                        refused = false;
+                }
+            }
+            s++;
+        }
+
+        if(refused)
+            continue;
+
+        if(len == 4 && strncasecmp(name, "gzip", 4) == 0)
+            encodings |= WEB_ENCODING_GZIP;
+        else if(len == 2 && strncasecmp(name, "br", 2) == 0)
+            encodings |= WEB_ENCODING_BROTLI;
+        else if(len == 4 && strncasecmp(name, "zstd", 4) == 0)
+            encodings |= WEB_ENCODING_ZSTD;
+    }
+
+    return encodings;
+}
+
+WEB_ENCODING web_encodings_enabled(void) {
+    WEB_ENCODING encodings = WEB_ENCODING_NONE;
+
+    if(web_enable_gzip)
+        encodings |= WEB_ENCODING_GZIP;
+
+#ifdef ENABLE_BROTLI
+    if(web_enable_brotli)
+        encodings |= WEB_ENCODING_BROTLI;
+#endif
+
+#ifdef ENABLE_ZSTD
+    if(web_enable_zstd)
+        encodings |= WEB_ENCODING_ZSTD;
+#endif
+
+    return encodings;
+}
+
+WEB_ENCODING web_encoding_select(WEB_ENCODING available, bool precompressed) {
+    if(precompressed) {
+        // brotli gives the smallest files at its highest quality
+        if(available & WEB_ENCODING_BROTLI) return WEB_ENCODING_BROTLI;
+        if(available & WEB_ENCODING_ZSTD) return WEB_ENCODING_ZSTD;
+    }
+    else {
+        // zstd is the fastest to compress, for the same ratio
+        if(available & WEB_ENCODING_ZSTD) return WEB_ENCODING_ZSTD;
+        if(available & WEB_ENCODING_BROTLI) return WEB_ENCODING_BROTLI;
+    }
+
+    if(available & WEB_ENCODING_GZIP) return WEB_ENCODING_GZIP;
+
+    return WEB_ENCODING_NONE;
+}
+
+bool web_content_type_is_compressible(HTTP_CONTENT_TYPE content_type) {
+    switch(content_type) {
+        case CT_APPLICATION_JSON:
+        case CT_TEXT_PLAIN:
+        case CT_TEXT_HTML:
+        case CT_APPLICATION_X_JAVASCRIPT:
+        case CT_TEXT_CSS:
+        case CT_TEXT_XML:
+        case CT_APPLICATION_XML:
+        case CT_TEXT_XSL:
+        case CT_APPLICATION_OCTET_STREAM:
+        case CT_APPLICATION_X_FONT_TRUETYPE:
+        case CT_APPLICATION_X_FONT_OPENTYPE:
+        case CT_APPLICATION_VND_MS_FONTOBJ:
+        case CT_IMAGE_SVG_XML:
+        case CT_IMAGE_XICON:
+        case CT_IMAGE_BMP:
+        case CT_PROMETHEUS:
+        case CT_TEXT_YAML:
+        case CT_APPLICATION_YAML:
+            return true;
+
+        default:
+            // already compressed (images, fonts, media, archives) or streamed
+            return false;
+    }
+}
+
+static bool web_encoding_compress_gzip(int level, const void *src, size_t src_len, BUFFER *dst) {
+    z_stream zs = { 0 };
+
+    if(deflateInit2(&zs, level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+        return false;
+
+    size_t bound = deflateBound(&zs, src_len);
+    buffer_need_bytes(dst, bound + 1);
+
+    zs.next_in = (Bytef *)src;
+    zs.avail_in = (uInt)src_len;
+    zs.next_out = (Bytef *)dst->buffer;
+    zs.avail_out = (uInt)bound;
+
+    int rc = deflate(&zs, Z_FINISH);
+    dst->len = zs.total_out;
+    deflateEnd(&zs);
+
+    return rc == Z_STREAM_END;
+}
+
+#ifdef ENABLE_BROTLI
+static bool web_encoding_compress_brotli(int level, const void *src, size_t src_len, BUFFER *dst) {
+    if(level < BROTLI_MIN_QUALITY) level = BROTLI_MIN_QUALITY;
+    else if(level > BROTLI_MAX_QUALITY) level = BROTLI_MAX_QUALITY;
+
+    size_t out_len = BrotliEncoderMaxCompressedSize(src_len);
+    if(!out_len)
+        return false;
+
+    buffer_need_bytes(dst, out_len + 1);
+
+    if(BrotliEncoderCompress(level, BROTLI_DEFAULT_WINDOW, BROTLI_MODE_TEXT,
+                             src_len, (const uint8_t *)src, &out_len, (uint8_t *)dst->buffer) != BROTLI_TRUE)
+        return false;
+
+    dst->len = out_len;
+    return true;
+}
+#endif
+
+#ifdef ENABLE_ZSTD
+static bool web_encoding_compress_zstd(int level, const void *src, size_t src_len, BUFFER *dst) {
+    if(level < 1) level = 1;
+    else if(level > ZSTD_maxCLevel()) level = ZSTD_maxCLevel();
+
+    size_t bound = ZSTD_compressBound(src_len);
+    buffer_need_bytes(dst, bound + 1);
+
+    size_t rc = ZSTD_compress(dst->buffer, bound, src, src_len, level);
+    if(ZSTD_isError(rc))
+        return false;
+
+    dst->len = rc;
+    return true;
+}
+#endif
+
+bool web_encoding_compress(WEB_ENCODING encoding, int level, const void *src, size_t src_len, BUFFER *dst) {
+    buffer_flush(dst);
+
+    bool ok = false;
+    switch(encoding) {
+        case WEB_ENCODING_GZIP:
+            ok = web_encoding_compress_gzip(level, src, src_len, dst);
+            break;
+
+#ifdef ENABLE_BROTLI
+        case WEB_ENCODING_BROTLI:
+            ok = web_encoding_compress_brotli(level, src, src_len, dst);
+            break;
+#endif
+
+#ifdef ENABLE_ZSTD
+        case WEB_ENCODING_ZSTD:
+            ok = web_encoding_compress_zstd(level, src, src_len, dst);
+            break;
+#endif
+
+        default:
+            break;
+    }
+
+    if(!ok)
+        buffer_flush(dst);
+
+    // compressed data are binary - keep the buffer terminated, without counting it
+    dst->buffer[dst->len] = '\0';
+
+    return ok;
+}
@@ -0,0 +1,42 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef NETDATA_WEB_COMPRESSION_H
+#define NETDATA_WEB_COMPRESSION_H
+
+#include "libnetdata/libnetdata.h"
+
+typedef enum __attribute__((packed)) {
+    WEB_ENCODING_NONE       = 0,
+    WEB_ENCODING_GZIP       = (1 << 0),
+    WEB_ENCODING_BROTLI     = (1 << 1),
+    WEB_ENCODING_ZSTD       = (1 << 2),
+} WEB_ENCODING;
+
+#define WEB_ENCODINGS_ALL (WEB_ENCODING_GZIP | WEB_ENCODING_BROTLI | WEB_ENCODING_ZSTD)
+
+extern int web_enable_brotli, web_brotli_level;
+extern int web_enable_zstd, web_zstd_level;
+
+// responses smaller than this are not worth compressing
+#define WEB_COMPRESSION_MIN_SIZE 1024
+
+// the value of the Content-Encoding header for an encoding
+const char *web_encoding_2str(WEB_ENCODING encoding);
+
+// the encodings in an Accept-Encoding header value (encodings with q=0 are excluded)
+WEB_ENCODING web_encodings_accepted(const char *accept_encoding);
+
+// the encodings that are compiled in and enabled
+WEB_ENCODING web_encodings_enabled(void);
+
+// pick one of the encodings available, in our order of preference
+// pre-compressed (static) content prefers the best ratio, dynamic content the fastest compressor
+WEB_ENCODING web_encoding_select(WEB_ENCODING available, bool precompressed);
+
+// is the content type worth compressing?
+bool web_content_type_is_compressible(HTTP_CONTENT_TYPE content_type);
+
+// compress src into dst (which is reset) in one go - returns false on failure
+bool web_encoding_compress(WEB_ENCODING encoding, int level, const void *src, size_t src_len, BUFFER *dst);
+
+#endif //NETDATA_WEB_COMPRESSION_H
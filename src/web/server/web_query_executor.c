@@ -0,0 +1,325 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "web_query_executor.h"
+#include "daemon/pulse/pulse-http-api.h"
+
+// a lower priority query waiting longer than this is served before higher priority ones
+#define WEB_QUERY_EXECUTOR_MAX_STARVATION_UT (2 * USEC_PER_SEC)
+
+#define WORKER_JOB_QUERY_DASHBOARD  (WEB_QUERY_PRIORITY_DASHBOARD)
+#define WORKER_JOB_QUERY_MCP        (WEB_QUERY_PRIORITY_MCP)
+#define WORKER_JOB_QUERY_BULK       (WEB_QUERY_PRIORITY_BULK)
+
+#if (WORKER_UTILIZATION_MAX_JOB_TYPES < 3)
+#error Please increase WORKER_UTILIZATION_MAX_JOB_TYPES to at least 3
+#endif
+
+typedef struct web_query_job {
+    WEB_QUERY_PRIORITY priority;
+    usec_t queued_ut;
+
+    web_query_execute_cb execute;
+    web_query_complete_cb complete;
+    void *data;
+
+    struct web_query_job *prev, *next;
+} WEB_QUERY_JOB;
+
+static struct {
+    bool running;
+    bool stop;
+
+    netdata_mutex_t mutex;
+    netdata_cond_t cond;
+
+    struct {
+        WEB_QUERY_JOB *head;
+        size_t queued;
+    } queues[WEB_QUERY_PRIORITY_MAX];
+
+    size_t threads;
+    ND_THREAD **thread;
+} executor = { 0 };
+
+static const char *priority_names[WEB_QUERY_PRIORITY_MAX] = {
+    [WEB_QUERY_PRIORITY_DASHBOARD] = "dashboard",
+    [WEB_QUERY_PRIORITY_MCP] = "mcp",
+    [WEB_QUERY_PRIORITY_BULK] = "bulk",
+};
+
+const char *web_query_priority_2str(WEB_QUERY_PRIORITY priority) {
+    if(priority >= WEB_QUERY_PRIORITY_MAX)
+        return "unknown";
+
+    return priority_names[priority];
+}
+
+// ----------------------------------------------------------------------------
+// request classification
+
+struct web_query_endpoint {
+    const char *name;
+    size_t len;
+    WEB_QUERY_PRIORITY priority;
+};
+
+#define WEB_QUERY_ENDPOINT(name, priority) { name, sizeof(name) - 1, priority }
+
+static const struct web_query_endpoint offloaded_endpoints[] = {
+    WEB_QUERY_ENDPOINT("data", WEB_QUERY_PRIORITY_DASHBOARD),
+    WEB_QUERY_ENDPOINT("weights", WEB_QUERY_PRIORITY_DASHBOARD),
+    WEB_QUERY_ENDPOINT("metric_correlations", WEB_QUERY_PRIORITY_DASHBOARD),
+    WEB_QUERY_ENDPOINT("contexts", WEB_QUERY_PRIORITY_DASHBOARD),
+    WEB_QUERY_ENDPOINT("q", WEB_QUERY_PRIORITY_DASHBOARD),
+    WEB_QUERY_ENDPOINT("function", WEB_QUERY_PRIORITY_DASHBOARD),
+    WEB_QUERY_ENDPOINT("badge.svg", WEB_QUERY_PRIORITY_DASHBOARD),
+    WEB_QUERY_ENDPOINT("allmetrics", WEB_QUERY_PRIORITY_BULK),
+
+    // terminator
+    { NULL, 0, 0 },
+};
+
+// data queries in these formats are exports, not dashboard queries
+static const char *bulk_data_formats[] = {
+    "csv", "tsv", "ssv", "ssvcomma", "html", "markdown", "binary", NULL,
+};
+
+#define segment_is(seg, slen, str) ((slen) == sizeof(str) - 1 && strncmp(seg, str, sizeof(str) - 1) == 0)
+
+static bool segment_is_version(const char *seg, size_t slen) {
+    return slen == 2 && seg[0] == 'v' && isdigit((uint8_t)seg[1]);
+}
+
+static bool query_string_has_bulk_format(const char *qs, const char *qs_end) {
+    if(!qs)
+        return false;
+
+    for(const char *s = qs; s < qs_end ; s++) {
+        if((s == qs || s[-1] == '&') && (size_t)(qs_end - s) > 7 && strncmp(s, "format=", 7) == 0) {
+            const char *v = &s[7];
+            size_t vlen = 0;
+            while(&v[vlen] < qs_end && v[vlen] != '&') vlen++;
+
+            for(size_t i = 0; bulk_data_formats[i] ; i++) {
+                if(strlen(bulk_data_formats[i]) == vlen && strncmp(v, bulk_data_formats[i], vlen) == 0)
+                    return true;
+            }
+
+            return false;
+        }
+    }
+
+    return false;
+}
+
+bool web_query_executor_classify(const char *request, size_t len, WEB_QUERY_PRIORITY *priority) {
+    // only complete requests are offloaded
+    if(len < 16 || !strstr(request, "\r\n\r\n"))
+        return false;
+
+    const char *s = request;
+    while(*s && *s != ' ' && *s != '\r') s++;
+    if(*s != ' ')
+        return false;
+    s++;
+
+    const char *path_end = s;
+    while(*path_end && *path_end != ' ' && *path_end != '?' && *path_end != '\r') path_end++;
+
+    const char *qs = NULL, *qs_end = NULL;
+    if(*path_end == '?') {
+        qs = qs_end = path_end + 1;
+        while(*qs_end && *qs_end != ' ' && *qs_end != '\r') qs_end++;
+    }
+
+    bool api = false, version = false, skip_next = false;
+    for(const char *seg = s; seg < path_end ;) {
+        while(seg < path_end && *seg == '/') seg++;
+
+        const char *end = seg;
+        while(end < path_end && *end != '/') end++;
+
+        size_t slen = end - seg;
+        if(!slen)
+            break;
+
+        if(skip_next)
+            skip_next = false;
+
+        else if(!api) {
+            if(segment_is(seg, slen, "host") || segment_is(seg, slen, "node"))
+                skip_next = true;
+            else if(segment_is(seg, slen, "api"))
+                api = true;
+            else if(segment_is(seg, slen, "mcp") || segment_is(seg, slen, "sse")) {
+                *priority = WEB_QUERY_PRIORITY_MCP;
+                return true;
+            }
+            else if(!segment_is_version(seg, slen))
+                return false;
+        }
+
+        else if(!version) {
+            if(!segment_is_version(seg, slen))
+                return false;
+
+            version = true;
+        }
+
+        else {
+            for(size_t i = 0; offloaded_endpoints[i].name ; i++) {
+                if(offloaded_endpoints[i].len == slen && strncmp(seg, offloaded_endpoints[i].name, slen) == 0) {
+                    *priority = offloaded_endpoints[i].priority;
+
+                    if(segment_is(seg, slen, "data") && query_string_has_bulk_format(qs, qs_end))
+                        *priority = WEB_QUERY_PRIORITY_BULK;
+
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        seg = end;
+    }
+
+    return false;
+}
+
+// ----------------------------------------------------------------------------
+// the queues
+
+static WEB_QUERY_JOB *web_query_executor_get_next_job_locked(void) {
+    usec_t now_ut = now_monotonic_usec();
+
+    // serve the oldest starving job first
+    WEB_QUERY_JOB *starving = NULL;
+    for(size_t p = WEB_QUERY_PRIORITY_DASHBOARD + 1; p < WEB_QUERY_PRIORITY_MAX ;p++) {
+        WEB_QUERY_JOB *j = executor.queues[p].head;
+        if(j && now_ut - j->queued_ut > WEB_QUERY_EXECUTOR_MAX_STARVATION_UT && (!starving || j->queued_ut < starving->queued_ut))
+            starving = j;
+    }
+
+    WEB_QUERY_JOB *j = starving;
+    for(size_t p = 0; !j && p < WEB_QUERY_PRIORITY_MAX ;p++)
+        j = executor.queues[p].head;
+
+    if(j) {
+        DOUBLE_LINKED_LIST_REMOVE_ITEM_UNSAFE(executor.queues[j->priority].head, j, prev, next);
+        executor.queues[j->priority].queued--;
+    }
+
+    return j;
+}
+
+static void web_query_executor_thread(void *ptr __maybe_unused) {
+    worker_register("WEBQUERY");
+    worker_register_job_name(WORKER_JOB_QUERY_DASHBOARD, "dashboard");
+    worker_register_job_name(WORKER_JOB_QUERY_MCP, "mcp");
+    worker_register_job_name(WORKER_JOB_QUERY_BULK, "bulk");
+
+    netdata_mutex_lock(&executor.mutex);
+    while(true) {
+        WEB_QUERY_JOB *j = web_query_executor_get_next_job_locked();
+        if(!j) {
+            if(executor.stop)
+                break;
+
+            worker_is_idle();
+            netdata_cond_wait(&executor.cond, &executor.mutex);
+            continue;
+        }
+        netdata_mutex_unlock(&executor.mutex);
+
+        worker_is_busy(j->priority);
+
+        usec_t started_ut = now_monotonic_usec();
+        j->execute(j->data);
+        usec_t finished_ut = now_monotonic_usec();
+
+        pulse_web_query_executed(j->priority, started_ut - j->queued_ut, finished_ut - started_ut);
+
+        if(j->complete)
+            j->complete(j->data);
+
+        freez(j);
+
+        netdata_mutex_lock(&executor.mutex);
+    }
+    netdata_mutex_unlock(&executor.mutex);
+
+    worker_unregister();
+}
+
+bool web_query_executor_dispatch(WEB_QUERY_PRIORITY priority, web_query_execute_cb execute, web_query_complete_cb complete, void *data) {
+    if(!__atomic_load_n(&executor.running, __ATOMIC_ACQUIRE) || priority >= WEB_QUERY_PRIORITY_MAX)
+        return false;
+
+    WEB_QUERY_JOB *j = callocz(1, sizeof(*j));
+    j->priority = priority;
+    j->queued_ut = now_monotonic_usec();
+    j->execute = execute;
+    j->complete = complete;
+    j->data = data;
+
+    pulse_web_query_queued(priority);
+
+    netdata_mutex_lock(&executor.mutex);
+    DOUBLE_LINKED_LIST_APPEND_ITEM_UNSAFE(executor.queues[priority].head, j, prev, next);
+    executor.queues[priority].queued++;
+    netdata_cond_signal(&executor.cond);
+    netdata_mutex_unlock(&executor.mutex);
+
+    return true;
+}
+
+bool web_query_executor_enabled(void) {
+    return __atomic_load_n(&executor.running, __ATOMIC_RELAXED);
+}
+
+void web_query_executor_init(size_t threads) {
+    if(!threads || executor.running)
+        return;
+
+    fatal_assert(0 == netdata_mutex_init(&executor.mutex));
+    fatal_assert(0 == netdata_cond_init(&executor.cond));
+
+    executor.stop = false;
+    executor.threads = threads;
+    executor.thread = callocz(threads, sizeof(*executor.thread));
+
+    for(size_t i = 0; i < threads ; i++) {
+        char tag[NETDATA_THREAD_TAG_MAX + 1];
+        snprintfz(tag, sizeof(tag) - 1, "WEBQUERY[%zu]", i);
+        executor.thread[i] = nd_thread_create(tag, NETDATA_THREAD_OPTION_DONT_LOG, web_query_executor_thread, NULL);
+    }
+
+    __atomic_store_n(&executor.running, true, __ATOMIC_RELEASE);
+
+    netdata_log_info("WEB QUERY EXECUTOR: started %zu threads", threads);
+}
+
+void web_query_executor_destroy(void) {
+    if(!executor.running)
+        return;
+
+    // no more jobs are accepted; the queued ones are still executed,
+    // since the web server threads are waiting for them
+    __atomic_store_n(&executor.running, false, __ATOMIC_RELEASE);
+
+    netdata_mutex_lock(&executor.mutex);
+    executor.stop = true;
+    netdata_cond_broadcast(&executor.cond);
+    netdata_mutex_unlock(&executor.mutex);
+
+    for(size_t i = 0; i < executor.threads ; i++)
+        nd_thread_join(executor.thread[i]);
+
+    freez(executor.thread);
+    executor.thread = NULL;
+    executor.threads = 0;
+
+    netdata_cond_destroy(&executor.cond);
+    netdata_mutex_destroy(&executor.mutex);
+}
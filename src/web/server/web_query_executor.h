@@ -0,0 +1,37 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef NETDATA_WEB_QUERY_EXECUTOR_H
+#define NETDATA_WEB_QUERY_EXECUTOR_H
+
+#include "libnetdata/libnetdata.h"
+
+// Heavy API requests are executed by a dedicated pool of threads, instead of the
+// web server thread polling the socket, so that a slow query does not delay the
+// other connections served by the same web server thread.
+
+typedef enum __attribute__((packed)) {
+    WEB_QUERY_PRIORITY_DASHBOARD = 0,   // interactive queries (data, weights, contexts, functions)
+    WEB_QUERY_PRIORITY_MCP,             // MCP requests (/mcp, /sse)
+    WEB_QUERY_PRIORITY_BULK,            // exports (allmetrics, csv/tsv/binary data)
+
+    // terminator
+    WEB_QUERY_PRIORITY_MAX,
+} WEB_QUERY_PRIORITY;
+
+typedef void (*web_query_execute_cb)(void *data);
+typedef void (*web_query_complete_cb)(void *data);
+
+const char *web_query_priority_2str(WEB_QUERY_PRIORITY priority);
+
+// check a complete HTTP request (as received) and decide if it should be offloaded
+bool web_query_executor_classify(const char *request, size_t len, WEB_QUERY_PRIORITY *priority);
+
+void web_query_executor_init(size_t threads);
+void web_query_executor_destroy(void);
+bool web_query_executor_enabled(void);
+
+// execute() runs on an executor thread, followed by complete() on the same thread
+// returns false when the executor is not running - the caller should run the query itself
+bool web_query_executor_dispatch(WEB_QUERY_PRIORITY priority, web_query_execute_cb execute, web_query_complete_cb complete, void *data);
+
+#endif //NETDATA_WEB_QUERY_EXECUTOR_H
@@ -56,5 +56,7 @@ struct web_client *web_client_create_on_listenfd(int listener);
 #endif // WEB_SERVER_INTERNALS
 
 #include "static/static-threaded.h"
+#include "web_query_executor.h"
+#include "web_static_cache.h"
 
 #endif /* NETDATA_WEB_SERVER_H */
@@ -0,0 +1,430 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#include "web_static_cache.h"
+#include "daemon/common.h"
+
+// static files are compressed once, so use high compression levels
+#define WEB_STATIC_CACHE_GZIP_LEVEL     9
+#define WEB_STATIC_CACHE_BROTLI_LEVEL   9
+#define WEB_STATIC_CACHE_ZSTD_LEVEL     15
+
+#define WEB_STATIC_CACHE_VARIANTS 3
+
+// a compressed variant - the file holds a reference, and every request copying it
+// holds another, so that it is copied without holding the spinlock of the file
+typedef struct web_static_variant {
+    REFCOUNT refcount;
+    size_t len;
+    char data[];
+} WEB_STATIC_VARIANT;
+
+typedef struct web_static_file {
+    SPINLOCK spinlock;
+    bool queued;                    // the file is in the compression queue
+
+    usec_t mtime_ut;                // the modification time of the file the variants were made from
+    off_t size;                     // the size of the file the variants were made from
+
+    WEB_STATIC_VARIANT *variants[WEB_STATIC_CACHE_VARIANTS];
+} WEB_STATIC_FILE;
+
+typedef struct web_static_job {
+    char *filename;
+    struct web_static_job *prev, *next;
+} WEB_STATIC_JOB;
+
+static struct {
+    bool running;
+    bool stop;
+
+    size_t max_memory;
+    size_t memory;                  // the bytes of all the variants cached
+
+    DICTIONARY *files;
+
+    netdata_mutex_t mutex;
+    netdata_cond_t cond;
+    WEB_STATIC_JOB *queue;
+
+    ND_THREAD *thread;
+} cache = { 0 };
+
+static const char *variant_extensions[WEB_STATIC_CACHE_VARIANTS] = {
+    [0] = ".gz",
+    [1] = ".br",
+    [2] = ".zst",
+};
+
+static inline size_t variant_index(WEB_ENCODING encoding) {
+    return (size_t)__builtin_ctz((unsigned)encoding);
+}
+
+static inline usec_t stat_mtime_ut(const struct stat *st) {
+#ifdef __APPLE__
+    return (usec_t)st->st_mtimespec.tv_sec * USEC_PER_SEC + (usec_t)st->st_mtimespec.tv_nsec / NSEC_PER_USEC;
+#else
+    return (usec_t)st->st_mtim.tv_sec * USEC_PER_SEC + (usec_t)st->st_mtim.tv_nsec / NSEC_PER_USEC;
+#endif
+}
+
+void web_static_cache_etag(const struct stat *st, char *dst, size_t dst_len) {
+    snprintfz(dst, dst_len, "\"%"PRIx64"-%"PRIx64"\"", (uint64_t)st->st_size, (uint64_t)stat_mtime_ut(st));
+}
+
+static bool web_static_file_is_cacheable(const char *filename, off_t size) {
+    return size >= WEB_COMPRESSION_MIN_SIZE && size <= WEB_STATIC_CACHE_MAX_FILE_SIZE &&
+           web_content_type_is_compressible(contenttype_for_filename(filename));
+}
+
+// ----------------------------------------------------------------------------
+// the variants
+
+static WEB_STATIC_VARIANT *web_static_variant_create(const char *data, size_t len) {
+    WEB_STATIC_VARIANT *v = mallocz(sizeof(*v) + len);
+    v->refcount = 1;
+    v->len = len;
+    memcpy(v->data, data, len);
+    return v;
+}
+
+static void web_static_variant_release(WEB_STATIC_VARIANT *v) {
+    if(v && refcount_decrement(&v->refcount) == 0)
+        freez(v);
+}
+
+// ----------------------------------------------------------------------------
+// the dictionary of files
+
+static void web_static_file_delete_cb(const DICTIONARY_ITEM *item __maybe_unused, void *value, void *data __maybe_unused) {
+    WEB_STATIC_FILE *f = value;
+
+    for(size_t i = 0; i < WEB_STATIC_CACHE_VARIANTS ; i++) {
+        if(!f->variants[i])
+            continue;
+
+        __atomic_sub_fetch(&cache.memory, f->variants[i]->len, __ATOMIC_RELAXED);
+        web_static_variant_release(f->variants[i]);
+        f->variants[i] = NULL;
+    }
+}
+
+static void web_static_cache_enqueue(const char *filename) {
+    WEB_STATIC_FILE tmp = { 0 };
+    WEB_STATIC_FILE *f = dictionary_set(cache.files, filename, &tmp, sizeof(tmp));
+
+    spinlock_lock(&f->spinlock);
+    bool queued = f->queued;
+    f->queued = true;
+    spinlock_unlock(&f->spinlock);
+
+    if(queued)
+        return;
+
+    WEB_STATIC_JOB *j = callocz(1, sizeof(*j));
+    j->filename = strdupz(filename);
+
+    netdata_mutex_lock(&cache.mutex);
+    DOUBLE_LINKED_LIST_APPEND_ITEM_UNSAFE(cache.queue, j, prev, next);
+    netdata_cond_signal(&cache.cond);
+    netdata_mutex_unlock(&cache.mutex);
+}
+
+bool web_static_cache_get(const char *filename, const struct stat *st, WEB_ENCODING accepted, BUFFER *dst, WEB_ENCODING *encoding) {
+    if(!__atomic_load_n(&cache.running, __ATOMIC_ACQUIRE))
+        return false;
+
+    accepted &= web_encodings_enabled();
+    if(!accepted || !web_static_file_is_cacheable(filename, st->st_size))
+        return false;
+
+    const DICTIONARY_ITEM *item = dictionary_get_and_acquire_item(cache.files, filename);
+    if(!item) {
+        web_static_cache_enqueue(filename);
+        return false;
+    }
+
+    WEB_STATIC_FILE *f = dictionary_acquired_item_value(item);
+    WEB_STATIC_VARIANT *v = NULL;
+    bool stale = false;
+
+    spinlock_lock(&f->spinlock);
+    if(f->size != st->st_size || f->mtime_ut != stat_mtime_ut(st))
+        stale = !f->queued;
+    else {
+        WEB_ENCODING available = WEB_ENCODING_NONE;
+        for(size_t i = 0; i < WEB_STATIC_CACHE_VARIANTS ; i++) {
+            if(f->variants[i])
+                available |= (WEB_ENCODING)(1 << i);
+        }
+
+        WEB_ENCODING selected = web_encoding_select(accepted & available, true);
+        if(selected != WEB_ENCODING_NONE) {
+            v = f->variants[variant_index(selected)];
+            refcount_increment(&v->refcount);
+            *encoding = selected;
+        }
+    }
+    spinlock_unlock(&f->spinlock);
+
+    dictionary_acquired_item_release(cache.files, item);
+
+    if(v) {
+        buffer_contents_replace(dst, v->data, v->len);
+        web_static_variant_release(v);
+    }
+
+    if(stale)
+        web_static_cache_enqueue(filename);
+
+    return v != NULL;
+}
+
+// ----------------------------------------------------------------------------
+// preparing the variants
+
+static bool web_static_cache_read_file(const char *filename, char *dst, size_t size) {
+    int fd = open(filename, O_RDONLY | O_CLOEXEC);
+    if(fd == -1)
+        return false;
+
+    bool ok = read(fd, dst, size) == (ssize_t)size;
+    close(fd);
+    return ok;
+}
+
+// load a pre-compressed sibling of the file (installed next to it), if it is up to date
+static WEB_STATIC_VARIANT *web_static_cache_load_sibling(const char *filename, const struct stat *st, size_t variant) {
+    char sibling[FILENAME_MAX + 1];
+    snprintfz(sibling, FILENAME_MAX, "%s%s", filename, variant_extensions[variant]);
+
+    struct stat sst;
+    if(stat(sibling, &sst) != 0 || !S_ISREG(sst.st_mode) || stat_mtime_ut(&sst) < stat_mtime_ut(st) ||
+        sst.st_size <= 0 || sst.st_size > WEB_STATIC_CACHE_MAX_FILE_SIZE)
+        return NULL;
+
+    WEB_STATIC_VARIANT *v = mallocz(sizeof(*v) + (size_t)sst.st_size);
+    v->refcount = 1;
+    v->len = (size_t)sst.st_size;
+
+    if(!web_static_cache_read_file(sibling, v->data, v->len)) {
+        freez(v);
+        return NULL;
+    }
+
+    return v;
+}
+
+static void web_static_cache_dequeued(const char *filename) {
+    const DICTIONARY_ITEM *item = dictionary_get_and_acquire_item(cache.files, filename);
+    if(!item)
+        return;
+
+    WEB_STATIC_FILE *f = dictionary_acquired_item_value(item);
+    spinlock_lock(&f->spinlock);
+    f->queued = false;
+    spinlock_unlock(&f->spinlock);
+
+    dictionary_acquired_item_release(cache.files, item);
+}
+
+static void web_static_cache_prepare(const char *filename, BUFFER *wb) {
+    struct stat st;
+    if(stat(filename, &st) != 0 || !S_ISREG(st.st_mode) || !web_static_file_is_cacheable(filename, st.st_size)) {
+        web_static_cache_dequeued(filename);
+        return;
+    }
+
+    char *src = NULL;
+    WEB_ENCODING enabled = web_encodings_enabled();
+    WEB_STATIC_VARIANT *fresh[WEB_STATIC_CACHE_VARIANTS] = { 0 };
+
+    size_t bytes = 0;
+    bool failed = false;
+    for(size_t i = 0; i < WEB_STATIC_CACHE_VARIANTS && !failed ; i++) {
+        WEB_ENCODING encoding = (WEB_ENCODING)(1 << i);
+        if(!(enabled & encoding))
+            continue;
+
+        fresh[i] = web_static_cache_load_sibling(filename, &st, i);
+        if(!fresh[i]) {
+            if(!src) {
+                src = mallocz((size_t)st.st_size + 1);
+                if(!web_static_cache_read_file(filename, src, (size_t)st.st_size)) {
+                    failed = true;
+                    continue;
+                }
+            }
+
+            int level = (encoding == WEB_ENCODING_BROTLI) ? WEB_STATIC_CACHE_BROTLI_LEVEL :
+                        (encoding == WEB_ENCODING_ZSTD) ? WEB_STATIC_CACHE_ZSTD_LEVEL : WEB_STATIC_CACHE_GZIP_LEVEL;
+
+            // keep only the variants that are actually smaller
+            if(!web_encoding_compress(encoding, level, src, (size_t)st.st_size, wb) || buffer_strlen(wb) >= (size_t)st.st_size)
+                continue;
+
+            fresh[i] = web_static_variant_create(buffer_tostring(wb), buffer_strlen(wb));
+        }
+
+        bytes += fresh[i]->len;
+    }
+    freez(src);
+
+    if(unlikely(failed)) {
+        // the file changed or vanished while it was read - keep what is cached
+        // and let the next request of the file queue it again
+        for(size_t i = 0; i < WEB_STATIC_CACHE_VARIANTS ; i++)
+            web_static_variant_release(fresh[i]);
+
+        web_static_cache_dequeued(filename);
+        return;
+    }
+
+    if(__atomic_load_n(&cache.memory, __ATOMIC_RELAXED) + bytes > cache.max_memory) {
+        nd_log_limit_static_global_var(erl, 60, 0);
+        nd_log_limit(&erl, NDLS_DAEMON, NDLP_NOTICE,
+                     "WEB STATIC CACHE: the cache is full (%zu bytes), file '%s' will be compressed on every request.",
+                     cache.max_memory, filename);
+
+        for(size_t i = 0; i < WEB_STATIC_CACHE_VARIANTS ; i++)
+            web_static_variant_release(fresh[i]);
+
+        // the file stays marked as queued, so that it is not compressed again and again
+        return;
+    }
+
+    WEB_STATIC_FILE tmp = { 0 };
+    WEB_STATIC_FILE *f = dictionary_set(cache.files, filename, &tmp, sizeof(tmp));
+
+    // swap the variants under the lock - the old ones are freed by their last reader
+    WEB_STATIC_VARIANT *old[WEB_STATIC_CACHE_VARIANTS];
+    spinlock_lock(&f->spinlock);
+    for(size_t i = 0; i < WEB_STATIC_CACHE_VARIANTS ; i++) {
+        old[i] = f->variants[i];
+        f->variants[i] = fresh[i];
+    }
+    f->size = st.st_size;
+    f->mtime_ut = stat_mtime_ut(&st);
+    f->queued = false;
+    spinlock_unlock(&f->spinlock);
+
+    for(size_t i = 0; i < WEB_STATIC_CACHE_VARIANTS ; i++) {
+        if(!old[i])
+            continue;
+
+        __atomic_sub_fetch(&cache.memory, old[i]->len, __ATOMIC_RELAXED);
+        web_static_variant_release(old[i]);
+    }
+
+    __atomic_add_fetch(&cache.memory, bytes, __ATOMIC_RELAXED);
+}
+
+// queue all the files of the web directory, so that the dashboard is ready before it is requested
+static void web_static_cache_warmup(const char *path, int depth) {
+    if(depth > 10)
+        return;
+
+    DIR *dir = opendir(path);
+    if(!dir)
+        return;
+
+    struct dirent *de;
+    while((de = readdir(dir)) && !__atomic_load_n(&cache.stop, __ATOMIC_RELAXED)) {
+        if(de->d_name[0] == '.')
+            continue;
+
+        char filename[FILENAME_MAX + 1];
+        snprintfz(filename, FILENAME_MAX, "%s/%s", path, de->d_name);
+
+        struct stat st;
+        if(stat(filename, &st) != 0)
+            continue;
+
+        if(S_ISDIR(st.st_mode))
+            web_static_cache_warmup(filename, depth + 1);
+        else if(S_ISREG(st.st_mode) && web_static_file_is_cacheable(filename, st.st_size))
+            web_static_cache_enqueue(filename);
+    }
+
+    closedir(dir);
+}
+
+static void web_static_cache_thread(void *ptr __maybe_unused) {
+    worker_register("WEBCOMPRESS");
+    worker_register_job_name(0, "compress");
+
+    web_static_cache_warmup(netdata_configured_web_dir, 0);
+
+    BUFFER *wb = buffer_create(64 * 1024, &netdata_buffers_statistics.buffers_web);
+
+    netdata_mutex_lock(&cache.mutex);
+    while(!cache.stop) {
+        WEB_STATIC_JOB *j = cache.queue;
+        if(!j) {
+            worker_is_idle();
+            netdata_cond_wait(&cache.cond, &cache.mutex);
+            continue;
+        }
+
+        DOUBLE_LINKED_LIST_REMOVE_ITEM_UNSAFE(cache.queue, j, prev, next);
+        netdata_mutex_unlock(&cache.mutex);
+
+        worker_is_busy(0);
+        web_static_cache_prepare(j->filename, wb);
+
+        freez(j->filename);
+        freez(j);
+
+        netdata_mutex_lock(&cache.mutex);
+    }
+    netdata_mutex_unlock(&cache.mutex);
+
+    buffer_free(wb);
+    worker_unregister();
+}
+
+void web_static_cache_init(size_t max_memory) {
+    if(!max_memory || cache.running || !web_encodings_enabled())
+        return;
+
+    fatal_assert(0 == netdata_mutex_init(&cache.mutex));
+    fatal_assert(0 == netdata_cond_init(&cache.cond));
+
+    cache.max_memory = max_memory;
+    cache.stop = false;
+    cache.files = dictionary_create_advanced(DICT_OPTION_DONT_OVERWRITE_VALUE | DICT_OPTION_FIXED_SIZE,
+                                             NULL, sizeof(WEB_STATIC_FILE));
+    dictionary_register_delete_callback(cache.files, web_static_file_delete_cb, NULL);
+
+    __atomic_store_n(&cache.running, true, __ATOMIC_RELEASE);
+
+    cache.thread = nd_thread_create("WEBCOMPRESS", NETDATA_THREAD_OPTION_DONT_LOG, web_static_cache_thread, NULL);
+}
+
+void web_static_cache_destroy(void) {
+    if(!cache.running)
+        return;
+
+    // the web server threads have stopped, nobody reads the cache anymore
+    __atomic_store_n(&cache.running, false, __ATOMIC_RELEASE);
+
+    netdata_mutex_lock(&cache.mutex);
+    __atomic_store_n(&cache.stop, true, __ATOMIC_RELAXED);
+    netdata_cond_signal(&cache.cond);
+    netdata_mutex_unlock(&cache.mutex);
+
+    nd_thread_join(cache.thread);
+    cache.thread = NULL;
+
+    while(cache.queue) {
+        WEB_STATIC_JOB *j = cache.queue;
+        DOUBLE_LINKED_LIST_REMOVE_ITEM_UNSAFE(cache.queue, j, prev, next);
+        freez(j->filename);
+        freez(j);
+    }
+
+    dictionary_destroy(cache.files);
+    cache.files = NULL;
+
+    netdata_cond_destroy(&cache.cond);
+    netdata_mutex_destroy(&cache.mutex);
+}
@@ -0,0 +1,29 @@
+// SPDX-License-Identifier: GPL-3.0-or-later
+
+#ifndef NETDATA_WEB_STATIC_CACHE_H
+#define NETDATA_WEB_STATIC_CACHE_H
+
+#include "libnetdata/libnetdata.h"
+#include "web_compression.h"
+
+// Compressed variants (gzip, br, zstd) of the static files of the dashboard,
+// kept in memory so that they are compressed once, not on every page load.
+// The variants are prepared by a background thread: all the files of the web
+// directory at startup, and later any file requested that is missing or has
+// changed on disk. Pre-compressed siblings (file.br, file.zst, file.gz) found
+// on disk, newer than the file itself, are loaded instead of compressing.
+
+// the cache holds only files up to this size
+#define WEB_STATIC_CACHE_MAX_FILE_SIZE (16 * 1024 * 1024)
+
+void web_static_cache_init(size_t max_memory);
+void web_static_cache_destroy(void);
+
+// the entity tag of a file, derived from its size and modification time
+void web_static_cache_etag(const struct stat *st, char *dst, size_t dst_len);
+
+// copy into dst the best variant of the file the client accepts
+// returns false (and schedules the file for compression) when there is none
+bool web_static_cache_get(const char *filename, const struct stat *st, WEB_ENCODING accepted, BUFFER *dst, WEB_ENCODING *encoding);
+
+#endif //NETDATA_WEB_STATIC_CACHE_H